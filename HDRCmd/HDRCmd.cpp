@@ -18,9 +18,16 @@
 
 #include "CLI/CLI.hpp"
 
+#include "subcommand/Apply.hpp"
+#include "subcommand/Batch.hpp"
 #include "subcommand/Disable.hpp"
 #include "subcommand/Enable.hpp"
+#include "subcommand/SaveTrace.hpp"
+#include "subcommand/Stats.hpp"
 #include "subcommand/Status.hpp"
+#include "subcommand/Tray.hpp"
+#include "subcommand/Vcp.hpp"
+#include "Trace.hpp"
 #include "version.h"
 #include "WinVerCheck.hpp"
 
@@ -44,12 +51,27 @@ int wmain(int argc, const wchar_t* const argv[])
     app.ignore_case();
     app.require_subcommand(1);
     app.failure_message(failure_message);
+    subcommand::add_direct_option(app);
+    subcommand::add_trace_option(app);
 
     subcommand::Status::add(app);
     subcommand::Enable::add(app);
     subcommand::Disable::add(app);
+    subcommand::Apply::add(app);
+    subcommand::Vcp::add(app);
+    subcommand::Batch::add(app);
+    subcommand::SaveTrace::add(app);
+    subcommand::Stats::add(app);
 
     CLI11_PARSE(app, argc, argv);
     const auto* subcmd = app.get_subcommands()[0];
-    return static_cast<const subcommand::Base*>(subcmd)->run();
+    int result;
+    {
+        trace::Span span("hdrcmd", subcmd->get_name().c_str());
+        result = static_cast<const subcommand::Base*>(subcmd)->run();
+        span.Arg("result", result);
+    }
+    if (!subcommand::write_own_trace() && result == 0)
+        result = 1;
+    return result;
 }
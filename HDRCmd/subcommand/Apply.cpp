@@ -0,0 +1,144 @@
+/*
+    HDRCmd - enable/disable "Use HDR" from command line
+    Copyright (C) 2024 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Apply.hpp"
+
+#include "MonitorSelection.hpp"
+
+#include "ColorTools.hpp"
+#include "ConfigManager.hpp"
+#include "RecordingBackends.hpp"
+#include "TransitionController.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <print>
+#include <utility>
+
+namespace subcommand {
+
+static void print_steps(const std::vector<std::pair<TransitionPhase, uint64_t>>& phases, bool dry_run)
+{
+    std::println("Steps{}:", dry_run ? " (estimated, waits skipped)" : "");
+    for (const auto& [phase, duration] : phases)
+        std::println("  {:<24}{:>8} ms", TransitionPhaseName(phase), duration);
+}
+
+static void print_operations(const backend::Recorder& recorder)
+{
+    using OpKind = backend::Recorder::OpKind;
+    const auto& operations = recorder.GetOperations();
+    size_t tool_runs = 0;
+    uint64_t tool_ms = 0;
+    uint64_t wait_ms = 0;
+    for (const auto& op : operations) {
+        if (backend::Recorder::RunsTool(op.kind)) {
+            tool_runs++;
+            tool_ms += op.durationMs;
+        } else if (op.kind == OpKind::Sleep) {
+            wait_ms += op.durationMs;
+        }
+    }
+
+    std::println("Operations: {}, {} tool runs taking {} ms, {} ms waiting", operations.size(), tool_runs, tool_ms,
+                 wait_ms);
+    for (const auto& op : operations) {
+        std::println("  {:>8} ms  {}{}{}", op.durationMs, CLI::narrow(backend::Recorder::Describe(op)),
+                     op.succeeded ? "" : " (failed)", op.redundant ? " (no change)" : "");
+    }
+}
+
+static void print_changes(const backend::Recorder& recorder)
+{
+    const auto changes = recorder.GetChanges();
+    const auto redundant = std::count_if(recorder.GetOperations().begin(), recorder.GetOperations().end(),
+                                         [](const backend::Recorder::Operation& op) { return op.redundant; });
+    std::println("Would perform {} operations ({} skipped, as they change nothing):", changes.size(), redundant);
+    for (const auto& op : changes)
+        std::println("  {}", CLI::narrow(backend::Recorder::Describe(op)));
+}
+
+Apply::Apply(CLI::App* parent)
+    : Base("Switch HDR and apply the HDRTray color profiles and monitor settings", "apply", parent)
+{
+    add_option("-m,--mode", mode, "Mode to switch to")
+        ->required()
+        ->transform(CLI::IsMember({ "hdr", "sdr" }, CLI::ignore_case));
+    add_monitor_option(*this, displays,
+                       "Monitor to apply color settings to: number as in the HDRTray log (1 is the first), or EDID "
+                       "id. May be given multiple times. HDR is always switched for all displays.");
+    add_flag("--dry-run", dry_run, "Only print what would be done, without changing anything");
+}
+
+int Apply::run() const
+{
+    ConfigManager config;
+    if (!config.Load()) {
+        std::cerr << "Could not load " << CLI::narrow(config.GetConfigFilePath()) << std::endl;
+        return -1;
+    }
+
+    ColorTools tools(ColorTools::InDirectory(ColorTools::GetExecutableDirectory()));
+
+    const auto selected = resolve_monitors(displays);
+    if (!selected)
+        return -1;
+    TransitionController::DisplayFilter filter;
+    if (!selected->empty())
+        filter = [&](const MonitorSettings& display) { return selected->contains(display.displayId); };
+
+    backend::Recorder recorder(tools.GetBackends(), dry_run);
+    ColorPipeline pipeline(recorder.GetBackends());
+    TransitionController controller(pipeline, config);
+    std::vector<std::pair<TransitionPhase, uint64_t>> phases;
+    controller.SetPhaseCallback(
+        [&](TransitionPhase phase, uint64_t duration_ms) { phases.emplace_back(phase, duration_ms); });
+
+    if (!config.GetSnapshot()->defaults.enableColorManagement)
+        std::cerr << "Color management is disabled in " << CLI::narrow(config.GetConfigFilePath())
+                  << ", only switching HDR" << std::endl;
+    else if (!pipeline.AreToolsAvailable())
+        std::cerr << "Color tools not found in " << CLI::narrow(tools.GetPaths().dispwin) << " and "
+                  << CLI::narrow(tools.GetPaths().winddcutil) << ", only switching HDR" << std::endl;
+
+    const bool enable = mode == "hdr";
+    std::println("{} {} mode", dry_run ? "Dry run, switching to" : "Switching to", enable ? "HDR" : "SDR");
+    const auto status = controller.Apply(enable, filter);
+
+    print_steps(phases, dry_run);
+    print_operations(recorder);
+    if (dry_run)
+        print_changes(recorder);
+
+    if (!status || *status == hdr::Status::Unsupported) {
+        std::cerr << "Switching HDR failed" << std::endl;
+        return -1;
+    }
+    if (*status != (enable ? hdr::Status::On : hdr::Status::Off) || !controller.GetLastTransition().succeeded) {
+        std::cerr << "Not all settings could be applied" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+CLI::App* Apply::add(CLI::App& app)
+{
+    return app.add_subcommand(std::shared_ptr<Apply>(new Apply(&app)));
+}
+
+} // namespace subcommand
@@ -0,0 +1,50 @@
+/*
+    HDRCmd - enable/disable "Use HDR" from command line
+    Copyright (C) 2024 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SUBCOMMAND_APPLY_HPP_
+#define SUBCOMMAND_APPLY_HPP_
+
+#include "Base.hpp"
+
+#include <string>
+#include <vector>
+
+namespace subcommand {
+/**
+ * Run the HDRTray color pipeline without HDRTray: switch to HDR or SDR and apply the
+ * configured color profiles and monitor settings, printing how long each step took.
+ * With "--dry-run", nothing is changed; the operations a real run would carry out are printed instead.
+ */
+class Apply : public Base
+{
+protected:
+    std::string mode;
+    std::vector<std::string> displays;
+    bool dry_run = false;
+
+    Apply(CLI::App* parent);
+
+public:
+    int run() const override;
+
+    static CLI::App* add(CLI::App& app);
+};
+
+} // namespace subcommand
+
+#endif // SUBCOMMAND_APPLY_HPP_
@@ -0,0 +1,308 @@
+/*
+    HDRCmd - enable/disable "Use HDR" from command line
+    Copyright (C) 2024 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Batch.hpp"
+
+#include "Apply.hpp"
+#include "Disable.hpp"
+#include "Enable.hpp"
+#include "Json.hpp"
+#include "Status.hpp"
+#include "Tray.hpp"
+#include "Vcp.hpp"
+
+#include "HDR.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <print>
+#include <thread>
+
+namespace subcommand {
+
+using namespace std::chrono_literals;
+
+static std::optional<hdr::Status> parse_status(const std::string& str)
+{
+    const auto lower = CLI::detail::to_lower(str);
+    if (lower == "on")
+        return hdr::Status::On;
+    if (lower == "off")
+        return hdr::Status::Off;
+    if (lower == "unsupported")
+        return hdr::Status::Unsupported;
+    return std::nullopt;
+}
+
+/// Script command: wait until HDR has a status, or a timeout expires
+class Wait : public Base
+{
+protected:
+    std::string status;
+    unsigned timeout_ms = 10000;
+
+    Wait(CLI::App* parent) : Base("Wait until HDR has the given status", "wait", parent)
+    {
+        add_option("status", status, "Status to wait for")
+            ->required()
+            ->transform(CLI::IsMember({ "on", "off", "unsupported" }, CLI::ignore_case));
+        add_option("-t,--timeout", timeout_ms, "Give up after this many milliseconds")->capture_default_str();
+    }
+
+public:
+    int run() const override
+    {
+        const auto target = parse_status(status);
+        const auto start = std::chrono::steady_clock::now();
+        const auto timeout = std::chrono::milliseconds(timeout_ms);
+        /* Windows reports a new HDR status with a delay after some changes, and there's no
+         * notification for that, so check again with growing intervals. With HDRTray running,
+         * a check only reads its status board. */
+        auto interval = 25ms;
+        while (true) {
+            hdr::InvalidateDisplayCache();
+            if (get_status() == target)
+                return 0;
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start);
+            if (elapsed >= timeout) {
+                std::cerr << "Timed out after " << elapsed.count() << " ms waiting for HDR to be " << status
+                          << std::endl;
+                return 1;
+            }
+            std::this_thread::sleep_for(std::min<std::chrono::milliseconds>(interval, timeout - elapsed));
+            interval = std::min<std::chrono::milliseconds>(interval * 2, 500ms);
+        }
+    }
+
+    static CLI::App* add(CLI::App& app) { return app.add_subcommand(std::shared_ptr<Wait>(new Wait(&app))); }
+};
+
+/// Script command: pause
+class Sleep : public Base
+{
+protected:
+    unsigned duration_ms = 0;
+
+    Sleep(CLI::App* parent) : Base("Pause for the given number of milliseconds", "sleep", parent)
+    {
+        add_option("milliseconds", duration_ms, "Time to pause")->required();
+    }
+
+public:
+    int run() const override
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+        // The display configuration may have changed meanwhile
+        hdr::InvalidateDisplayCache();
+        return 0;
+    }
+
+    static CLI::App* add(CLI::App& app) { return app.add_subcommand(std::shared_ptr<Sleep>(new Sleep(&app))); }
+};
+
+/// Parsed script line
+struct Step
+{
+    size_t line;
+    std::string text;
+    /// Status the command is conditional on
+    std::optional<hdr::Status> condition;
+    /// Run the command if the status is not the one in \c condition
+    bool negate = false;
+    /// Holds the parsed subcommand
+    std::unique_ptr<CLI::App> app;
+};
+
+/// Outcome of a step
+struct StepResult
+{
+    const Step* step;
+    bool skipped = false;
+    int exit_code = 0;
+    std::chrono::microseconds duration { 0 };
+};
+
+static std::unique_ptr<CLI::App> make_script_app()
+{
+    // A fresh parser per line, so no option value carries over from an earlier line
+    auto app = std::make_unique<CLI::App>("HDRCmd batch script command");
+    app->allow_windows_style_options();
+    app->ignore_case();
+    app->require_subcommand(1);
+    Status::add(*app);
+    Enable::add(*app);
+    Disable::add(*app);
+    Apply::add(*app);
+    Vcp::add(*app);
+    Wait::add(*app);
+    Sleep::add(*app);
+    return app;
+}
+
+static bool read_script(const std::string& name, std::vector<std::string>& lines)
+{
+    std::ifstream file;
+    std::istream* in = &std::cin;
+    if (name != "-") {
+        file.open(std::filesystem::path(CLI::widen(name)));
+        if (!file)
+            return false;
+        in = &file;
+    }
+    std::string line;
+    while (std::getline(*in, line)) {
+        // Editors on Windows like to add a BOM and CRs
+        if (lines.empty() && line.starts_with("\xEF\xBB\xBF"))
+            line.erase(0, 3);
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        lines.push_back(std::move(line));
+    }
+    return true;
+}
+
+/**
+ * Parse a script line.
+ * @return Step; nothing for empty lines and comments
+ * @throws CLI::ParseError if the line is not a valid command
+ */
+static std::optional<Step> parse_line(size_t number, const std::string& line, std::string& error)
+{
+    auto args = CLI::detail::split_up(line);
+    args.erase(std::remove(args.begin(), args.end(), std::string {}), args.end());
+    if (args.empty() || args.front().starts_with("#"))
+        return std::nullopt;
+
+    Step step { number, line };
+    size_t first = 0;
+    if (CLI::detail::to_lower(args[0]) == "if") {
+        first = 1;
+        if (first < args.size() && CLI::detail::to_lower(args[first]) == "not") {
+            step.negate = true;
+            first++;
+        }
+        if (first < args.size())
+            step.condition = parse_status(args[first++]);
+        if (!step.condition || first == args.size()) {
+            error = "expected \"if [not] on|off|unsupported COMMAND\"";
+            return std::nullopt;
+        }
+    }
+
+    args.erase(args.begin(), args.begin() + first);
+    // CLI11 takes arguments in reverse order
+    std::reverse(args.begin(), args.end());
+    step.app = make_script_app();
+    step.app->parse(std::move(args));
+    return step;
+}
+
+static void print_summary(const std::vector<StepResult>& results, size_t step_count,
+                          std::chrono::microseconds parse_time, std::chrono::microseconds total_time,
+                          uint64_t topology_queries)
+{
+    const auto ms = [](std::chrono::microseconds us) { return us.count() / 1000.0; };
+    const auto run = std::count_if(results.begin(), results.end(), [](const StepResult& r) { return !r.skipped; });
+    std::println(stderr, "Ran {} of {} commands in {:.1f} ms (parsing {:.2f} ms), {} display queries", run,
+                 step_count, ms(total_time), ms(parse_time), topology_queries);
+    std::println(stderr, "{:>6}  {:>4}  {:>10}  {}", "Line", "Exit", "Time (ms)", "Command");
+    for (const auto& result : results) {
+        if (result.skipped)
+            std::println(stderr, "{:>6}  {:>4}  {:>10}  {}", result.step->line, "-", "skipped", result.step->text);
+        else
+            std::println(stderr, "{:>6}  {:>4}  {:>10.2f}  {}", result.step->line, result.exit_code,
+                         ms(result.duration), result.step->text);
+    }
+}
+
+Batch::Batch(CLI::App* parent) : Base("Run commands from a script, one per line, in a single process", "batch", parent)
+{
+    add_option("script", script, "Script file, or - to read from standard input")->required();
+    add_flag("-k,--keep-going", keep_going, "Run the remaining commands after one failed");
+}
+
+int Batch::run() const
+{
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> lines;
+    if (!read_script(script, lines)) {
+        std::cerr << "Could not read " << script << std::endl;
+        return -1;
+    }
+
+    // Parse everything first: a typo further down shouldn't show up after HDR was switched
+    std::vector<Step> steps;
+    for (size_t i = 0; i < lines.size(); i++) {
+        std::string error;
+        try {
+            if (auto step = parse_line(i + 1, lines[i], error))
+                steps.push_back(std::move(*step));
+        } catch (const CLI::ParseError& e) {
+            error = e.what();
+        }
+        if (!error.empty()) {
+            std::cerr << script << ", line " << (i + 1) << ": " << error << std::endl;
+            return -1;
+        }
+    }
+    const auto parsed = std::chrono::steady_clock::now();
+    const auto start_queries = hdr::GetQueryStats().topologyQueries;
+
+    std::vector<StepResult> results;
+    int exit_code = 0;
+    for (const auto& step : steps) {
+        StepResult result { &step };
+        const auto step_start = std::chrono::steady_clock::now();
+        if (step.condition)
+            result.skipped = (get_status() == *step.condition) == step.negate;
+        if (!result.skipped) {
+            const auto* subcmd = step.app->get_subcommands()[0];
+            result.exit_code = static_cast<const Base*>(subcmd)->run();
+            // Commands print to the console; keep their output in order with the summary
+            std::fflush(stdout);
+        }
+        result.duration
+            = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - step_start);
+        results.push_back(result);
+
+        if (result.exit_code != 0) {
+            exit_code = result.exit_code;
+            if (!keep_going)
+                break;
+        }
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    print_summary(results, steps.size(), std::chrono::duration_cast<std::chrono::microseconds>(parsed - start),
+                  std::chrono::duration_cast<std::chrono::microseconds>(end - start),
+                  hdr::GetQueryStats().topologyQueries - start_queries);
+    return exit_code;
+}
+
+CLI::App* Batch::add(CLI::App& app)
+{
+    return app.add_subcommand(std::shared_ptr<Batch>(new Batch(&app)));
+}
+
+} // namespace subcommand
@@ -0,0 +1,49 @@
+/*
+    HDRCmd - enable/disable "Use HDR" from command line
+    Copyright (C) 2024 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SUBCOMMAND_BATCH_HPP_
+#define SUBCOMMAND_BATCH_HPP_
+
+#include "Base.hpp"
+
+#include <string>
+
+namespace subcommand {
+/**
+ * Run a script of commands, one per line, in this process.
+ * Commands share the display cache, so displays are only enumerated again after a wait.
+ * Besides the normal subcommands, scripts may use "wait" (for an HDR status, with a timeout),
+ * "sleep" and an "if [not] STATUS" prefix making a command conditional.
+ */
+class Batch : public Base
+{
+protected:
+    std::string script;
+    bool keep_going = false;
+
+    Batch(CLI::App* parent);
+
+public:
+    int run() const override;
+
+    static CLI::App* add(CLI::App& app);
+};
+
+} // namespace subcommand
+
+#endif // SUBCOMMAND_BATCH_HPP_
@@ -18,18 +18,19 @@
 
 #include "Disable.hpp"
 
-#include "HDR.h"
+#include "DisplaySelection.hpp"
 
 namespace subcommand {
 
-Disable::Disable(CLI::App* parent) : Base("Turn HDR off", "off", parent) { }
+Disable::Disable(CLI::App* parent) : Base("Turn HDR off", "off", parent)
+{
+    add_display_option(*this, displays);
+    add_format_option(*this, format);
+}
 
 int Disable::run() const
 {
-    auto result = hdr::SetWindowsHDRStatus(false);
-    if (!result)
-        return -1;
-    return *result == hdr::Status::Off ? 0 : 1;
+    return set_hdr_status(displays, false, output_format(format));
 }
 
 CLI::App* Disable::add(CLI::App& app)
@@ -21,10 +21,16 @@
 
 #include "Base.hpp"
 
+#include <string>
+#include <vector>
+
 namespace subcommand {
 class Disable : public Base
 {
 protected:
+    std::vector<std::string> displays;
+    std::string format;
+
     Disable(CLI::App* parent);
 
 public:
@@ -0,0 +1,210 @@
+/*
+    HDRCmd - enable/disable "Use HDR" from command line
+    Copyright (C) 2024 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "DisplaySelection.hpp"
+
+#include "HDR.h"
+#include "Json.hpp"
+#include "Tray.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <iostream>
+#include <optional>
+
+namespace subcommand {
+
+void add_display_option(CLI::App& app, std::vector<std::string>& selectors)
+{
+    auto display_option = app.add_option("-d,--display", selectors,
+                                         "Only change these displays: number or id from \"status --mode long\", or name");
+    display_option->type_name("DISPLAY");
+}
+
+static bool equals_no_case(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size() && CLI::detail::to_lower(std::string(a)) == CLI::detail::to_lower(std::string(b));
+}
+
+static std::optional<hdr::DisplayId> find_display(const std::vector<hdr::Display>& displays,
+                                                  const std::string& selector)
+{
+    // Display number
+    size_t index = 0;
+    const auto [end, ec] = std::from_chars(selector.data(), selector.data() + selector.size(), index);
+    if (ec == std::errc() && end == selector.data() + selector.size()) {
+        if (index < displays.size())
+            return displays[index].id;
+        return std::nullopt;
+    }
+
+    // Display id; may also refer to a display without a name
+    if (auto id = hdr::DisplayId::FromString(CLI::widen(selector)))
+        return id;
+
+    // Display name
+    for (const auto& disp : displays) {
+        if (equals_no_case(CLI::narrow(disp.name), selector))
+            return disp.id;
+    }
+    return std::nullopt;
+}
+
+static int set_all_displays(bool enable, std::vector<DisplayOutcome>& outcomes)
+{
+    const auto requested = enable ? hdr::Status::On : hdr::Status::Off;
+
+    // From the display cache SetWindowsHDRStatus() uses as well
+    const auto before = hdr::GetDisplays();
+    auto result = hdr::SetWindowsHDRStatus(enable);
+
+    const auto after = hdr::GetDisplays();
+    for (const auto& disp : before) {
+        auto now = std::find_if(after.begin(), after.end(), [&](const hdr::Display& d) { return d.id == disp.id; });
+        std::string_view outcome;
+        if (disp.status == hdr::Status::Unsupported)
+            outcome = "unsupported";
+        else if (disp.status == requested)
+            outcome = "unchanged";
+        else if (now != after.end() && now->status == requested)
+            outcome = "changed";
+        else
+            outcome = "failed";
+        outcomes.push_back(DisplayOutcome { disp.id, outcome });
+    }
+
+    if (!result)
+        return -1;
+    return *result == requested ? 0 : 1;
+}
+
+/// Resolve selectors to display ids; prints an error and returns nothing if one doesn't match
+static std::optional<std::vector<hdr::DisplayId>> resolve_selectors(const std::vector<hdr::Display>& displays,
+                                                                    const std::vector<std::string>& selectors,
+                                                                    std::string& error)
+{
+    std::vector<hdr::DisplayId> ids;
+    for (const auto& selector : selectors) {
+        auto id = find_display(displays, selector);
+        if (!id) {
+            error = std::format("No display matches \"{}\"", selector);
+            std::cerr << error << std::endl;
+            return std::nullopt;
+        }
+        ids.push_back(*id);
+    }
+    return ids;
+}
+
+static int collect_results(const std::vector<hdr::DisplayResult>& results, bool enable,
+                           std::vector<DisplayOutcome>& outcomes, std::string& error)
+{
+    const auto requested = enable ? hdr::Status::On : hdr::Status::Off;
+
+    int exit_code = 0;
+    for (const auto& result : results) {
+        if (!result.status) {
+            error = std::format("Display {}: HDR not supported, or changing it failed",
+                                CLI::narrow(result.id.ToString()));
+            std::cerr << error << std::endl;
+            exit_code = -1;
+            outcomes.push_back(DisplayOutcome { result.id, "failed" });
+        } else if (*result.status != requested) {
+            if (exit_code == 0)
+                exit_code = 1;
+            outcomes.push_back(DisplayOutcome { result.id, "failed" });
+        } else {
+            outcomes.push_back(DisplayOutcome { result.id, result.unchanged ? "unchanged" : "changed" });
+        }
+    }
+    return exit_code;
+}
+
+static int set_selected_displays(const std::vector<std::string>& selectors, bool enable,
+                                 std::vector<DisplayOutcome>& outcomes, std::string& error)
+{
+    auto ids = resolve_selectors(hdr::GetDisplays(), selectors, error);
+    if (!ids)
+        return -1;
+    return collect_results(hdr::SetDisplaysHDRStatus(*ids, enable), enable, outcomes, error);
+}
+
+/**
+ * Have a running HDRTray change the status, so its color profiles are applied as well.
+ * @return Exit code; nothing if HDRTray isn't running
+ */
+static std::optional<int> forward_set_hdr_status(const std::vector<std::string>& selectors, bool enable)
+{
+    ipc::Request request { ipc::Command::SetStatus, enable };
+    std::string error;
+    if (!selectors.empty()) {
+        std::vector<hdr::Display> displays;
+        auto listing = forward_to_tray({ ipc::Command::GetDisplays });
+        if (!listing)
+            return std::nullopt;
+        for (auto& entry : listing->displays)
+            displays.push_back({ entry.id, std::move(entry.name), entry.status.value_or(hdr::Status::Unsupported) });
+        auto ids = resolve_selectors(displays, selectors, error);
+        if (!ids)
+            return -1;
+        request.displays = std::move(*ids);
+    }
+
+    auto response = forward_to_tray(request);
+    if (!response)
+        return std::nullopt;
+    if (selectors.empty()) {
+        if (!response->changedStatus)
+            return -1;
+        return *response->changedStatus == (enable ? hdr::Status::On : hdr::Status::Off) ? 0 : 1;
+    }
+
+    std::vector<hdr::DisplayResult> results;
+    for (const auto& entry : response->displays)
+        results.push_back({ entry.id, entry.status, entry.unchanged });
+    std::vector<DisplayOutcome> outcomes;
+    return collect_results(results, enable, outcomes, error);
+}
+
+int set_hdr_status(const std::vector<std::string>& selectors, bool enable, OutputFormat format)
+{
+    const bool json = format == OutputFormat::Json;
+    // The JSON report lists the API calls made by this process, so don't forward those
+    if (!json) {
+        if (auto exit_code = forward_set_hdr_status(selectors, enable))
+            return *exit_code;
+    }
+    if (json)
+        hdr::StartCallRecording();
+
+    std::vector<DisplayOutcome> outcomes;
+    std::string error;
+    const int exit_code = selectors.empty() ? set_all_displays(enable, outcomes)
+                                            : set_selected_displays(selectors, enable, outcomes, error);
+
+    if (json) {
+        auto displays = hdr::GetDisplayDetails();
+        auto status = hdr::GetWindowsHDRStatus();
+        auto calls = hdr::StopCallRecording();
+        print_json_report(enable ? "on" : "off", status, displays, calls, outcomes, exit_code, error);
+    }
+    return exit_code;
+}
+
+} // namespace subcommand
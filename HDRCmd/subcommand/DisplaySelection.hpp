@@ -0,0 +1,47 @@
+/*
+    HDRCmd - enable/disable "Use HDR" from command line
+    Copyright (C) 2024 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SUBCOMMAND_DISPLAYSELECTION_HPP_
+#define SUBCOMMAND_DISPLAYSELECTION_HPP_
+
+#include "CLI/CLI.hpp"
+
+#include "Json.hpp"
+
+#include <string>
+#include <vector>
+
+namespace subcommand {
+
+/// Add the "--display" option, for selecting the displays a command applies to
+void add_display_option(CLI::App& app, std::vector<std::string>& selectors);
+
+/**
+ * Turn HDR on or off, on all displays if there are no selectors.
+ * Selectors are a display number as printed by "status --mode long", a display id or a display name.
+ * If HDRTray is running, it makes the change, so its color profiles are applied as well.
+ * With JSON output, a report with the outcome and details of every display is printed;
+ * that is always done directly.
+ * @return Exit code: 0 if all displays got the requested status, 1 if some didn't,
+ *   -1 if a display didn't support HDR or changing the status failed
+ */
+int set_hdr_status(const std::vector<std::string>& selectors, bool enable, OutputFormat format);
+
+} // namespace subcommand
+
+#endif // SUBCOMMAND_DISPLAYSELECTION_HPP_
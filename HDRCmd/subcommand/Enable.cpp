@@ -18,18 +18,19 @@
 
 #include "Enable.hpp"
 
-#include "HDR.h"
+#include "DisplaySelection.hpp"
 
 namespace subcommand {
 
-Enable::Enable(CLI::App* parent) : Base("Turn HDR on", "on", parent) { }
+Enable::Enable(CLI::App* parent) : Base("Turn HDR on", "on", parent)
+{
+    add_display_option(*this, displays);
+    add_format_option(*this, format);
+}
 
 int Enable::run() const
 {
-    auto result = hdr::SetWindowsHDRStatus(true);
-    if (!result)
-        return -1;
-    return *result == hdr::Status::On ? 0 : 1;
+    return set_hdr_status(displays, true, output_format(format));
 }
 
 CLI::App* Enable::add(CLI::App& app)
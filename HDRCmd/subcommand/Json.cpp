@@ -0,0 +1,289 @@
+/*
+    HDRCmd - enable/disable "Use HDR" from command line
+    Copyright (C) 2024 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Json.hpp"
+
+#include <algorithm>
+#include <format>
+#include <print>
+
+namespace subcommand {
+
+class FormatValidator : public CLI::Validator
+{
+    static constexpr const char* descr_string = "text,json";
+
+    static std::string validate_func(std::string& item)
+    {
+        item = CLI::detail::to_lower(item);
+        if (item == "text" || item == "json")
+            return {};
+        return std::format("\"{}\" not in {}", item, descr_string);
+    }
+
+public:
+    FormatValidator() : Validator(descr_string, &validate_func) { }
+};
+
+void add_format_option(CLI::App& app, std::string& format)
+{
+    auto format_option = app.add_option("-f,--format", format, "Output format");
+    format_option->type_name("FORMAT");
+    format_option->transform(FormatValidator());
+}
+
+OutputFormat output_format(const std::string& format)
+{
+    return stricmp(format.c_str(), "json") == 0 ? OutputFormat::Json : OutputFormat::Text;
+}
+
+std::string_view color_mode_string(hdr::ColorMode mode)
+{
+    switch (mode) {
+    case hdr::ColorMode::Sdr:
+        return "sdr";
+    case hdr::ColorMode::Wcg:
+        return "wcg";
+    case hdr::ColorMode::Hdr:
+        return "hdr";
+    }
+    return "???";
+}
+
+void JsonWriter::newline()
+{
+    if (!indent)
+        return;
+    out += '\n';
+    out.append(scope_empty.size() * 2, ' ');
+}
+
+void JsonWriter::begin_value()
+{
+    if (after_key) {
+        after_key = false;
+        return;
+    }
+    if (scope_empty.empty())
+        return;
+    if (!scope_empty.back())
+        out += ',';
+    scope_empty.back() = false;
+    newline();
+}
+
+void JsonWriter::write_string(std::string_view str)
+{
+    out += '"';
+    for (char c : str) {
+        switch (c) {
+        case '"':
+            out += "\\\"";
+            break;
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+                out += std::format("\\u{:04x}", static_cast<unsigned>(c));
+            else
+                out += c;
+            break;
+        }
+    }
+    out += '"';
+}
+
+void JsonWriter::begin_object()
+{
+    begin_value();
+    out += '{';
+    scope_empty.push_back(true);
+}
+
+void JsonWriter::end_object()
+{
+    const bool empty = scope_empty.back();
+    scope_empty.pop_back();
+    if (!empty)
+        newline();
+    out += '}';
+}
+
+void JsonWriter::begin_array()
+{
+    begin_value();
+    out += '[';
+    scope_empty.push_back(true);
+}
+
+void JsonWriter::end_array()
+{
+    const bool empty = scope_empty.back();
+    scope_empty.pop_back();
+    if (!empty)
+        newline();
+    out += ']';
+}
+
+void JsonWriter::key(std::string_view name)
+{
+    begin_value();
+    write_string(name);
+    out += indent ? ": " : ":";
+    after_key = true;
+}
+
+void JsonWriter::value(std::string_view str)
+{
+    begin_value();
+    write_string(str);
+}
+
+void JsonWriter::value(const std::wstring& str)
+{
+    value(CLI::narrow(str));
+}
+
+void JsonWriter::value(bool b)
+{
+    begin_value();
+    out += b ? "true" : "false";
+}
+
+void JsonWriter::value(int64_t n)
+{
+    begin_value();
+    out += std::format("{}", n);
+}
+
+void JsonWriter::value(uint64_t n)
+{
+    begin_value();
+    out += std::format("{}", n);
+}
+
+void JsonWriter::value(double d)
+{
+    begin_value();
+    out += std::format("{}", d);
+}
+
+void JsonWriter::null()
+{
+    begin_value();
+    out += "null";
+}
+
+static double microseconds(uint64_t ns)
+{
+    // Nanosecond precision is noise for calls into the OS
+    return static_cast<double>(ns / 100) / 10.0;
+}
+
+static void write_calls(JsonWriter& json, const std::vector<hdr::ApiCall>& calls,
+                        const std::optional<hdr::DisplayId>& display)
+{
+    json.key("apiCalls");
+    json.begin_array();
+    for (const auto& call : calls) {
+        if (call.display != display)
+            continue;
+        json.begin_object();
+        json.field("function", hdr::ToString(call.function));
+        json.field("succeeded", call.succeeded);
+        json.field("microseconds", microseconds(call.durationNs));
+        json.end_object();
+    }
+    json.end_array();
+}
+
+void print_json_report(std::string_view command, hdr::Status status, const std::vector<hdr::DisplayDetails>& displays,
+                       const std::vector<hdr::ApiCall>& calls, const std::vector<DisplayOutcome>& outcomes,
+                       std::optional<int> exit_code, std::string_view error)
+{
+    JsonWriter json(true);
+    json.begin_object();
+    json.field("command", command);
+    json.field("status", status_string(status));
+    if (exit_code)
+        json.field("exitCode", *exit_code);
+    if (!error.empty())
+        json.field("error", error);
+
+    json.key("displays");
+    json.begin_array();
+    for (size_t i = 0; i < displays.size(); i++) {
+        const auto& disp = displays[i];
+        json.begin_object();
+        json.field("index", static_cast<uint64_t>(i));
+        json.field("id", disp.id.ToString());
+        json.field("adapterId", std::format("{:08X}{:08X}", static_cast<uint32_t>(disp.id.adapterHigh),
+                                            disp.id.adapterLow));
+        json.field("targetId", disp.id.targetId);
+        json.field("name", disp.name);
+        json.field("internal", disp.internal);
+        json.key("edid");
+        if (disp.edidManufacturer.empty()) {
+            json.null();
+        } else {
+            json.begin_object();
+            json.field("manufacturer", disp.edidManufacturer);
+            json.field("productCode", static_cast<uint32_t>(disp.edidProductCode.value_or(0)));
+            json.field("hardwareId", disp.HardwareId());
+            json.end_object();
+        }
+        json.field("devicePath", disp.devicePath);
+        json.field("status", status_string(disp.status));
+        json.key("colorMode");
+        if (disp.colorMode)
+            json.value(color_mode_string(*disp.colorMode));
+        else
+            json.null();
+        json.field("bitsPerColorChannel", disp.bitsPerColorChannel);
+        json.field("sdrWhiteLevelNits", disp.sdrWhiteLevelNits);
+        auto outcome = std::find_if(outcomes.begin(), outcomes.end(),
+                                    [&](const DisplayOutcome& o) { return o.id == disp.id; });
+        if (outcome != outcomes.end())
+            json.field("result", outcome->result);
+        write_calls(json, calls, disp.id);
+        json.end_object();
+    }
+    json.end_array();
+
+    // Calls not made for a single display, ie QueryDisplayConfig()
+    write_calls(json, calls, std::nullopt);
+    uint64_t total_ns = 0;
+    for (const auto& call : calls)
+        total_ns += call.durationNs;
+    json.field("apiMicroseconds", microseconds(total_ns));
+    json.end_object();
+
+    std::println("{}", json.str());
+}
+
+} // namespace subcommand
@@ -0,0 +1,120 @@
+/*
+    HDRCmd - enable/disable "Use HDR" from command line
+    Copyright (C) 2024 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SUBCOMMAND_JSON_HPP_
+#define SUBCOMMAND_JSON_HPP_
+
+#include "CLI/CLI.hpp"
+
+#include "HDR.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace subcommand {
+
+enum class OutputFormat
+{
+    Text,
+    Json
+};
+
+/// Add the "--format" option
+void add_format_option(CLI::App& app, std::string& format);
+/// Parse the value of the "--format" option
+OutputFormat output_format(const std::string& format);
+
+/// "on", "off" or "unsupported", as printed by "status"
+std::string_view status_string(hdr::Status status);
+/// "sdr", "wcg" or "hdr"
+std::string_view color_mode_string(hdr::ColorMode mode);
+
+/// Writes JSON text, either on a single line or indented
+class JsonWriter
+{
+    std::string out;
+    bool indent;
+    // One entry per open object or array: whether nothing was written to it yet
+    std::vector<bool> scope_empty;
+    bool after_key = false;
+
+    void begin_value();
+    void newline();
+    void write_string(std::string_view str);
+
+public:
+    explicit JsonWriter(bool indent) : indent(indent) { }
+
+    void begin_object();
+    void end_object();
+    void begin_array();
+    void end_array();
+    void key(std::string_view name);
+
+    void value(std::string_view str);
+    void value(const std::wstring& str);
+    void value(const char* str) { value(std::string_view(str)); }
+    void value(bool b);
+    void value(int64_t n);
+    void value(uint64_t n);
+    void value(int n) { value(static_cast<int64_t>(n)); }
+    void value(uint32_t n) { value(static_cast<uint64_t>(n)); }
+    void value(double d);
+    void null();
+    template<typename T> void value(const std::optional<T>& opt)
+    {
+        if (opt)
+            value(*opt);
+        else
+            null();
+    }
+
+    template<typename T> void field(std::string_view name, const T& v)
+    {
+        key(name);
+        value(v);
+    }
+
+    const std::string& str() const { return out; }
+};
+
+/// Outcome of a command for a single display
+struct DisplayOutcome
+{
+    hdr::DisplayId id;
+    /// "changed", "unchanged", "unsupported" or "failed"
+    std::string_view result;
+};
+
+/**
+ * Print the result of a command as JSON: overall status, details of all displays and
+ * the display configuration API calls made, with the time each took.
+ * @param outcomes Per display outcome of a change, added to the displays' details
+ * @param exit_code Exit code of the command, if it's not implied by the status
+ * @param error Message if the command failed
+ */
+void print_json_report(std::string_view command, hdr::Status status, const std::vector<hdr::DisplayDetails>& displays,
+                       const std::vector<hdr::ApiCall>& calls, const std::vector<DisplayOutcome>& outcomes,
+                       std::optional<int> exit_code, std::string_view error = {});
+
+} // namespace subcommand
+
+#endif // SUBCOMMAND_JSON_HPP_
@@ -0,0 +1,69 @@
+/*
+    HDRCmd - enable/disable "Use HDR" from command line
+    Copyright (C) 2024 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "MonitorSelection.hpp"
+
+#include "Edid.hpp"
+#include "Win32Backends.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <iostream>
+
+namespace subcommand {
+
+void add_monitor_option(CLI::App& app, std::vector<std::string>& selectors, const std::string& description)
+{
+    auto display_option = app.add_option("-d,--display", selectors, description);
+    display_option->type_name("MONITOR");
+}
+
+static std::optional<int> find_monitor(const std::vector<std::wstring>& edid_ids, const std::string& selector)
+{
+    int number = 0;
+    const auto* end = selector.data() + selector.size();
+    auto [ptr, ec] = std::from_chars(selector.data(), end, number);
+    if (ec == std::errc() && ptr == end)
+        return number >= 1 ? std::optional<int>(number) : std::nullopt;
+
+    const auto id = NormalizeEdidId(CLI::widen(selector));
+    const auto it = std::find(edid_ids.begin(), edid_ids.end(), id);
+    if (it == edid_ids.end())
+        return std::nullopt;
+    return static_cast<int>(it - edid_ids.begin()) + 1;
+}
+
+std::optional<std::set<int>> resolve_monitors(const std::vector<std::string>& selectors)
+{
+    std::set<int> monitors;
+    if (selectors.empty())
+        return monitors;
+
+    const auto edid_ids = backend::WindowsDisplay().GetEdidIds();
+    for (const auto& selector : selectors) {
+        auto monitor = find_monitor(edid_ids, selector);
+        if (!monitor) {
+            std::cerr << "No monitor matching '" << selector << "'" << std::endl;
+            return std::nullopt;
+        }
+        monitors.insert(*monitor);
+    }
+    return monitors;
+}
+
+} // namespace subcommand
@@ -0,0 +1,45 @@
+/*
+    HDRCmd - enable/disable "Use HDR" from command line
+    Copyright (C) 2024 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SUBCOMMAND_MONITORSELECTION_HPP_
+#define SUBCOMMAND_MONITORSELECTION_HPP_
+
+#include "CLI/CLI.hpp"
+
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace subcommand {
+
+/**
+ * Add the "--display" option for commands talking to monitors via DDC/CI or loading profiles.
+ * These number monitors like winddcutil and dispwin, unlike "on" and "off".
+ */
+void add_monitor_option(CLI::App& app, std::vector<std::string>& selectors, const std::string& description);
+
+/**
+ * Resolve monitor selectors: a monitor number as in the HDRTray log (1 is the first), or an EDID id.
+ * @return Monitor numbers; nothing if a selector doesn't match, after printing an error
+ */
+std::optional<std::set<int>> resolve_monitors(const std::vector<std::string>& selectors);
+
+} // namespace subcommand
+
+#endif // SUBCOMMAND_MONITORSELECTION_HPP_
@@ -0,0 +1,83 @@
+/*
+    HDRCmd - enable/disable "Use HDR" from command line
+    Copyright (C) 2024 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "SaveTrace.hpp"
+
+#include "Tray.hpp"
+
+#include "Trace.hpp"
+
+#include <filesystem>
+#include <iostream>
+
+namespace subcommand {
+
+static std::string own_trace_file;
+
+SaveTrace::SaveTrace(CLI::App* parent)
+    : Base("Write the spans recorded by the running HDRTray to a Chrome trace file", "trace", parent)
+{
+    add_option("file", file, "Trace file to write (JSON, open in chrome://tracing or ui.perfetto.dev)")->required();
+}
+
+int SaveTrace::run() const
+{
+    /* HDRTray writes the file itself: a trace of a long running session can be megabytes,
+     * more than fits a response. It runs in another working directory, so pass an absolute path. */
+    std::error_code ec;
+    const auto path = std::filesystem::absolute(std::filesystem::path(CLI::widen(file)), ec);
+    if (ec) {
+        std::cerr << "Invalid trace file name: " << file << std::endl;
+        return -1;
+    }
+
+    ipc::Request request { ipc::Command::SaveTrace };
+    request.path = path.wstring();
+    const auto response = forward_to_tray(request);
+    if (!response) {
+        std::cerr << "HDRTray is not running" << std::endl;
+        return -1;
+    }
+    if (response->result != ipc::Result::Ok) {
+        std::cerr << "HDRTray failed to write " << file << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+CLI::App* SaveTrace::add(CLI::App& app)
+{
+    return app.add_subcommand(std::shared_ptr<SaveTrace>(new SaveTrace(&app)));
+}
+
+void add_trace_option(CLI::App& app)
+{
+    app.add_option("--trace", own_trace_file, "Write a Chrome trace of what this command did to a file");
+}
+
+bool write_own_trace()
+{
+    if (own_trace_file.empty())
+        return true;
+    if (trace::WriteFile(std::filesystem::path(CLI::widen(own_trace_file))))
+        return true;
+    std::cerr << "Failed to write " << own_trace_file << std::endl;
+    return false;
+}
+
+} // namespace subcommand
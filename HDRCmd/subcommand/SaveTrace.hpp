@@ -0,0 +1,47 @@
+/*
+    HDRCmd - enable/disable "Use HDR" from command line
+    Copyright (C) 2024 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SUBCOMMAND_SAVETRACE_HPP_
+#define SUBCOMMAND_SAVETRACE_HPP_
+
+#include "Base.hpp"
+
+#include <string>
+
+namespace subcommand {
+class SaveTrace : public Base
+{
+protected:
+    std::string file;
+
+    SaveTrace(CLI::App* parent);
+
+public:
+    int run() const override;
+
+    static CLI::App* add(CLI::App& app);
+};
+
+/// Add the global "--trace" option, which writes the spans HDRCmd recorded to a file
+void add_trace_option(CLI::App& app);
+/// Write the spans HDRCmd recorded, if "--trace" was given; false if that failed
+bool write_own_trace();
+
+} // namespace subcommand
+
+#endif // SUBCOMMAND_SAVETRACE_HPP_
@@ -0,0 +1,206 @@
+/*
+    HDRCmd - enable/disable "Use HDR" from command line
+    Copyright (C) 2024 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Stats.hpp"
+
+#include "Json.hpp"
+#include "Tray.hpp"
+
+#include "ColorTools.hpp"
+#include "Metrics.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <print>
+
+namespace subcommand {
+
+static constexpr double kPercentiles[] = { 50, 95, 99 };
+
+/// Hits and lookups of a cache, from the counters "<name>.cache_hits" and "<name>.lookups"
+struct CacheRate
+{
+    std::string name;
+    uint64_t hits;
+    uint64_t lookups;
+};
+
+static std::vector<CacheRate> cache_rates(const metrics::Snapshot& snapshot)
+{
+    constexpr std::string_view hits_suffix = ".cache_hits";
+    std::vector<CacheRate> rates;
+    for (const auto& counter : snapshot.counters) {
+        if (!counter.name.ends_with(hits_suffix))
+            continue;
+        const auto name = counter.name.substr(0, counter.name.size() - hits_suffix.size());
+        if (const auto* lookups = snapshot.FindCounter(name + ".lookups"))
+            rates.push_back({ name, counter.value, lookups->value });
+    }
+    return rates;
+}
+
+/// Remove metrics not matching any of the prefixes
+static void filter(metrics::Snapshot& snapshot, const std::vector<std::string>& prefixes)
+{
+    if (prefixes.empty())
+        return;
+    const auto unmatched = [&](const auto& metric) {
+        return std::none_of(prefixes.begin(), prefixes.end(),
+                            [&](const std::string& prefix) { return metric.name.starts_with(prefix); });
+    };
+    std::erase_if(snapshot.counters, unmatched);
+    std::erase_if(snapshot.gauges, unmatched);
+    std::erase_if(snapshot.histograms, unmatched);
+}
+
+static std::string time_string(uint64_t unix_ms)
+{
+    const auto time = std::chrono::floor<std::chrono::seconds>(
+        std::chrono::system_clock::time_point(std::chrono::milliseconds(unix_ms)));
+    return std::format("{:%Y-%m-%d %H:%M:%S}", std::chrono::zoned_time(std::chrono::current_zone(), time));
+}
+
+static void print_text(const metrics::Snapshot& snapshot, const std::vector<CacheRate>& rates, bool from_tray)
+{
+    if (from_tray)
+        std::println("Metrics of the running HDRTray");
+    else
+        std::println("Metrics saved by HDRTray at {}", time_string(snapshot.takenUnixMs));
+
+    if (!snapshot.counters.empty()) {
+        std::println("\n{:<40} {:>12}", "Counter", "Value");
+        for (const auto& counter : snapshot.counters)
+            std::println("{:<40} {:>12}", counter.name, counter.value);
+    }
+    if (!snapshot.gauges.empty()) {
+        std::println("\n{:<40} {:>12}", "Gauge", "Value");
+        for (const auto& gauge : snapshot.gauges)
+            std::println("{:<40} {:>12}", gauge.name, gauge.value);
+    }
+    if (!snapshot.histograms.empty()) {
+        std::println("\n{:<40} {:>8} {:>8} {:>8} {:>8} {:>8} {:>8}", "Histogram", "Count", "Mean", "p50", "p95", "p99",
+                     "Max");
+        for (const auto& histogram : snapshot.histograms) {
+            if (histogram.count == 0) {
+                std::println("{:<40} {:>8} {:>8} {:>8} {:>8} {:>8} {:>8}", histogram.name, 0, "-", "-", "-", "-", "-");
+                continue;
+            }
+            std::println("{:<40} {:>8} {:>8} {:>8} {:>8} {:>8} {:>8}", histogram.name, histogram.count,
+                         histogram.sum / histogram.count, histogram.Percentile(kPercentiles[0]),
+                         histogram.Percentile(kPercentiles[1]), histogram.Percentile(kPercentiles[2]), histogram.max);
+        }
+    }
+    if (!rates.empty()) {
+        std::println("\n{:<40} {:>12} {:>12} {:>8}", "Cache", "Hits", "Lookups", "Rate");
+        for (const auto& rate : rates) {
+            const auto percent = rate.lookups > 0 ? std::format("{:.1f}%", 100.0 * rate.hits / rate.lookups) : "-";
+            std::println("{:<40} {:>12} {:>12} {:>8}", rate.name, rate.hits, rate.lookups, percent);
+        }
+    }
+}
+
+static void print_json(const metrics::Snapshot& snapshot, const std::vector<CacheRate>& rates, bool from_tray)
+{
+    JsonWriter json(true);
+    json.begin_object();
+    json.field("source", from_tray ? "tray" : "file");
+    json.field("takenUnixMs", snapshot.takenUnixMs);
+    json.key("counters");
+    json.begin_object();
+    for (const auto& counter : snapshot.counters)
+        json.field(counter.name, counter.value);
+    json.end_object();
+    json.key("gauges");
+    json.begin_object();
+    for (const auto& gauge : snapshot.gauges)
+        json.field(gauge.name, gauge.value);
+    json.end_object();
+    json.key("histograms");
+    json.begin_object();
+    for (const auto& histogram : snapshot.histograms) {
+        json.key(histogram.name);
+        json.begin_object();
+        json.field("count", histogram.count);
+        json.field("sum", histogram.sum);
+        json.field("min", histogram.min);
+        json.field("max", histogram.max);
+        for (double percentile : kPercentiles)
+            json.field(std::format("p{}", percentile), histogram.Percentile(percentile));
+        json.end_object();
+    }
+    json.end_object();
+    json.key("cacheHitRates");
+    json.begin_object();
+    for (const auto& rate : rates) {
+        json.key(rate.name);
+        if (rate.lookups > 0)
+            json.value(static_cast<double>(rate.hits) / rate.lookups);
+        else
+            json.null();
+    }
+    json.end_object();
+    json.end_object();
+    std::println("{}", json.str());
+}
+
+Stats::Stats(CLI::App* parent) : Base("Print the counters and latency percentiles HDRTray collected", "stats", parent)
+{
+    add_option("prefix", prefixes, "Only print metrics whose name starts with one of these, eg \"vcp.\"");
+    add_format_option(*this, format);
+}
+
+int Stats::run() const
+{
+    std::optional<metrics::Snapshot> snapshot;
+    bool from_tray = false;
+    if (const auto response = forward_to_tray({ ipc::Command::GetMetrics })) {
+        snapshot = metrics::Parse(response->metrics);
+        from_tray = true;
+        if (!snapshot) {
+            std::cerr << "HDRTray sent malformed metrics" << std::endl;
+            return 1;
+        }
+    } else {
+        // HDRCmd is installed next to HDRTray
+        const auto file = std::filesystem::path(ColorTools::GetExecutableDirectory()) / metrics::kFileName;
+        snapshot = metrics::ReadFile(file);
+        if (!snapshot) {
+            std::cerr << "HDRTray is not running and saved no metrics" << std::endl;
+            return -1;
+        }
+    }
+
+    filter(*snapshot, prefixes);
+    const auto rates = cache_rates(*snapshot);
+    if (output_format(format) == OutputFormat::Json)
+        print_json(*snapshot, rates, from_tray);
+    else
+        print_text(*snapshot, rates, from_tray);
+    return 0;
+}
+
+CLI::App* Stats::add(CLI::App& app)
+{
+    return app.add_subcommand(std::shared_ptr<Stats>(new Stats(&app)));
+}
+
+} // namespace subcommand
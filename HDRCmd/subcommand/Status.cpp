@@ -18,9 +18,16 @@
 
 #include "Status.hpp"
 
+#include "Json.hpp"
+#include "Tray.hpp"
+
+#include "framework.h"
 #include "HDR.h"
+#include "StatusWatcher.hpp"
 
 #include <array>
+#include <atomic>
+#include <cstdio>
 #include <format>
 #include <print>
 
@@ -58,9 +65,11 @@ Status::Status(CLI::App* parent) : Base("Print current HDR status", "status", pa
     auto mode_option = add_option("-m,--mode", mode, "How to report status mode");
     mode_option->type_name("MODE");
     mode_option->transform(StatusModeValidator());
+    add_flag("-w,--watch", watch, "Keep running and print a line whenever the HDR status changes");
+    add_format_option(*this, format);
 }
 
-static std::string_view status_string(hdr::Status status)
+std::string_view status_string(hdr::Status status)
 {
     switch (status) {
     case hdr::Status::Off:
@@ -73,28 +82,27 @@ static std::string_view status_string(hdr::Status status)
     return "???";
 }
 
-void Status::print_status_short()
+void Status::print_status_short(hdr::Status status)
 {
-    auto status = hdr::GetWindowsHDRStatus();
     std::println("HDR is {}", status_string(status));
 }
 
-void Status::print_status_long()
+void Status::print_status_long(const std::vector<hdr::Display>& displays)
 {
-    auto displays = hdr::GetDisplays();
-
     // Tabulate.
-    // Columns: #, Display name, Status
-    static constexpr size_t num_cols = 3;
-    static constexpr std::string_view col_headings[num_cols] = { "Display #", "Name", "Status" };
+    // Columns: #, Display name, Status, Id
+    static constexpr size_t num_cols = 4;
+    static constexpr std::string_view col_headings[num_cols] = { "Display #", "Name", "Status", "Id" };
     std::array<size_t, num_cols> widths;
     widths[0] = std::max(size_t(ceil(log10(displays.size() + 1))) + 1, col_headings[0].size());
     widths[1] = col_headings[1].size();
     widths[2] = col_headings[2].size();
+    widths[3] = col_headings[3].size();
     for(const auto& disp : displays)
     {
         widths[1] = std::max(widths[1], disp.name.size());
         widths[2] = std::max(widths[2], status_string(disp.status).size());
+        widths[3] = std::max(widths[3], disp.id.ToString().size());
     }
 
     // Print heading
@@ -115,32 +123,264 @@ void Status::print_status_long()
     for (size_t i = 0; i < displays.size(); i++)
     {
         const auto& disp = displays[i];
-        std::println("{:>{}}\t{:<{}}\t{:<{}}", i, widths[0], CLI::narrow(disp.name), widths[1],
-                     status_string(disp.status), widths[2]);
+        std::println("{:>{}}\t{:<{}}\t{:<{}}\t{:<{}}", i, widths[0], CLI::narrow(disp.name), widths[1],
+                     status_string(disp.status), widths[2], CLI::narrow(disp.id.ToString()), widths[3]);
+    }
+}
+
+// Same as GUID_CONSOLE_DISPLAY_STATE
+static const GUID console_display_state = { 0x6fe69556, 0x704a, 0x47a0, { 0x8f, 0x24, 0xc2, 0x8d, 0x93, 0x6f, 0xda, 0x47 } };
+
+struct WatchState
+{
+    hdr::StatusWatcher watcher;
+    bool per_display = false;
+    bool json = false;
+    hdr::Status status = hdr::Status::Unsupported;
+};
+
+// Window receiving the display change notifications; Ctrl+C closes it
+static std::atomic<HWND> watch_window;
+
+static std::string_view change_status_string(const std::optional<hdr::Status>& status)
+{
+    return status ? status_string(*status) : "absent";
+}
+
+/* Print status changes reported by the watcher, and arm the re-check timer if the watcher
+ * wants to look at the status again */
+static void handle_changes(HWND hwnd, WatchState& state, const std::vector<hdr::StatusWatcher::Change>& changes)
+{
+    if (state.json) {
+        // One object per line
+        for (const auto& change : changes) {
+            JsonWriter json(false);
+            json.begin_object();
+            json.field("event", "change");
+            json.field("id", change.id.ToString());
+            json.field("name", change.name);
+            json.key("previous");
+            if (change.previous)
+                json.value(status_string(*change.previous));
+            else
+                json.null();
+            json.key("current");
+            if (change.current)
+                json.value(status_string(*change.current));
+            else
+                json.null();
+            json.field("status", status_string(state.watcher.GetStatus()));
+            json.end_object();
+            std::println("{}", json.str());
+        }
+    } else if (state.per_display) {
+        for (const auto& change : changes) {
+            std::println("{}\t{}\t{} -> {}", CLI::narrow(change.id.ToString()), CLI::narrow(change.name),
+                         change_status_string(change.previous), change_status_string(change.current));
+        }
     }
+    const auto status = state.watcher.GetStatus();
+    if (!state.json && !state.per_display && status != state.status)
+        std::println("HDR is {}", status_string(status));
+    state.status = status;
+    // Consumers of the output usually read from a pipe
+    std::fflush(stdout);
+
+    if (state.watcher.IsPending())
+        SetTimer(hwnd, 1, state.watcher.MsUntilDue(GetTickCount64()), nullptr);
+    else
+        KillTimer(hwnd, 1);
+}
+
+static LRESULT CALLBACK watch_window_proc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam)
+{
+    if (message == WM_NCCREATE) {
+        auto* create = reinterpret_cast<CREATESTRUCTW*>(lParam);
+        SetWindowLongPtrW(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(create->lpCreateParams));
+    }
+    auto* state = reinterpret_cast<WatchState*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+
+    switch (message) {
+    case WM_DISPLAYCHANGE:
+        handle_changes(hwnd, *state, state->watcher.Notify(hdr::StatusWatcher::Event::DisplayChange, GetTickCount64()));
+        return 0;
+    case WM_POWERBROADCAST:
+        if (wParam == PBT_APMRESUMEAUTOMATIC || wParam == PBT_APMRESUMESUSPEND) {
+            handle_changes(hwnd, *state, state->watcher.Notify(hdr::StatusWatcher::Event::Resume, GetTickCount64()));
+        } else if (wParam == PBT_POWERSETTINGCHANGE) {
+            auto pbs = reinterpret_cast<POWERBROADCAST_SETTING*>(lParam);
+            // Data: 0 = off, 1 = on, 2 = dimmed
+            if (pbs && IsEqualGUID(pbs->PowerSetting, console_display_state)
+                && *reinterpret_cast<DWORD*>(&pbs->Data) == 1)
+                handle_changes(hwnd, *state,
+                               state->watcher.Notify(hdr::StatusWatcher::Event::DisplayOn, GetTickCount64()));
+        }
+        return TRUE;
+    case WM_TIMER:
+        handle_changes(hwnd, *state, state->watcher.Poll(GetTickCount64()));
+        return 0;
+    case WM_DESTROY:
+        PostQuitMessage(0);
+        return 0;
+    }
+    return DefWindowProcW(hwnd, message, wParam, lParam);
+}
+
+static BOOL WINAPI watch_ctrl_handler(DWORD ctrl_type)
+{
+    switch (ctrl_type) {
+    case CTRL_C_EVENT:
+    case CTRL_BREAK_EVENT:
+    case CTRL_CLOSE_EVENT:
+        if (HWND hwnd = watch_window.load()) {
+            PostMessageW(hwnd, WM_CLOSE, 0, 0);
+            return TRUE;
+        }
+        break;
+    }
+    return FALSE;
+}
+
+static uint64_t filetime_to_100ns(const FILETIME& ft)
+{
+    return (uint64_t(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+}
+
+static double process_cpu_ms()
+{
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        return 0;
+    return (filetime_to_100ns(kernel) + filetime_to_100ns(user)) / 10000.0;
+}
+
+int Status::watch_status(bool per_display, bool json)
+{
+    WatchState state;
+    state.per_display = per_display;
+    state.json = json;
+    state.watcher.Start(GetTickCount64());
+    state.status = state.watcher.GetStatus();
+
+    // Initial status, changes follow
+    if (json) {
+        JsonWriter initial(false);
+        initial.begin_object();
+        initial.field("event", "initial");
+        initial.field("status", status_string(state.status));
+        initial.key("displays");
+        initial.begin_array();
+        for (const auto& disp : state.watcher.GetDisplays()) {
+            initial.begin_object();
+            initial.field("id", disp.id.ToString());
+            initial.field("name", disp.name);
+            initial.field("status", status_string(disp.status));
+            initial.end_object();
+        }
+        initial.end_array();
+        initial.end_object();
+        std::println("{}", initial.str());
+    } else if (per_display) {
+        print_status_short(state.status);
+        std::cout << std::endl;
+        print_status_long(state.watcher.GetDisplays());
+    } else
+        std::println("HDR is {}", status_string(state.status));
+    std::fflush(stdout);
+
+    /* WM_DISPLAYCHANGE is only broadcast to top-level windows, so a message-only window won't do.
+     * The window is never shown. */
+    const auto instance = GetModuleHandleW(nullptr);
+    WNDCLASSEXW wcex = { sizeof(WNDCLASSEXW) };
+    wcex.lpfnWndProc = watch_window_proc;
+    wcex.hInstance = instance;
+    wcex.lpszClassName = L"HDRCmdWatchWindow";
+    RegisterClassExW(&wcex);
+    HWND hwnd = CreateWindowExW(0, wcex.lpszClassName, L"HDRCmd", WS_OVERLAPPED, 0, 0, 0, 0, nullptr, nullptr,
+                                instance, &state);
+    if (!hwnd) {
+        std::cerr << "Failed to create window for display notifications" << std::endl;
+        return -1;
+    }
+    auto power_notify = RegisterPowerSettingNotification(hwnd, &console_display_state, DEVICE_NOTIFY_WINDOW_HANDLE);
+    watch_window = hwnd;
+    SetConsoleCtrlHandler(watch_ctrl_handler, TRUE);
+
+    // Nothing happens between notifications: every wake-up is a message
+    const auto start_ms = GetTickCount64();
+    const auto start_cpu_ms = process_cpu_ms();
+    const auto start_queries = hdr::GetQueryStats().topologyQueries;
+    uint64_t wakeups = 0;
+    MSG msg;
+    while (GetMessageW(&msg, nullptr, 0, 0) > 0) {
+        wakeups++;
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
+    }
+
+    SetConsoleCtrlHandler(watch_ctrl_handler, FALSE);
+    watch_window = nullptr;
+    if (power_notify)
+        UnregisterPowerSettingNotification(power_notify);
+
+    const double seconds = (GetTickCount64() - start_ms) / 1000.0;
+    const auto& stats = state.watcher.GetStats();
+    std::println(stderr,
+                 "Watched for {:.1f} s: {} wake-ups ({:.2f}/min), {:.1f} ms CPU, {} notifications, "
+                 "{} status checks, {} topology queries",
+                 seconds, wakeups, seconds > 0 ? wakeups * 60 / seconds : 0.0, process_cpu_ms() - start_cpu_ms,
+                 stats.events, stats.checks, hdr::GetQueryStats().topologyQueries - start_queries);
+    return 0;
+}
+
+static int status_exit_code(hdr::Status status)
+{
+    switch (status) {
+    case hdr::Status::On:
+        return 0;
+    case hdr::Status::Off:
+        return 1;
+    case hdr::Status::Unsupported:
+        return 2;
+    }
+    return -1;
 }
 
 int Status::run() const
 {
+    const bool json = output_format(format) == OutputFormat::Json;
+    if (watch) {
+        if (stricmp(mode.c_str(), "exitcode") == 0) {
+            std::cerr << "--watch can't be combined with --mode exitcode" << std::endl;
+            return -1;
+        }
+        return watch_status(stricmp(mode.c_str(), "long") == 0, json);
+    }
+
+    if (json) {
+        // Everything in one go; the mode only matters for the exit code
+        hdr::StartCallRecording();
+        auto displays = hdr::GetDisplayDetails();
+        auto status = hdr::GetWindowsHDRStatus();
+        auto calls = hdr::StopCallRecording();
+        const bool exitcode_mode = stricmp(mode.c_str(), "exitcode") == 0;
+        print_json_report("status", status, displays, calls, {},
+                          exitcode_mode ? std::optional<int>(status_exit_code(status)) : std::nullopt);
+        return exitcode_mode ? status_exit_code(status) : 0;
+    }
+
+    // Answered by HDRTray, if it's running, from its display cache
     if (mode.empty() || stricmp(mode.c_str(), "short") == 0) {
-        print_status_short();
+        print_status_short(get_status());
         return 0;
     } else if (stricmp(mode.c_str(), "long") == 0) {
-        print_status_short();
+        std::vector<hdr::Display> displays;
+        print_status_short(get_displays(displays));
         std::cout << std::endl;
-        print_status_long();
+        print_status_long(displays);
         return 0;
     } else if (stricmp(mode.c_str(), "exitcode") == 0) {
-        auto status = hdr::GetWindowsHDRStatus();
-        switch(status)
-        {
-        case hdr::Status::On:
-            return 0;
-        case hdr::Status::Off:
-            return 1;
-        case hdr::Status::Unsupported:
-            return 2;
-        }
+        return status_exit_code(get_status());
     }
     // Validation should've caught other cases...
     return -1;
@@ -21,14 +21,21 @@
 
 #include "Base.hpp"
 
+#include "HDR.h"
+
+#include <vector>
+
 namespace subcommand {
 class Status : public Base
 {
-    static void print_status_short();
-    static void print_status_long();
+    static void print_status_short(hdr::Status status);
+    static void print_status_long(const std::vector<hdr::Display>& displays);
+    static int watch_status(bool per_display, bool json);
 
 protected:
     std::string mode;
+    std::string format;
+    bool watch = false;
 
     Status(CLI::App* parent);
 
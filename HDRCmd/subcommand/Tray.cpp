@@ -0,0 +1,88 @@
+/*
+    HDRCmd - enable/disable "Use HDR" from command line
+    Copyright (C) 2024 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Tray.hpp"
+
+#include "IpcChannel.hpp"
+#include "StatusBoard.hpp"
+
+#include <chrono>
+
+namespace subcommand {
+
+static bool direct = false;
+
+/* Changing the status includes the color profile switch, which can take a few seconds
+ * with DDC/CI. If HDRTray isn't running, the call fails right away. */
+static constexpr std::chrono::milliseconds tray_timeout { 30000 };
+
+void add_direct_option(CLI::App& app)
+{
+    app.add_flag("--direct", direct, "Don't forward commands to a running HDRTray, always talk to Windows directly");
+}
+
+std::optional<ipc::Response> forward_to_tray(const ipc::Request& request)
+{
+    if (direct)
+        return std::nullopt;
+    auto response = ipc::Call(ipc::DefaultEndpoint(), request, tray_timeout);
+    if (!response || response->result == ipc::Result::BadRequest || response->result == ipc::Result::Unavailable)
+        return std::nullopt;
+    return response;
+}
+
+/* Status published by HDRTray. Cheapest way to get the status: just mapping the board,
+ * no system calls beyond that and no round trip to HDRTray. */
+static std::optional<board::State> read_status_board()
+{
+    if (direct)
+        return std::nullopt;
+    board::Reader reader;
+    if (!reader.Open(board::DefaultName()))
+        return std::nullopt;
+    return reader.Read();
+}
+
+hdr::Status get_status()
+{
+    if (auto state = read_status_board())
+        return state->status;
+    if (auto response = forward_to_tray({ ipc::Command::GetStatus }))
+        return response->status;
+    return hdr::GetWindowsHDRStatus();
+}
+
+hdr::Status get_displays(std::vector<hdr::Display>& displays)
+{
+    if (auto state = read_status_board()) {
+        displays.clear();
+        for (auto& disp : state->displays)
+            displays.push_back({ disp.id, std::move(disp.name), disp.status });
+        return state->status;
+    }
+    if (auto response = forward_to_tray({ ipc::Command::GetDisplays })) {
+        displays.clear();
+        for (auto& entry : response->displays)
+            displays.push_back({ entry.id, std::move(entry.name), entry.status.value_or(hdr::Status::Unsupported) });
+        return response->status;
+    }
+    displays = hdr::GetDisplays();
+    return hdr::GetWindowsHDRStatus();
+}
+
+} // namespace subcommand
@@ -0,0 +1,50 @@
+/*
+    HDRCmd - enable/disable "Use HDR" from command line
+    Copyright (C) 2024 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SUBCOMMAND_TRAY_HPP_
+#define SUBCOMMAND_TRAY_HPP_
+
+#include "CLI/CLI.hpp"
+
+#include "HDR.h"
+#include "IpcProtocol.hpp"
+
+#include <optional>
+#include <vector>
+
+namespace subcommand {
+
+/// Add the "--direct" option, which disables forwarding commands to HDRTray
+void add_direct_option(CLI::App& app);
+
+/**
+ * Send a request to a running HDRTray. It answers from its display cache, and applies
+ * its color profiles when it changes the HDR status.
+ * @return Response; nothing if "--direct" was given, HDRTray isn't running or can't handle
+ *   the request, in which case the caller does the work itself.
+ */
+std::optional<ipc::Response> forward_to_tray(const ipc::Request& request);
+
+/// Overall HDR status, from the HDRTray status board or HDRTray itself if it's running
+hdr::Status get_status();
+/// Overall HDR status and all displays, from the HDRTray status board or HDRTray itself if it's running
+hdr::Status get_displays(std::vector<hdr::Display>& displays);
+
+} // namespace subcommand
+
+#endif // SUBCOMMAND_TRAY_HPP_
@@ -0,0 +1,265 @@
+/*
+    HDRCmd - enable/disable "Use HDR" from command line
+    Copyright (C) 2024 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Vcp.hpp"
+
+#include "Json.hpp"
+#include "MonitorSelection.hpp"
+
+#include "VcpBatch.hpp"
+#include "Win32Backends.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <print>
+#include <string_view>
+
+namespace subcommand {
+
+/// Parse a number, hexadecimal with a "0x" prefix or if \c hex is set
+static std::optional<int> parse_number(std::string_view str, bool hex, int max)
+{
+    if (str.starts_with("0x") || str.starts_with("0X")) {
+        str.remove_prefix(2);
+        hex = true;
+    }
+    int number = 0;
+    const auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), number, hex ? 16 : 10);
+    if (str.empty() || ec != std::errc() || end != str.data() + str.size() || number < 0 || number > max)
+        return std::nullopt;
+    return number;
+}
+
+/// VCP codes are given in hexadecimal, as in the MCCS standard and by winddcutil
+static std::optional<int> parse_vcp_code(std::string_view str)
+{
+    return parse_number(str, true, 0xFF);
+}
+
+/// Options and output shared by "vcp get" and "vcp set"
+class VcpCommand : public Base
+{
+protected:
+    std::vector<std::string> displays;
+    std::string format;
+    bool sequential = false;
+
+    template<typename... Arg>
+    VcpCommand(Arg&&... arg) : Base(std::forward<Arg>(arg)...)
+    {
+        add_monitor_option(*this, displays,
+                           "Monitor to talk to: number as in the HDRTray log (1 is the first), or EDID id. "
+                           "May be given multiple times; all monitors if not given.");
+        add_flag("--sequential", sequential, "Talk to one monitor after the other, not all at the same time");
+        add_format_option(*this, format);
+    }
+
+    /**
+     * Run transactions on all selected monitors and print the results.
+     * @param add_requests Adds the transactions for one monitor to the batch
+     * @return Exit code: 0 if all transactions succeeded, 1 if some failed, -1 if no monitor could be used
+     */
+    int run_batch(std::string_view command, const std::function<void(VcpBatch&, int display)>& add_requests) const;
+};
+
+static std::string code_string(int vcp_code)
+{
+    return std::format("0x{:02X}", vcp_code);
+}
+
+static void print_text(const std::vector<VcpBatch::Result>& results)
+{
+    std::println("{:>7}  {:>4}  {:>6}  {:>9}", "Monitor", "Code", "Value", "Time (ms)");
+    for (const auto& result : results) {
+        std::println("{:>7}  {:>4}  {:>6}  {:>9.1f}", result.display, code_string(result.vcpCode),
+                     result.succeeded ? std::to_string(result.value) : "failed", result.durationUs / 1000.0);
+    }
+}
+
+static void print_json(std::string_view command, const std::vector<VcpBatch::Result>& results, bool concurrent,
+                       uint64_t total_us, uint64_t transaction_us, int exit_code)
+{
+    JsonWriter json(true);
+    json.begin_object();
+    json.field("command", command);
+    json.field("exitCode", exit_code);
+    json.field("concurrent", concurrent);
+    json.field("microseconds", total_us);
+    json.field("transactionMicroseconds", transaction_us);
+    json.key("results");
+    json.begin_array();
+    for (const auto& result : results) {
+        json.begin_object();
+        json.field("display", result.display);
+        json.field("code", code_string(result.vcpCode));
+        json.field("write", result.write);
+        json.field("succeeded", result.succeeded);
+        json.key("value");
+        if (result.succeeded)
+            json.value(result.value);
+        else
+            json.null();
+        json.field("startMicroseconds", result.startUs);
+        json.field("microseconds", result.durationUs);
+        json.end_object();
+    }
+    json.end_array();
+    json.end_object();
+    std::println("{}", json.str());
+}
+
+int VcpCommand::run_batch(std::string_view command,
+                          const std::function<void(VcpBatch&, int display)>& add_requests) const
+{
+    const auto selected = resolve_monitors(displays);
+    if (!selected)
+        return -1;
+
+    backend::Dxva2Ddc ddc;
+    if (!ddc.IsAvailable()) {
+        std::cerr << "No monitor supports DDC/CI" << std::endl;
+        return -1;
+    }
+    VcpBatch batch;
+    if (selected->empty()) {
+        for (int display = 1; display <= ddc.GetMonitorCount(); display++)
+            add_requests(batch, display);
+    } else {
+        for (int display : *selected) {
+            if (display > ddc.GetMonitorCount()) {
+                std::cerr << "No monitor " << display << ", there are " << ddc.GetMonitorCount() << std::endl;
+                return -1;
+            }
+            add_requests(batch, display);
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto results = batch.Run(ddc, !sequential);
+    const auto total_us = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+
+    uint64_t transaction_us = 0;
+    for (const auto& result : results)
+        transaction_us += result.durationUs;
+    const bool all_succeeded
+        = std::all_of(results.begin(), results.end(), [](const VcpBatch::Result& r) { return r.succeeded; });
+    const int exit_code = all_succeeded ? 0 : 1;
+
+    if (output_format(format) == OutputFormat::Json) {
+        print_json(command, results, !sequential, total_us, transaction_us, exit_code);
+    } else {
+        print_text(results);
+        std::println(stderr, "{} transactions on {} monitors in {:.1f} ms ({:.1f} ms one after another)",
+                     results.size(), batch.GetDisplayCount(), total_us / 1000.0, transaction_us / 1000.0);
+    }
+    return exit_code;
+}
+
+class VcpGet : public VcpCommand
+{
+protected:
+    std::vector<std::string> codes;
+
+    VcpGet(CLI::App* parent) : VcpCommand("Read monitor settings", "get", parent)
+    {
+        add_option("codes", codes, "VCP codes, hexadecimal, eg 10,12,16")->required()->delimiter(',');
+    }
+
+public:
+    int run() const override
+    {
+        std::vector<int> vcp_codes;
+        for (const auto& code : codes) {
+            auto vcp_code = parse_vcp_code(code);
+            if (!vcp_code) {
+                std::cerr << "Invalid VCP code '" << code << "'" << std::endl;
+                return -1;
+            }
+            vcp_codes.push_back(*vcp_code);
+        }
+        return run_batch("vcp get", [&](VcpBatch& batch, int display) {
+            for (int vcp_code : vcp_codes)
+                batch.Get(display, vcp_code);
+        });
+    }
+
+    static CLI::App* add(CLI::App& app) { return app.add_subcommand(std::shared_ptr<VcpGet>(new VcpGet(&app))); }
+};
+
+class VcpSet : public VcpCommand
+{
+protected:
+    std::vector<std::string> assignments;
+
+    VcpSet(CLI::App* parent) : VcpCommand("Change monitor settings", "set", parent)
+    {
+        add_option("values", assignments, "CODE=VALUE pairs, code hexadecimal, value decimal, eg 10=50,16=46")
+            ->required()
+            ->delimiter(',');
+    }
+
+public:
+    int run() const override
+    {
+        std::vector<std::pair<int, int>> values;
+        for (const auto& assignment : assignments) {
+            const auto equals = assignment.find('=');
+            std::optional<int> vcp_code, value;
+            if (equals != std::string::npos) {
+                vcp_code = parse_vcp_code(std::string_view(assignment).substr(0, equals));
+                value = parse_number(std::string_view(assignment).substr(equals + 1), false, 0xFFFF);
+            }
+            if (!vcp_code || !value) {
+                std::cerr << "Invalid setting '" << assignment << "', expected CODE=VALUE" << std::endl;
+                return -1;
+            }
+            values.emplace_back(*vcp_code, *value);
+        }
+        return run_batch("vcp set", [&](VcpBatch& batch, int display) {
+            for (const auto& [vcp_code, value] : values)
+                batch.Set(display, vcp_code, value);
+        });
+    }
+
+    static CLI::App* add(CLI::App& app) { return app.add_subcommand(std::shared_ptr<VcpSet>(new VcpSet(&app))); }
+};
+
+Vcp::Vcp(CLI::App* parent) : Base("Read or change monitor settings via DDC/CI", "vcp", parent)
+{
+    require_subcommand(1);
+    VcpGet::add(*this);
+    VcpSet::add(*this);
+}
+
+int Vcp::run() const
+{
+    return static_cast<const Base*>(get_subcommands()[0])->run();
+}
+
+CLI::App* Vcp::add(CLI::App& app)
+{
+    return app.add_subcommand(std::shared_ptr<Vcp>(new Vcp(&app)));
+}
+
+} // namespace subcommand
@@ -21,15 +21,20 @@
 
 #pragma once
 
+#include "ColorPipeline.hpp"
+#include "ColorTools.hpp"
+
+#include <memory>
 #include <string>
-#include <optional>
+#include <vector>
 
 // Forward declaration
 class ConfigManager;
 
 /**
  * Manager for color profile operations and monitor calibration.
- * Handles ICC profile loading and DDC/CI monitor control via external tools.
+ * Locates (or extracts) the external tools; ColorTools wires them up as backends
+ * for the ColorPipeline, which handles ICC profile loading and DDC/CI monitor control.
  */
 class ColorProfileManager
 {
@@ -86,41 +91,33 @@ public:
      * Get config manager for direct access to settings
      * @return Pointer to ConfigManager
      */
-    class ConfigManager* GetConfig() { return m_config; }
+    ConfigManager* GetConfig() { return m_config.get(); }
+
+    /**
+     * Get the platform-independent color pipeline doing the actual work
+     */
+    ColorPipeline& GetPipeline() { return *m_pipeline; }
 
 private:
-    std::wstring GetExecutablePath() const;
-    std::wstring GetToolPath(const wchar_t* toolName) const;
-    std::wstring GetProfilePath(const wchar_t* profileName) const;
+    /// Displays to apply to, according to the current settings
+    std::vector<MonitorSettings> CurrentDisplays();
 
     bool ExtractEmbeddedResource(int resourceId, const wchar_t* resourceType, const std::wstring& outputPath);
     bool ExtractEmbeddedTools();
     void CleanupTemporaryFiles();
 
-    bool ExecuteCommand(const std::wstring& command) const;
-    bool ExecuteCommandWithOutput(const std::wstring& command, std::wstring& output) const;
-    bool LoadICCProfile(const wchar_t* profilePath) const;
-    bool SetMonitorVCP(int display, int vcpCode, int value) const;
-    bool GetMonitorVCP(int display, int vcpCode, int& currentValue) const;
-    bool SetMonitorVCPVerified(int display, int vcpCode, int value, int maxRetries = 3) const;
-    bool EnsureVcp14ColorMode(int display) const;
-    bool WaitForVcpReadable(int display, int vcpCode, int timeoutMs, int pollMs) const;
-    void Sleep(int milliseconds) const;
-
     // Paths
     std::wstring m_executablePath;
-    std::wstring m_binPath;
-    std::wstring m_profilesPath;
     std::wstring m_tempPath;
 
-    // Tool paths
-    std::wstring m_dispwinPath;
-    std::wstring m_winddcutilPath;
-
     // Flags
     bool m_toolsExtracted;
     bool m_useEmbeddedTools;
 
     // Configuration from INI file
-    class ConfigManager* m_config;
+    std::unique_ptr<ConfigManager> m_config;
+
+    // Backends running the external tools
+    std::unique_ptr<ColorTools> m_tools;
+    std::unique_ptr<ColorPipeline> m_pipeline;
 };
@@ -0,0 +1,50 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Color Profile Management Extension
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ColorTools.hpp"
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <shlwapi.h>
+
+#pragma comment(lib, "shlwapi.lib")
+
+std::wstring ColorTools::GetExecutableDirectory()
+{
+    wchar_t path[MAX_PATH];
+    GetModuleFileNameW(nullptr, path, MAX_PATH);
+    PathRemoveFileSpecW(path);
+    return std::wstring(path);
+}
+
+ColorTools::Paths ColorTools::InDirectory(const std::wstring& directory)
+{
+    const std::wstring binPath = directory + L"\\bin";
+    return Paths { binPath + L"\\dispwin.exe", binPath + L"\\winddcutil.exe", directory + L"\\profiles" };
+}
+
+ColorTools::ColorTools(Paths paths)
+    : m_paths(std::move(paths))
+    , m_ddc(m_paths.winddcutil)
+    , m_gamma(m_paths.dispwin, m_paths.profiles)
+{
+}
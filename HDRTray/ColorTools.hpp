@@ -0,0 +1,61 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Color Profile Management Extension
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Win32Backends.hpp"
+
+#include <string>
+
+/**
+ * The external tools the color pipeline runs, wired up as its backends:
+ * dispwin.exe for profiles, winddcutil.exe for DDC/CI.
+ * Shared by HDRTray and the headless "HDRCmd apply".
+ */
+class ColorTools
+{
+public:
+    struct Paths
+    {
+        std::wstring dispwin;
+        std::wstring winddcutil;
+        /// Directory with the profile and calibration files
+        std::wstring profiles;
+    };
+
+    /// Directory of the running executable; HDRTray and HDRCmd are installed next to each other
+    static std::wstring GetExecutableDirectory();
+    /// Tools in the "bin" and profiles in the "profiles" directory below the given one
+    static Paths InDirectory(const std::wstring& directory);
+
+    explicit ColorTools(Paths paths);
+
+    const Paths& GetPaths() const { return m_paths; }
+    backend::Set GetBackends() { return backend::Set { m_clock, m_display, m_ddc, m_gamma }; }
+    backend::DispwinGamma& GetGamma() { return m_gamma; }
+
+private:
+    Paths m_paths;
+    backend::Win32Clock m_clock;
+    backend::WindowsDisplay m_display;
+    backend::WinddcutilDdc m_ddc;
+    backend::DispwinGamma m_gamma;
+};
@@ -20,9 +20,20 @@
 #include "HDRTray.h"
 #include "HDR.h"
 #include "l10n.h"
+#include "ColorTools.hpp"
+#include "DisplayEventDebouncer.hpp"
+#include "IpcChannel.hpp"
+#include "Log.hpp"
+#include "Metrics.hpp"
 #include "NotifyIcon.hpp"
+#include "StatusBoard.hpp"
+#include "StatusWatcher.hpp"
+#include "Trace.hpp"
 #include "WinVerCheck.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
 #include <memory>
 #include <utility>
 #include <powrprof.h>
@@ -34,6 +45,8 @@ DEFINE_GUID(GUID_CONSOLE_DISPLAY_STATE, 0x6fe69556, 0x704a, 0x47a0, 0x8f, 0x24,
 
 #define MAX_LOADSTRING 100
 
+using logging::Category;
+
 // Global Variables:
 HINSTANCE hInst;                                // current instance
 WCHAR szTitle[MAX_LOADSTRING];                  // The title bar text
@@ -43,6 +56,10 @@ static const wchar_t szWindowClass[] = L"HDRTrayWindow";  // the main window cla
 ATOM                MyRegisterClass(HINSTANCE hInstance);
 BOOL                InitInstance(HINSTANCE, int);
 LRESULT CALLBACK    WndProc(HWND, UINT, WPARAM, LPARAM);
+static void         StopIpcServer();
+static void         StartLogging();
+static void         LoadMetrics();
+static void         SaveMetrics();
 
 int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
                      _In_opt_ HINSTANCE hPrevInstance,
@@ -57,6 +74,10 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
     else
         SetProcessDPIAware();
 
+    trace::SetThreadName("UI");
+    StartLogging();
+    LoadMetrics();
+
     // Initialize global strings
     l10n::LoadString(IDS_APP_TITLE, szTitle);
 
@@ -84,9 +105,50 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
         DispatchMessage(&msg);
     }
 
+    StopIpcServer();
+    SaveMetrics();
+    logging::Stop();
+
     return (int) msg.wParam;
 }
 
+/* Levels come from the HDRTRAY_LOG environment variable, e.g. "debug" or "info,ddc=debug";
+ * the log files go next to the executable. */
+static void StartLogging()
+{
+    char spec[256];
+    DWORD length = GetEnvironmentVariableA("HDRTRAY_LOG", spec, static_cast<DWORD>(std::size(spec)));
+    const std::string_view value(spec, length < std::size(spec) ? length : 0);
+    if (!value.empty() && !logging::Configure(value))
+        logging::Warning(Category::General, "Ignoring invalid HDRTRAY_LOG value \"{}\"", value);
+
+    logging::FileOptions options;
+    options.directory = ColorTools::GetExecutableDirectory();
+    if (!logging::Start(options))
+        logging::Warning(Category::General, "Failed to open log file, logging to the debugger only");
+}
+
+static metrics::Counter process_starts("process.starts");
+
+static std::filesystem::path MetricsFile()
+{
+    return std::filesystem::path(ColorTools::GetExecutableDirectory()) / metrics::kFileName;
+}
+
+/// Continue counting from where the last run left off
+static void LoadMetrics()
+{
+    if (auto saved = metrics::ReadFile(MetricsFile()))
+        metrics::Restore(*saved);
+    process_starts.Add();
+}
+
+static void SaveMetrics()
+{
+    if (!metrics::WriteFile(MetricsFile()))
+        logging::Warning(Category::General, "Failed to save metrics");
+}
+
 
 
 //
@@ -139,10 +201,164 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
 
 static std::unique_ptr<NotifyIcon> notify_icon;
 static UINT msg_TaskbarCreated;
-static unsigned hdr_status_check_count;
 static HPOWERNOTIFY hPowerNotify = nullptr;
+static DisplayEventDebouncer display_events;
+static hdr::StatusWatcher status_watcher;
 
-enum { TIMER_ID_WAIT_TASKBAR_CREATED = 1, TIMER_ID_RECHECK_HDR_STATUS = 2, TIMER_ID_REAPPLY_COLOR_CORRECTION = 3 };
+static ipc::Server ipc_server;
+static board::Publisher status_board;
+/// Transition count as of the last status board update
+static uint64_t status_board_transitions = 0;
+
+enum { TIMER_ID_WAIT_TASKBAR_CREATED = 1, TIMER_ID_RECHECK_HDR_STATUS = 2, TIMER_ID_REAPPLY_COLOR_CORRECTION = 3,
+       TIMER_ID_SAVE_METRICS = 4 };
+// Metrics are saved this often, so not much is lost if HDRTray doesn't exit cleanly
+static const UINT METRICS_SAVE_INTERVAL_MS = 5 * 60 * 1000;
+// Sent by the IPC server thread, lParam points to an IpcCall
+enum { WM_APP_IPC_REQUEST = WM_APP + 1 };
+
+struct IpcCall
+{
+    const ipc::Request& request;
+    ipc::Response response;
+};
+
+/* Record a display/power event. The color correction reapply timer is re-armed to fire
+ * once the burst the event belongs to has settled.
+ * Returns whether the event started a new burst. */
+static bool RecordDisplayEvent(HWND hWnd, MonitorReapplyReason reason)
+{
+    const auto now = GetTickCount64();
+    bool new_burst = display_events.Record(reason, now);
+    SetTimer(hWnd, TIMER_ID_REAPPLY_COLOR_CORRECTION, display_events.MsUntilDue(now), nullptr);
+    return new_burst;
+}
+
+/* Publish the current state on the status board. The display status is answered from
+ * the display cache the status watcher keeps up to date. */
+static void PublishStatusBoard()
+{
+    if (!status_board.IsOpen() || !notify_icon)
+        return;
+
+    board::State state;
+    state.publishedUnixMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                std::chrono::system_clock::now().time_since_epoch())
+                                .count();
+    state.status = hdr::GetWindowsHDRStatus();
+    for (auto& disp : hdr::GetDisplays())
+        state.displays.push_back({ disp.id, std::move(disp.name), disp.status });
+    notify_icon->FillStatusBoard(state);
+    status_board_transitions = notify_icon->GetTransitionCount();
+    status_board.Publish(state);
+}
+
+/// Publish the state if a toggle or reapply ran since the last update
+static void PublishStatusBoardAfterTransition()
+{
+    if (notify_icon && notify_icon->GetTransitionCount() != status_board_transitions)
+        PublishStatusBoard();
+}
+
+/* Update the icon if the status watcher reported changes, and arm the re-check
+ * timer if the watcher wants to look at the status again. */
+static void HandleStatusChanges(HWND hWnd, const std::vector<hdr::StatusWatcher::Change>& changes)
+{
+    if (!changes.empty()) {
+        const auto& stats = status_watcher.GetStats();
+        logging::Info(Category::Display,
+                      "HDR status changed on {} display(s) ({} events, {} coalesced, {} checks, {} re-checks)",
+                      changes.size(), stats.events, stats.coalescedEvents, stats.checks, stats.rechecks);
+        // Answered from the display cache the watcher just refreshed
+        notify_icon->UpdateHDRStatus();
+        PublishStatusBoard();
+    }
+
+    if (status_watcher.IsPending())
+        SetTimer(hWnd, TIMER_ID_RECHECK_HDR_STATUS, status_watcher.MsUntilDue(GetTickCount64()), nullptr);
+    else
+        KillTimer(hWnd, TIMER_ID_RECHECK_HDR_STATUS);
+}
+
+/* Answer a request from HDRCmd. Runs on the UI thread, so requests share the display cache,
+ * the transition controller and the status watcher with the icon menu. */
+static ipc::Response HandleIpcRequest(HWND hWnd, const ipc::Request& request)
+{
+    ipc::Response response;
+    if (!notify_icon) {
+        // Shutting down
+        response.result = ipc::Result::Unavailable;
+        return response;
+    }
+
+    switch (request.command) {
+    case ipc::Command::GetStatus:
+        break;
+    case ipc::Command::GetDisplays:
+        for (auto& disp : hdr::GetDisplays())
+            response.displays.push_back({ disp.id, std::move(disp.name), disp.status });
+        break;
+    case ipc::Command::SetStatus:
+        if (request.displays.empty()) {
+            response.changedStatus = notify_icon->SetHDR(request.enable);
+            if (!response.changedStatus)
+                response.result = ipc::Result::Failed;
+        } else {
+            // Skip displays by their current status, not a cached one
+            hdr::InvalidateDisplayCache();
+            const auto displays = hdr::GetDisplays();
+            for (const auto& result : hdr::SetDisplaysHDRStatus(request.displays, request.enable)) {
+                ipc::DisplayEntry entry { result.id, {}, result.status, result.unchanged };
+                auto disp = std::find_if(displays.begin(), displays.end(),
+                                         [&](const hdr::Display& d) { return d.id == result.id; });
+                if (disp != displays.end())
+                    entry.name = disp->name;
+                response.displays.push_back(std::move(entry));
+            }
+            notify_icon->UpdateHDRStatus();
+        }
+        // Take the change into the watcher's snapshot
+        HandleStatusChanges(hWnd, status_watcher.Notify(hdr::StatusWatcher::Event::Refresh, GetTickCount64()));
+        // Also publish if the watcher saw no change, for the profile switch and transition result
+        PublishStatusBoard();
+        break;
+    case ipc::Command::SaveTrace:
+        if (!trace::WriteFile(request.path))
+            response.result = ipc::Result::Failed;
+        break;
+    case ipc::Command::GetMetrics:
+        response.metrics = metrics::Format(metrics::Collect());
+        break;
+    }
+    response.status = hdr::GetWindowsHDRStatus();
+    return response;
+}
+
+/* Listen for HDRCmd. Requests are handed to the UI thread. SendMessage() fails once the window
+ * is destroyed, so StopIpcServer() after the message loop can't deadlock; HDRCmd does the work
+ * itself then. */
+static void StartIpcServer(HWND hWnd)
+{
+    bool started = ipc_server.Start(ipc::DefaultEndpoint(), [hWnd](const ipc::Request& request) {
+        IpcCall call { request };
+        if (!SendMessageW(hWnd, WM_APP_IPC_REQUEST, 0, reinterpret_cast<LPARAM>(&call))) {
+            call.response = {};
+            call.response.result = ipc::Result::Unavailable;
+        }
+        return call.response;
+    });
+    if (started)
+        logging::Info(Category::Ipc, "Listening for HDRCmd requests");
+    else
+        logging::Warning(Category::Ipc, "Failed to create HDRCmd endpoint, another instance may be running");
+}
+
+static void StopIpcServer()
+{
+    const auto stats = ipc_server.GetStats();
+    ipc_server.Stop();
+    logging::Info(Category::Ipc, "HDRCmd endpoint closed: {} requests, {} errors", stats.requests, stats.errors);
+}
 
 static void HandleTimer(HWND hWnd, int id)
 {
@@ -155,22 +371,39 @@ static void HandleTimer(HWND hWnd, int id)
             DestroyWindow(hWnd);
         break;
     case TIMER_ID_RECHECK_HDR_STATUS:
-        if (hdr_status_check_count > 0) {
-            hdr_status_check_count--;
-            if (notify_icon->UpdateHDRStatus())
-                hdr_status_check_count = 0;
-        } else
-            KillTimer(hWnd, TIMER_ID_RECHECK_HDR_STATUS);
+        HandleStatusChanges(hWnd, status_watcher.Poll(GetTickCount64()));
         break;
     case TIMER_ID_REAPPLY_COLOR_CORRECTION:
         KillTimer(hWnd, TIMER_ID_REAPPLY_COLOR_CORRECTION);
-        OutputDebugStringW(L"Timer: Reapplying color correction after monitor reconnection\n");
         {
+            const auto now = GetTickCount64();
+            if (auto job = display_events.Poll(now)) {
+                const auto& stats = display_events.GetStats();
+                const auto query_stats = hdr::GetQueryStats();
+                logging::Info(Category::Display,
+                              "Display events settled: {} event(s) over {} ms, reason {} "
+                              "(saved so far: {} topology queries, {} DDC/CI probes; "
+                              "display config: {} queries, {} device info calls, {} cache hits)",
+                              job->coalescedEvents, job->burstDurationMs, job->reason, stats.topologyQueriesSaved,
+                              stats.ddcProbesSaved, query_stats.topologyQueries, query_stats.deviceInfoCalls,
+                              query_stats.cacheHits);
+                notify_icon->QueueMonitorReconnection(job->reason);
+            } else if (display_events.IsPending()) {
+                // Burst is still going on
+                SetTimer(hWnd, TIMER_ID_REAPPLY_COLOR_CORRECTION, display_events.MsUntilDue(now), nullptr);
+                break;
+            }
+
+            logging::Info(Category::Transition, "Timer: Reapplying color correction after monitor reconnection");
             const int retryDelayMs = notify_icon->HandleMonitorReconnection();
             if (retryDelayMs > 0)
                 SetTimer(hWnd, TIMER_ID_REAPPLY_COLOR_CORRECTION, retryDelayMs, nullptr);
+            PublishStatusBoardAfterTransition();
         }
         break;
+    case TIMER_ID_SAVE_METRICS:
+        SaveMetrics();
+        break;
     }
 }
 
@@ -191,6 +424,13 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
     case WM_CREATE:
         msg_TaskbarCreated = RegisterWindowMessage(L"TaskbarCreated");
         notify_icon.reset(new NotifyIcon(hWnd));
+        status_watcher.Start(GetTickCount64());
+        StartIpcServer(hWnd);
+        SetTimer(hWnd, TIMER_ID_SAVE_METRICS, METRICS_SAVE_INTERVAL_MS, nullptr);
+        if (status_board.Open(board::DefaultName()))
+            PublishStatusBoard();
+        else
+            logging::Warning(Category::Ipc, "Failed to create status board, another instance may be running");
         if (!notify_icon->Add())
         {
             // Set up a timer, this is the amount of time we wait for TaskbarCreated
@@ -200,11 +440,11 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         hPowerNotify = RegisterPowerSettingNotification(hWnd, &GUID_CONSOLE_DISPLAY_STATE, DEVICE_NOTIFY_WINDOW_HANDLE);
         if (hPowerNotify)
         {
-            OutputDebugStringW(L"Successfully registered for monitor power notifications\n");
+            logging::Info(Category::Display, "Successfully registered for monitor power notifications");
         }
         else
         {
-            OutputDebugStringW(L"Failed to register for monitor power notifications\n");
+            logging::Warning(Category::Display, "Failed to register for monitor power notifications");
         }
         break;
     case WM_COMMAND:
@@ -240,33 +480,33 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
             default:
                 return DefWindowProc(hWnd, message, wParam, lParam);
             }
+            // Menu commands may toggle HDR or change the applied profiles
+            PublishStatusBoard();
         }
         break;
     case WM_DISPLAYCHANGE:
         // Position window at (0,0) so it's always on the primary monitor
         SetWindowPos(hWnd, nullptr, 0, 0, 0, 0, SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE);
-        if (!notify_icon->UpdateHDRStatus())
         {
+            // Handle potential monitor reconnection (signal restore after loss, standby exit, etc.)
+            // The reapplication is delayed until the event burst settled, to ensure the monitor
+            // is ready to receive DDC/CI commands
+            logging::Info(Category::Display, "Display change detected - scheduling color correction reapplication");
+            RecordDisplayEvent(hWnd, MonitorReapplyReason::DisplayChange);
             /* HDR status doesn't seem to be always immediately up-to-date when receiving
-             * WM_DISPLAYCHANGE, so periodically re-check it over a short duration */
-            hdr_status_check_count = 10;
-            SetTimer(hWnd, TIMER_ID_RECHECK_HDR_STATUS, 500, nullptr);
+             * WM_DISPLAYCHANGE, the watcher re-checks it over a short duration */
+            HandleStatusChanges(hWnd, status_watcher.Notify(hdr::StatusWatcher::Event::DisplayChange, GetTickCount64()));
         }
-        // Handle potential monitor reconnection (signal restore after loss, standby exit, etc.)
-        // Use a delayed timer to ensure monitor is ready to receive DDC/CI commands
-        OutputDebugStringW(L"Display change detected - scheduling color correction reapplication\n");
-        notify_icon->QueueMonitorReconnection(NotifyIcon::MonitorReapplyReason::DisplayChange);
-        SetTimer(hWnd, TIMER_ID_REAPPLY_COLOR_CORRECTION, 3000, nullptr);
         break;
     case WM_POWERBROADCAST:
         // Handle power events (monitor standby/resume and monitor on/off)
         if (wParam == PBT_APMRESUMEAUTOMATIC || wParam == PBT_APMRESUMESUSPEND)
         {
-            // System resumed from standby - monitor needs more time to stabilize
-            // Use a longer delay than WM_DISPLAYCHANGE
-            OutputDebugStringW(L"System resumed from standby - scheduling color correction reapplication\n");
-            notify_icon->QueueMonitorReconnection(NotifyIcon::MonitorReapplyReason::SystemResume);
-            SetTimer(hWnd, TIMER_ID_REAPPLY_COLOR_CORRECTION, 5000, nullptr);
+            // System resumed from standby - monitor needs more time to stabilize,
+            // the debouncer uses a longer base delay than for WM_DISPLAYCHANGE
+            logging::Info(Category::Display, "System resumed from standby - scheduling color correction reapplication");
+            RecordDisplayEvent(hWnd, MonitorReapplyReason::SystemResume);
+            HandleStatusChanges(hWnd, status_watcher.Notify(hdr::StatusWatcher::Event::Resume, GetTickCount64()));
         }
         else if (wParam == PBT_POWERSETTINGCHANGE)
         {
@@ -278,13 +518,14 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                 // displayState: 0 = off, 1 = on, 2 = dimmed
                 if (displayState == 1) // Monitor turned on
                 {
-                    OutputDebugStringW(L"Monitor turned ON - scheduling color correction reapplication\n");
-                    notify_icon->QueueMonitorReconnection(NotifyIcon::MonitorReapplyReason::DisplayOn);
-                    SetTimer(hWnd, TIMER_ID_REAPPLY_COLOR_CORRECTION, 3000, nullptr);
+                    logging::Info(Category::Display, "Monitor turned ON - scheduling color correction reapplication");
+                    RecordDisplayEvent(hWnd, MonitorReapplyReason::DisplayOn);
+                    HandleStatusChanges(hWnd,
+                                        status_watcher.Notify(hdr::StatusWatcher::Event::DisplayOn, GetTickCount64()));
                 }
                 else if (displayState == 0)
                 {
-                    OutputDebugStringW(L"Monitor turned OFF\n");
+                    logging::Info(Category::Display, "Monitor turned OFF");
                 }
             }
         }
@@ -298,14 +539,26 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         {
             UnregisterPowerSettingNotification(hPowerNotify);
             hPowerNotify = nullptr;
-            OutputDebugStringW(L"Unregistered monitor power notifications\n");
+            logging::Info(Category::Display, "Unregistered monitor power notifications");
         }
+        status_board.Close();
         notify_icon->Remove();
         notify_icon.reset();
         PostQuitMessage(0);
         break;
     case NotifyIcon::MESSAGE:
-        return notify_icon->HandleMessage(hWnd, wParam, lParam);
+        {
+            // A click on the icon toggles HDR
+            LRESULT result = notify_icon->HandleMessage(hWnd, wParam, lParam);
+            PublishStatusBoardAfterTransition();
+            return result;
+        }
+    case WM_APP_IPC_REQUEST:
+        {
+            auto* call = reinterpret_cast<IpcCall*>(lParam);
+            call->response = HandleIpcRequest(hWnd, call->request);
+        }
+        return 1;
     case WM_TIMER:
         HandleTimer(hWnd, wParam);
         break;
@@ -18,18 +18,26 @@
 
 #include "NotifyIcon.hpp"
 #include "ConfigManager.hpp"
+#include "ConfigSchema.hpp"
+#include "IniDocument.hpp"
+#include "Log.hpp"
 
 #include "l10n.h"
 #include "Resource.h"
+#include "Trace.hpp"
 #include "WinVerCheck.hpp"
 
 #include "Windows10Colors.h"
 
+#include <algorithm>
+#include <iterator>
 #include <CommCtrl.h>
 #include <windowsx.h>
 #include <winreg.h>
 #include <shlwapi.h>
 
+using logging::Category;
+
 /*
     Enabling dark mode based on this information:
     https://gist.github.com/rounk-ctrl/b04e5622e30e0d62956870d5c22b7017
@@ -63,7 +71,7 @@ static void InitDarkModeSupport()
 static const wchar_t autostart_registry_path[] = L"Software\\Microsoft\\Windows\\CurrentVersion\\Run";
 static const wchar_t autostart_registry_key[] = L"HDRTray";
 
-// Wraps Shell_NotifyIconW(), prints to debug output in case of a failure
+// Wraps Shell_NotifyIconW(), logs a warning in case of a failure
 static BOOL wrap_Shell_NotifyIconW(DWORD message, NOTIFYICONDATAW* data)
 {
     auto result = Shell_NotifyIconW(message, data);
@@ -89,13 +97,11 @@ static BOOL wrap_Shell_NotifyIconW(DWORD message, NOTIFYICONDATAW* data)
         break;
     }
 
-    wchar_t debug_message[256];
     if (msg_str) {
-        swprintf_s(debug_message, L"Shell_NotifyIconW(%ls) failed :(\n", msg_str);
+        logging::Warning(Category::General, "Shell_NotifyIconW({}) failed :(", msg_str);
     } else {
-        swprintf_s(debug_message, L"Shell_NotifyIconW(%d) failed :(\n", message);
+        logging::Warning(Category::General, "Shell_NotifyIconW({}) failed :(", message);
     }
-    OutputDebugStringW(debug_message);
     return result;
 }
 
@@ -118,8 +124,11 @@ NotifyIcon::NotifyIcon(HWND hwnd)
     // Initialize color profile manager
     color_profile_manager = std::make_unique<ColorProfileManager>();
     if (!color_profile_manager->AreToolsAvailable()) {
-        OutputDebugStringW(L"Warning: Color profile management tools not found. Profile management disabled.\n");
+        logging::Warning(Category::Profile,
+                         "Color profile management tools not found. Profile management disabled.");
     }
+    transition_controller = std::make_unique<TransitionController>(color_profile_manager->GetPipeline(),
+                                                                   *color_profile_manager->GetConfig());
 }
 
 NotifyIcon::~NotifyIcon()
@@ -157,17 +166,17 @@ bool NotifyIcon::Add()
     // Apply color profiles on startup based on current HDR state
     if (color_profile_manager && color_profile_manager->AreToolsAvailable() &&
         color_profile_manager->GetConfig()->GetMonitorSettings().enableColorManagement) {
-        OutputDebugStringW(L"Startup: Applying color profiles based on current HDR state...\n");
+        logging::Info(Category::Transition, "Startup: Applying color profiles based on current HDR state...");
 
         if (hdr_status == hdr::Status::On) {
-            OutputDebugStringW(L"Startup: System is in HDR mode, applying HDR calibration...\n");
+            logging::Info(Category::Transition, "Startup: System is in HDR mode, applying HDR calibration...");
             if (!color_profile_manager->ApplyHDRCalibration()) {
-                OutputDebugStringW(L"Startup: Warning - Failed to apply HDR calibration\n");
+                logging::Warning(Category::Transition, "Startup: Failed to apply HDR calibration");
             }
         } else if (hdr_status == hdr::Status::Off) {
-            OutputDebugStringW(L"Startup: System is in SDR mode, applying SDR profile...\n");
+            logging::Info(Category::Transition, "Startup: System is in SDR mode, applying SDR profile...");
             if (!color_profile_manager->ApplySDRProfile()) {
-                OutputDebugStringW(L"Startup: Warning - Failed to apply SDR profile\n");
+                logging::Warning(Category::Transition, "Startup: Failed to apply SDR profile");
             }
         }
     }
@@ -203,63 +212,62 @@ void NotifyIcon::UpdateDarkMode()
 
 void NotifyIcon::QueueMonitorReconnection(MonitorReapplyReason reason)
 {
-    if (static_cast<int>(reason) > static_cast<int>(m_pendingReapplyReason))
-        m_pendingReapplyReason = reason;
-
-    // New event: allow retries again (monitor might still be stabilizing)
-    m_reapplyRetryCount = 0;
+    if (transition_controller)
+        transition_controller->QueueMonitorReconnection(reason);
 }
 
 int NotifyIcon::HandleMonitorReconnection()
 {
-    const auto reason = m_pendingReapplyReason;
-    m_pendingReapplyReason = MonitorReapplyReason::None;
-
-    // Check if color management is enabled
-    if (!color_profile_manager || !color_profile_manager->GetConfig())
-        return 0;
-
-    const auto& settings = color_profile_manager->GetConfig()->GetMonitorSettings();
-    if (!settings.enableColorManagement)
+    if (!transition_controller)
         return 0;
 
-    if (reason == MonitorReapplyReason::None)
-        return 0;
-
-    const bool forceReapply = (reason != MonitorReapplyReason::DisplayChange);
-    bool success = true;
+    WaitForPrewarm();
+    return transition_controller->HandleMonitorReconnection(hdr_status);
+}
 
-    // Reapply color correction based on current mode
-    if (hdr_status == hdr::Status::On)
-    {
-        OutputDebugStringW(L"Monitor reconnected in HDR mode - reapplying color correction\n");
-        success = color_profile_manager->ReapplyHDRColorCorrection(forceReapply);
-    }
-    else if (hdr_status == hdr::Status::Off)
-    {
-        OutputDebugStringW(L"Monitor reconnected in SDR mode - reapplying color correction\n");
-        success = color_profile_manager->ReapplySDRColorCorrection(forceReapply);
-    }
+uint64_t NotifyIcon::GetTransitionCount() const
+{
+    return transition_controller ? transition_controller->GetLastTransition().count : 0;
+}
 
-    if (success)
-    {
-        m_reapplyRetryCount = 0;
-        return 0;
+void NotifyIcon::FillStatusBoard(board::State& state) const
+{
+    if (!transition_controller)
+        return;
+    auto& pipeline = color_profile_manager->GetPipeline();
+
+    for (const auto& applied : pipeline.GetAppliedSettings()) {
+        board::Monitor monitor;
+        monitor.index = applied.display;
+        monitor.hdr = applied.hdr;
+        monitor.profileHash = applied.hash;
+        state.monitors.push_back(std::move(monitor));
     }
-
-    // If we got a "strong" event (display on/resume), the monitor may just not be ready yet.
-    // Schedule a few retries with a small backoff.
-    if (forceReapply && m_reapplyRetryCount < kMaxReapplyRetries)
-    {
-        m_reapplyRetryCount++;
-        m_pendingReapplyReason = reason;
-        const int delayMs = 1500 + (m_reapplyRetryCount * 750);
-        OutputDebugStringW((L"Monitor reapply failed, scheduling retry in " + std::to_wstring(delayMs) + L"ms\n").c_str());
-        return delayMs;
+    for (const auto& cached : pipeline.GetVcpCache()) {
+        auto monitor = std::find_if(state.monitors.begin(), state.monitors.end(),
+                                    [&](const board::Monitor& m) { return m.index == cached.display; });
+        if (monitor == state.monitors.end()) {
+            // Values read, but nothing applied yet (eg a pre-warm)
+            state.monitors.push_back({});
+            monitor = std::prev(state.monitors.end());
+            monitor->index = cached.display;
+        }
+        monitor->vcp.push_back({ static_cast<uint8_t>(cached.vcpCode), static_cast<uint16_t>(cached.value),
+                                 static_cast<uint32_t>(cached.ageMs) });
     }
 
-    m_reapplyRetryCount = 0;
-    return 0;
+    const auto& last = transition_controller->GetLastTransition();
+    if (last.count == 0)
+        return;
+    auto& transition = state.lastTransition;
+    transition.kind = last.reapply ? board::TransitionKind::Reapply : board::TransitionKind::Toggle;
+    transition.count = last.count;
+    transition.succeeded = last.succeeded;
+    transition.status = last.status;
+    transition.durationMs = static_cast<uint32_t>(last.durationMs);
+    // Transition times are from the pipeline clock (tick count), the board has wall clock times
+    const uint64_t sinceFinished = pipeline.GetBackends().clock.NowMs() - last.finishedMs;
+    transition.finishedUnixMs = state.publishedUnixMs - sinceFinished;
 }
 
 LRESULT NotifyIcon::HandleMessage(HWND hWnd, WPARAM wParam, LPARAM lParam)
@@ -267,7 +275,12 @@ LRESULT NotifyIcon::HandleMessage(HWND hWnd, WPARAM wParam, LPARAM lParam)
     auto event = LOWORD(lParam);
     switch(event)
     {
+    case WM_MOUSEMOVE:
+        // User might be about to click, get ready
+        StartPrewarm();
+        break;
     case WM_CONTEXTMENU:
+        StartPrewarm();
         PopupIconMenu(hWnd, POINT { GET_X_LPARAM(wParam), GET_Y_LPARAM(wParam) });
         break;
     case NIN_KEYSELECT:
@@ -341,105 +354,36 @@ void NotifyIcon::ToggleAutostartEnabled()
     RegCloseKey(key_autostart);
 }
 
-void NotifyIcon::ToggleHDR()
+std::optional<hdr::Status> NotifyIcon::ToggleHDR()
 {
     // Prevent multiple simultaneous toggles
     if (m_isToggling) {
-        OutputDebugStringW(L"ToggleHDR: Already toggling, ignoring request\n");
-        return;
+        logging::Info(Category::Transition, "ToggleHDR: Already toggling, ignoring request");
+        return std::nullopt;
     }
     m_isToggling = true;
 
+    // Let a pre-warm finish, its results are used by the toggle
+    WaitForPrewarm();
+
     /* Toggling HDR moves the mouse cursor to the screen center,
      * so save & restore it's position */
     POINT mouse_pos;
     bool has_mouse_pos = GetCursorPos(&mouse_pos);
 
-    // Always re-fetch HDR status from system to ensure we're in sync
-    FetchHDRStatus();
-    OutputDebugStringW((L"ToggleHDR: Current HDR status from system: " +
-                       std::to_wstring(static_cast<int>(hdr_status)) + L"\n").c_str());
-
-    // Determine target state (opposite of current)
-    bool enabling_hdr = (hdr_status != hdr::Status::On);
-
-    OutputDebugStringW((L"ToggleHDR: Target state - enabling_hdr: " +
-                       std::to_wstring(enabling_hdr) + L"\n").c_str());
-
-    // Reload configuration before applying profiles (so changes in .ini take effect immediately)
-    if (color_profile_manager && color_profile_manager->GetConfig()) {
-        color_profile_manager->GetConfig()->Load();
-        OutputDebugStringW(L"Configuration reloaded from HDRTray.ini\n");
-    }
-
-    // Check if color management is enabled (master toggle)
-    bool colorManagementEnabled = color_profile_manager &&
-                                   color_profile_manager->GetConfig() &&
-                                   color_profile_manager->GetConfig()->GetMonitorSettings().enableColorManagement;
-
-    // Apply color profile and calibration based on the INTENDED state
-    if (colorManagementEnabled && color_profile_manager->AreToolsAvailable()) {
-        if (enabling_hdr) {
-            // Switching to HDR - apply HDR calibration
-            OutputDebugStringW(L"Enabling HDR with calibration...\n");
-
-            // Following the exact order from the batch file:
-            // 1. First toggle to HDR
-            hdr::SetWindowsHDRStatus(true);
-
-            // Check if color preset change is enabled
-            bool presetChangeEnabled = color_profile_manager->GetConfig()->GetMonitorSettings().enableColorPresetChange;
-
-            if (presetChangeEnabled) {
-                // 2. Wait 3 seconds and set color preset (0x14)
-                if (!color_profile_manager->PrepareForHDR()) {
-                    OutputDebugStringW(L"Warning: Failed to prepare monitor for HDR\n");
-                }
-
-                // 3. Toggle HDR OFF then ON again (required for color preset to take effect)
-                OutputDebugStringW(L"Toggling HDR OFF/ON for calibration\n");
-                hdr::SetWindowsHDRStatus(false);
-                hdr::SetWindowsHDRStatus(true);
-            } else {
-                OutputDebugStringW(L"Color preset change disabled, skipping HDR toggle\n");
-            }
+    // Sequencing (status re-fetch, profile application) is done by the transition controller
+    auto new_status = transition_controller->ToggleHDR();
 
-            // 4. Apply calibration file and color settings
-            if (!color_profile_manager->ApplyHDRCalibration()) {
-                OutputDebugStringW(L"Warning: Failed to apply HDR calibration\n");
-            }
-
-            hdr_status = hdr::Status::On;
-        } else {
-            // Switching to SDR - apply SDR profile
-            OutputDebugStringW(L"Disabling HDR, applying SDR profile...\n");
-
-            // First toggle to SDR
-            hdr::SetWindowsHDRStatus(false);
-
-            // Apply SDR profile (includes sleep, ICC profile load, and calibrations)
-            if (!color_profile_manager->ApplySDRProfile()) {
-                OutputDebugStringW(L"Warning: Failed to apply SDR profile\n");
-            }
-
-            hdr_status = hdr::Status::Off;
-        }
+    if(new_status) {
+        hdr_status = *new_status;
         UpdateIcon();
     } else {
-        // No color tools available, just toggle HDR normally
-        auto new_status = hdr::ToggleHDRStatus();
-
-        if(new_status) {
-            hdr_status = *new_status;
-            UpdateIcon();
-        } else {
-            // Pop up error balloon if toggle failed
-            auto notify_balloon_tip = notify_template;
-            notify_balloon_tip.uFlags |= NIF_INFO | NIF_REALTIME;
-            l10n::LoadString(IDS_TOGGLE_HDR_ERROR, notify_balloon_tip.szInfo);
-            notify_balloon_tip.dwInfoFlags = NIIF_ERROR;
-            Shell_NotifyIconW(NIM_MODIFY, &notify_balloon_tip);
-        }
+        // Pop up error balloon if toggle failed
+        auto notify_balloon_tip = notify_template;
+        notify_balloon_tip.uFlags |= NIF_INFO | NIF_REALTIME;
+        l10n::LoadString(IDS_TOGGLE_HDR_ERROR, notify_balloon_tip.szInfo);
+        notify_balloon_tip.dwInfoFlags = NIIF_ERROR;
+        Shell_NotifyIconW(NIM_MODIFY, &notify_balloon_tip);
     }
 
     // Release toggle lock
@@ -447,6 +391,52 @@ void NotifyIcon::ToggleHDR()
 
     if(has_mouse_pos)
         SetCursorPos(mouse_pos.x, mouse_pos.y);
+
+    return new_status;
+}
+
+std::optional<hdr::Status> NotifyIcon::SetHDR(bool enable)
+{
+    // Decide on the current status, not a cached one
+    hdr::InvalidateDisplayCache();
+    FetchHDRStatus();
+    if (hdr_status == hdr::Status::Unsupported)
+        return hdr::Status::Unsupported;
+    // Overall status changes: same as clicking the icon, including the color profile switch
+    if ((hdr_status == hdr::Status::On) != enable)
+        return ToggleHDR();
+
+    /* Overall status already is the requested one, but some displays may not be.
+     * Bring those along; no-op if there are none. */
+    auto new_status = hdr::SetWindowsHDRStatus(enable);
+    UpdateHDRStatus();
+    return new_status;
+}
+
+void NotifyIcon::StartPrewarm()
+{
+    if (!transition_controller || m_isToggling)
+        return;
+    // Still running?
+    if (prewarm_task.valid() && prewarm_task.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return;
+    if (!transition_controller->NeedsPrewarm())
+        return;
+
+    auto settings = transition_controller->BeginPrewarm();
+    if (!settings)
+        return;
+    prewarm_task = std::async(std::launch::async,
+                              [controller = transition_controller.get(), settings = std::move(settings)]() {
+                                  trace::SetThreadName("Prewarm");
+                                  controller->RunPrewarm(*settings);
+                              });
+}
+
+void NotifyIcon::WaitForPrewarm()
+{
+    if (prewarm_task.valid())
+        prewarm_task.get();
 }
 
 void NotifyIcon::PopupIconMenu(HWND hWnd, POINT pos)
@@ -612,47 +602,27 @@ bool NotifyIcon::IsAutostartEnabled() const
 
 void NotifyIcon::OpenSettings()
 {
-    // Get the config file path
-    wchar_t exePath[MAX_PATH];
-    GetModuleFileNameW(nullptr, exePath, MAX_PATH);
-    PathRemoveFileSpecW(exePath);
-
-    std::wstring configPath = std::wstring(exePath) + L"\\HDRTray.ini";
-
-    // Check if config file exists, if not create it
-    if (!PathFileExistsW(configPath.c_str()))
+    std::wstring configPath;
+    if (color_profile_manager)
+    {
+        // Saving creates the file from the default template if it doesn't exist yet
+        auto* config = color_profile_manager->GetConfig();
+        configPath = config->GetConfigFilePath();
+        if (!PathFileExistsW(configPath.c_str()))
+            config->Save();
+    }
+    else
     {
-        // Create default config file with comments
-        std::wstring defaultConfig =
-            L"; HDRTray Configuration File\r\n"
-            L"; Edit these values to customize your monitor settings\r\n"
-            L"\r\n"
-            L"[Monitor]\r\n"
-            L"; Display ID (usually 1 for primary monitor)\r\n"
-            L"DisplayId=1\r\n"
-            L"\r\n"
-            L"[SDR]\r\n"
-            L"; SDR Mode Settings (VCP codes: 0x10=Brightness, 0x16=Red, 0x18=Green, 0x1A=Blue)\r\n"
-            L"Brightness=50\r\n"
-            L"RedGain=50\r\n"
-            L"GreenGain=49\r\n"
-            L"BlueGain=49\r\n"
-            L"\r\n"
-            L"[HDR]\r\n"
-            L"; HDR Mode Settings\r\n"
-            L"Brightness=100\r\n"
-            L"RedGain=46\r\n"
-            L"GreenGain=49\r\n"
-            L"BlueGain=49\r\n"
-            L"; Color Preset (VCP 0x14, specific to your monitor)\r\n"
-            L"ColorPreset=12\r\n";
-
-        HANDLE hFile = CreateFileW(configPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
-        if (hFile != INVALID_HANDLE_VALUE)
+        wchar_t exePath[MAX_PATH];
+        GetModuleFileNameW(nullptr, exePath, MAX_PATH);
+        PathRemoveFileSpecW(exePath);
+        configPath = std::wstring(exePath) + L"\\HDRTray.ini";
+
+        if (!PathFileExistsW(configPath.c_str()))
         {
-            DWORD bytesWritten;
-            WriteFile(hFile, defaultConfig.c_str(), static_cast<DWORD>(defaultConfig.length() * sizeof(wchar_t)), &bytesWritten, nullptr);
-            CloseHandle(hFile);
+            IniDocument defaultConfig;
+            defaultConfig.ParseText(schema::DefaultFileText(), IniDocument::Encoding::Utf16LE);
+            defaultConfig.WriteFile(configPath);
         }
     }
 
@@ -665,12 +635,13 @@ void NotifyIcon::ToggleSdrProfile()
     if (!color_profile_manager)
         return;
 
-    auto settings = color_profile_manager->GetConfig()->GetMonitorSettings();
-    settings.enableSdrProfile = !settings.enableSdrProfile;
-    color_profile_manager->GetConfig()->SetMonitorSettings(settings);
-    color_profile_manager->GetConfig()->Save();
+    bool enabled = false;
+    color_profile_manager->GetConfig()->UpdateMonitorSettings([&](MonitorSettings& settings) {
+        settings.enableSdrProfile = !settings.enableSdrProfile;
+        enabled = settings.enableSdrProfile;
+    });
 
-    OutputDebugStringW(settings.enableSdrProfile ? L"SDR profile enabled\n" : L"SDR profile disabled\n");
+    logging::Info(Category::Config, "SDR profile {}", enabled ? "enabled" : "disabled");
 }
 
 void NotifyIcon::ToggleHdrProfile()
@@ -678,12 +649,13 @@ void NotifyIcon::ToggleHdrProfile()
     if (!color_profile_manager)
         return;
 
-    auto settings = color_profile_manager->GetConfig()->GetMonitorSettings();
-    settings.enableHdrProfile = !settings.enableHdrProfile;
-    color_profile_manager->GetConfig()->SetMonitorSettings(settings);
-    color_profile_manager->GetConfig()->Save();
+    bool enabled = false;
+    color_profile_manager->GetConfig()->UpdateMonitorSettings([&](MonitorSettings& settings) {
+        settings.enableHdrProfile = !settings.enableHdrProfile;
+        enabled = settings.enableHdrProfile;
+    });
 
-    OutputDebugStringW(settings.enableHdrProfile ? L"HDR profile enabled\n" : L"HDR profile disabled\n");
+    logging::Info(Category::Config, "HDR profile {}", enabled ? "enabled" : "disabled");
 }
 
 void NotifyIcon::ToggleColorPreset()
@@ -691,12 +663,13 @@ void NotifyIcon::ToggleColorPreset()
     if (!color_profile_manager)
         return;
 
-    auto settings = color_profile_manager->GetConfig()->GetMonitorSettings();
-    settings.enableColorPresetChange = !settings.enableColorPresetChange;
-    color_profile_manager->GetConfig()->SetMonitorSettings(settings);
-    color_profile_manager->GetConfig()->Save();
+    bool enabled = false;
+    color_profile_manager->GetConfig()->UpdateMonitorSettings([&](MonitorSettings& settings) {
+        settings.enableColorPresetChange = !settings.enableColorPresetChange;
+        enabled = settings.enableColorPresetChange;
+    });
 
-    OutputDebugStringW(settings.enableColorPresetChange ? L"Color preset change enabled\n" : L"Color preset change disabled\n");
+    logging::Info(Category::Config, "Color preset change {}", enabled ? "enabled" : "disabled");
 }
 
 void NotifyIcon::ToggleColorManagement()
@@ -704,10 +677,11 @@ void NotifyIcon::ToggleColorManagement()
     if (!color_profile_manager)
         return;
 
-    auto settings = color_profile_manager->GetConfig()->GetMonitorSettings();
-    settings.enableColorManagement = !settings.enableColorManagement;
-    color_profile_manager->GetConfig()->SetMonitorSettings(settings);
-    color_profile_manager->GetConfig()->Save();
+    bool enabled = false;
+    color_profile_manager->GetConfig()->UpdateMonitorSettings([&](MonitorSettings& settings) {
+        settings.enableColorManagement = !settings.enableColorManagement;
+        enabled = settings.enableColorManagement;
+    });
 
-    OutputDebugStringW(settings.enableColorManagement ? L"Color management enabled\n" : L"Color management disabled\n");
+    logging::Info(Category::Config, "Color management {}", enabled ? "enabled" : "disabled");
 }
@@ -22,9 +22,14 @@
 #include "framework.h"
 #include "HDR.h"
 #include "ColorProfileManager.hpp"
+#include "DisplayEventDebouncer.hpp"
+#include "StatusBoard.hpp"
+#include "TransitionController.hpp"
 
 #include <shellapi.h>
+#include <future>
 #include <memory>
+#include <optional>
 
 class NotifyIcon
 {
@@ -45,15 +50,12 @@ class NotifyIcon
     bool m_isToggling = false;  // Flag to prevent multiple simultaneous toggles
 
     std::unique_ptr<ColorProfileManager> color_profile_manager;
+    std::unique_ptr<TransitionController> transition_controller;
+    /// Speculative preparation for a toggle, started when the user hovers over the icon
+    std::future<void> prewarm_task;
 
 public:
-    enum class MonitorReapplyReason
-    {
-        None = 0,
-        DisplayChange = 1,
-        DisplayOn = 2,
-        SystemResume = 3,
-    };
+    using MonitorReapplyReason = ::MonitorReapplyReason;
 
     NotifyIcon(HWND hwnd);
     ~NotifyIcon();
@@ -67,12 +69,23 @@ public:
     void QueueMonitorReconnection(MonitorReapplyReason reason);
     int HandleMonitorReconnection();
 
+    /// Number of toggles and reapplies so far, to tell whether the status board needs an update
+    uint64_t GetTransitionCount() const;
+    /**
+     * Fill in the color management part of the status board: monitors and the last transition.
+     * Expects the publishing time to be set already.
+     */
+    void FillStatusBoard(board::State& state) const;
+
     LRESULT HandleMessage(HWND hWnd, WPARAM wParam, LPARAM lParam);
 
     enum { MESSAGE = WM_USER + 11 };
 
     void ToggleAutostartEnabled();
-    void ToggleHDR();
+    /// Toggle HDR, applying color profiles; returns the new status, nothing on failure
+    std::optional<hdr::Status> ToggleHDR();
+    /// Turn HDR on or off, as requested by HDRCmd; toggles if the overall status differs
+    std::optional<hdr::Status> SetHDR(bool enable);
     void OpenSettings();
     void ToggleColorManagement();
     void ToggleSdrProfile();
@@ -89,10 +102,8 @@ protected:
 
     bool IsAutostartEnabled() const;
 
-private:
-    MonitorReapplyReason m_pendingReapplyReason = MonitorReapplyReason::None;
-    int m_reapplyRetryCount = 0;
-    static constexpr int kMaxReapplyRetries = 6;
+    void StartPrewarm();
+    void WaitForPrewarm();
 };
 
 #endif // NOTIFYICON_HPP_
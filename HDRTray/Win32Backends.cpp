@@ -0,0 +1,506 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Color Profile Management Extension
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Win32Backends.hpp"
+#include "Edid.hpp"
+#include "Log.hpp"
+#include "Metrics.hpp"
+#include "VcpOutput.hpp"
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <shlwapi.h>
+#include <setupapi.h>
+#include <physicalmonitorenumerationapi.h>
+#include <lowlevelmonitorconfigurationapi.h>
+#include <algorithm>
+#include <vector>
+
+#pragma comment(lib, "shlwapi.lib")
+#pragma comment(lib, "setupapi.lib")
+#pragma comment(lib, "dxva2.lib")
+
+namespace backend {
+
+using logging::Category;
+
+static metrics::Counter tool_launches("tools.launches");
+static metrics::Counter tool_launch_failures("tools.launch_failures");
+/// Runs that ended with an exit code other than 0
+static metrics::Counter tool_errors("tools.errors");
+static metrics::Histogram tool_run_ms("tools.run_ms");
+
+static bool TryMultiByteToWide(UINT codePage, DWORD flags, const std::string& input, std::wstring& output)
+{
+    if (input.empty())
+    {
+        output.clear();
+        return true;
+    }
+
+    int size = MultiByteToWideChar(codePage, flags, input.c_str(), -1, nullptr, 0);
+    if (size <= 0)
+        return false;
+
+    std::vector<wchar_t> buffer(size);
+    size = MultiByteToWideChar(codePage, flags, input.c_str(), -1, buffer.data(), size);
+    if (size <= 0)
+        return false;
+
+    output.assign(buffer.data());
+    return true;
+}
+
+static std::wstring MultiByteToWideBestEffort(const std::string& input)
+{
+    std::wstring output;
+
+    // Try UTF-8 first (some tools emit UTF-8), then fall back to OEM/ANSI codepages
+    if (TryMultiByteToWide(CP_UTF8, MB_ERR_INVALID_CHARS, input, output))
+        return output;
+
+    if (TryMultiByteToWide(GetOEMCP(), 0, input, output))
+        return output;
+
+    (void)TryMultiByteToWide(GetACP(), 0, input, output);
+    return output;
+}
+
+static bool ExecuteCommand(const std::wstring& command)
+{
+    STARTUPINFOW si = { sizeof(STARTUPINFOW) };
+    PROCESS_INFORMATION pi = {};
+
+    si.dwFlags = STARTF_USESHOWWINDOW;
+    si.wShowWindow = SW_HIDE;
+
+    // CreateProcess requires a modifiable string
+    std::wstring cmdLine = command;
+
+    tool_launches.Add();
+    const ULONGLONG startMs = GetTickCount64();
+    BOOL result = CreateProcessW(
+        nullptr,
+        &cmdLine[0],
+        nullptr,
+        nullptr,
+        FALSE,
+        CREATE_NO_WINDOW,
+        nullptr,
+        nullptr,
+        &si,
+        &pi
+    );
+
+    if (!result)
+    {
+        tool_launch_failures.Add();
+        logging::Warning(Category::General, "Failed to execute command: {}", command);
+        return false;
+    }
+
+    // Wait for process to complete
+    WaitForSingleObject(pi.hProcess, INFINITE);
+
+    DWORD exitCode = 0;
+    GetExitCodeProcess(pi.hProcess, &exitCode);
+    tool_run_ms.Record(GetTickCount64() - startMs);
+    if (exitCode != 0)
+        tool_errors.Add();
+
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+
+    return exitCode == 0;
+}
+
+static bool ExecuteCommandWithOutput(const std::wstring& command, std::wstring& output)
+{
+    SECURITY_ATTRIBUTES sa = {};
+    sa.nLength = sizeof(SECURITY_ATTRIBUTES);
+    sa.bInheritHandle = TRUE;
+    sa.lpSecurityDescriptor = nullptr;
+
+    // Create pipes for stdout
+    HANDLE hReadPipe = nullptr;
+    HANDLE hWritePipe = nullptr;
+    if (!CreatePipe(&hReadPipe, &hWritePipe, &sa, 0))
+    {
+        logging::Warning(Category::General, "Failed to create pipe");
+        return false;
+    }
+
+    // Ensure read handle is not inherited
+    SetHandleInformation(hReadPipe, HANDLE_FLAG_INHERIT, 0);
+
+    STARTUPINFOW si = { sizeof(STARTUPINFOW) };
+    PROCESS_INFORMATION pi = {};
+
+    si.dwFlags = STARTF_USESHOWWINDOW | STARTF_USESTDHANDLES;
+    si.wShowWindow = SW_HIDE;
+    si.hStdOutput = hWritePipe;
+    si.hStdError = hWritePipe;
+
+    // CreateProcess requires a modifiable string
+    std::wstring cmdLine = command;
+
+    tool_launches.Add();
+    const ULONGLONG startMs = GetTickCount64();
+    BOOL result = CreateProcessW(
+        nullptr,
+        &cmdLine[0],
+        nullptr,
+        nullptr,
+        TRUE, // Inherit handles
+        CREATE_NO_WINDOW,
+        nullptr,
+        nullptr,
+        &si,
+        &pi
+    );
+
+    if (!result)
+    {
+        tool_launch_failures.Add();
+        logging::Warning(Category::General, "Failed to execute command: {}", command);
+        CloseHandle(hReadPipe);
+        CloseHandle(hWritePipe);
+        return false;
+    }
+
+    // Close write pipe in parent process
+    CloseHandle(hWritePipe);
+
+    // Read output from pipe
+    char buffer[4096];
+    DWORD bytesRead;
+    std::string outputStr;
+
+    while (ReadFile(hReadPipe, buffer, sizeof(buffer) - 1, &bytesRead, nullptr) && bytesRead > 0)
+    {
+        buffer[bytesRead] = '\0';
+        outputStr += buffer;
+    }
+
+    // Convert to wstring
+    if (!outputStr.empty())
+    {
+        output = MultiByteToWideBestEffort(outputStr);
+    }
+
+    // Wait for process to complete
+    WaitForSingleObject(pi.hProcess, INFINITE);
+
+    DWORD exitCode = 0;
+    GetExitCodeProcess(pi.hProcess, &exitCode);
+    tool_run_ms.Record(GetTickCount64() - startMs);
+    if (exitCode != 0)
+        tool_errors.Add();
+
+    CloseHandle(hReadPipe);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+
+    return exitCode == 0;
+}
+
+uint64_t Win32Clock::NowMs()
+{
+    return GetTickCount64();
+}
+
+void Win32Clock::SleepMs(int milliseconds)
+{
+    ::Sleep(milliseconds);
+}
+
+hdr::Status WindowsDisplay::GetHDRStatus()
+{
+    return hdr::GetWindowsHDRStatus();
+}
+
+std::optional<hdr::Status> WindowsDisplay::SetHDRStatus(bool enable)
+{
+    return hdr::SetWindowsHDRStatus(enable);
+}
+
+void WindowsDisplay::Refresh()
+{
+    hdr::InvalidateDisplayCache();
+}
+
+// Read the EDID the monitor driver stored in the registry
+static std::vector<uint8_t> ReadMonitorEdid(const wchar_t* interfacePath)
+{
+    std::vector<uint8_t> edid;
+    HDEVINFO devInfo = SetupDiCreateDeviceInfoList(nullptr, nullptr);
+    if (devInfo == INVALID_HANDLE_VALUE)
+        return edid;
+
+    SP_DEVICE_INTERFACE_DATA interfaceData = { sizeof(interfaceData) };
+    SP_DEVINFO_DATA devInfoData = { sizeof(devInfoData) };
+    if (SetupDiOpenDeviceInterfaceW(devInfo, interfacePath, 0, &interfaceData)
+        && (SetupDiGetDeviceInterfaceDetailW(devInfo, &interfaceData, nullptr, 0, nullptr, &devInfoData)
+            || GetLastError() == ERROR_INSUFFICIENT_BUFFER))
+    {
+        HKEY key = SetupDiOpenDevRegKey(devInfo, &devInfoData, DICS_FLAG_GLOBAL, 0, DIREG_DEV, KEY_READ);
+        if (key != INVALID_HANDLE_VALUE)
+        {
+            DWORD size = 0;
+            if (RegQueryValueExW(key, L"EDID", nullptr, nullptr, nullptr, &size) == ERROR_SUCCESS && size > 0)
+            {
+                edid.resize(size);
+                if (RegQueryValueExW(key, L"EDID", nullptr, nullptr, edid.data(), &size) != ERROR_SUCCESS)
+                    edid.clear();
+            }
+            RegCloseKey(key);
+        }
+    }
+    SetupDiDestroyDeviceInfoList(devInfo);
+    return edid;
+}
+
+// dispwin and winddcutil number displays in monitor enumeration order
+static std::vector<HMONITOR> EnumerateMonitors()
+{
+    std::vector<HMONITOR> monitors;
+    EnumDisplayMonitors(
+        nullptr, nullptr,
+        [](HMONITOR monitor, HDC, LPRECT, LPARAM param) -> BOOL {
+            reinterpret_cast<std::vector<HMONITOR>*>(param)->push_back(monitor);
+            return TRUE;
+        },
+        reinterpret_cast<LPARAM>(&monitors));
+    return monitors;
+}
+
+std::vector<std::wstring> WindowsDisplay::GetEdidIds()
+{
+    const auto monitors = EnumerateMonitors();
+    std::vector<std::wstring> ids;
+    ids.reserve(monitors.size());
+    for (HMONITOR monitor : monitors)
+    {
+        MONITORINFOEXW monitorInfo = {};
+        monitorInfo.cbSize = sizeof(monitorInfo);
+        DISPLAY_DEVICEW device = { sizeof(device) };
+        std::wstring id;
+        if (GetMonitorInfoW(monitor, &monitorInfo)
+            && EnumDisplayDevicesW(monitorInfo.szDevice, 0, &device, EDD_GET_DEVICE_INTERFACE_NAME))
+        {
+            const auto edid = ReadMonitorEdid(device.DeviceID);
+            if (auto info = ParseEdid(edid.data(), edid.size()))
+                id = info->Id();
+        }
+        // Keep an entry even without EDID, so positions match display indices
+        ids.push_back(std::move(id));
+    }
+    return ids;
+}
+
+Dxva2Ddc::Dxva2Ddc()
+{
+    for (HMONITOR monitor : EnumerateMonitors())
+    {
+        DWORD count = 0;
+        if (!GetNumberOfPhysicalMonitorsFromHMONITOR(monitor, &count) || count == 0)
+            continue;
+        std::vector<PHYSICAL_MONITOR> physical(count);
+        if (!GetPhysicalMonitorsFromHMONITOR(monitor, count, physical.data()))
+            continue;
+        for (const auto& entry : physical)
+        {
+            auto added = std::make_unique<Monitor>();
+            added->handle = entry.hPhysicalMonitor;
+            m_monitors.push_back(std::move(added));
+        }
+    }
+}
+
+Dxva2Ddc::~Dxva2Ddc()
+{
+    for (const auto& monitor : m_monitors)
+        DestroyPhysicalMonitor(monitor->handle);
+}
+
+bool Dxva2Ddc::IsAvailable() const
+{
+    return !m_monitors.empty();
+}
+
+Dxva2Ddc::Monitor* Dxva2Ddc::GetMonitor(int display)
+{
+    if (display < 1 || display > GetMonitorCount())
+        return nullptr;
+    return m_monitors[display - 1].get();
+}
+
+bool Dxva2Ddc::SetVcp(int display, int vcpCode, int value)
+{
+    Monitor* monitor = GetMonitor(display);
+    if (!monitor)
+        return false;
+
+    // Waits for the time the monitor needs to process the command
+    std::lock_guard lock(monitor->mutex);
+    if (!SetVCPFeature(monitor->handle, static_cast<BYTE>(vcpCode), static_cast<DWORD>(value)))
+    {
+        logging::Warning(Category::Ddc, "SetVCPFeature failed for display {}", display);
+        return false;
+    }
+    return true;
+}
+
+bool Dxva2Ddc::GetVcp(int display, int vcpCode, int& currentValue)
+{
+    Monitor* monitor = GetMonitor(display);
+    if (!monitor)
+        return false;
+
+    std::lock_guard lock(monitor->mutex);
+    MC_VCP_CODE_TYPE type;
+    DWORD current = 0;
+    DWORD maximum = 0;
+    if (!GetVCPFeatureAndVCPFeatureReply(monitor->handle, static_cast<BYTE>(vcpCode), &type, &current, &maximum))
+    {
+        logging::Warning(Category::Ddc, "GetVCPFeatureAndVCPFeatureReply failed for display {}", display);
+        return false;
+    }
+    currentValue = static_cast<int>(current);
+    return true;
+}
+
+WinddcutilDdc::WinddcutilDdc(std::wstring toolPath) : m_toolPath(std::move(toolPath)) { }
+
+bool WinddcutilDdc::IsAvailable() const
+{
+    return PathFileExistsW(m_toolPath.c_str());
+}
+
+bool WinddcutilDdc::SetVcp(int display, int vcpCode, int value)
+{
+    // Format VCP code as hexadecimal (e.g., 0x10, not 0x16)
+    wchar_t vcpHex[8];
+    swprintf_s(vcpHex, L"%X", vcpCode);
+
+    std::wstring command = L"\"" + m_toolPath + L"\" setvcp " +
+                          std::to_wstring(display) + L" 0x" +
+                          vcpHex + L" " +
+                          std::to_wstring(value);
+
+    logging::Debug(Category::Ddc, "Setting VCP: {}", command);
+    return ExecuteCommand(command);
+}
+
+bool WinddcutilDdc::GetVcp(int display, int vcpCode, int& currentValue)
+{
+    // Format VCP code as hexadecimal
+    wchar_t vcpHex[8];
+    swprintf_s(vcpHex, L"%X", vcpCode);
+
+    std::wstring command = L"\"" + m_toolPath + L"\" getvcp " +
+                          std::to_wstring(display) + L" 0x" +
+                          vcpHex;
+
+    logging::Debug(Category::Ddc, "Getting VCP: {}", command);
+
+    std::wstring output;
+    if (!ExecuteCommandWithOutput(command, output))
+    {
+        logging::Warning(Category::Ddc, "Failed to execute getvcp command");
+        return false;
+    }
+
+    if (!ParseVcpCurrentValue(output, currentValue))
+    {
+        logging::Warning(Category::Ddc, "Could not parse getvcp output: {}", output);
+        return false;
+    }
+
+    logging::Debug(Category::Ddc, "Current VCP value: {}", currentValue);
+    return true;
+}
+
+DispwinGamma::DispwinGamma(std::wstring toolPath, std::wstring profilesPath)
+    : m_toolPath(std::move(toolPath))
+    , m_profilesPath(std::move(profilesPath))
+{
+}
+
+bool DispwinGamma::IsAvailable() const
+{
+    return PathFileExistsW(m_toolPath.c_str());
+}
+
+std::wstring DispwinGamma::GetProfilePath(const std::wstring& profileName) const
+{
+    return m_profilesPath + L"\\" + profileName;
+}
+
+bool DispwinGamma::PrepareProfile(const std::wstring& profileName)
+{
+    auto info = m_profileCache.Get(GetProfilePath(profileName));
+    if (!info)
+        return false;
+
+    if (!info->valid)
+    {
+        logging::Warning(Category::Profile, "Profile {} is invalid: {}", profileName, info->error);
+        return false;
+    }
+
+    if (info->type == ProfileInfo::Type::IccProfile && !info->iccHasVcgt)
+    {
+        logging::Info(Category::Profile, "Profile {} has no vcgt tag, no calibration will be loaded", profileName);
+    }
+    return true;
+}
+
+bool DispwinGamma::LoadProfile(int display, const std::wstring& profileName)
+{
+    const std::wstring profilePath = GetProfilePath(profileName);
+
+    // Check file extension to determine if we need -I flag
+    // .cal files don't need -I flag, .icc/.icm files do
+    std::wstring extension;
+    size_t dotPos = profilePath.find_last_of(L'.');
+    if (dotPos != std::wstring::npos) {
+        extension = profilePath.substr(dotPos);
+        // Convert to lowercase for comparison
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::towlower);
+    }
+
+    std::wstring command = L"\"" + m_toolPath + L"\"";
+
+    // Only add -I flag for .icc or .icm files (ICC profile installation)
+    // .cal files are calibration files and should be loaded without -I flag
+    if (extension == L".icc" || extension == L".icm") {
+        command += L" -I";
+    }
+
+    command += L" -d " + std::to_wstring(display) + L" \"" + profilePath + L"\"";
+
+    logging::Debug(Category::Profile, "Loading color profile: {}", command);
+    return ExecuteCommand(command);
+}
+
+} // namespace backend
@@ -0,0 +1,121 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Color Profile Management Extension
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "ColorBackends.hpp"
+#include "ProfileInfo.hpp"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace backend {
+
+/// Clock based on GetTickCount64()/Sleep()
+class Win32Clock : public Clock
+{
+public:
+    uint64_t NowMs() override;
+    void SleepMs(int milliseconds) override;
+};
+
+/// "Use HDR" switch via the hdr:: functions
+class WindowsDisplay : public Display
+{
+public:
+    hdr::Status GetHDRStatus() override;
+    std::optional<hdr::Status> SetHDRStatus(bool enable) override;
+    void Refresh() override;
+    std::vector<std::wstring> GetEdidIds() override;
+};
+
+/// DDC/CI monitor control by running winddcutil.exe
+class WinddcutilDdc : public Ddc
+{
+public:
+    explicit WinddcutilDdc(std::wstring toolPath);
+
+    bool IsAvailable() const override;
+    bool SetVcp(int display, int vcpCode, int value) override;
+    bool GetVcp(int display, int vcpCode, int& currentValue) override;
+
+private:
+    std::wstring m_toolPath;
+};
+
+/**
+ * DDC/CI monitor control in this process, with the Monitor Configuration API (dxva2.dll),
+ * saving a process start per transaction. Monitors are numbered like winddcutil does:
+ * physical monitors in monitor enumeration order, the first one is 1.
+ * Transactions for different monitors may run at the same time; those for one monitor are serialized.
+ */
+class Dxva2Ddc : public Ddc
+{
+public:
+    /// Enumerates the monitors; connected ones are only picked up by a new instance
+    Dxva2Ddc();
+    ~Dxva2Ddc() override;
+
+    Dxva2Ddc(const Dxva2Ddc&) = delete;
+    Dxva2Ddc& operator=(const Dxva2Ddc&) = delete;
+
+    bool IsAvailable() const override;
+    bool SetVcp(int display, int vcpCode, int value) override;
+    bool GetVcp(int display, int vcpCode, int& currentValue) override;
+
+    int GetMonitorCount() const { return static_cast<int>(m_monitors.size()); }
+
+private:
+    struct Monitor
+    {
+        /// Physical monitor HANDLE
+        void* handle;
+        /// Serializes the transactions on the monitor's bus
+        std::mutex mutex;
+    };
+    std::vector<std::unique_ptr<Monitor>> m_monitors;
+
+    Monitor* GetMonitor(int display);
+};
+
+/// Profile/calibration loading by running ArgyllCMS dispwin.exe
+class DispwinGamma : public Gamma
+{
+public:
+    DispwinGamma(std::wstring toolPath, std::wstring profilesPath);
+
+    bool IsAvailable() const override;
+    bool PrepareProfile(const std::wstring& profileName) override;
+    bool LoadProfile(int display, const std::wstring& profileName) override;
+
+    ProfileCache::Stats GetProfileCacheStats() const { return m_profileCache.GetStats(); }
+
+private:
+    std::wstring m_toolPath;
+    std::wstring m_profilesPath;
+    ProfileCache m_profileCache;
+
+    std::wstring GetProfilePath(const std::wstring& profileName) const;
+};
+
+} // namespace backend
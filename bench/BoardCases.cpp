@@ -0,0 +1,106 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* Status board cases: reading the state HDRTray publishes in shared memory, compared with what HDRCmd
+ * does without it, a cold status query against a fake display configuration of 2 adapters with 4 displays
+ * each, where each call takes 20 us. Reads with the board mapped once, a full open/read/close as done per
+ * HDRCmd invocation, publishing, and reads while another thread publishes continuously. */
+
+#include "Cases.hpp"
+
+#include "DisplayConfigBackend.hpp"
+#include "FakeDisplayConfig.hpp"
+#include "HDR.h"
+#include "Samples.hpp"
+#include "SharedMemory.hpp"
+#include "StatusBoard.hpp"
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace cases {
+
+namespace {
+
+constexpr unsigned kMonitors = 4;
+
+/// Board of the cases, with the display configuration its states are made from
+struct Board
+{
+    hdr::FakeDisplayConfig fake;
+    // Not the default name, so the cases can run next to a tray
+    std::string name = SharedMemory::SessionName("HDRTray.Bench-" + std::to_string(std::random_device {}()));
+    board::Publisher publisher;
+    board::Reader reader;
+    /// States published by the contending thread, in turn
+    std::vector<board::State> states;
+    size_t next = 0;
+
+    Board() : fake(MakeOptions())
+    {
+        fake.AddSyntheticTopology(2, 4);
+        hdr::SetDisplayConfigBackend(&fake);
+        const auto displays = hdr::GetDisplays();
+        hdr::SetDisplayConfigBackend(nullptr);
+        for (uint64_t generation = 1; generation <= 64; generation++)
+            states.push_back(samples::MakeBoardState(displays, kMonitors, generation));
+        publisher.Open(name);
+        publisher.Publish(states[0]);
+        reader.Open(name);
+    }
+
+private:
+    static hdr::FakeDisplayConfig::Options MakeOptions()
+    {
+        hdr::FakeDisplayConfig::Options options;
+        options.callLatency = std::chrono::microseconds(20);
+        return options;
+    }
+};
+
+} // namespace
+
+void AddBoard(harness::Suite& suite)
+{
+    auto board = std::make_shared<Board>();
+
+    // What HDRCmd does without a board: every invocation starts with an empty display cache
+    auto directStatus = []() {
+        hdr::InvalidateDisplayCache();
+        harness::Consume(hdr::GetWindowsHDRStatus());
+    };
+    auto useFake = [board]() { hdr::SetDisplayConfigBackend(&board->fake); };
+    suite.Add("board.direct.status", directStatus, { useFake, []() { hdr::SetDisplayConfigBackend(nullptr); } });
+    // What HDRCmd does with a board
+    suite.Add("board.open_read", [board]() {
+        board::Reader invocation;
+        invocation.Open(board->name);
+        harness::Consume(invocation.Read());
+    });
+    auto read = [board]() { harness::Consume(board->reader.Read()); };
+    suite.Add("board.read", read);
+    auto publish = [board]() { board->publisher.Publish(board->states[board->next++ % board->states.size()]); };
+    suite.Add("board.publish", publish);
+    // While the tray publishes as fast as it can; far more often than it really does
+    suite.Add("board.read.contended", read, harness::Threads(1, [publish](unsigned) { publish(); }));
+}
+
+} // namespace cases
@@ -0,0 +1,58 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CASES_HPP_
+#define CASES_HPP_
+
+#include "Harness.hpp"
+
+#include <filesystem>
+
+/**
+ * Cases of hdrtray_bench that need more setup than fits into its main(), one function per area.
+ * The state of the cases is kept alive by the cases themselves.
+ */
+namespace cases {
+
+/// Threads to run next to a measured operation in contended cases: all other CPUs, at least one
+unsigned ContendingThreads();
+
+/// Status board: reads and publishing of the shared memory board, next to a direct status query
+void AddBoard(harness::Suite& suite);
+
+/// HDR status: the hdr:: functions on a fake display configuration, with and without the 24H2 functions
+void AddHDR(harness::Suite& suite);
+
+/// IPC: requests to a server on the local endpoint, next to the direct calls, on a fake display configuration
+void AddIpc(harness::Suite& suite);
+
+/// Logging: filtered calls, and records written to a log file in scratch, next to building the message by hand
+void AddLog(harness::Suite& suite, const std::filesystem::path& scratch);
+
+/// Metrics: counter and histogram updates, alone and contended, collecting, formatting and parsing
+void AddMetrics(harness::Suite& suite);
+
+/// Settings snapshot: loads and stores of SnapshotCell, std::atomic<std::shared_ptr> and a mutex
+void AddSnapshot(harness::Suite& suite);
+
+/// Span tracing: recording spans, with tracing on and off, exporting and collecting under contention
+void AddTrace(harness::Suite& suite);
+
+} // namespace cases
+
+#endif // CASES_HPP_
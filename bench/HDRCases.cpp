@@ -0,0 +1,106 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* HDR status cases: the hdr:: functions shared by HDRTray and HDRCmd, on a fake display configuration
+ * of 4 adapters with 16 displays each, some with HDR, some with ACM, where each call takes 20 us.
+ * Calls made by an operation add to its time, so more calls show up as a slowdown. */
+
+#include "Cases.hpp"
+
+#include "DisplayConfigBackend.hpp"
+#include "FakeDisplayConfig.hpp"
+#include "HDR.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace cases {
+
+namespace {
+
+/// Display configuration of the cases
+struct Topology
+{
+    hdr::FakeDisplayConfig fake;
+    std::vector<hdr::DisplayId> ids;
+    unsigned next = 0;
+
+    explicit Topology(bool legacy) : fake(MakeOptions(legacy))
+    {
+        fake.AddSyntheticTopology(4, 16);
+        hdr::SetDisplayConfigBackend(&fake);
+        for (const auto& display : hdr::GetDisplays())
+            ids.push_back(display.id);
+        hdr::SetDisplayConfigBackend(nullptr);
+    }
+
+private:
+    static hdr::FakeDisplayConfig::Options MakeOptions(bool legacy)
+    {
+        hdr::FakeDisplayConfig::Options options;
+        options.hdrStateFunctions = !legacy;
+        options.callLatency = std::chrono::microseconds(20);
+        return options;
+    }
+};
+
+/// Background that sets the topology as the backend of hdr:: while a case runs
+harness::Background Use(const std::shared_ptr<Topology>& topology)
+{
+    return { [topology]() { hdr::SetDisplayConfigBackend(&topology->fake); },
+             []() { hdr::SetDisplayConfigBackend(nullptr); } };
+}
+
+/// Cases on one topology; legacy leaves out the functions added in Windows 11 24H2
+void AddTopology(harness::Suite& suite, bool legacy)
+{
+    auto topology = std::make_shared<Topology>(legacy);
+    auto add = [&](const char* name, std::function<void()> operation) {
+        suite.Add(std::string(legacy ? "hdr.legacy." : "hdr.") + name, std::move(operation), Use(topology));
+    };
+
+    // Right after a display change
+    add("status.cold", []() {
+        hdr::InvalidateDisplayCache();
+        harness::Consume(hdr::GetWindowsHDRStatus());
+    });
+    add("status.warm", []() { harness::Consume(hdr::GetWindowsHDRStatus()); });
+    add("displays", []() { harness::Consume(hdr::GetDisplays()); });
+    add("details", []() { harness::Consume(hdr::GetDisplayDetails()); });
+    add("toggle", []() { harness::Consume(hdr::ToggleHDRStatus()); });
+    // Turn each display on, then off again
+    add("set_one", [topology]() {
+        const unsigned i = topology->next++;
+        const hdr::DisplayId id = topology->ids[(i / 2) % topology->ids.size()];
+        harness::Consume(hdr::SetDisplaysHDRStatus(std::span(&id, 1), i % 2 == 0));
+    });
+}
+
+} // namespace
+
+void AddHDR(harness::Suite& suite)
+{
+    AddTopology(suite, false);
+    AddTopology(suite, true);
+}
+
+} // namespace cases
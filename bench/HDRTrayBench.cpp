@@ -0,0 +1,389 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* Micro-benchmarks of the platform independent parts of HDRTray, run by a common harness:
+ * parsing calibration (.cal) and ICC profiles, parsing the output of DDC/CI tools, bulk DDC/CI
+ * reads and writes on fake monitors, loading
+ * and saving HDRTray.ini, as a document and through the config manager and its file watcher,
+ * reading and publishing the settings snapshot with and without contention, HDR status queries
+ * and changes on a fake display configuration, requests to HDRTray over IPC,
+ * reading and publishing the status board, logging, metrics, recording and exporting trace spans,
+ * UTF-8 and UTF-16 transcoding, resampling calibration curves, the PQ
+ * and HLG transfer functions with each method, and toggles and reconnections through the
+ * transition pipeline on simulated backends.
+ * Results can be written as JSON, and compared against an earlier run to flag regressions.
+ * The results themselves are checked by the unit tests, which share the sample inputs. */
+
+#include "Cases.hpp"
+#include "FakeDdc.hpp"
+#include "Harness.hpp"
+
+#include "ColorPipeline.hpp"
+#include "ConfigManager.hpp"
+#include "IniDocument.hpp"
+#include "Log.hpp"
+#include "ProfileInfo.hpp"
+#include "Samples.hpp"
+#include "SimBackends.hpp"
+#include "TransferFunction.hpp"
+#include "TransitionController.hpp"
+#include "Unicode.hpp"
+#include "VcpBatch.hpp"
+#include "VcpOutput.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options
+{
+    harness::Options harness;
+    const char* json = nullptr;
+    const char* baseline = nullptr;
+    double tolerancePct = 10;
+    bool list = false;
+};
+
+/// Temporary directory for the files of the cases, removed with its contents at exit
+struct ScratchDirectory
+{
+    std::filesystem::path path;
+
+    ScratchDirectory()
+        : path(std::filesystem::temp_directory_path() / ("hdrtray_bench-" + std::to_string(std::random_device {}())))
+    {
+        std::filesystem::create_directories(path);
+    }
+    ~ScratchDirectory()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(path, ec);
+    }
+};
+
+/// Wait until the config publishes a snapshot other than the given one
+void WaitForNewSnapshot(const ConfigManager& config, const SettingsSnapshot& current)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (config.GetSnapshot() == current && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+/// Simulated machine for the transition cases, like a World in hdrsim
+struct SimMachine
+{
+    sim::Random random { 1 };
+    sim::Timings timings;
+    sim::VirtualClock clock;
+    sim::SimulatedMonitor monitor { clock, random, timings };
+    sim::FakeDisplay display { clock, random, timings, monitor };
+    sim::FakeGamma gamma { clock, random, timings };
+    sim::FixedSettings settings { ColorSettings() };
+    ColorPipeline pipeline { backend::Set { clock, display, monitor, gamma } };
+    TransitionController controller { pipeline, settings };
+
+    /// Queue a reconnection and handle it, including the retries
+    void Reconnect(MonitorReapplyReason reason)
+    {
+        controller.QueueMonitorReconnection(reason);
+        for (int retry = 0; retry < 10; retry++) {
+            const int delayMs = controller.HandleMonitorReconnection(display.GetHDRStatus());
+            if (delayMs == 0)
+                break;
+            clock.Advance(delayMs);
+        }
+    }
+};
+
+/// Batch conversion of the transfer function library, with its inputs
+struct TransferCase
+{
+    const char* name;
+    void (*batch)(std::span<const float>, std::span<float>, transfer::Method);
+    const std::vector<float>* input;
+};
+
+std::optional<std::string> ReadFile(const char* path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return std::nullopt;
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+void Usage(const char* argv0)
+{
+    std::fprintf(stderr,
+                 "Usage: %s [--filter TEXT] [--warmup-ms N] [--repetitions N] [--min-sample-us N] [--json FILE]\n"
+                 "          [--baseline FILE] [--tolerance PCT] [--list]\n",
+                 argv0);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        auto arg = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                Usage(argv[0]);
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (std::strcmp(argv[i], "--filter") == 0)
+            options.harness.filter = arg();
+        else if (std::strcmp(argv[i], "--warmup-ms") == 0)
+            options.harness.warmupMs = static_cast<unsigned>(std::strtoul(arg(), nullptr, 10));
+        else if (std::strcmp(argv[i], "--repetitions") == 0)
+            options.harness.repetitions = static_cast<unsigned>(std::strtoul(arg(), nullptr, 10));
+        else if (std::strcmp(argv[i], "--min-sample-us") == 0)
+            options.harness.minSampleUs = static_cast<unsigned>(std::strtoul(arg(), nullptr, 10));
+        else if (std::strcmp(argv[i], "--json") == 0)
+            options.json = arg();
+        else if (std::strcmp(argv[i], "--baseline") == 0)
+            options.baseline = arg();
+        else if (std::strcmp(argv[i], "--tolerance") == 0)
+            options.tolerancePct = std::strtod(arg(), nullptr);
+        else if (std::strcmp(argv[i], "--list") == 0)
+            options.list = true;
+        else {
+            Usage(argv[0]);
+            return 2;
+        }
+    }
+    options.harness.repetitions = std::max(options.harness.repetitions, 1u);
+    // Only the log cases log; elsewhere it would only add noise
+    logging::SetLevel(logging::Level::Off);
+
+    harness::Suite suite;
+    const ScratchDirectory scratch;
+
+    // Profiles: parsed when settings change and before a transition, unless cached
+    const auto calibration = samples::MakeCalibration(256);
+    const auto calibrationLarge = samples::MakeCalibration(1024);
+    const auto iccProfile = samples::MakeIccProfile();
+    suite.Add("cal.parse", [&]() { harness::Consume(ParseCalibration(calibration)); });
+    suite.Add("cal.parse.1024", [&]() { harness::Consume(ParseCalibration(calibrationLarge)); });
+    suite.Add("icc.parse", [&]() { harness::Consume(ParseIccProfile(iccProfile.data(), iccProfile.size())); });
+
+    // DDC/CI tool output: parsed for every VCP read through winddcutil
+    const std::wstring vcpLabelled = L"VCP 0x10 (Luminance): current value = 50, maximum value = 100\r\n";
+    const std::wstring vcpTerse = L"VCP 0x10 50 100\r\n";
+    const std::wstring vcpValue = L"Luminance: value = 0x32, max = 0x64\r\n";
+    int vcpResult = 0;
+    suite.Add("vcp.parse.labelled", [&]() { harness::Consume(ParseVcpCurrentValue(vcpLabelled, vcpResult)); });
+    suite.Add("vcp.parse.terse", [&]() { harness::Consume(ParseVcpCurrentValue(vcpTerse, vcpResult)); });
+    suite.Add("vcp.parse.value", [&]() { harness::Consume(ParseVcpCurrentValue(vcpValue, vcpResult)); });
+
+    // "HDRCmd vcp": reading 8 registers from 4 monitors, with transactions 1/40 as long as the DDC/CI spec asks for
+    FakeDdc ddc(4, std::chrono::microseconds(1000), std::chrono::microseconds(1250));
+    VcpBatch vcpReads;
+    VcpBatch vcpWrites;
+    for (int display = 1; display <= 4; display++) {
+        for (int code = 0x10; code < 0x18; code++) {
+            vcpReads.Get(display, code);
+            vcpWrites.Set(display, code, display + code);
+        }
+    }
+    suite.Add("vcp.batch.read.sequential", [&]() { harness::Consume(vcpReads.Run(ddc, false)); });
+    suite.Add("vcp.batch.read.concurrent", [&]() { harness::Consume(vcpReads.Run(ddc, true)); });
+    suite.Add("vcp.batch.write.concurrent", [&]() { harness::Consume(vcpWrites.Run(ddc, true)); });
+
+    // HDRTray.ini: loaded on start and on every change, saved on every menu toggle
+    const auto iniText = samples::MakeIni(8);
+    std::wstring iniWide;
+    unicode::DecodeUtf8(iniText, iniWide);
+    std::string iniUtf16 = "\xFF\xFE";
+    unicode::EncodeUtf16LE(iniWide, iniUtf16);
+    IniDocument iniDoc;
+    iniDoc.Parse(iniText);
+    IniDocument iniDocUtf16;
+    iniDocUtf16.Parse(iniUtf16);
+    suite.Add("ini.load", [&]() {
+        IniDocument doc;
+        doc.Parse(iniText);
+        harness::Consume(doc);
+    });
+    suite.Add("ini.load.utf16", [&]() {
+        IniDocument doc;
+        doc.Parse(iniUtf16);
+        harness::Consume(doc);
+    });
+    suite.Add("ini.save", [&]() { harness::Consume(iniDoc.Serialize()); });
+    suite.Add("ini.save.utf16", [&]() { harness::Consume(iniDocUtf16.Serialize()); });
+
+    // Configuration: Load() of an unchanged file only reads and hashes it; a menu toggle changes a setting and
+    // saves; an edit of the file is published by the watcher after its settle time
+    const auto configPath = scratch.path / "HDRTray.ini";
+    IniDocument::WriteBytes(configPath, iniText);
+    ConfigManager config(configPath.wstring());
+    config.Load();
+    config.StartWatching();
+    suite.Add("config.load", [&]() { harness::Consume(config.Load()); });
+    suite.Add("config.save", [&]() { harness::Consume(config.Save()); });
+    suite.Add("config.toggle", [&]() {
+        // Like NotifyIcon::ToggleSdrProfile()
+        harness::Consume(config.UpdateMonitorSettings(
+            [](ConfigManager::MonitorSettings& settings) { settings.enableSdrProfile = !settings.enableSdrProfile; }));
+    });
+    suite.Add("config.watch", [&]() {
+        const auto current = config.GetSnapshot();
+        IniDocument doc;
+        doc.ReadFile(configPath);
+        doc.SetInt(L"SDR", L"Brightness", current->defaults.sdrBrightness == 40 ? 60 : 40);
+        doc.WriteFile(configPath);
+        WaitForNewSnapshot(config, current);
+    });
+
+    cases::AddSnapshot(suite);
+    cases::AddHDR(suite);
+    cases::AddIpc(suite);
+    cases::AddLog(suite, scratch.path);
+    cases::AddMetrics(suite);
+    cases::AddBoard(suite);
+    cases::AddTrace(suite);
+
+    // Transcoding: INI files, log files, tool output
+    const auto text = samples::MakeText(16 * 1024);
+    std::string textUtf8;
+    unicode::EncodeUtf8(text, textUtf8);
+    std::string textUtf16;
+    unicode::EncodeUtf16LE(text, textUtf16);
+    std::wstring wideOut;
+    std::string bytesOut;
+    suite.Add("utf8.decode", [&]() { harness::Consume(unicode::DecodeUtf8(textUtf8, wideOut)); });
+    suite.Add("utf8.encode", [&]() {
+        bytesOut.clear();
+        unicode::EncodeUtf8(text, bytesOut);
+        harness::Consume(bytesOut);
+    });
+    suite.Add("utf16.decode", [&]() {
+        unicode::DecodeUtf16LE(textUtf16, wideOut);
+        harness::Consume(wideOut);
+    });
+    suite.Add("utf16.encode", [&]() {
+        bytesOut.clear();
+        unicode::EncodeUtf16LE(text, bytesOut);
+        harness::Consume(bytesOut);
+    });
+
+    // Calibration curves to the size of the video card gamma table and finer
+    const auto parsedCal = ParseCalibration(calibration);
+    const auto parsedLarge = ParseCalibration(calibrationLarge);
+    suite.Add("lut.resample.1024to256", [&]() { harness::Consume(ResampleCurve(parsedLarge.red, 256)); });
+    suite.Add("lut.resample.256to4096", [&]() { harness::Consume(ResampleCurve(parsedCal.red, 4096)); });
+
+    // Transfer functions: signal values and luminance of HDR calibration ramps and measurements
+    constexpr size_t kTransferValues = 4096;
+    std::vector<float> signals(kTransferValues);
+    std::vector<float> nits(kTransferValues);
+    std::vector<float> scenes(kTransferValues);
+    for (size_t i = 0; i < kTransferValues; i++) {
+        signals[i] = static_cast<float>(i) / (kTransferValues - 1);
+        nits[i] = static_cast<float>(transfer::PqEotf(signals[i]));
+        scenes[i] = static_cast<float>(transfer::HlgInverseOetf(signals[i]));
+    }
+    static const std::pair<const char*, transfer::Method> transferMethods[] = {
+        { "reference", transfer::Method::Reference },
+        { "table", transfer::Method::Table },
+        { "poly", transfer::Method::Polynomial },
+        { "vector", transfer::Method::Vector },
+    };
+    const TransferCase transferCases[] = {
+        { "pq.eotf", transfer::PqEotf, &signals },
+        { "pq.inverse", transfer::PqInverseEotf, &nits },
+        { "hlg.oetf", transfer::HlgOetf, &scenes },
+        { "hlg.inverse", transfer::HlgInverseOetf, &signals },
+    };
+    std::vector<float> transferOut(kTransferValues);
+    for (const auto& tc : transferCases) {
+        for (const auto& [methodName, method] : transferMethods) {
+            suite.Add(std::string(tc.name) + "." + methodName, [&tc, &transferOut, method = method]() {
+                tc.batch(*tc.input, transferOut, method);
+                harness::Consume(transferOut);
+            });
+        }
+    }
+
+    // Transition pipeline: the logic itself, with backends that take no real time
+    SimMachine machine;
+    suite.Add("sim.toggle", [&]() { harness::Consume(machine.controller.ToggleHDR()); });
+    suite.Add("sim.reconnect", [&]() {
+        machine.clock.Advance(10000);
+        machine.Reconnect(MonitorReapplyReason::DisplayOn);
+    });
+
+    if (options.list) {
+        for (const auto& name : suite.GetNames())
+            std::printf("%s\n", name.c_str());
+        return 0;
+    }
+
+    const auto results = suite.Run(options.harness);
+
+    int result = 0;
+    if (options.json) {
+        std::ofstream out(options.json, std::ios::binary);
+        out << harness::ToJson(results, options.harness);
+        if (!out.good()) {
+            std::fprintf(stderr, "Could not write results to %s\n", options.json);
+            result = 2;
+        }
+    }
+
+    std::printf("\nTransfer function vector kernels: %s\n", transfer::VectorIsa());
+
+    if (options.baseline) {
+        const auto baselineText = ReadFile(options.baseline);
+        const auto baseline = baselineText ? harness::FromJson(*baselineText) : std::nullopt;
+        if (!baseline) {
+            std::fprintf(stderr, "Could not read baseline from %s\n", options.baseline);
+            return 2;
+        }
+        std::printf("\n%-34s %12s %12s %9s %9s\n", "Baseline", "median ns", "now ns", "change", "min");
+        for (const auto& comparison : harness::Compare(*baseline, results, options.tolerancePct)) {
+            std::printf("%-34s %12.1f %12.1f %+8.1f%% %+8.1f%%%s\n", comparison.name.c_str(), comparison.baselineNs,
+                        comparison.currentNs, comparison.change * 100, comparison.minChange * 100,
+                        comparison.regression ? "  REGRESSION" : "");
+            if (comparison.regression) {
+                std::fprintf(stderr, "REGRESSION: %s median %.1f ns exceeds baseline %.1f ns by more than %.0f%%\n",
+                             comparison.name.c_str(), comparison.currentNs, comparison.baselineNs,
+                             options.tolerancePct);
+                result = result == 0 ? 1 : result;
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,429 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Harness.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+namespace harness {
+
+namespace detail {
+
+static const void* volatile escaped;
+
+void Escape(const void* pointer)
+{
+    escaped = pointer;
+}
+
+} // namespace detail
+
+using Clock = std::chrono::steady_clock;
+
+Background Threads(unsigned count, std::function<void(unsigned thread)> body)
+{
+    struct State
+    {
+        std::function<void(unsigned)> body;
+        std::atomic<bool> stop { false };
+        std::vector<std::thread> threads;
+    };
+    auto state = std::make_shared<State>();
+    state->body = std::move(body);
+    Background background;
+    background.start = [state, count]() {
+        state->stop = false;
+        for (unsigned t = 0; t < count; t++) {
+            state->threads.emplace_back([state = state.get(), t]() {
+                while (!state->stop.load(std::memory_order_relaxed))
+                    state->body(t);
+            });
+        }
+    };
+    background.stop = [state]() {
+        state->stop = true;
+        for (auto& thread : state->threads)
+            thread.join();
+        state->threads.clear();
+    };
+    return background;
+}
+
+void Suite::Add(std::string name, std::function<void()> operation)
+{
+    m_cases.push_back({ std::move(name), std::move(operation), {} });
+}
+
+void Suite::Add(std::string name, std::function<void()> operation, Background background)
+{
+    m_cases.push_back({ std::move(name), std::move(operation), std::move(background) });
+}
+
+std::vector<std::string> Suite::GetNames() const
+{
+    std::vector<std::string> names;
+    for (const auto& entry : m_cases)
+        names.push_back(entry.name);
+    return names;
+}
+
+static double ElapsedNs(Clock::time_point start, Clock::time_point end)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+static Summary Summarize(std::string name, uint64_t batch, std::vector<double> samplesNs)
+{
+    std::sort(samplesNs.begin(), samplesNs.end());
+    Summary summary;
+    summary.name = std::move(name);
+    summary.batch = batch;
+    summary.samples = static_cast<unsigned>(samplesNs.size());
+    if (samplesNs.empty())
+        return summary;
+
+    const size_t count = samplesNs.size();
+    summary.minNs = samplesNs.front();
+    summary.medianNs = count % 2 ? samplesNs[count / 2] : (samplesNs[count / 2 - 1] + samplesNs[count / 2]) / 2;
+    // Nearest rank
+    const size_t rank95 = static_cast<size_t>(std::ceil(0.95 * static_cast<double>(count)));
+    summary.p95Ns = samplesNs[std::clamp<size_t>(rank95, 1, count) - 1];
+    double sum = 0;
+    for (double v : samplesNs)
+        sum += v;
+    summary.meanNs = sum / static_cast<double>(count);
+    if (count > 1) {
+        double squares = 0;
+        for (double v : samplesNs)
+            squares += (v - summary.meanNs) * (v - summary.meanNs);
+        summary.stddevNs = std::sqrt(squares / static_cast<double>(count - 1));
+    }
+    return summary;
+}
+
+std::vector<Summary> Suite::Run(const Options& options) const
+{
+    std::vector<Summary> results;
+    std::printf("%-34s %10s %8s %12s %12s %12s %10s\n", "", "batch", "samples", "min ns", "median ns", "p95 ns",
+                "stddev %");
+    for (const auto& entry : m_cases) {
+        if (!options.filter.empty() && entry.name.find(options.filter) == std::string::npos)
+            continue;
+
+        if (entry.background.start)
+            entry.background.start();
+
+        // Warm up caches, branch predictors and the CPU clock, counting operations to size the batch
+        uint64_t warmupOps = 0;
+        const auto warmupStart = Clock::now();
+        const auto warmupEnd = warmupStart + std::chrono::milliseconds(options.warmupMs);
+        Clock::time_point now;
+        do {
+            entry.operation();
+            warmupOps++;
+            now = Clock::now();
+        } while (now < warmupEnd);
+        const double perOpNs = ElapsedNs(warmupStart, now) / static_cast<double>(warmupOps);
+        const uint64_t batch
+            = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(options.minSampleUs * 1000.0 / perOpNs)));
+
+        std::vector<double> samplesNs;
+        samplesNs.reserve(options.repetitions);
+        for (unsigned r = 0; r < options.repetitions; r++) {
+            const auto start = Clock::now();
+            for (uint64_t n = 0; n < batch; n++)
+                entry.operation();
+            const auto end = Clock::now();
+            samplesNs.push_back(ElapsedNs(start, end) / static_cast<double>(batch));
+        }
+        if (entry.background.stop)
+            entry.background.stop();
+
+        auto summary = Summarize(entry.name, batch, std::move(samplesNs));
+        std::printf("%-34s %10llu %8u %12.1f %12.1f %12.1f %10.1f\n", summary.name.c_str(),
+                    static_cast<unsigned long long>(summary.batch), summary.samples, summary.minNs, summary.medianNs,
+                    summary.p95Ns, summary.meanNs > 0 ? summary.stddevNs / summary.meanNs * 100 : 0);
+        std::fflush(stdout);
+        results.push_back(std::move(summary));
+    }
+    return results;
+}
+
+static void AppendString(std::string& out, std::string_view str)
+{
+    out += '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    out += '"';
+}
+
+static void AppendNumber(std::string& out, double value)
+{
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.3f", value);
+    out += buffer;
+}
+
+std::string ToJson(const std::vector<Summary>& results, const Options& options)
+{
+    std::string out = "{\n  \"options\": {";
+    out += "\"warmup_ms\": " + std::to_string(options.warmupMs);
+    out += ", \"repetitions\": " + std::to_string(options.repetitions);
+    out += ", \"min_sample_us\": " + std::to_string(options.minSampleUs);
+    out += "},\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& result = results[i];
+        out += i > 0 ? ",\n    {" : "\n    {";
+        out += "\"name\": ";
+        AppendString(out, result.name);
+        out += ", \"batch\": " + std::to_string(result.batch);
+        out += ", \"samples\": " + std::to_string(result.samples);
+        const std::pair<const char*, double> times[] = { { "min_ns", result.minNs },
+                                                         { "median_ns", result.medianNs },
+                                                         { "mean_ns", result.meanNs },
+                                                         { "p95_ns", result.p95Ns },
+                                                         { "stddev_ns", result.stddevNs } };
+        for (const auto& [key, value] : times) {
+            out += ", \"";
+            out += key;
+            out += "\": ";
+            AppendNumber(out, value);
+        }
+        out += '}';
+    }
+    out += "\n  ]\n}\n";
+    return out;
+}
+
+namespace {
+
+/// Reads just enough JSON for the output of ToJson(); anything it doesn't know is skipped
+class JsonReader
+{
+public:
+    explicit JsonReader(std::string_view json) : m_json(json) { }
+
+    bool Consume(char c)
+    {
+        SkipSpace();
+        if (m_pos < m_json.size() && m_json[m_pos] == c) {
+            m_pos++;
+            return true;
+        }
+        return false;
+    }
+
+    bool Peek(char c)
+    {
+        SkipSpace();
+        return m_pos < m_json.size() && m_json[m_pos] == c;
+    }
+
+    std::optional<std::string> String()
+    {
+        if (!Consume('"'))
+            return std::nullopt;
+        std::string str;
+        while (m_pos < m_json.size() && m_json[m_pos] != '"') {
+            if (m_json[m_pos] == '\\') {
+                // Only the escapes ToJson() writes
+                if (++m_pos >= m_json.size())
+                    return std::nullopt;
+            }
+            str += m_json[m_pos++];
+        }
+        if (m_pos >= m_json.size())
+            return std::nullopt;
+        m_pos++;
+        return str;
+    }
+
+    std::optional<double> Number()
+    {
+        SkipSpace();
+        constexpr std::string_view numberChars = "+-.0123456789eE";
+        const size_t start = m_pos;
+        while (m_pos < m_json.size() && numberChars.find(m_json[m_pos]) != std::string_view::npos)
+            m_pos++;
+        if (m_pos == start)
+            return std::nullopt;
+        const std::string token(m_json.substr(start, m_pos - start));
+        char* end = nullptr;
+        const double value = std::strtod(token.c_str(), &end);
+        if (end != token.c_str() + token.size())
+            return std::nullopt;
+        return value;
+    }
+
+    /// Skip any value
+    bool Skip()
+    {
+        if (Peek('"'))
+            return String().has_value();
+        if (Consume('{')) {
+            if (Consume('}'))
+                return true;
+            do {
+                if (!String() || !Consume(':') || !Skip())
+                    return false;
+            } while (Consume(','));
+            return Consume('}');
+        }
+        if (Consume('[')) {
+            if (Consume(']'))
+                return true;
+            do {
+                if (!Skip())
+                    return false;
+            } while (Consume(','));
+            return Consume(']');
+        }
+        for (std::string_view literal : { "true", "false", "null" }) {
+            if (m_json.substr(m_pos, literal.size()) == literal) {
+                m_pos += literal.size();
+                return true;
+            }
+        }
+        return Number().has_value();
+    }
+
+    bool AtEnd()
+    {
+        SkipSpace();
+        return m_pos == m_json.size();
+    }
+
+private:
+    std::string_view m_json;
+    size_t m_pos = 0;
+
+    void SkipSpace()
+    {
+        while (m_pos < m_json.size() && (m_json[m_pos] == ' ' || m_json[m_pos] == '\n' || m_json[m_pos] == '\r'
+                                         || m_json[m_pos] == '\t'))
+            m_pos++;
+    }
+};
+
+bool ReadSummary(JsonReader& reader, Summary& summary)
+{
+    if (!reader.Consume('{'))
+        return false;
+    if (reader.Consume('}'))
+        return false;
+    bool hasName = false;
+    bool hasMedian = false;
+    do {
+        const auto key = reader.String();
+        if (!key || !reader.Consume(':'))
+            return false;
+        if (*key == "name") {
+            auto name = reader.String();
+            if (!name)
+                return false;
+            summary.name = std::move(*name);
+            hasName = true;
+            continue;
+        }
+        double* const fields[] = { &summary.minNs, &summary.medianNs, &summary.meanNs, &summary.p95Ns,
+                                   &summary.stddevNs };
+        const std::string_view names[] = { "min_ns", "median_ns", "mean_ns", "p95_ns", "stddev_ns" };
+        const auto field = std::find(std::begin(names), std::end(names), *key);
+        if (field != std::end(names) || *key == "batch" || *key == "samples") {
+            const auto value = reader.Number();
+            if (!value)
+                return false;
+            if (field != std::end(names))
+                *fields[field - std::begin(names)] = *value;
+            else if (*key == "batch")
+                summary.batch = static_cast<uint64_t>(*value);
+            else
+                summary.samples = static_cast<unsigned>(*value);
+            hasMedian |= *key == "median_ns";
+        } else if (!reader.Skip()) {
+            return false;
+        }
+    } while (reader.Consume(','));
+    return reader.Consume('}') && hasName && hasMedian;
+}
+
+} // namespace
+
+std::optional<std::vector<Summary>> FromJson(std::string_view json)
+{
+    JsonReader reader(json);
+    std::vector<Summary> results;
+    bool hasBenchmarks = false;
+    if (!reader.Consume('{'))
+        return std::nullopt;
+    do {
+        const auto key = reader.String();
+        if (!key || !reader.Consume(':'))
+            return std::nullopt;
+        if (*key != "benchmarks") {
+            if (!reader.Skip())
+                return std::nullopt;
+            continue;
+        }
+        if (!reader.Consume('['))
+            return std::nullopt;
+        if (!reader.Consume(']')) {
+            do {
+                Summary summary;
+                if (!ReadSummary(reader, summary))
+                    return std::nullopt;
+                results.push_back(std::move(summary));
+            } while (reader.Consume(','));
+            if (!reader.Consume(']'))
+                return std::nullopt;
+        }
+        hasBenchmarks = true;
+    } while (reader.Consume(','));
+    if (!reader.Consume('}') || !reader.AtEnd() || !hasBenchmarks)
+        return std::nullopt;
+    return results;
+}
+
+std::vector<Comparison> Compare(const std::vector<Summary>& baseline, const std::vector<Summary>& current,
+                                double tolerancePct)
+{
+    std::vector<Comparison> comparisons;
+    for (const auto& result : current) {
+        const auto it = std::find_if(baseline.begin(), baseline.end(),
+                                     [&](const Summary& base) { return base.name == result.name; });
+        if (it == baseline.end() || it->medianNs <= 0 || it->minNs <= 0)
+            continue;
+        const double change = result.medianNs / it->medianNs - 1;
+        const double minChange = result.minNs / it->minNs - 1;
+        const bool regression = change * 100 > tolerancePct && minChange * 100 > tolerancePct;
+        comparisons.push_back({ result.name, it->medianNs, result.medianNs, change, minChange, regression });
+    }
+    return comparisons;
+}
+
+} // namespace harness
@@ -0,0 +1,146 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef HARNESS_HPP_
+#define HARNESS_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * Minimal micro-benchmark harness for hdrtray_bench.
+ *
+ * Each case is a function doing one operation. It runs for a warm-up time first, which also
+ * tells how many operations make up a sample of the minimum sample time; then a number of
+ * samples are timed, and their per-operation times summarized. Results can be written as JSON
+ * and compared against JSON written by an earlier run.
+ */
+namespace harness {
+
+struct Options
+{
+    /// Only run cases whose name contains this
+    std::string filter;
+    /// Time to run each case before measuring
+    unsigned warmupMs = 100;
+    /// Samples per case
+    unsigned repetitions = 30;
+    /// Minimum duration of a sample; short operations are repeated until a sample is this long
+    unsigned minSampleUs = 2000;
+};
+
+/// Per-operation times of a case, in nanoseconds
+struct Summary
+{
+    std::string name;
+    /// Operations per sample
+    uint64_t batch = 0;
+    unsigned samples = 0;
+    double minNs = 0;
+    double medianNs = 0;
+    double meanNs = 0;
+    double p95Ns = 0;
+    double stddevNs = 0;
+};
+
+/**
+ * Activity that goes on while a case runs, eg threads contending with the measured operation.
+ * start() is called before the warm-up, stop() after the last sample.
+ */
+struct Background
+{
+    std::function<void()> start;
+    std::function<void()> stop;
+};
+
+/// Background of a number of threads, each calling a function with its index in a loop until the case is done
+Background Threads(unsigned count, std::function<void(unsigned thread)> body);
+
+class Suite
+{
+public:
+    /// Add a case; names are compared against a baseline, so keep them stable
+    void Add(std::string name, std::function<void()> operation);
+    /// Add a case that runs with some background activity
+    void Add(std::string name, std::function<void()> operation, Background background);
+
+    std::vector<std::string> GetNames() const;
+    /// Run all cases matching the filter, printing a line per case as it finishes
+    std::vector<Summary> Run(const Options& options) const;
+
+private:
+    struct Case
+    {
+        std::string name;
+        std::function<void()> operation;
+        Background background;
+    };
+    std::vector<Case> m_cases;
+};
+
+namespace detail {
+void Escape(const void* pointer);
+} // namespace detail
+
+/// Keep the compiler from optimizing away a result that isn't used otherwise
+template<typename T> void Consume(const T& result)
+{
+#if defined(_MSC_VER)
+    detail::Escape(&result);
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "r"(&result) : "memory");
+#endif
+}
+
+/// Results as JSON, with the options they were measured with
+std::string ToJson(const std::vector<Summary>& results, const Options& options);
+/// Read the results from JSON written by ToJson(); only the name, batch, samples and times are read
+std::optional<std::vector<Summary>> FromJson(std::string_view json);
+
+struct Comparison
+{
+    std::string name;
+    double baselineNs;
+    double currentNs;
+    /// Relative change of the median, eg 0.1 for 10% slower
+    double change;
+    /// Relative change of the fastest sample
+    double minChange;
+    bool regression;
+};
+/**
+ * Compare the cases measured in both runs.
+ * A case is a regression if both its median and its fastest sample are slower than the baseline
+ * by more than tolerancePct: interference from other processes slows down some samples, and
+ * can move the median, but rarely all of them.
+ */
+std::vector<Comparison> Compare(const std::vector<Summary>& baseline, const std::vector<Summary>& current,
+                                double tolerancePct);
+
+} // namespace harness
+
+#endif // HARNESS_HPP_
@@ -0,0 +1,149 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* IPC cases: round trips of the requests HDRCmd forwards to HDRTray, over the local endpoint, next to
+ * the direct calls HDRCmd would make otherwise. The server answers from a fake display configuration of
+ * 2 adapters with 4 displays each, where each call takes 20 us. */
+
+#include "Cases.hpp"
+
+#include "DisplayConfigBackend.hpp"
+#include "FakeDisplayConfig.hpp"
+#include "HDR.h"
+#include "IpcChannel.hpp"
+#include "IpcProtocol.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace cases {
+
+namespace {
+
+constexpr std::chrono::milliseconds kTimeout { 1000 };
+
+/// Server and display configuration of the cases
+struct Endpoint
+{
+    hdr::FakeDisplayConfig fake;
+    ipc::Server server;
+    std::filesystem::path path = Named("-bench");
+    std::vector<hdr::DisplayId> ids;
+    ipc::Response displays;
+    unsigned next = 0;
+
+    Endpoint() : fake(MakeOptions())
+    {
+        fake.AddSyntheticTopology(2, 4);
+        hdr::SetDisplayConfigBackend(&fake);
+        for (auto& display : hdr::GetDisplays()) {
+            ids.push_back(display.id);
+            displays.displays.push_back({ display.id, std::move(display.name), display.status });
+        }
+        hdr::SetDisplayConfigBackend(nullptr);
+    }
+
+    static ipc::Response Handle(const ipc::Request& request)
+    {
+        ipc::Response response;
+        if (request.command == ipc::Command::GetDisplays) {
+            for (auto& display : hdr::GetDisplays())
+                response.displays.push_back({ display.id, std::move(display.name), display.status });
+        } else if (request.command == ipc::Command::SetStatus) {
+            for (const auto& result : hdr::SetDisplaysHDRStatus(request.displays, request.enable))
+                response.displays.push_back({ result.id, {}, result.status, result.unchanged });
+        }
+        response.status = hdr::GetWindowsHDRStatus();
+        return response;
+    }
+
+    /// Endpoint next to the one of HDRTray, so it works with named pipes as well as sockets
+    static std::filesystem::path Named(const char* suffix)
+    {
+        auto path = ipc::DefaultEndpoint();
+        path += suffix;
+        return path;
+    }
+
+private:
+    static hdr::FakeDisplayConfig::Options MakeOptions()
+    {
+        hdr::FakeDisplayConfig::Options options;
+        options.callLatency = std::chrono::microseconds(20);
+        return options;
+    }
+};
+
+/// Background that sets the display configuration as the backend of hdr:: and serves requests while a case runs
+harness::Background Serve(const std::shared_ptr<Endpoint>& endpoint)
+{
+    auto start = [endpoint]() {
+        hdr::SetDisplayConfigBackend(&endpoint->fake);
+        endpoint->server.Start(endpoint->path, &Endpoint::Handle);
+    };
+    auto stop = [endpoint]() {
+        endpoint->server.Stop();
+        hdr::SetDisplayConfigBackend(nullptr);
+    };
+    return { std::move(start), std::move(stop) };
+}
+
+} // namespace
+
+void AddIpc(harness::Suite& suite)
+{
+    auto endpoint = std::make_shared<Endpoint>();
+    auto add = [&](const char* name, std::function<void()> operation) {
+        suite.Add(std::string("ipc.") + name, std::move(operation), Serve(endpoint));
+    };
+    auto call = [endpoint](const ipc::Request& request) {
+        harness::Consume(ipc::Call(endpoint->path, request, kTimeout));
+    };
+
+    // What HDRCmd does without a tray
+    add("direct.status", []() {
+        hdr::InvalidateDisplayCache();
+        harness::Consume(hdr::GetWindowsHDRStatus());
+    });
+    add("direct.displays", []() {
+        hdr::InvalidateDisplayCache();
+        harness::Consume(hdr::GetDisplays());
+    });
+    add("status", [call]() { call({ ipc::Command::GetStatus }); });
+    add("displays", [call]() { call({ ipc::Command::GetDisplays }); });
+    // Turn each display on, then off again
+    add("set_one", [endpoint, call]() {
+        const unsigned i = endpoint->next++;
+        call({ ipc::Command::SetStatus, i % 2 == 0, { endpoint->ids[(i / 2) % endpoint->ids.size()] } });
+    });
+    // Cost of finding out there's no tray, before falling back to direct mode
+    add("no_server", [missing = Endpoint::Named("-missing")]() {
+        harness::Consume(ipc::Call(missing, { ipc::Command::GetStatus }, kTimeout));
+    });
+    add("codec", [endpoint]() {
+        const auto frame = ipc::EncodeFrame(endpoint->displays);
+        harness::Consume(ipc::DecodeResponse(std::span(frame).subspan(ipc::kFrameHeaderSize)));
+    });
+}
+
+} // namespace cases
@@ -0,0 +1,82 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* Logging cases: a call below the level of its category, the string concatenation deferred
+ * formatting replaces, and bursts of records logged and written to a log file by the
+ * background thread. Everything else runs with logging off, where it would only add noise. */
+
+#include "Cases.hpp"
+
+#include "Log.hpp"
+
+#include <filesystem>
+#include <string>
+
+using logging::Category;
+
+namespace cases {
+
+namespace {
+
+/// Records per burst; the queue holds many more, so none are dropped
+constexpr unsigned kBurst = 64;
+
+const std::wstring kProfile = L"Calibrated HDR.icm";
+
+/// Message the way it was put together before deferred formatting
+std::wstring Concatenated(int display, int vcpCode, int value, const std::wstring& profile)
+{
+    return L"Setting VCP " + std::to_wstring(vcpCode) + L" on display " + std::to_wstring(display) + L" to "
+           + std::to_wstring(value) + L" for " + profile + L"\n";
+}
+
+} // namespace
+
+void AddLog(harness::Suite& suite, const std::filesystem::path& scratch)
+{
+    // Log at the default level, to a file with room for all records of a run
+    auto start = [scratch]() {
+        logging::SetLevel(logging::Level::Info);
+        logging::FileOptions file;
+        file.directory = scratch;
+        file.baseName = L"bench";
+        file.fileSize = 64 * 1024 * 1024;
+        file.keepFiles = 0;
+        logging::Start(file);
+    };
+    auto stop = []() {
+        logging::Stop();
+        logging::SetLevel(logging::Level::Off);
+    };
+
+    // What every debug call costs with the default level
+    auto disabled = []() {
+        logging::Debug(Category::Ddc, "Setting VCP {:02X} on display {} to {} for {}", 0x14, 1, 50, kProfile);
+    };
+    suite.Add("log.disabled", disabled, { start, stop });
+    suite.Add("log.concatenate", []() { harness::Consume(Concatenated(1, 0x14, 50, kProfile)); });
+    // Logging, formatting and writing a burst; the background thread mustn't fall behind and drop records
+    auto burst = []() {
+        for (unsigned n = 0; n < kBurst; n++)
+            logging::Info(Category::Ddc, "Setting VCP {:02X} on display {} to {} for {}", 0x14, n, 50, kProfile);
+        logging::Flush();
+    };
+    suite.Add("log.burst.64", burst, { start, stop });
+}
+
+} // namespace cases
@@ -0,0 +1,64 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* Metrics cases: adding to a counter and recording into a histogram, alone and while all other
+ * CPUs record into the same histogram, collecting all metrics and turning them into text and back. */
+
+#include "Cases.hpp"
+
+#include "Metrics.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace cases {
+
+namespace {
+
+metrics::Counter benchCounter("bench.counter");
+metrics::Histogram benchLatency("bench.latency_ns");
+metrics::Histogram benchContended("bench.contended_ns");
+
+} // namespace
+
+void AddMetrics(harness::Suite& suite)
+{
+    auto next = std::make_shared<uint64_t>(0);
+    suite.Add("metrics.counter.add", []() { benchCounter.Add(); });
+    suite.Add("metrics.histogram.record", [next]() { benchLatency.Record((*next)++ % 100000); });
+    auto recordContended = [next]() { benchContended.Record(1000 + (*next)++ % 5000); };
+    suite.Add("metrics.histogram.record.contended", recordContended,
+              harness::Threads(ContendingThreads(), [](unsigned thread) {
+                  thread_local uint64_t recorded = 0;
+                  benchContended.Record(1000 + (recorded++ + thread) % 5000);
+              }));
+
+    // Snapshot with every histogram filled, as HDRTray saves it
+    for (uint64_t value = 0; value < 100000; value += 7) {
+        benchLatency.Record(value);
+        benchContended.Record(value);
+    }
+    auto snapshot = std::make_shared<metrics::Snapshot>(metrics::Collect());
+    auto text = std::make_shared<std::string>(metrics::Format(*snapshot));
+    suite.Add("metrics.collect", []() { harness::Consume(metrics::Collect()); });
+    suite.Add("metrics.format", [snapshot]() { harness::Consume(metrics::Format(*snapshot)); });
+    suite.Add("metrics.parse", [text]() { harness::Consume(metrics::Parse(*text)); });
+}
+
+} // namespace cases
@@ -0,0 +1,133 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* Settings snapshot cases: transitions, pre-warms and the menu fetch the current snapshot, while the
+ * config file watcher publishes new ones. SnapshotCell is compared with std::atomic<std::shared_ptr>
+ * and a mutex protected std::shared_ptr, alone and with other threads reading and writing. */
+
+#include "Cases.hpp"
+
+#include "SnapshotCell.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace cases {
+
+namespace {
+
+struct Payload
+{
+    uint64_t generation = 0;
+    std::array<uint64_t, 15> values {};
+};
+
+std::shared_ptr<const Payload> MakePayload(uint64_t generation)
+{
+    auto payload = std::make_shared<Payload>();
+    payload->generation = generation;
+    payload->values.fill(generation);
+    return payload;
+}
+
+class CellStore
+{
+    SnapshotCell<Payload> m_cell { MakePayload(0) };
+
+public:
+    static constexpr const char* name = "cell";
+    std::shared_ptr<const Payload> Load() const { return m_cell.Load(); }
+    void Store(std::shared_ptr<const Payload> value) { m_cell.Store(std::move(value)); }
+};
+
+class AtomicStore
+{
+    std::atomic<std::shared_ptr<const Payload>> m_value { MakePayload(0) };
+
+public:
+    static constexpr const char* name = "atomic";
+    std::shared_ptr<const Payload> Load() const { return m_value.load(); }
+    void Store(std::shared_ptr<const Payload> value) { m_value.store(std::move(value)); }
+};
+
+class MutexStore
+{
+    mutable std::mutex m_mutex;
+    std::shared_ptr<const Payload> m_value = MakePayload(0);
+
+public:
+    static constexpr const char* name = "mutex";
+    std::shared_ptr<const Payload> Load() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_value;
+    }
+    void Store(std::shared_ptr<const Payload> value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_value = std::move(value);
+    }
+};
+
+template<typename Store>
+void AddStore(harness::Suite& suite)
+{
+    auto store = std::make_shared<Store>();
+    auto generation = std::make_shared<std::atomic<uint64_t>>(0);
+    const std::string prefix = std::string("snapshot.") + Store::name;
+
+    const auto load = [store]() { harness::Consume(store->Load()); };
+    const auto publish = [store, generation]() { store->Store(MakePayload(++*generation)); };
+
+    suite.Add(prefix + ".load", load);
+    suite.Add(prefix + ".store", publish);
+    // Reads while every other CPU reads too, and the watcher publishes a little more often than it ever would
+    suite.Add(prefix + ".load.contended", load, harness::Threads(ContendingThreads(), [=](unsigned thread) {
+        if (thread == 0) {
+            publish();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        } else {
+            load();
+        }
+    }));
+    // Publishing while every other CPU reads
+    suite.Add(prefix + ".store.contended", publish, harness::Threads(ContendingThreads(), [=](unsigned) { load(); }));
+}
+
+} // namespace
+
+unsigned ContendingThreads()
+{
+    return std::max(2u, std::thread::hardware_concurrency()) - 1;
+}
+
+void AddSnapshot(harness::Suite& suite)
+{
+    AddStore<CellStore>(suite);
+    AddStore<AtomicStore>(suite);
+    AddStore<MutexStore>(suite);
+}
+
+} // namespace cases
@@ -0,0 +1,65 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* Span tracing cases: a span while tracing is off, a span without and with arguments, exporting
+ * full buffers, and collecting while all other CPUs record as fast as they can. */
+
+#include "Cases.hpp"
+
+#include "Trace.hpp"
+
+#include <cstdint>
+#include <string>
+
+namespace cases {
+
+namespace {
+
+/// Span with the arguments of a typical instrumented call
+void RecordArgs(int64_t i)
+{
+    trace::Span span("bench", "Args");
+    span.Arg("i", i).Arg("display", 1).Arg("profile", L"Calibrated.icm");
+}
+
+} // namespace
+
+void AddTrace(harness::Suite& suite)
+{
+    // What every instrumented call costs in a release build nobody traces
+    auto disable = []() { trace::SetEnabled(false); };
+    auto enable = []() { trace::SetEnabled(true); };
+    auto disabled = []() { trace::Span span("bench", "Disabled"); };
+    suite.Add("trace.span.disabled", disabled, { disable, enable });
+    suite.Add("trace.span.plain", []() { trace::Span span("bench", "Plain"); });
+    suite.Add("trace.span.args", []() { RecordArgs(0); });
+
+    // Buffer of the measuring thread full
+    auto fill = []() {
+        for (size_t n = 0; n < trace::kBufferCapacity; n++)
+            RecordArgs(static_cast<int64_t>(n));
+    };
+    auto exportAll = []() { harness::Consume(trace::Export()); };
+    suite.Add("trace.export", exportAll, { fill, &trace::Clear });
+    // Collecting while other threads overwrite the spans being collected
+    auto collect = []() { harness::Consume(trace::Collect()); };
+    suite.Add("trace.collect.contended", collect,
+              harness::Threads(ContendingThreads(), [](unsigned thread) { RecordArgs(thread); }));
+}
+
+} // namespace cases
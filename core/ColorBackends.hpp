@@ -0,0 +1,103 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Color Profile Management Extension
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "HDR.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * Interfaces to everything the color pipeline touches outside of its own logic.
+ * The Windows implementations live in Win32Backends; the transition simulator
+ * provides fakes so the pipeline can run without Windows or a real monitor.
+ */
+namespace backend {
+
+/// Time source and sleeping
+class Clock
+{
+public:
+    virtual ~Clock() = default;
+
+    /// Monotonic time in milliseconds
+    virtual uint64_t NowMs() = 0;
+    virtual void SleepMs(int milliseconds) = 0;
+};
+
+/// Windows "Use HDR" switch
+class Display
+{
+public:
+    virtual ~Display() = default;
+
+    virtual hdr::Status GetHDRStatus() = 0;
+    virtual std::optional<hdr::Status> SetHDRStatus(bool enable) = 0;
+    /// Forget any cached status, so the next GetHDRStatus() asks the system
+    virtual void Refresh() = 0;
+    /**
+     * Get the EDID ids (see EdidInfo::Id()) of the connected displays, ordered by the
+     * display index used by the Ddc and Gamma backends: the first entry is display 1.
+     * Entries are empty for displays without a readable EDID.
+     */
+    virtual std::vector<std::wstring> GetEdidIds() = 0;
+};
+
+/// Monitor control via DDC/CI
+class Ddc
+{
+public:
+    virtual ~Ddc() = default;
+
+    virtual bool IsAvailable() const = 0;
+    virtual bool SetVcp(int display, int vcpCode, int value) = 0;
+    virtual bool GetVcp(int display, int vcpCode, int& currentValue) = 0;
+};
+
+/// Video card gamma table / ICC profile loading
+class Gamma
+{
+public:
+    virtual ~Gamma() = default;
+
+    virtual bool IsAvailable() const = 0;
+    /**
+     * Check whether a profile (.icc/.icm) or calibration (.cal) file with the given name exists
+     * and is loadable. The result may be cached, so calling this ahead of a transition makes
+     * the check during the transition cheap.
+     */
+    virtual bool PrepareProfile(const std::wstring& profileName) = 0;
+    virtual bool LoadProfile(int display, const std::wstring& profileName) = 0;
+};
+
+/// All backends used by the color pipeline
+struct Set
+{
+    Clock& clock;
+    Display& display;
+    Ddc& ddc;
+    Gamma& gamma;
+};
+
+} // namespace backend
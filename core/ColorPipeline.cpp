@@ -0,0 +1,782 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Color Profile Management Extension
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ColorPipeline.hpp"
+#include "Log.hpp"
+#include "Metrics.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+using logging::Category;
+
+static metrics::Counter vcp_lookups("vcp.lookups");
+static metrics::Counter vcp_cache_hits("vcp.cache_hits");
+static metrics::Counter vcp_read_failures("vcp.read_failures");
+static metrics::Counter vcp_write_failures("vcp.write_failures");
+static metrics::Counter vcp_retries("vcp.retries");
+static metrics::Counter vcp_verify_failures("vcp.verify_failures");
+static metrics::Histogram vcp_get_ms("vcp.get_ms");
+static metrics::Histogram vcp_set_ms("vcp.set_ms");
+static metrics::Counter profile_load_failures("profile.load_failures");
+static metrics::Histogram profile_load_ms("profile.load_ms");
+/// Connected displays with color settings, as of the last transition
+static metrics::Gauge displays_configured("displays.configured");
+
+ColorPipeline::ColorPipeline(backend::Set backends) : m_backends(backends) { }
+
+std::vector<MonitorSettings> ColorPipeline::ResolveDisplays(const ColorSettings& settings)
+{
+    std::vector<MonitorSettings> displays;
+    if (settings.displays.empty())
+    {
+        displays.push_back(settings.defaults);
+        displays_configured.Set(1);
+        return displays;
+    }
+
+    // Match by EDID id: one hash lookup per connected display
+    const auto edidIds = m_backends.display.GetEdidIds();
+    for (size_t i = 0; i < edidIds.size(); i++)
+    {
+        if (edidIds[i].empty())
+            continue;
+        const auto it = settings.displays.find(edidIds[i]);
+        if (it == settings.displays.end())
+        {
+            logging::Info(Category::Config, "No settings for display {} ({})", i + 1, edidIds[i]);
+            continue;
+        }
+
+        MonitorSettings display = it->second;
+        display.displayId = static_cast<int>(i) + 1;
+        // Toggles (eg from the tray menu) are global
+        display.enableColorManagement = settings.defaults.enableColorManagement;
+        display.enableSdrProfile = settings.defaults.enableSdrProfile;
+        display.enableHdrProfile = settings.defaults.enableHdrProfile;
+        display.enableColorPresetChange = settings.defaults.enableColorPresetChange;
+        displays.push_back(std::move(display));
+    }
+    displays_configured.Set(static_cast<int64_t>(displays.size()));
+    return displays;
+}
+
+bool ColorPipeline::AreToolsAvailable() const
+{
+    return m_backends.gamma.IsAvailable() && m_backends.ddc.IsAvailable();
+}
+
+bool ColorPipeline::CanApply(const std::vector<MonitorSettings>& displays) const
+{
+    if (!AreToolsAvailable())
+    {
+        logging::Warning(Category::Profile, "Color profile tools not available");
+        return false;
+    }
+    if (displays.empty())
+    {
+        logging::Info(Category::Ddc, "None of the configured displays is connected");
+        return false;
+    }
+    return true;
+}
+
+bool ColorPipeline::SetMonitorVCPVerified(int display, int vcpCode, int value, int maxRetries)
+{
+    constexpr int kSetVerifySettleDelayMs = 200;
+    const int kRetryBackoffMs[] = { 150, 300, 500 };
+    const int kRetryBackoffCount = static_cast<int>(sizeof(kRetryBackoffMs) / sizeof(kRetryBackoffMs[0]));
+
+    trace::Span span("ddc", "SetVcpVerified");
+    span.Arg("display", display).Arg("vcp", vcpCode).Arg("value", value);
+
+    for (int attempt = 0; attempt < maxRetries; attempt++)
+    {
+        trace::Span attemptSpan("ddc", attempt > 0 ? "Retry" : "Attempt");
+        attemptSpan.Arg("attempt", attempt + 1);
+        if (attempt > 0)
+        {
+            vcp_retries.Add();
+            logging::Info(Category::Ddc, "Retry attempt {} of {}", attempt + 1, maxRetries);
+        }
+
+        // Set the VCP value
+        if (!WriteVcp(display, vcpCode, value))
+        {
+            logging::Warning(Category::Ddc, "Failed to set VCP value");
+            if (attempt < maxRetries - 1)
+            {
+                const int backoffIndex = (std::min)(attempt, kRetryBackoffCount - 1);
+                Sleep(kRetryBackoffMs[backoffIndex]);
+                continue;
+            }
+            vcp_verify_failures.Add();
+            return false;
+        }
+
+        // Wait briefly for the monitor to settle before verification
+        Sleep(kSetVerifySettleDelayMs);
+
+        // Verify the value was set correctly
+        int currentValue = -1;
+        if (ReadVcp(display, vcpCode, currentValue))
+        {
+            if (currentValue == value)
+            {
+                logging::Debug(Category::Ddc, "VCP value verified successfully");
+                return true;
+            }
+            else
+            {
+                logging::Warning(Category::Ddc, "VCP 0x{:02X} value mismatch on display {}: expected {}, got {}",
+                                 vcpCode, display, value, currentValue);
+                if (attempt < maxRetries - 1)
+                {
+                    const int backoffIndex = (std::min)(attempt, kRetryBackoffCount - 1);
+                    Sleep(kRetryBackoffMs[backoffIndex]);
+                }
+            }
+        }
+        else
+        {
+            logging::Warning(Category::Ddc, "Failed to verify VCP value (getvcp failed)");
+            // Continue anyway as getvcp might not be supported for all codes
+            if (attempt == maxRetries - 1)
+            {
+                logging::Warning(Category::Ddc, "Could not verify VCP value, assuming success");
+                return true;
+            }
+
+            const int backoffIndex = (std::min)(attempt, kRetryBackoffCount - 1);
+            Sleep(kRetryBackoffMs[backoffIndex]);
+        }
+    }
+
+    logging::Warning(Category::Ddc, "Failed to set and verify VCP value after all retries");
+    vcp_verify_failures.Add();
+    return false;
+}
+
+bool ColorPipeline::EnsureVcp14ColorMode(int display)
+{
+    // VCP 0x14 is known to be the color mode selector on supported displays.
+    // Read it only after DDC/CI is ready to avoid false negatives during transitions.
+    if (!WaitForVcpReadable(display, 0x14, /*timeoutMs=*/10000, /*pollMs=*/250))
+    {
+        logging::Warning(Category::Ddc, "DDC/CI not ready (getvcp probe timed out) for VCP 0x14");
+        return false;
+    }
+
+    int currentValue = -1;
+
+    // Value was just read by the readiness probe
+    if (!ReadVcp(display, 0x14, currentValue, kVcpCacheMaxAgeMs))
+    {
+        logging::Warning(Category::Ddc, "Failed to read VCP 0x14 before color correction despite readiness probe");
+        return false;
+    }
+
+    if (currentValue == 12)
+    {
+        logging::Info(Category::Ddc, "VCP 0x14 already set to 12");
+        return true;
+    }
+
+    logging::Info(Category::Ddc, "Setting VCP 0x14 to 12 before applying color correction");
+    if (!SetMonitorVCPVerified(display, 0x14, 12))
+    {
+        logging::Warning(Category::Ddc, "Failed to set VCP 0x14 to 12, aborting color correction path");
+        return false;
+    }
+
+    // Re-check after the write settles; abort if the value is still not readable/12.
+    if (!WaitForVcpReadable(display, 0x14, /*timeoutMs=*/10000, /*pollMs=*/250))
+    {
+        logging::Warning(Category::Ddc, "DDC/CI became unreadable after setting VCP 0x14");
+        return false;
+    }
+
+    constexpr int kVcp14StabilizationWindowMs = 2500;
+    constexpr int kVcp14StabilizationPollMs = 250;
+    constexpr int kVcp14RequiredConsecutiveReads = 2;
+
+    int consecutiveReads = 0;
+    bool stabilized = false;
+    const uint64_t stabilizationStartTick = m_backends.clock.NowMs();
+    trace::Span stabilizationSpan("wait", "Vcp14Stabilization");
+    stabilizationSpan.Arg("display", display);
+
+    while (static_cast<int>(m_backends.clock.NowMs() - stabilizationStartTick) < kVcp14StabilizationWindowMs)
+    {
+        if (ReadVcp(display, 0x14, currentValue))
+        {
+            if (currentValue == 12)
+            {
+                consecutiveReads++;
+                if (consecutiveReads >= kVcp14RequiredConsecutiveReads)
+                {
+                    stabilized = true;
+                    break;
+                }
+            }
+            else
+            {
+                consecutiveReads = 0;
+            }
+        }
+        else
+        {
+            logging::Warning(Category::Ddc, "Failed to re-read VCP 0x14 during stabilization");
+            consecutiveReads = 0;
+        }
+
+        Sleep(kVcp14StabilizationPollMs);
+    }
+
+    stabilizationSpan.Arg("stabilized", stabilized);
+    if (!stabilized)
+    {
+        logging::Warning(Category::Ddc, "VCP 0x14 did not stabilize at 12 (last value {})", currentValue);
+        return false;
+    }
+
+    logging::Info(Category::Ddc, "VCP 0x14 set to 12 successfully");
+    return true;
+}
+
+bool ColorPipeline::WaitForVcpReadable(int display, int vcpCode, int timeoutMs, int pollMs)
+{
+    trace::Span span("wait", "WaitForVcpReadable");
+    span.Arg("display", display).Arg("vcp", vcpCode).Arg("timeoutMs", timeoutMs);
+    const uint64_t startTick = m_backends.clock.NowMs();
+    int currentValue = -1;
+
+    while (static_cast<int>(m_backends.clock.NowMs() - startTick) < timeoutMs)
+    {
+        // A value read very recently means DDC/CI is responding
+        if (ReadVcp(display, vcpCode, currentValue, kVcpCacheMaxAgeMs))
+        {
+            span.Arg("ready", 1);
+            return true;
+        }
+        Sleep(pollMs);
+    }
+    span.Arg("ready", 0);
+    return false;
+}
+
+void ColorPipeline::Sleep(int milliseconds)
+{
+    trace::Span span("wait", "Sleep");
+    span.Arg("ms", milliseconds);
+    m_backends.clock.SleepMs(milliseconds);
+}
+
+bool ColorPipeline::LoadProfile(int display, const std::wstring& profileName)
+{
+    trace::Span span("gamma", "LoadProfile");
+    span.Arg("display", display).Arg("profile", profileName);
+    const uint64_t start = m_backends.clock.NowMs();
+    const bool loaded = m_backends.gamma.LoadProfile(display, profileName);
+    profile_load_ms.Record(m_backends.clock.NowMs() - start);
+    if (!loaded)
+        profile_load_failures.Add();
+    span.Arg("ok", loaded);
+    return loaded;
+}
+
+bool ColorPipeline::ReadVcp(int display, int vcpCode, int& currentValue, int maxAgeMs)
+{
+    const auto key = std::make_pair(display, vcpCode);
+    {
+        std::lock_guard<std::mutex> lock(m_vcpCacheMutex);
+        m_stats.vcpReads++;
+        vcp_lookups.Add();
+        auto cached = m_vcpCache.find(key);
+        if (cached != m_vcpCache.end() && m_backends.clock.NowMs() - cached->second.readAtMs <= static_cast<uint64_t>(maxAgeMs))
+        {
+            m_stats.vcpCacheHits++;
+            vcp_cache_hits.Add();
+            currentValue = cached->second.value;
+            return true;
+        }
+    }
+
+    trace::Span span("ddc", "GetVcp");
+    span.Arg("display", display).Arg("vcp", vcpCode);
+    const uint64_t start = m_backends.clock.NowMs();
+    const bool read = m_backends.ddc.GetVcp(display, vcpCode, currentValue);
+    vcp_get_ms.Record(m_backends.clock.NowMs() - start);
+    if (!read)
+    {
+        vcp_read_failures.Add();
+        span.Arg("ok", false);
+        return false;
+    }
+    span.Arg("value", currentValue);
+
+    std::lock_guard<std::mutex> lock(m_vcpCacheMutex);
+    m_vcpCache[key] = CachedVcp { currentValue, m_backends.clock.NowMs() };
+    return true;
+}
+
+bool ColorPipeline::WriteVcp(int display, int vcpCode, int value)
+{
+    {
+        // Writes may be dropped by the monitor, so the value is only known after reading it back
+        std::lock_guard<std::mutex> lock(m_vcpCacheMutex);
+        m_vcpCache.erase(std::make_pair(display, vcpCode));
+    }
+    trace::Span span("ddc", "SetVcp");
+    span.Arg("display", display).Arg("vcp", vcpCode).Arg("value", value);
+    const uint64_t start = m_backends.clock.NowMs();
+    const bool written = m_backends.ddc.SetVcp(display, vcpCode, value);
+    vcp_set_ms.Record(m_backends.clock.NowMs() - start);
+    if (!written)
+        vcp_write_failures.Add();
+    span.Arg("ok", written);
+    return written;
+}
+
+void ColorPipeline::InvalidateVcpCache()
+{
+    std::lock_guard<std::mutex> lock(m_vcpCacheMutex);
+    m_vcpCache.clear();
+}
+
+std::vector<ColorPipeline::CachedVcpValue> ColorPipeline::GetVcpCache() const
+{
+    const uint64_t now = m_backends.clock.NowMs();
+    std::lock_guard<std::mutex> lock(m_vcpCacheMutex);
+    std::vector<CachedVcpValue> values;
+    values.reserve(m_vcpCache.size());
+    for (const auto& [key, cached] : m_vcpCache)
+        values.push_back(CachedVcpValue { key.first, key.second, cached.value, now - cached.readAtMs });
+    return values;
+}
+
+/// FNV-1a, over the settings that determine what a display looks like
+static uint64_t HashAppliedSettings(const MonitorSettings& settings, bool hdr)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto add = [&](const void* data, size_t size) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+    };
+    auto addInt = [&](int value) { add(&value, sizeof(value)); };
+
+    addInt(hdr ? 1 : 0);
+    const bool profileEnabled = hdr ? settings.enableHdrProfile : settings.enableSdrProfile;
+    const std::wstring& profile = hdr ? settings.hdrCalibrationName : settings.sdrProfileName;
+    if (profileEnabled)
+        add(profile.data(), profile.size() * sizeof(wchar_t));
+    addInt(hdr ? settings.hdrBrightness : settings.sdrBrightness);
+    addInt(hdr ? settings.hdrRedGain : settings.sdrRedGain);
+    addInt(hdr ? settings.hdrGreenGain : settings.sdrGreenGain);
+    addInt(hdr ? settings.hdrBlueGain : settings.sdrBlueGain);
+    if (hdr && settings.enableColorPresetChange)
+        addInt(settings.hdrColorPreset);
+    return hash;
+}
+
+void ColorPipeline::RecordApplied(const MonitorSettings& settings, bool hdr)
+{
+    std::lock_guard<std::mutex> lock(m_vcpCacheMutex);
+    m_applied[settings.displayId] = AppliedSettings { settings.displayId, hdr, HashAppliedSettings(settings, hdr) };
+}
+
+std::vector<ColorPipeline::AppliedSettings> ColorPipeline::GetAppliedSettings() const
+{
+    std::lock_guard<std::mutex> lock(m_vcpCacheMutex);
+    std::vector<AppliedSettings> applied;
+    applied.reserve(m_applied.size());
+    for (const auto& [display, settings] : m_applied)
+        applied.push_back(settings);
+    return applied;
+}
+
+ColorPipeline::Stats ColorPipeline::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_vcpCacheMutex);
+    return m_stats;
+}
+
+bool ColorPipeline::Prewarm(const std::vector<MonitorSettings>& displays)
+{
+    bool responding = !displays.empty();
+    for (const auto& settings : displays)
+        responding &= PrewarmDisplay(settings);
+    return responding;
+}
+
+bool ColorPipeline::PrewarmDisplay(const MonitorSettings& settings)
+{
+    // Parse the profiles, so the existence/validity checks during the transition hit the cache
+    if (settings.enableSdrProfile && !settings.sdrProfileName.empty())
+        m_backends.gamma.PrepareProfile(settings.sdrProfileName);
+    if (settings.enableHdrProfile && !settings.hdrCalibrationName.empty())
+        m_backends.gamma.PrepareProfile(settings.hdrCalibrationName);
+
+    // Open the DDC/CI channel: the first read also brings the tool into the file cache.
+    // If the monitor doesn't answer, don't bother reading the rest.
+    int value = -1;
+    if (!ReadVcp(settings.displayId, 0x10, value))
+    {
+        logging::Warning(Category::Ddc, "Prewarm: DDC/CI not responding on display {} ({})", settings.displayId,
+                         settings.edidId);
+        return false;
+    }
+    for (int vcpCode : { 0x14, 0x16, 0x18, 0x1A })
+        ReadVcp(settings.displayId, vcpCode, value);
+    return true;
+}
+
+bool ColorPipeline::ApplySDRProfile(const std::vector<MonitorSettings>& displays)
+{
+    if (!CanApply(displays))
+        return false;
+
+    logging::Info(Category::Profile, "Applying SDR profile and settings");
+
+    // Wait for monitor to switch to SDR mode before applying profile
+    // Increased delay from 1s to 3s to ensure monitor is fully stabilized
+    // This fixes the issue where brightness is not applied when switching from HDR->SDR
+    logging::Info(Category::Ddc, "Waiting 3 seconds for monitor to switch to SDR mode...");
+    Sleep(3000);
+
+    // Monitors switch in parallel, so one wait is enough for all of them
+    bool success = true;
+    for (const auto& settings : displays)
+        success &= ApplySDRDisplay(settings);
+    return success;
+}
+
+bool ColorPipeline::ApplySDRDisplay(const MonitorSettings& settings)
+{
+    logging::Info(Category::Ddc, "Applying SDR settings to display {} ({})", settings.displayId, settings.edidId);
+
+    // Load SDR ICC profile (optional - skip if disabled or file doesn't exist)
+    if (settings.enableSdrProfile)
+    {
+        if (!settings.sdrProfileName.empty())
+        {
+            if (m_backends.gamma.PrepareProfile(settings.sdrProfileName))
+            {
+                logging::Info(Category::Profile, "Loading SDR ICC profile...");
+                if (!LoadProfile(settings.displayId, settings.sdrProfileName))
+                {
+                    logging::Warning(Category::Profile, "Failed to load SDR ICC profile");
+                    // Continue anyway - not a critical error
+                }
+            }
+            else
+            {
+                logging::Warning(Category::Profile, "SDR profile not found or not loadable: {} (skipping)",
+                                 settings.sdrProfileName);
+            }
+        }
+        else
+        {
+            logging::Info(Category::Profile, "No SDR profile configured (skipping)");
+        }
+    }
+    else
+    {
+        logging::Info(Category::Profile, "SDR profile disabled (skipping)");
+    }
+
+    if (!EnsureVcp14ColorMode(settings.displayId))
+    {
+        logging::Warning(Category::Ddc, "Aborting SDR color correction because VCP 0x14 could not be ensured");
+        return false;
+    }
+
+    // Apply SDR monitor calibrations via DDC/CI (from config)
+    logging::Info(Category::Ddc, "Applying SDR calibrations (brightness and RGB gains)...");
+    WriteVcp(settings.displayId, 0x10, settings.sdrBrightness);  // Brightness
+    WriteVcp(settings.displayId, 0x16, settings.sdrRedGain);     // Video Gain Red
+    WriteVcp(settings.displayId, 0x18, settings.sdrGreenGain);   // Video Gain Green
+    WriteVcp(settings.displayId, 0x1A, settings.sdrBlueGain);    // Video Gain Blue
+
+    logging::Info(Category::Ddc, "SDR settings applied successfully");
+    RecordApplied(settings, false);
+    return true;
+}
+
+bool ColorPipeline::PrepareForHDR(const std::vector<MonitorSettings>& displays)
+{
+    if (!CanApply(displays))
+        return false;
+
+    logging::Info(Category::Ddc, "Preparing monitor for HDR mode");
+
+    // Wait before starting calibration (same as batch file: timeout 3)
+    Sleep(3000);
+
+    // Set monitor to specific color preset for HDR
+    for (const auto& settings : displays)
+    {
+        logging::Info(Category::Ddc, "Setting HDR color preset on display {} ({})", settings.displayId,
+                      settings.edidId);
+        WriteVcp(settings.displayId, 0x14, settings.hdrColorPreset);
+    }
+
+    return true;
+}
+
+bool ColorPipeline::ApplyHDRCalibration(const std::vector<MonitorSettings>& displays)
+{
+    if (!CanApply(displays))
+        return false;
+
+    logging::Info(Category::Profile, "Applying HDR calibration and settings");
+
+    // NOTE: The caller (NotifyIcon::ToggleHDR) should have already:
+    // 1. Enabled HDR
+    // 2. Called PrepareForHDR() (which waits 3s and sets color preset 0x14) if enableColorPresetChange
+    // 3. Toggled HDR OFF then ON again if enableColorPresetChange
+    // This function continues from that point
+
+    // Wait for monitor to switch to HDR mode before applying profile
+    // Increased delay from 1s to 3s to ensure monitor is fully stabilized
+    // This fixes the issue where brightness is not applied when switching from SDR->HDR
+    // after the system started in HDR mode
+    logging::Info(Category::Ddc, "Waiting 3 seconds for monitor to switch to HDR mode...");
+    Sleep(3000);
+
+    bool success = true;
+    for (const auto& settings : displays)
+        success &= ApplyHDRDisplay(settings);
+    return success;
+}
+
+bool ColorPipeline::ApplyHDRDisplay(const MonitorSettings& settings)
+{
+    logging::Info(Category::Ddc, "Applying HDR settings to display {} ({})", settings.displayId, settings.edidId);
+
+    // Load HDR calibration file (optional - skip if disabled or file doesn't exist)
+    if (settings.enableHdrProfile)
+    {
+        if (!settings.hdrCalibrationName.empty())
+        {
+            if (m_backends.gamma.PrepareProfile(settings.hdrCalibrationName))
+            {
+                logging::Info(Category::Profile, "Loading HDR calibration...");
+                if (!LoadProfile(settings.displayId, settings.hdrCalibrationName))
+                {
+                    logging::Warning(Category::Profile, "Failed to load HDR calibration");
+                    // Continue anyway
+                }
+            }
+            else
+            {
+                logging::Warning(Category::Profile, "HDR calibration not found or not loadable: {} (skipping)",
+                                 settings.hdrCalibrationName);
+            }
+        }
+        else
+        {
+            logging::Info(Category::Profile, "No HDR calibration configured (skipping)");
+        }
+    }
+    else
+    {
+        logging::Info(Category::Profile, "HDR profile disabled (skipping)");
+    }
+
+    // Apply HDR monitor calibrations via DDC/CI (from config)
+    logging::Info(Category::Ddc, "Applying HDR calibrations (brightness and RGB gains)...");
+    WriteVcp(settings.displayId, 0x10, settings.hdrBrightness);  // Brightness
+    WriteVcp(settings.displayId, 0x16, settings.hdrRedGain);     // Video Gain Red
+    WriteVcp(settings.displayId, 0x18, settings.hdrGreenGain);   // Video Gain Green
+    WriteVcp(settings.displayId, 0x1A, settings.hdrBlueGain);    // Video Gain Blue
+
+    logging::Info(Category::Profile, "HDR calibration applied successfully");
+    RecordApplied(settings, true);
+    return true;
+}
+
+bool ColorPipeline::ReapplyHDRColorCorrection(const std::vector<MonitorSettings>& displays, bool force)
+{
+    if (!CanApply(displays))
+        return false;
+
+    logging::Info(Category::Ddc, "Reapplying HDR color correction (DDC/CI only)...");
+
+    bool success = true;
+    for (const auto& settings : displays)
+        success &= ReapplyHDRDisplay(settings, force);
+    return success;
+}
+
+bool ColorPipeline::ReapplyHDRDisplay(const MonitorSettings& settings, bool force)
+{
+    logging::Info(Category::Ddc, "Reapplying HDR settings to display {} ({})", settings.displayId, settings.edidId);
+
+    // The monitor might be "on" but not yet ready to accept/read DDC/CI after signal restore.
+    // Probe using a generally-supported VCP (brightness) and wait a bit.
+    if (!WaitForVcpReadable(settings.displayId, 0x10, /*timeoutMs=*/15000, /*pollMs=*/500))
+    {
+        logging::Warning(Category::Ddc, "DDC/CI not ready (getvcp probe timed out), skipping HDR reapply");
+        return false;
+    }
+
+    if (!force)
+    {
+        int readableCount = 0;
+        bool mismatch = false;
+
+        struct Pair { int code; int desired; };
+        const Pair desired[] = {
+            { 0x10, settings.hdrBrightness },
+            { 0x16, settings.hdrRedGain },
+            { 0x18, settings.hdrGreenGain },
+            { 0x1A, settings.hdrBlueGain },
+        };
+
+        for (const auto& item : desired)
+        {
+            int currentValue = -1;
+            if (!ReadVcp(settings.displayId, item.code, currentValue, kVcpCacheMaxAgeMs))
+                continue;
+            readableCount++;
+            if (currentValue != item.desired)
+            {
+                mismatch = true;
+                break;
+            }
+        }
+
+        // Skip only if we can read *all* relevant values and they match.
+        // If the tool/monitor can't report some VCPs, assume we might still need reapply.
+        if (readableCount == static_cast<int>(std::size(desired)) && !mismatch)
+        {
+            logging::Info(Category::Ddc, "HDR VCP values already match desired settings, skipping reapply");
+            return true;
+        }
+    }
+
+    logging::Info(Category::Ddc, "Applying HDR calibrations (brightness and RGB gains) with verification...");
+    bool success = true;
+    success &= SetMonitorVCPVerified(settings.displayId, 0x10, settings.hdrBrightness);  // Brightness
+    success &= SetMonitorVCPVerified(settings.displayId, 0x16, settings.hdrRedGain);     // Video Gain Red
+    success &= SetMonitorVCPVerified(settings.displayId, 0x18, settings.hdrGreenGain);   // Video Gain Green
+    success &= SetMonitorVCPVerified(settings.displayId, 0x1A, settings.hdrBlueGain);    // Video Gain Blue
+
+    if (success)
+    {
+        logging::Info(Category::Ddc, "HDR color correction reapplied successfully");
+        RecordApplied(settings, true);
+    }
+    else
+    {
+        logging::Warning(Category::Ddc, "Some HDR color corrections may not have been applied correctly");
+    }
+
+    return success;
+}
+
+bool ColorPipeline::ReapplySDRColorCorrection(const std::vector<MonitorSettings>& displays, bool force)
+{
+    if (!CanApply(displays))
+        return false;
+
+    logging::Info(Category::Ddc, "Reapplying SDR color correction (DDC/CI only)...");
+
+    bool success = true;
+    for (const auto& settings : displays)
+        success &= ReapplySDRDisplay(settings, force);
+    return success;
+}
+
+bool ColorPipeline::ReapplySDRDisplay(const MonitorSettings& settings, bool force)
+{
+    logging::Info(Category::Ddc, "Reapplying SDR settings to display {} ({})", settings.displayId, settings.edidId);
+
+    if (!WaitForVcpReadable(settings.displayId, 0x10, /*timeoutMs=*/15000, /*pollMs=*/500))
+    {
+        logging::Warning(Category::Ddc, "DDC/CI not ready (getvcp probe timed out), skipping SDR reapply");
+        return false;
+    }
+
+    if (!force)
+    {
+        int readableCount = 0;
+        bool mismatch = false;
+
+        struct Pair { int code; int desired; };
+        const Pair desired[] = {
+            { 0x10, settings.sdrBrightness },
+            { 0x16, settings.sdrRedGain },
+            { 0x18, settings.sdrGreenGain },
+            { 0x1A, settings.sdrBlueGain },
+        };
+
+        for (const auto& item : desired)
+        {
+            int currentValue = -1;
+            if (!ReadVcp(settings.displayId, item.code, currentValue, kVcpCacheMaxAgeMs))
+                continue;
+            readableCount++;
+            if (currentValue != item.desired)
+            {
+                mismatch = true;
+                break;
+            }
+        }
+
+        if (readableCount == static_cast<int>(std::size(desired)) && !mismatch)
+        {
+            logging::Info(Category::Ddc, "SDR VCP values already match desired settings, skipping reapply");
+            return true;
+        }
+    }
+
+    if (!EnsureVcp14ColorMode(settings.displayId))
+    {
+        logging::Warning(Category::Ddc, "Aborting SDR reapply because VCP 0x14 could not be ensured");
+        return false;
+    }
+
+    logging::Info(Category::Ddc, "Applying SDR calibrations (brightness and RGB gains) with verification...");
+    bool success = true;
+    success &= SetMonitorVCPVerified(settings.displayId, 0x10, settings.sdrBrightness);  // Brightness
+    success &= SetMonitorVCPVerified(settings.displayId, 0x16, settings.sdrRedGain);     // Video Gain Red
+    success &= SetMonitorVCPVerified(settings.displayId, 0x18, settings.sdrGreenGain);   // Video Gain Green
+    success &= SetMonitorVCPVerified(settings.displayId, 0x1A, settings.sdrBlueGain);    // Video Gain Blue
+
+    if (success)
+    {
+        logging::Info(Category::Ddc, "SDR color correction reapplied successfully");
+        RecordApplied(settings, false);
+    }
+    else
+    {
+        logging::Warning(Category::Ddc, "Some SDR color corrections may not have been applied correctly");
+    }
+
+    return success;
+}
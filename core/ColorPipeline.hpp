@@ -0,0 +1,163 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Color Profile Management Extension
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "ColorBackends.hpp"
+#include "MonitorSettings.hpp"
+
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * Profile loading and DDC/CI monitor calibration steps for HDR/SDR transitions.
+ * All platform interaction goes through the backends, so this runs unchanged
+ * in HDRTray and in the transition simulator.
+ */
+class ColorPipeline
+{
+public:
+    explicit ColorPipeline(backend::Set backends);
+
+    /**
+     * Check if the required tools are available
+     * @return true if the profile loader and DDC/CI backends are usable
+     */
+    bool AreToolsAvailable() const;
+
+    /**
+     * Get the settings to apply for each connected display, with displayId set to its current index.
+     * Per-display settings are matched by EDID id, so they follow a display to another port
+     * or position. Without per-display settings, the defaults are used for their displayId.
+     */
+    std::vector<MonitorSettings> ResolveDisplays(const ColorSettings& settings);
+
+    /**
+     * Apply SDR color profile and monitor settings
+     * @return true if successful, false otherwise
+     */
+    bool ApplySDRProfile(const std::vector<MonitorSettings>& displays);
+
+    /**
+     * Prepare monitor for HDR mode by setting color preset
+     * Should be called before toggling HDR on
+     * @return true if successful, false otherwise
+     */
+    bool PrepareForHDR(const std::vector<MonitorSettings>& displays);
+
+    /**
+     * Apply HDR calibration and monitor settings
+     * @return true if successful, false otherwise
+     */
+    bool ApplyHDRCalibration(const std::vector<MonitorSettings>& displays);
+
+    // Reapply color correction (DDC/CI only, no ICC/cal profiles) after monitor reconnection:
+    // - force=true: always reapply (useful after standby/resume where the monitor may glitch without changing VCP values)
+    // - force=false: only reapply if a readable VCP value mismatches the desired settings
+    bool ReapplyHDRColorCorrection(const std::vector<MonitorSettings>& displays, bool force);
+    bool ReapplySDRColorCorrection(const std::vector<MonitorSettings>& displays, bool force);
+
+    /**
+     * Do the preparations for a transition ahead of time: parse the configured profiles,
+     * probe DDC/CI and read the current VCP values into the cache.
+     * May run on a background thread, as long as no other pipeline method runs at the same time.
+     * @param displays Displays to prepare, from ResolveDisplays()
+     * @return true if all monitors answered via DDC/CI
+     */
+    bool Prewarm(const std::vector<MonitorSettings>& displays);
+
+    /**
+     * Forget cached VCP values.
+     * Must be called when the monitor may have changed them on its own (video signal change, power loss).
+     */
+    void InvalidateVcpCache();
+
+    struct Stats
+    {
+        uint64_t vcpReads = 0;
+        /// VCP reads answered from the cache, each saving a DDC/CI transaction
+        uint64_t vcpCacheHits = 0;
+    };
+    Stats GetStats() const;
+
+    struct CachedVcpValue
+    {
+        int display;
+        int vcpCode;
+        int value;
+        /// Time since the value was read from the monitor
+        uint64_t ageMs;
+    };
+    /// Current contents of the VCP cache
+    std::vector<CachedVcpValue> GetVcpCache() const;
+
+    /// Settings applied last to a display
+    struct AppliedSettings
+    {
+        int display;
+        bool hdr;
+        /// Hash of the profile and the monitor settings; changes if any of them change
+        uint64_t hash;
+    };
+    /// Settings applied last, per display; displays nothing was applied to yet are missing
+    std::vector<AppliedSettings> GetAppliedSettings() const;
+
+    backend::Set& GetBackends() { return m_backends; }
+
+private:
+    /// Check tools and displays, logging why nothing can be applied
+    bool CanApply(const std::vector<MonitorSettings>& displays) const;
+    bool ApplySDRDisplay(const MonitorSettings& settings);
+    bool ApplyHDRDisplay(const MonitorSettings& settings);
+    bool ReapplyHDRDisplay(const MonitorSettings& settings, bool force);
+    bool ReapplySDRDisplay(const MonitorSettings& settings, bool force);
+    bool PrewarmDisplay(const MonitorSettings& settings);
+
+    bool SetMonitorVCPVerified(int display, int vcpCode, int value, int maxRetries = 3);
+    bool EnsureVcp14ColorMode(int display);
+    bool WaitForVcpReadable(int display, int vcpCode, int timeoutMs, int pollMs);
+    void Sleep(int milliseconds);
+    bool LoadProfile(int display, const std::wstring& profileName);
+
+    /// Read a VCP value, from the cache if it was read no longer than maxAgeMs ago
+    bool ReadVcp(int display, int vcpCode, int& currentValue, int maxAgeMs = 0);
+    bool WriteVcp(int display, int vcpCode, int value);
+    /// Remember the settings a display was successfully set up with
+    void RecordApplied(const MonitorSettings& settings, bool hdr);
+
+    /// How long a VCP value read from the monitor is trusted without reading it again
+    static constexpr int kVcpCacheMaxAgeMs = 1000;
+
+    backend::Set m_backends;
+
+    struct CachedVcp
+    {
+        int value;
+        uint64_t readAtMs;
+    };
+    /// Guards the VCP cache, the applied settings and the stats
+    mutable std::mutex m_vcpCacheMutex;
+    std::map<std::pair<int, int>, CachedVcp> m_vcpCache;
+    std::map<int, AppliedSettings> m_applied;
+    Stats m_stats;
+};
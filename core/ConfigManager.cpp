@@ -0,0 +1,350 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Configuration Management
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ConfigManager.hpp"
+#include "ConfigSchema.hpp"
+#include "ConfigWatcher.hpp"
+#include "Edid.hpp"
+#include "IniDocument.hpp"
+#include "Log.hpp"
+
+#include <array>
+#include <cwchar>
+#include <cwctype>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <shlwapi.h>
+
+#pragma comment(lib, "shlwapi.lib")
+#endif
+
+namespace {
+
+/// FNV-1a hash of the file contents, to detect actual changes
+uint64_t HashContents(std::string_view bytes)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (unsigned char c : bytes) {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+/// Get the display id from a "Display.<EDID id>" section name
+std::optional<std::wstring> DisplaySectionId(std::wstring_view section)
+{
+    constexpr std::wstring_view prefix = L"Display.";
+    if (section.size() <= prefix.size())
+        return std::nullopt;
+    for (size_t i = 0; i < prefix.size(); i++) {
+        if (std::towlower(section[i]) != std::towlower(prefix[i]))
+            return std::nullopt;
+    }
+    return NormalizeEdidId(section.substr(prefix.size()));
+}
+
+/// Read a setting from the INI, keeping the current value if the key is missing
+void ReadSetting(const IniDocument& ini, std::wstring_view section, std::wstring_view key,
+                 const schema::Setting& setting, MonitorSettings& settings)
+{
+    switch (setting.type) {
+    case schema::Type::Int:
+        settings.*setting.intMember = ini.GetInt(section, key, settings.*setting.intMember);
+        break;
+    case schema::Type::Bool:
+        settings.*setting.boolMember = ini.GetBool(section, key, settings.*setting.boolMember);
+        break;
+    case schema::Type::String:
+        if (const auto value = ini.Find(section, key))
+            (settings.*setting.stringMember).assign(*value);
+        break;
+    }
+}
+
+/// Whether a setting has the same value in both
+bool SameValue(const schema::Setting& setting, const MonitorSettings& a, const MonitorSettings& b)
+{
+    switch (setting.type) {
+    case schema::Type::Int:
+        return a.*setting.intMember == b.*setting.intMember;
+    case schema::Type::Bool:
+        return a.*setting.boolMember == b.*setting.boolMember;
+    case schema::Type::String:
+        return a.*setting.stringMember == b.*setting.stringMember;
+    }
+    return false;
+}
+
+/**
+ * Correct values that can't be right, like ConfigManager::SetMonitorSettings() does: clamp numbers
+ * to their range, and turn off profiles that have no name. The other values are kept.
+ * @return Whether anything had to be corrected
+ */
+bool Correct(MonitorSettings& settings, std::wstring_view section)
+{
+    std::wstring error;
+    if (ConfigManager::Validate(settings, error))
+        return false;
+    if (!section.empty())
+        error = L"[" + std::wstring(section) + L"] " + error;
+    logging::Warning(logging::Category::Config, "Configuration in HDRTray.ini corrected: {}", error);
+
+    schema::Clamp(settings);
+    if (settings.sdrProfileName.empty())
+        settings.enableSdrProfile = false;
+    if (settings.hdrCalibrationName.empty())
+        settings.enableHdrProfile = false;
+    return true;
+}
+
+} // namespace
+
+ConfigManager::ConfigManager()
+    : m_snapshot(std::make_shared<const ColorSettings>())
+{
+    // Get config file path (in the same directory as the executable)
+    m_configFilePath = (std::filesystem::path(GetExecutablePath()) / L"HDRTray.ini").wstring();
+}
+
+ConfigManager::ConfigManager(std::wstring configFilePath)
+    : m_configFilePath(std::move(configFilePath))
+    , m_snapshot(std::make_shared<const ColorSettings>())
+{
+}
+
+ConfigManager::~ConfigManager()
+{
+    StopWatching();
+}
+
+std::wstring ConfigManager::GetExecutablePath()
+{
+#if defined(_WIN32)
+    wchar_t path[MAX_PATH];
+    GetModuleFileNameW(nullptr, path, MAX_PATH);
+    PathRemoveFileSpecW(path);
+    return std::wstring(path);
+#else
+    std::error_code ec;
+    return std::filesystem::read_symlink("/proc/self/exe", ec).parent_path().wstring();
+#endif
+}
+
+bool ConfigManager::Load()
+{
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    m_stats.loads++;
+
+    // Check if config file exists
+    std::error_code ec;
+    if (!std::filesystem::exists(m_configFilePath, ec))
+    {
+        // Create default config
+        return SaveLocked();
+    }
+
+    const auto bytes = IniDocument::ReadBytes(m_configFilePath);
+    if (!bytes)
+        return false;
+
+    // Nothing to do if the contents didn't change, eg when the watcher sees our own Save()
+    const uint64_t hash = HashContents(*bytes);
+    if (hash == m_contentHash)
+        return true;
+    m_stats.parses++;
+
+    // Parse the whole file once
+    IniDocument ini;
+    ini.Parse(*bytes);
+
+    auto settings = std::make_shared<ColorSettings>();
+    auto& defaults = settings->defaults;
+    for (const auto& setting : schema::kSettings)
+        ReadSetting(ini, setting.section, setting.key, setting, defaults);
+
+    // Broken values are corrected, eg while the file is being edited, so the rest of the file still applies
+    bool corrected = Correct(defaults, {});
+
+    // Per-display settings; values not given are taken from the sections above
+    for (const auto section : ini.GetSectionNames()) {
+        const auto id = DisplaySectionId(section);
+        if (!id || settings->displays.contains(*id))
+            continue;
+
+        MonitorSettings display = defaults;
+        display.edidId = *id;
+        for (const auto& setting : schema::kSettings) {
+            if (!setting.displayKey.empty())
+                ReadSetting(ini, section, setting.displayKey, setting, display);
+        }
+        corrected = Correct(display, section) || corrected;
+        settings->displays.emplace(*id, std::move(display));
+    }
+    if (corrected)
+        m_stats.corrected++;
+
+    // Corrections aren't saved, only changes made later
+    m_fileDefaults = settings->defaults;
+    m_snapshot.Store(std::move(settings));
+    m_contentHash = hash;
+    logging::Info(logging::Category::Config, "Configuration reloaded from HDRTray.ini ({} per-display sections)",
+                  GetSnapshot()->displays.size());
+    return true;
+}
+
+bool ConfigManager::Save()
+{
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    return SaveLocked();
+}
+
+bool ConfigManager::SaveLocked()
+{
+    // Only the defaults can be changed from HDRTray, [Display.<id>] sections are kept as they are
+    const auto snapshot = GetSnapshot();
+    const auto& settings = snapshot->defaults;
+
+    // Start from the current file contents, so comments and unknown keys are kept
+    const auto current = IniDocument::ReadBytes(m_configFilePath);
+    IniDocument ini;
+    if (current)
+        ini.Parse(*current);
+    else
+        ini.ParseText(schema::DefaultFileText(), IniDocument::Encoding::Utf16LE);
+
+    // Only write values changed since the file was last loaded or saved, so edits to the file that weren't
+    // loaded yet are kept. Without an earlier load, or a file, compare with what the document has now.
+    MonitorSettings previous;
+    if (current && m_fileDefaults) {
+        previous = *m_fileDefaults;
+    } else {
+        for (const auto& setting : schema::kSettings)
+            ReadSetting(ini, setting.section, setting.key, setting, previous);
+    }
+
+    // Values are formatted into local buffers and applied in one pass
+    std::array<IniDocument::Assignment, schema::kSettingCount> values;
+    wchar_t numbers[schema::kSettingCount][12];
+    size_t count = 0;
+    for (size_t i = 0; i < schema::kSettingCount; i++) {
+        const auto& setting = schema::kSettings[i];
+        if (SameValue(setting, settings, previous))
+            continue;
+        std::wstring_view value;
+        switch (setting.type) {
+        case schema::Type::Int:
+            value = std::wstring_view(numbers[i], std::swprintf(numbers[i], std::size(numbers[i]), L"%d",
+                                                                 settings.*setting.intMember));
+            break;
+        case schema::Type::Bool:
+            value = settings.*setting.boolMember ? L"1" : L"0";
+            break;
+        case schema::Type::String:
+            value = settings.*setting.stringMember;
+            break;
+        }
+        values[count++] = { setting.section, setting.key, value };
+    }
+    ini.Set(std::span(values.data(), count));
+
+    // Single write, replacing the file atomically
+    const std::string bytes = ini.Serialize();
+    if (!IniDocument::WriteBytes(m_configFilePath, bytes))
+        return false;
+    // The watcher will report this write; the hash tells Load() there's nothing new.
+    // Unless the file had changes that weren't loaded yet: then the next Load() has to pick them up.
+    if (!current || HashContents(*current) == m_contentHash) {
+        m_contentHash = HashContents(bytes);
+        m_fileDefaults = settings;
+    } else {
+        m_contentHash = 0;
+    }
+    return true;
+}
+
+bool ConfigManager::StartWatching()
+{
+    if (!m_watcher)
+        m_watcher = std::make_unique<ConfigWatcher>(m_configFilePath, [this]() { Load(); });
+    return m_watcher->IsWatching();
+}
+
+void ConfigManager::StopWatching()
+{
+    m_watcher.reset();
+}
+
+void ConfigManager::SetMonitorSettings(const MonitorSettings& settings)
+{
+    // Keeps the per-display settings, even if a reload replaces them at the same time
+    m_snapshot.Update([&](ColorSettings& current) {
+        current.defaults = settings;
+        schema::Clamp(current.defaults);
+    });
+}
+
+bool ConfigManager::UpdateMonitorSettings(const std::function<void(MonitorSettings&)>& modify)
+{
+    // No reload between changing and saving
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    m_snapshot.Update([&](ColorSettings& current) {
+        modify(current.defaults);
+        schema::Clamp(current.defaults);
+    });
+    return SaveLocked();
+}
+
+bool ConfigManager::Validate(const MonitorSettings& settings, std::wstring& error)
+{
+    for (const auto& setting : schema::kSettings) {
+        if (setting.type != schema::Type::Int)
+            continue;
+        const int value = settings.*setting.intMember;
+        if (value < setting.min || value > setting.max) {
+            error = L"[" + std::wstring(setting.section) + L"] " + std::wstring(setting.key) + L" must be between "
+                    + std::to_wstring(setting.min) + L" and " + std::to_wstring(setting.max);
+            return false;
+        }
+    }
+
+    if (settings.enableSdrProfile && settings.sdrProfileName.empty()) {
+        error = L"SDRProfile is empty, but EnableSDRProfile is set";
+        return false;
+    }
+    if (settings.enableHdrProfile && settings.hdrCalibrationName.empty()) {
+        error = L"HDRCalibration is empty, but EnableHDRProfile is set";
+        return false;
+    }
+    return true;
+}
+
+ConfigManager::Stats ConfigManager::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    return m_stats;
+}
@@ -0,0 +1,139 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Configuration Management
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "MonitorSettings.hpp"
+#include "SnapshotCell.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+class ConfigWatcher;
+
+/**
+ * Configuration manager for HDRTray color profile settings.
+ * Uses an INI file to store user preferences.
+ *
+ * Settings are published as immutable snapshots. With StartWatching(), changes
+ * to the INI file are picked up in the background, so readers never have to
+ * touch the file.
+ */
+class ConfigManager : public SettingsSource
+{
+public:
+    using MonitorSettings = ::MonitorSettings;
+
+    /// Use HDRTray.ini next to the executable
+    ConfigManager();
+    explicit ConfigManager(std::wstring configFilePath);
+    ~ConfigManager() override;
+
+    /**
+     * Load configuration from INI file.
+     * The file is only parsed if its contents changed since it was last loaded or saved.
+     * Values that fail validation are corrected like SetMonitorSettings() does, with a warning;
+     * the other values in the file still apply.
+     * @return true if successful
+     */
+    bool Load();
+
+    /**
+     * Save configuration to INI file.
+     * Only values changed since the file was last loaded or saved are written; everything else in the file is kept.
+     * @return true if successful
+     */
+    bool Save();
+
+    /**
+     * Watch the INI file, calling Load() in the background whenever it changes
+     * @return true if change notifications are available
+     */
+    bool StartWatching();
+    void StopWatching();
+
+    SettingsSnapshot GetSnapshot() const override { return m_snapshot.Load(); }
+
+    /**
+     * Get a copy of the current default monitor settings
+     */
+    MonitorSettings GetMonitorSettings() const { return GetSnapshot()->defaults; }
+
+    /**
+     * Set default monitor settings, publishing a new snapshot.
+     * Values outside their valid range are clamped.
+     */
+    void SetMonitorSettings(const MonitorSettings& settings);
+
+    /**
+     * Change the default monitor settings and save them, clamping values to their valid range.
+     * Unlike GetMonitorSettings() followed by SetMonitorSettings(), a reload in between can't get lost.
+     * @return true if saving was successful
+     */
+    bool UpdateMonitorSettings(const std::function<void(MonitorSettings&)>& modify);
+
+    /// Contention on the settings snapshot
+    SnapshotCell<ColorSettings>::Stats GetSnapshotStats() const { return m_snapshot.GetStats(); }
+
+    /**
+     * Check settings for values that can't be right, ie outside the range given by the settings schema
+     * @param error Receives a description of the first problem found
+     * @return true if the settings are usable
+     */
+    static bool Validate(const MonitorSettings& settings, std::wstring& error);
+
+    struct Stats
+    {
+        uint64_t loads = 0;
+        /// Loads that actually parsed the file, because its contents changed
+        uint64_t parses = 0;
+        /// Parsed files with values that failed validation and were corrected
+        uint64_t corrected = 0;
+    };
+    Stats GetStats() const;
+
+    /**
+     * Get config file path
+     */
+    std::wstring GetConfigFilePath() const { return m_configFilePath; }
+
+private:
+    std::wstring m_configFilePath;
+    SnapshotCell<ColorSettings> m_snapshot;
+
+    /// Serializes Load() and Save(), which may run on the watcher thread and the UI thread
+    mutable std::mutex m_fileMutex;
+    /// Hash of the file contents last loaded or saved; 0 if none
+    uint64_t m_contentHash = 0;
+    /// Default settings as last loaded from or saved to the file; nothing if neither happened
+    std::optional<MonitorSettings> m_fileDefaults;
+    Stats m_stats;
+
+    std::unique_ptr<ConfigWatcher> m_watcher;
+
+    static std::wstring GetExecutablePath();
+    /// Save() with m_fileMutex held
+    bool SaveLocked();
+};
@@ -0,0 +1,61 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Configuration Management
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "ConfigSchema.hpp"
+
+#include <algorithm>
+
+MonitorSettings::MonitorSettings()
+{
+    schema::ApplyDefaults(*this);
+}
+
+namespace schema {
+
+void ApplyDefaults(MonitorSettings& settings)
+{
+    for (const auto& setting : kSettings) {
+        switch (setting.type) {
+        case Type::Int:
+            settings.*setting.intMember = setting.defaultValue;
+            break;
+        case Type::Bool:
+            settings.*setting.boolMember = setting.defaultValue != 0;
+            break;
+        case Type::String:
+            settings.*setting.stringMember = setting.defaultString;
+            break;
+        }
+    }
+}
+
+void Clamp(MonitorSettings& settings)
+{
+    for (const auto& setting : kSettings) {
+        if (setting.type == Type::Int) {
+            auto& value = settings.*setting.intMember;
+            value = std::clamp(value, setting.min, setting.max);
+        }
+    }
+}
+
+} // namespace schema
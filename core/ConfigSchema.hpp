@@ -0,0 +1,288 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Configuration Management
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "MonitorSettings.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Description of the settings stored in HDRTray.ini.
+ * This table is the only place that knows keys, defaults and valid ranges:
+ * loading, saving and validating settings, the MonitorSettings defaults and
+ * the contents of a newly created HDRTray.ini all derive from it.
+ */
+namespace schema {
+
+enum class Type : uint8_t
+{
+    Int,
+    Bool,
+    String
+};
+
+struct Setting
+{
+    std::wstring_view section {};
+    std::wstring_view key {};
+    /// Key in [Display.<EDID id>] sections; empty if the setting can't be changed per display
+    std::wstring_view displayKey {};
+    Type type = Type::Int;
+
+    // Member holding the value, the one matching the type is set
+    int MonitorSettings::*intMember = nullptr;
+    bool MonitorSettings::*boolMember = nullptr;
+    std::wstring MonitorSettings::*stringMember = nullptr;
+
+    /// Default of Int and Bool (0 or 1) settings
+    int defaultValue = 0;
+    /// Default of String settings
+    std::wstring_view defaultString {};
+    /// Valid values of Int settings
+    int min = 0;
+    int max = 0;
+    /// VCP code the value is written to over DDC/CI; 0 if none
+    uint8_t vcpCode = 0;
+
+    /// Comment put above the key in a new HDRTray.ini; may be empty
+    std::wstring_view comment {};
+};
+
+constexpr Setting Int(std::wstring_view section, std::wstring_view key, std::wstring_view displayKey,
+                      int MonitorSettings::*member, int defaultValue, int min, int max, uint8_t vcpCode,
+                      std::wstring_view comment)
+{
+    Setting setting { section, key, displayKey, Type::Int };
+    setting.intMember = member;
+    setting.defaultValue = defaultValue;
+    setting.min = min;
+    setting.max = max;
+    setting.vcpCode = vcpCode;
+    setting.comment = comment;
+    return setting;
+}
+
+constexpr Setting Bool(std::wstring_view section, std::wstring_view key, bool MonitorSettings::*member,
+                       bool defaultValue, std::wstring_view comment)
+{
+    Setting setting { section, key, {}, Type::Bool };
+    setting.boolMember = member;
+    setting.defaultValue = defaultValue ? 1 : 0;
+    setting.min = 0;
+    setting.max = 1;
+    setting.comment = comment;
+    return setting;
+}
+
+constexpr Setting String(std::wstring_view section, std::wstring_view key, std::wstring_view displayKey,
+                         std::wstring MonitorSettings::*member, std::wstring_view defaultString,
+                         std::wstring_view comment)
+{
+    Setting setting { section, key, displayKey, Type::String };
+    setting.stringMember = member;
+    setting.defaultString = defaultString;
+    setting.comment = comment;
+    return setting;
+}
+
+// Continuous VCP controls are written as percentage; VCP 0x14 takes a single byte
+inline constexpr Setting kSettings[] = {
+    Int(L"Monitor", L"DisplayId", {}, &MonitorSettings::displayId, 1, 1, 99, 0,
+        L"Display ID (usually 1 for primary monitor)"),
+
+    Bool(L"Profiles", L"EnableColorManagement", &MonitorSettings::enableColorManagement, true,
+         L"Master toggle for ALL color management features (1=enabled, 0=disabled)"),
+    String(L"Profiles", L"SDRProfile", L"SDRProfile", &MonitorSettings::sdrProfileName, L"Xiaomi 27i Pro_Rtings.icm",
+           L"ICC profile loaded in SDR mode"),
+    String(L"Profiles", L"HDRCalibration", L"HDRCalibration", &MonitorSettings::hdrCalibrationName,
+           L"xiaomi_miniled_1d.cal", L"Calibration loaded in HDR mode"),
+    Bool(L"Profiles", L"EnableSDRProfile", &MonitorSettings::enableSdrProfile, true,
+         L"Enable/disable profile loading (1=enabled, 0=disabled)"),
+    Bool(L"Profiles", L"EnableHDRProfile", &MonitorSettings::enableHdrProfile, true, {}),
+    Bool(L"Profiles", L"EnableColorPresetChange", &MonitorSettings::enableColorPresetChange, false,
+         L"Enable/disable color preset change with HDR toggle (requires extra OFF/ON cycle)"),
+
+    Int(L"SDR", L"Brightness", L"SDRBrightness", &MonitorSettings::sdrBrightness, 50, 0, 100, 0x10,
+        L"SDR mode brightness"),
+    Int(L"SDR", L"RedGain", L"SDRRedGain", &MonitorSettings::sdrRedGain, 50, 0, 100, 0x16, L"SDR mode red gain"),
+    Int(L"SDR", L"GreenGain", L"SDRGreenGain", &MonitorSettings::sdrGreenGain, 49, 0, 100, 0x18,
+        L"SDR mode green gain"),
+    Int(L"SDR", L"BlueGain", L"SDRBlueGain", &MonitorSettings::sdrBlueGain, 49, 0, 100, 0x1A, L"SDR mode blue gain"),
+
+    Int(L"HDR", L"Brightness", L"HDRBrightness", &MonitorSettings::hdrBrightness, 100, 0, 100, 0x10,
+        L"HDR mode brightness"),
+    Int(L"HDR", L"RedGain", L"HDRRedGain", &MonitorSettings::hdrRedGain, 46, 0, 100, 0x16, L"HDR mode red gain"),
+    Int(L"HDR", L"GreenGain", L"HDRGreenGain", &MonitorSettings::hdrGreenGain, 49, 0, 100, 0x18,
+        L"HDR mode green gain"),
+    Int(L"HDR", L"BlueGain", L"HDRBlueGain", &MonitorSettings::hdrBlueGain, 49, 0, 100, 0x1A, L"HDR mode blue gain"),
+    Int(L"HDR", L"ColorPreset", L"HDRColorPreset", &MonitorSettings::hdrColorPreset, 12, 0, 255, 0x14,
+        L"Color preset, specific to your monitor"),
+};
+
+inline constexpr size_t kSettingCount = std::size(kSettings);
+
+/// Set all values described by the schema to their defaults
+void ApplyDefaults(MonitorSettings& settings);
+/// Bring Int values into their valid range
+void Clamp(MonitorSettings& settings);
+
+namespace detail {
+
+/// Writes text to a buffer, or only counts characters if there is none
+struct TextWriter
+{
+    wchar_t* out = nullptr;
+    size_t size = 0;
+
+    constexpr void Put(wchar_t c)
+    {
+        if (out)
+            out[size] = c;
+        size++;
+    }
+    constexpr void Put(std::wstring_view str)
+    {
+        for (wchar_t c : str)
+            Put(c);
+    }
+    constexpr void PutInt(int value)
+    {
+        if (value < 0)
+            Put(L'-');
+        unsigned magnitude = value < 0 ? 0u - static_cast<unsigned>(value) : static_cast<unsigned>(value);
+        unsigned divisor = 1;
+        while (magnitude / divisor >= 10)
+            divisor *= 10;
+        for (; divisor > 0; divisor /= 10)
+            Put(static_cast<wchar_t>(L'0' + magnitude / divisor % 10));
+    }
+    constexpr void PutHex(uint8_t value)
+    {
+        constexpr std::wstring_view digits = L"0123456789ABCDEF";
+        Put(L"0x");
+        Put(digits[value >> 4]);
+        Put(digits[value & 0xF]);
+    }
+    constexpr void EndLine() { Put(L"\r\n"); }
+};
+
+constexpr void WriteDefaultFile(TextWriter& w)
+{
+    w.Put(L"; HDRTray Configuration File");
+    w.EndLine();
+    w.Put(L"; Edit these values to customize your monitor settings");
+    w.EndLine();
+
+    std::wstring_view section;
+    for (const auto& setting : kSettings) {
+        if (setting.section != section) {
+            section = setting.section;
+            w.EndLine();
+            w.Put(L'[');
+            w.Put(section);
+            w.Put(L']');
+            w.EndLine();
+        }
+        if (!setting.comment.empty()) {
+            w.Put(L"; ");
+            w.Put(setting.comment);
+            if (setting.vcpCode != 0) {
+                w.Put(L" (VCP ");
+                w.PutHex(setting.vcpCode);
+                w.Put(L", ");
+                w.PutInt(setting.min);
+                w.Put(L'-');
+                w.PutInt(setting.max);
+                w.Put(L')');
+            }
+            w.EndLine();
+        }
+        w.Put(setting.key);
+        w.Put(L'=');
+        if (setting.type == Type::String)
+            w.Put(setting.defaultString);
+        else
+            w.PutInt(setting.defaultValue);
+        w.EndLine();
+    }
+
+    w.EndLine();
+    w.Put(L"; Settings for a single display go into a [Display.<EDID id>] section, eg [Display.DEL4123-0000ABCD].");
+    w.EndLine();
+    w.Put(L"; Possible keys:");
+    for (const auto& setting : kSettings) {
+        if (!setting.displayKey.empty()) {
+            w.Put(L' ');
+            w.Put(setting.displayKey);
+        }
+    }
+    w.EndLine();
+}
+
+constexpr auto MakeDefaultFile()
+{
+    constexpr size_t size = [] {
+        TextWriter counter;
+        WriteDefaultFile(counter);
+        return counter.size;
+    }();
+    std::array<wchar_t, size> text {};
+    TextWriter writer { text.data() };
+    WriteDefaultFile(writer);
+    return text;
+}
+
+constexpr bool SettingsAreValid()
+{
+    for (size_t i = 0; i < kSettingCount; i++) {
+        const auto& setting = kSettings[i];
+        const bool memberOk = (setting.type == Type::Int && setting.intMember)
+                              || (setting.type == Type::Bool && setting.boolMember)
+                              || (setting.type == Type::String && setting.stringMember);
+        if (!memberOk || setting.min > setting.max || setting.defaultValue < setting.min
+            || setting.defaultValue > setting.max)
+            return false;
+        // Settings of a section must be consecutive, so each section is written once
+        for (size_t j = i + 1; j < kSettingCount; j++) {
+            if (kSettings[j].section == setting.section && kSettings[j - 1].section != setting.section)
+                return false;
+        }
+    }
+    return true;
+}
+
+} // namespace detail
+
+static_assert(detail::SettingsAreValid(), "Inconsistent settings schema");
+
+/// Contents of a new HDRTray.ini, with all settings at their defaults
+inline constexpr auto kDefaultFileText = detail::MakeDefaultFile();
+
+constexpr std::wstring_view DefaultFileText()
+{
+    return std::wstring_view(kDefaultFileText.data(), kDefaultFileText.size());
+}
+
+} // namespace schema
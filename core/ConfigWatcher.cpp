@@ -0,0 +1,265 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Configuration Management
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ConfigWatcher.hpp"
+#include "Log.hpp"
+
+#include <algorithm>
+#include <string>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <cstdint>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Deadline while no callback is pending
+constexpr Clock::time_point kNoDeadline = Clock::time_point::max();
+
+/// Time left until a pending callback is due, in milliseconds; -1 (wait forever) if none is pending
+long long TimeoutMs(Clock::time_point deadline)
+{
+    if (deadline == kNoDeadline)
+        return -1;
+    const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+    return std::max<long long>(left, 0);
+}
+
+std::filesystem::path WatchedDirectory(const std::filesystem::path& file)
+{
+    auto directory = file.parent_path();
+    return directory.empty() ? std::filesystem::path(".") : directory;
+}
+
+} // namespace
+
+ConfigWatcher::ConfigWatcher(std::filesystem::path file, Callback callback, std::chrono::milliseconds settleTime)
+    : m_file(std::move(file))
+    , m_callback(std::move(callback))
+    , m_settleTime(settleTime)
+{
+    if (Open()) {
+        m_thread = std::thread(&ConfigWatcher::Run, this);
+    } else {
+        logging::Warning(logging::Category::Config, "ConfigWatcher: Can't watch {} for changes", m_file.native());
+        Close();
+    }
+}
+
+ConfigWatcher::~ConfigWatcher()
+{
+    if (m_thread.joinable()) {
+#if defined(_WIN32)
+        SetEvent(m_stopEvent);
+#elif defined(__linux__)
+        const uint64_t one = 1;
+        [[maybe_unused]] auto written = write(m_stopFd, &one, sizeof(one));
+#endif
+        m_thread.join();
+    }
+    Close();
+}
+
+#if defined(_WIN32)
+
+bool ConfigWatcher::Open()
+{
+    HANDLE directory = CreateFileW(WatchedDirectory(m_file).c_str(), FILE_LIST_DIRECTORY,
+                                   FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                   FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (directory == INVALID_HANDLE_VALUE)
+        return false;
+    m_directory = directory;
+
+    m_stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    return m_stopEvent != nullptr;
+}
+
+void ConfigWatcher::Run()
+{
+    const std::wstring name = m_file.filename().wstring();
+    HANDLE directory = m_directory;
+
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!overlapped.hEvent)
+        return;
+
+    alignas(DWORD) BYTE buffer[4096];
+    bool reading = false;
+    // Set when the file changed: call back once no further change was seen until then
+    Clock::time_point deadline = kNoDeadline;
+
+    while (true) {
+        if (!reading) {
+            ResetEvent(overlapped.hEvent);
+            if (!ReadDirectoryChangesW(directory, buffer, sizeof(buffer), FALSE,
+                                       FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE
+                                           | FILE_NOTIFY_CHANGE_LAST_WRITE,
+                                       nullptr, &overlapped, nullptr)) {
+                logging::Warning(logging::Category::Config, "ConfigWatcher: ReadDirectoryChangesW failed: {}",
+                                 GetLastError());
+                break;
+            }
+            reading = true;
+        }
+
+        const HANDLE handles[] = { m_stopEvent, overlapped.hEvent };
+        const long long timeout = TimeoutMs(deadline);
+        const DWORD wait = WaitForMultipleObjects(2, handles, FALSE,
+                                                  timeout < 0 ? INFINITE : static_cast<DWORD>(timeout));
+        if (wait == WAIT_TIMEOUT) {
+            deadline = kNoDeadline;
+            m_callback();
+            continue;
+        }
+        if (wait != WAIT_OBJECT_0 + 1) // Stop requested, or error
+            break;
+
+        reading = false;
+        DWORD size = 0;
+        if (!GetOverlappedResult(directory, &overlapped, &size, FALSE))
+            break;
+        if (size == 0) {
+            // Buffer overflow, so changes were lost: assume the file was among them
+            deadline = Clock::now() + m_settleTime;
+            continue;
+        }
+        auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buffer);
+        while (true) {
+            const int length = static_cast<int>(info->FileNameLength / sizeof(wchar_t));
+            if (CompareStringOrdinal(info->FileName, length, name.data(), static_cast<int>(name.size()), TRUE)
+                == CSTR_EQUAL)
+                deadline = Clock::now() + m_settleTime;
+            if (info->NextEntryOffset == 0)
+                break;
+            info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(reinterpret_cast<const BYTE*>(info)
+                                                                     + info->NextEntryOffset);
+        }
+    }
+
+    if (reading) {
+        CancelIoEx(directory, &overlapped);
+        DWORD size = 0;
+        GetOverlappedResult(directory, &overlapped, &size, TRUE);
+    }
+    CloseHandle(overlapped.hEvent);
+}
+
+void ConfigWatcher::Close()
+{
+    if (m_directory) {
+        CloseHandle(m_directory);
+        m_directory = nullptr;
+    }
+    if (m_stopEvent) {
+        CloseHandle(m_stopEvent);
+        m_stopEvent = nullptr;
+    }
+}
+
+#elif defined(__linux__)
+
+bool ConfigWatcher::Open()
+{
+    m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotify < 0)
+        return false;
+    constexpr uint32_t mask = IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+    if (inotify_add_watch(m_inotify, WatchedDirectory(m_file).c_str(), mask) < 0)
+        return false;
+
+    m_stopFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    return m_stopFd >= 0;
+}
+
+void ConfigWatcher::Run()
+{
+    const std::string name = m_file.filename().string();
+
+    alignas(inotify_event) char buffer[4096];
+    // Set when the file changed: call back once no further change was seen until then
+    Clock::time_point deadline = kNoDeadline;
+
+    while (true) {
+        pollfd fds[] = { { m_stopFd, POLLIN, 0 }, { m_inotify, POLLIN, 0 } };
+        const int ready = poll(fds, 2, static_cast<int>(TimeoutMs(deadline)));
+        if (ready < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        if (ready == 0) {
+            deadline = kNoDeadline;
+            m_callback();
+            continue;
+        }
+        if (fds[0].revents != 0) // Stop requested
+            break;
+
+        ssize_t size;
+        while ((size = read(m_inotify, buffer, sizeof(buffer))) > 0) {
+            for (ssize_t offset = 0; offset < size;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                // On overflow, changes were lost: assume the file was among them
+                if ((event->mask & IN_Q_OVERFLOW) != 0 || (event->len > 0 && name == event->name))
+                    deadline = Clock::now() + m_settleTime;
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            }
+        }
+    }
+}
+
+void ConfigWatcher::Close()
+{
+    if (m_inotify >= 0) {
+        close(m_inotify);
+        m_inotify = -1;
+    }
+    if (m_stopFd >= 0) {
+        close(m_stopFd);
+        m_stopFd = -1;
+    }
+}
+
+#else
+
+// No change notifications: settings are only reloaded on explicit request
+
+bool ConfigWatcher::Open()
+{
+    return false;
+}
+
+void ConfigWatcher::Run() { }
+
+void ConfigWatcher::Close() { }
+
+#endif
@@ -0,0 +1,73 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Configuration Management
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <thread>
+
+/**
+ * Watches a file for changes.
+ * Uses directory change notifications on Windows and inotify on Linux, so the
+ * file is not polled. Watching the directory instead of the file itself also
+ * catches editors (and IniDocument::WriteFile()) replacing the file.
+ *
+ * The callback runs on a background thread once changes have settled, ie no
+ * further change was seen for the settle time. It can also be called when the
+ * contents didn't change, eg when the file was only touched.
+ */
+class ConfigWatcher
+{
+public:
+    using Callback = std::function<void()>;
+
+    ConfigWatcher(std::filesystem::path file, Callback callback,
+                  std::chrono::milliseconds settleTime = std::chrono::milliseconds(100));
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    /// Whether change notifications could be set up
+    bool IsWatching() const { return m_thread.joinable(); }
+
+private:
+    std::filesystem::path m_file;
+    Callback m_callback;
+    std::chrono::milliseconds m_settleTime;
+    std::thread m_thread;
+
+#if defined(_WIN32)
+    // Directory and "stop" event handles
+    void* m_directory = nullptr;
+    void* m_stopEvent = nullptr;
+#elif defined(__linux__)
+    // inotify instance and "stop" eventfd
+    int m_inotify = -1;
+    int m_stopFd = -1;
+#endif
+
+    bool Open();
+    void Run();
+    void Close();
+};
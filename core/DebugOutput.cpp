@@ -0,0 +1,41 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "DebugOutput.hpp"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+void DebugOutput(const wchar_t* message)
+{
+    OutputDebugStringW(message);
+}
+#else
+#include <cstdio>
+#include <cstdlib>
+
+void DebugOutput(const wchar_t* message)
+{
+    static const bool enabled = std::getenv("HDRTRAY_DEBUG") != nullptr;
+    if (enabled)
+        std::fprintf(stderr, "%ls", message);
+}
+#endif
@@ -0,0 +1,105 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DISPLAYCONFIGBACKEND_HPP_
+#define DISPLAYCONFIGBACKEND_HPP_
+
+#include "HDR.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace hdr {
+
+/// DISPLAYCONFIG_GET_ADVANCED_COLOR_INFO
+struct AdvancedColorInfo
+{
+    bool advancedColorSupported = false;
+    /// Also set in WCG mode, ie with "Automatic color management" on
+    bool advancedColorEnabled = false;
+    /// Set in WCG mode
+    bool wideColorEnforced = false;
+    uint32_t bitsPerColorChannel = 0;
+};
+
+/// DISPLAYCONFIG_GET_ADVANCED_COLOR_INFO_2 (Windows 11 24H2 and later)
+struct AdvancedColorInfo2
+{
+    bool highDynamicRangeSupported = false;
+    ColorMode activeColorMode = ColorMode::Sdr;
+    uint32_t bitsPerColorChannel = 0;
+};
+
+/// DISPLAYCONFIG_TARGET_DEVICE_NAME
+struct TargetName
+{
+    std::wstring monitorFriendlyDeviceName;
+    bool friendlyNameFromEdid = false;
+    /// Manufacturer id and product code from the EDID, if known. Manufacturer id in EDID byte order (big endian).
+    std::optional<uint16_t> edidManufactureId;
+    std::optional<uint16_t> edidProductCodeId;
+    std::wstring monitorDevicePath;
+};
+
+/**
+ * Access to the display configuration API (QueryDisplayConfig(), DisplayConfigGetDeviceInfo(),
+ * DisplayConfigSetDeviceInfo()).
+ * The hdr:: functions only talk to displays through this interface, so they can run against
+ * a fake display configuration, eg for benchmarks.
+ * Calls are made with the hdr:: display cache lock held, so they are never concurrent.
+ */
+class DisplayConfigBackend
+{
+public:
+    virtual ~DisplayConfigBackend() = default;
+
+    /// Whether GetAdvancedColorInfo2() and SetHdrState() are available (Windows 11 24H2 and later)
+    virtual bool HasHdrStateFunctions() const = 0;
+
+    /**
+     * Get the targets of all active display paths
+     * @return false if querying the display configuration failed
+     */
+    virtual bool QueryActiveTargets(std::vector<DisplayId>& targets) = 0;
+
+    // Device info queries; nothing if the query failed
+    virtual std::optional<AdvancedColorInfo> GetAdvancedColorInfo(const DisplayId& target) = 0;
+    virtual std::optional<AdvancedColorInfo2> GetAdvancedColorInfo2(const DisplayId& target) = 0;
+    virtual std::optional<TargetName> GetTargetName(const DisplayId& target) = 0;
+    /// Whether the display is built in (DISPLAYCONFIG_TARGET_BASE_TYPE)
+    virtual std::optional<bool> IsInternalDisplay(const DisplayId& target) = 0;
+    /// Brightness of SDR content in HDR mode, in thousandths of 80 nits (DISPLAYCONFIG_SDR_WHITE_LEVEL)
+    virtual std::optional<uint32_t> GetSdrWhiteLevel(const DisplayId& target) = 0;
+
+    // Device changes; return whether the call succeeded
+    virtual bool SetHdrState(const DisplayId& target, bool enable) = 0;
+    virtual bool SetAdvancedColorState(const DisplayId& target, bool enable) = 0;
+};
+
+/**
+ * Set the backend used by the hdr:: functions, and invalidate the display cache.
+ * nullptr selects the default: the Windows display configuration API on Windows, none elsewhere.
+ * The backend must outlive its use.
+ */
+void SetDisplayConfigBackend(DisplayConfigBackend* backend);
+
+} // namespace hdr
+
+#endif // DISPLAYCONFIGBACKEND_HPP_
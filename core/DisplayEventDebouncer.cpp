@@ -0,0 +1,104 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "DisplayEventDebouncer.hpp"
+
+#include <algorithm>
+
+uint32_t DisplayEventDebouncer::BaseDelayMs(MonitorReapplyReason reason)
+{
+    switch (reason) {
+    case MonitorReapplyReason::None:
+        break;
+    case MonitorReapplyReason::DisplayChange:
+    case MonitorReapplyReason::DisplayOn:
+        return 3000;
+    case MonitorReapplyReason::SystemResume:
+        // Monitor needs more time to stabilize after a resume
+        return 5000;
+    }
+    return 0;
+}
+
+bool DisplayEventDebouncer::Record(MonitorReapplyReason reason, uint64_t nowMs)
+{
+    if (reason == MonitorReapplyReason::None)
+        return false;
+
+    m_stats.rawEvents++;
+    const uint32_t isDisplayChange = reason == MonitorReapplyReason::DisplayChange ? 1 : 0;
+
+    if (!m_pending) {
+        m_pending = Burst { reason, nowMs, nowMs, 0, 1, isDisplayChange };
+        m_pending->dueMs = ComputeDue(*m_pending);
+        return true;
+    }
+
+    auto& burst = *m_pending;
+    if (static_cast<int>(reason) > static_cast<int>(burst.reason))
+        burst.reason = reason;
+    burst.lastMs = std::max(burst.lastMs, nowMs);
+    burst.events++;
+    burst.displayChangeEvents += isDisplayChange;
+    burst.dueMs = ComputeDue(burst);
+    return false;
+}
+
+uint32_t DisplayEventDebouncer::MsUntilDue(uint64_t nowMs) const
+{
+    if (!m_pending || m_pending->dueMs <= nowMs)
+        return 0;
+    return static_cast<uint32_t>(m_pending->dueMs - nowMs);
+}
+
+std::optional<DisplayEventDebouncer::Job> DisplayEventDebouncer::Poll(uint64_t nowMs)
+{
+    if (!m_pending || nowMs < m_pending->dueMs)
+        return std::nullopt;
+
+    const auto& burst = *m_pending;
+    Job job;
+    job.reason = burst.reason;
+    job.coalescedEvents = burst.events;
+    job.burstDurationMs = nowMs - burst.firstMs;
+
+    // Without debouncing, every display change refreshed the HDR status and every event
+    // ended up running a reconnection, each starting with a DDC/CI readiness probe.
+    if (burst.displayChangeEvents > 1)
+        m_stats.topologyQueriesSaved += burst.displayChangeEvents - 1;
+    m_stats.ddcProbesSaved += burst.events - 1;
+    m_stats.jobsEmitted++;
+
+    m_pending.reset();
+    return job;
+}
+
+uint64_t DisplayEventDebouncer::ComputeDue(const Burst& burst) const
+{
+    // The quiet window follows the pace of the burst: events arriving in quick succession
+    // settle quickly, slowly trickling events (eg a monitor doing several mode sets)
+    // need a longer window to be recognized as belonging together.
+    uint64_t quietMs = kMinQuietMs;
+    if (burst.events > 1) {
+        const uint64_t meanGapMs = (burst.lastMs - burst.firstMs) / (burst.events - 1);
+        quietMs = std::clamp<uint64_t>(meanGapMs * 2, kMinQuietMs, kMaxQuietMs);
+    }
+
+    const uint64_t due = std::max(burst.firstMs + BaseDelayMs(burst.reason), burst.lastMs + quietMs);
+    return std::min(due, burst.firstMs + kMaxBurstMs);
+}
@@ -0,0 +1,115 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DISPLAYEVENTDEBOUNCER_HPP_
+#define DISPLAYEVENTDEBOUNCER_HPP_
+
+#include <cstdint>
+#include <optional>
+
+/// Why monitor color correction needs to be reapplied. Higher values take priority.
+enum class MonitorReapplyReason
+{
+    None = 0,
+    DisplayChange = 1,
+    DisplayOn = 2,
+    SystemResume = 3,
+};
+
+/**
+ * Collapses bursts of display, power and resume notifications into a single reconnection job.
+ *
+ * A monitor wake typically produces several WM_DISPLAYCHANGE messages plus power setting
+ * and resume broadcasts within a few seconds. Each raw event is recorded with a timestamp;
+ * the burst is considered settled once no new event arrived for a "quiet window" that adapts
+ * to the observed inter-event gaps. Only then a single job, carrying the highest priority
+ * reason seen during the burst, is emitted.
+ *
+ * The class is purely time-driven (all timestamps are passed in), so it has no OS dependencies.
+ */
+class DisplayEventDebouncer
+{
+public:
+    /// Reconnection job emitted once a burst settled
+    struct Job
+    {
+        /// Highest priority reason seen during the burst
+        MonitorReapplyReason reason = MonitorReapplyReason::None;
+        /// Number of raw events collapsed into this job
+        uint32_t coalescedEvents = 0;
+        /// Time from first event to job emission
+        uint64_t burstDurationMs = 0;
+    };
+
+    /// Cumulative statistics
+    struct Stats
+    {
+        /// Raw events recorded
+        uint64_t rawEvents = 0;
+        /// Reconnection jobs emitted
+        uint64_t jobsEmitted = 0;
+        /// Display topology queries avoided compared to refreshing status on every display change event
+        uint64_t topologyQueriesSaved = 0;
+        /// DDC/CI readiness probes avoided compared to running a reconnection for every event
+        uint64_t ddcProbesSaved = 0;
+    };
+
+    /**
+     * Record a raw event.
+     * \returns \c true if the event started a new burst. Callers should do any
+     *   "immediate" work (like refreshing the HDR status icon) only in that case.
+     */
+    bool Record(MonitorReapplyReason reason, uint64_t nowMs);
+
+    /// Whether a burst is currently pending
+    bool IsPending() const { return m_pending.has_value(); }
+    /// Milliseconds until the pending burst is due. Only meaningful if \c IsPending().
+    uint32_t MsUntilDue(uint64_t nowMs) const;
+
+    /// Emit the reconnection job if the pending burst has settled.
+    std::optional<Job> Poll(uint64_t nowMs);
+
+    const Stats& GetStats() const { return m_stats; }
+
+    /// Minimum delay between the first event of a burst and the job, per reason
+    static uint32_t BaseDelayMs(MonitorReapplyReason reason);
+
+private:
+    /// Lower bound of the quiet window appended after each event
+    static constexpr uint32_t kMinQuietMs = 500;
+    /// Upper bound of the quiet window appended after each event
+    static constexpr uint32_t kMaxQuietMs = 2500;
+    /// Bursts are cut off after this long even if events keep coming
+    static constexpr uint32_t kMaxBurstMs = 15000;
+
+    struct Burst
+    {
+        MonitorReapplyReason reason;
+        uint64_t firstMs;
+        uint64_t lastMs;
+        uint64_t dueMs;
+        uint32_t events;
+        uint32_t displayChangeEvents;
+    };
+    std::optional<Burst> m_pending;
+    Stats m_stats;
+
+    uint64_t ComputeDue(const Burst& burst) const;
+};
+
+#endif // DISPLAYEVENTDEBOUNCER_HPP_
@@ -0,0 +1,114 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Color Profile Management Extension
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#include "Edid.hpp"
+
+#include <algorithm>
+#include <cwchar>
+#include <iterator>
+
+namespace {
+
+constexpr size_t kBaseBlockSize = 128;
+
+/// Text of a display descriptor: up to 13 ASCII characters, terminated by a line feed
+std::wstring DescriptorText(const uint8_t* descriptor)
+{
+    std::wstring text;
+    for (int i = 5; i < 18 && descriptor[i] != '\n'; i++) {
+        if (descriptor[i] >= 0x20 && descriptor[i] < 0x7f)
+            text.push_back(static_cast<wchar_t>(descriptor[i]));
+    }
+    while (!text.empty() && text.back() == L' ')
+        text.pop_back();
+    return text;
+}
+
+uint32_t Fnv1a32(std::wstring_view text)
+{
+    uint32_t hash = 0x811c9dc5u;
+    for (wchar_t c : text) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x01000193u;
+    }
+    return hash;
+}
+
+} // namespace
+
+std::wstring EdidInfo::Id() const
+{
+    const uint32_t serial = (serialNumber != 0 || serialText.empty()) ? serialNumber : Fnv1a32(serialText);
+    wchar_t buffer[32];
+    std::swprintf(buffer, std::size(buffer), L"%ls%04X-%08X", manufacturer.c_str(), productCode, serial);
+    return buffer;
+}
+
+std::optional<EdidInfo> ParseEdid(const uint8_t* data, size_t size)
+{
+    static const uint8_t header[] = { 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00 };
+    if (!data || size < kBaseBlockSize || !std::equal(std::begin(header), std::end(header), data))
+        return std::nullopt;
+
+    uint8_t checksum = 0;
+    for (size_t i = 0; i < kBaseBlockSize; i++)
+        checksum += data[i];
+    if (checksum != 0)
+        return std::nullopt;
+
+    EdidInfo info;
+    // Manufacturer: three 5 bit letters, big endian
+    const uint16_t vendor = static_cast<uint16_t>((data[8] << 8) | data[9]);
+    for (int shift : { 10, 5, 0 }) {
+        const int letter = (vendor >> shift) & 0x1f;
+        if (letter < 1 || letter > 26)
+            return std::nullopt;
+        info.manufacturer.push_back(static_cast<wchar_t>(L'A' + letter - 1));
+    }
+    info.productCode = static_cast<uint16_t>(data[10] | (data[11] << 8));
+    info.serialNumber = uint32_t(data[12]) | (uint32_t(data[13]) << 8) | (uint32_t(data[14]) << 16)
+                        | (uint32_t(data[15]) << 24);
+
+    // Four 18 byte descriptors; display descriptors start with a zero pixel clock
+    for (size_t offset = 54; offset < 126; offset += 18) {
+        const uint8_t* descriptor = data + offset;
+        if (descriptor[0] != 0 || descriptor[1] != 0)
+            continue;
+        if (descriptor[3] == 0xff)
+            info.serialText = DescriptorText(descriptor);
+        else if (descriptor[3] == 0xfc)
+            info.name = DescriptorText(descriptor);
+    }
+    return info;
+}
+
+std::wstring NormalizeEdidId(std::wstring_view id)
+{
+    std::wstring result;
+    result.reserve(id.size());
+    for (wchar_t c : id) {
+        if (c == L' ' || c == L'\t')
+            continue;
+        result.push_back((c >= L'a' && c <= L'z') ? static_cast<wchar_t>(c - L'a' + L'A') : c);
+    }
+    return result;
+}
@@ -0,0 +1,62 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Color Profile Management Extension
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/**
+ * Identity of a display, from the base block of its EDID.
+ */
+struct EdidInfo
+{
+    /// Three letter PnP manufacturer id
+    std::wstring manufacturer;
+    uint16_t productCode = 0;
+    /// Serial number from the header, 0 if not set
+    uint32_t serialNumber = 0;
+    /// Serial number descriptor (0xFF), empty if not present
+    std::wstring serialText;
+    /// Monitor name descriptor (0xFC), empty if not present
+    std::wstring name;
+
+    /**
+     * Stable id of the display, eg "XMI3FA4-0000BC61".
+     * Manufacturer and product code as in the Windows hardware id, followed by the
+     * serial number, or a hash of the serial number descriptor if the header has none.
+     * Doesn't change when the display is connected to a different port.
+     */
+    std::wstring Id() const;
+};
+
+/**
+ * Parse the EDID base block
+ * @return Display identity, or nothing if the data is not a valid EDID
+ */
+std::optional<EdidInfo> ParseEdid(const uint8_t* data, size_t size);
+
+/// Normalize a display id given by the user, for comparison with EdidInfo::Id()
+std::wstring NormalizeEdidId(std::wstring_view id);
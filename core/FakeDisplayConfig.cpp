@@ -0,0 +1,239 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "FakeDisplayConfig.hpp"
+
+#include <algorithm>
+#include <string>
+
+namespace hdr {
+
+FakeDisplayConfig::FakeDisplayConfig() : FakeDisplayConfig(Options {}) { }
+
+FakeDisplayConfig::FakeDisplayConfig(Options options) : m_options(options) { }
+
+int32_t FakeDisplayConfig::AddAdapter()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nextAdapter++;
+}
+
+DisplayId FakeDisplayConfig::AddTarget(int32_t adapter, Target target)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    target.id.adapterHigh = adapter;
+    target.id.adapterLow = 0x1000;
+    target.id.targetId = m_nextTargetId++;
+    if (!target.hdrSupported && target.mode == ColorMode::Hdr)
+        target.mode = ColorMode::Sdr;
+    if (target.acm && target.mode == ColorMode::Sdr)
+        target.mode = ColorMode::Wcg;
+    m_targets.push_back(target);
+    return target.id;
+}
+
+void FakeDisplayConfig::AddSyntheticTopology(unsigned adapters, unsigned targetsPerAdapter)
+{
+    unsigned n = 0;
+    for (unsigned a = 0; a < adapters; a++) {
+        const int32_t adapter = AddAdapter();
+        for (unsigned t = 0; t < targetsPerAdapter; t++, n++) {
+            Target target;
+            target.name = L"Synthetic Display " + std::to_wstring(n);
+            target.hdrSupported = n % 3 != 2;
+            target.acm = n % 4 == 3;
+            target.mode = target.hdrSupported && n % 2 == 0 ? ColorMode::Hdr : ColorMode::Sdr;
+            // A built-in display without EDID name on the first adapter, like a laptop
+            target.internal = n == 0;
+            target.nameFromEdid = n != 0;
+            target.productCode = static_cast<uint16_t>(0x1000 + n);
+            target.bitsPerColorChannel = target.hdrSupported ? 10 : 8;
+            // 80 to 480 nits, like the slider in the Windows settings
+            target.sdrWhiteLevel = 1000 + (n % 6) * 1000;
+            AddTarget(adapter, target);
+        }
+    }
+}
+
+std::vector<FakeDisplayConfig::Target> FakeDisplayConfig::GetTargets() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_targets;
+}
+
+void FakeDisplayConfig::FailNextCalls(unsigned count)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_failCalls = count;
+}
+
+void FakeDisplayConfig::SetCallLatency(std::chrono::nanoseconds latency)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_options.callLatency = latency;
+}
+
+FakeDisplayConfig::Stats FakeDisplayConfig::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+FakeDisplayConfig::Target* FakeDisplayConfig::Find(const DisplayId& id)
+{
+    auto it = std::find_if(m_targets.begin(), m_targets.end(), [&](const Target& t) { return t.id == id; });
+    return it != m_targets.end() ? &*it : nullptr;
+}
+
+bool FakeDisplayConfig::BeginCall(uint64_t& counter)
+{
+    counter++;
+    if (m_options.callLatency.count() > 0) {
+        const auto until = std::chrono::steady_clock::now() + m_options.callLatency;
+        while (std::chrono::steady_clock::now() < until) { }
+    }
+    if (m_failCalls > 0) {
+        m_failCalls--;
+        return false;
+    }
+    return true;
+}
+
+bool FakeDisplayConfig::QueryActiveTargets(std::vector<DisplayId>& targets)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!BeginCall(m_stats.topologyQueries))
+        return false;
+
+    targets.clear();
+    for (const auto& target : m_targets) {
+        if (target.active)
+            targets.push_back(target.id);
+    }
+    return true;
+}
+
+std::optional<AdvancedColorInfo> FakeDisplayConfig::GetAdvancedColorInfo(const DisplayId& id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto* target = Find(id);
+    if (!BeginCall(m_stats.deviceInfoGets) || !target || !target->active)
+        return std::nullopt;
+
+    AdvancedColorInfo info;
+    // Advanced color covers WCG as well, so displays without HDR but with ACM support it too
+    info.advancedColorSupported = target->hdrSupported || target->acm;
+    info.advancedColorEnabled = target->mode != ColorMode::Sdr;
+    info.wideColorEnforced = target->mode == ColorMode::Wcg;
+    info.bitsPerColorChannel = target->bitsPerColorChannel;
+    return info;
+}
+
+std::optional<AdvancedColorInfo2> FakeDisplayConfig::GetAdvancedColorInfo2(const DisplayId& id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto* target = Find(id);
+    if (!m_options.hdrStateFunctions || !BeginCall(m_stats.deviceInfoGets) || !target || !target->active)
+        return std::nullopt;
+
+    AdvancedColorInfo2 info;
+    info.highDynamicRangeSupported = target->hdrSupported;
+    info.activeColorMode = target->mode;
+    info.bitsPerColorChannel = target->bitsPerColorChannel;
+    return info;
+}
+
+std::optional<TargetName> FakeDisplayConfig::GetTargetName(const DisplayId& id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto* target = Find(id);
+    if (!BeginCall(m_stats.deviceInfoGets) || !target || !target->active)
+        return std::nullopt;
+
+    TargetName name;
+    name.friendlyNameFromEdid = target->nameFromEdid;
+    if (target->nameFromEdid)
+        name.monitorFriendlyDeviceName = target->name;
+    if (target->manufacturer.size() == 3) {
+        uint16_t id = 0;
+        for (wchar_t c : target->manufacturer)
+            id = static_cast<uint16_t>((id << 5) | ((c - L'A' + 1) & 0x1F));
+        name.edidManufactureId = id;
+        name.edidProductCodeId = target->productCode;
+    }
+    name.monitorDevicePath = L"\\\\?\\DISPLAY#" + target->manufacturer + L"#" + std::to_wstring(target->id.targetId);
+    return name;
+}
+
+std::optional<bool> FakeDisplayConfig::IsInternalDisplay(const DisplayId& id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto* target = Find(id);
+    if (!BeginCall(m_stats.deviceInfoGets) || !target || !target->active)
+        return std::nullopt;
+    return target->internal;
+}
+
+std::optional<uint32_t> FakeDisplayConfig::GetSdrWhiteLevel(const DisplayId& id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto* target = Find(id);
+    if (!BeginCall(m_stats.deviceInfoGets) || !target || !target->active)
+        return std::nullopt;
+    return target->sdrWhiteLevel;
+}
+
+bool FakeDisplayConfig::SetHdrState(const DisplayId& id, bool enable)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto* target = Find(id);
+    if (!m_options.hdrStateFunctions || !BeginCall(m_stats.deviceInfoSets) || !target || !target->active
+        || !target->hdrSupported)
+        return false;
+
+    if (enable)
+        target->mode = ColorMode::Hdr;
+    else
+        target->mode = target->acm ? ColorMode::Wcg : ColorMode::Sdr;
+    return true;
+}
+
+bool FakeDisplayConfig::SetAdvancedColorState(const DisplayId& id, bool enable)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto* target = Find(id);
+    if (!BeginCall(m_stats.deviceInfoSets) || !target || !target->active)
+        return false;
+
+    if (enable) {
+        if (target->hdrSupported)
+            target->mode = ColorMode::Hdr;
+        else if (target->acm)
+            target->mode = ColorMode::Wcg;
+        else
+            return false;
+    } else if (!target->acm) {
+        // With ACM, advanced color stays on
+        target->mode = ColorMode::Sdr;
+    } else if (target->mode == ColorMode::Hdr) {
+        target->mode = ColorMode::Wcg;
+    }
+    return true;
+}
+
+} // namespace hdr
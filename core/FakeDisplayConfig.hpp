@@ -0,0 +1,146 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FAKEDISPLAYCONFIG_HPP_
+#define FAKEDISPLAYCONFIG_HPP_
+
+#include "DisplayConfigBackend.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace hdr {
+
+/**
+ * In-memory display configuration, for running the hdr:: functions without Windows.
+ * Models adapters with any number of targets, displays with and without HDR, "Automatic
+ * color management" (ACM, which puts SDR displays into WCG mode) and the difference
+ * between the APIs before and after Windows 11 24H2:
+ * - GetAdvancedColorInfo() reports advanced color as enabled in WCG mode as well,
+ * - SetAdvancedColorState(false) leaves a display with ACM in WCG mode,
+ * - SetHdrState() and GetAdvancedColorInfo2() are only available with hdrStateFunctions.
+ *
+ * Every call takes the configured latency (busy waiting, so short latencies are accurate).
+ * The configuration can be changed at any time, eg to simulate displays being connected
+ * or HDR being switched elsewhere; like on Windows, the hdr:: functions only see such
+ * changes after hdr::InvalidateDisplayCache().
+ */
+class FakeDisplayConfig : public DisplayConfigBackend
+{
+public:
+    struct Target
+    {
+        DisplayId id;
+        std::wstring name = L"Fake Display";
+        /// Whether the name comes from the EDID; if not, the hdr:: functions use a fallback name
+        bool nameFromEdid = true;
+        bool internal = false;
+        bool hdrSupported = true;
+        /// Automatic color management: SDR mode is actually WCG
+        bool acm = false;
+        ColorMode mode = ColorMode::Sdr;
+        bool active = true;
+        /// EDID identity; no EDID ids are reported if the manufacturer is empty
+        std::wstring manufacturer = L"FAK";
+        uint16_t productCode = 0x0001;
+        uint32_t bitsPerColorChannel = 10;
+        /// SDR white level, in thousandths of 80 nits
+        uint32_t sdrWhiteLevel = 1000;
+    };
+
+    struct Options
+    {
+        /// Whether the Windows 11 24H2 functions are available
+        bool hdrStateFunctions = true;
+        /// Time each call takes
+        std::chrono::nanoseconds callLatency { 0 };
+    };
+
+    struct Stats
+    {
+        uint64_t topologyQueries = 0;
+        uint64_t deviceInfoGets = 0;
+        uint64_t deviceInfoSets = 0;
+    };
+
+    FakeDisplayConfig();
+    explicit FakeDisplayConfig(Options options);
+
+    /// Add an adapter, returning the high part of its LUID
+    int32_t AddAdapter();
+    /// Add a target to an adapter; the target id in the display id is assigned
+    DisplayId AddTarget(int32_t adapter, Target target);
+
+    /**
+     * Add adapters with targets.
+     * Every third display doesn't support HDR, every fourth has ACM on, and every other
+     * HDR display has HDR on.
+     */
+    void AddSyntheticTopology(unsigned adapters, unsigned targetsPerAdapter);
+
+    /// Change a target, eg to connect or disconnect it or switch its mode
+    template<typename F> bool Modify(const DisplayId& id, F modify)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto* target = Find(id);
+        if (!target)
+            return false;
+        modify(*target);
+        return true;
+    }
+    /// Get a copy of all targets
+    std::vector<Target> GetTargets() const;
+
+    /// Make the next calls fail (return an error)
+    void FailNextCalls(unsigned count);
+    void SetCallLatency(std::chrono::nanoseconds latency);
+
+    Stats GetStats() const;
+
+    bool HasHdrStateFunctions() const override { return m_options.hdrStateFunctions; }
+    bool QueryActiveTargets(std::vector<DisplayId>& targets) override;
+    std::optional<AdvancedColorInfo> GetAdvancedColorInfo(const DisplayId& target) override;
+    std::optional<AdvancedColorInfo2> GetAdvancedColorInfo2(const DisplayId& target) override;
+    std::optional<TargetName> GetTargetName(const DisplayId& target) override;
+    std::optional<bool> IsInternalDisplay(const DisplayId& target) override;
+    std::optional<uint32_t> GetSdrWhiteLevel(const DisplayId& target) override;
+    bool SetHdrState(const DisplayId& target, bool enable) override;
+    bool SetAdvancedColorState(const DisplayId& target, bool enable) override;
+
+private:
+    mutable std::mutex m_mutex;
+    Options m_options;
+    std::vector<Target> m_targets;
+    int32_t m_nextAdapter = 1;
+    uint32_t m_nextTargetId = 0x1100;
+    unsigned m_failCalls = 0;
+    Stats m_stats;
+
+    Target* Find(const DisplayId& id);
+    /**
+     * Common part of all calls: wait for the latency, check for injected failures.
+     * Requires m_mutex. @return false if the call should fail
+     */
+    bool BeginCall(uint64_t& counter);
+};
+
+} // namespace hdr
+
+#endif // FAKEDISPLAYCONFIG_HPP_
@@ -0,0 +1,517 @@
+/*
+ *  Copyright (C) 2005-2018 Team Kodi
+ *
+ *  This file is based on source code from Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "HDR.h"
+#include "DisplayConfigBackend.hpp"
+#include "Metrics.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cwchar>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include "Win32DisplayConfig.hpp"
+#endif
+
+namespace hdr {
+
+/// Cached information about an active display
+struct Target
+{
+    DisplayId id;
+    Status status;
+    std::optional<ColorMode> colorMode;
+    std::optional<uint32_t> bitsPerColorChannel;
+    /// Whether a name could be determined; displays without one are not reported by GetDisplays()
+    bool hasName;
+    std::wstring name;
+    std::optional<uint16_t> edidManufactureId;
+    std::optional<uint16_t> edidProductCode;
+    std::wstring devicePath;
+};
+
+/// Snapshot of the active displays
+struct Topology
+{
+    /// Value of the generation counter when this snapshot was taken
+    uint64_t generation = 0;
+    /// One entry per active path
+    std::vector<Target> targets;
+};
+
+static std::atomic<uint64_t> cache_generation { 1 };
+static std::atomic<uint64_t> topology_queries { 0 };
+static std::atomic<uint64_t> device_info_calls { 0 };
+static std::atomic<uint64_t> cache_hits { 0 };
+// Same as above, but kept across HDRTray restarts
+static metrics::Counter topology_lookups_metric("display.lookups");
+static metrics::Counter cache_hits_metric("display.cache_hits");
+
+// Guards the cached topology; held while displays are queried or changed
+static std::mutex topology_mutex;
+static Topology topology;
+
+// Set with SetDisplayConfigBackend(); guarded by topology_mutex
+static DisplayConfigBackend* backend_override = nullptr;
+
+// Guarded by topology_mutex
+static bool call_recording = false;
+static std::vector<ApiCall> recorded_calls;
+
+/// Get the backend to use. Requires topology_mutex.
+static DisplayConfigBackend* CurrentBackend()
+{
+    if (backend_override)
+        return backend_override;
+#if defined(_WIN32)
+    static Win32DisplayConfig win32_backend;
+    return &win32_backend;
+#else
+    return nullptr;
+#endif
+}
+
+/// Make a backend call, recording it if enabled. Requires topology_mutex.
+template<typename F> static auto BackendCall(ApiFunction function, const DisplayId* display, F call)
+{
+    if (!call_recording)
+        return call();
+
+    const auto start = std::chrono::steady_clock::now();
+    auto result = call();
+    ApiCall record;
+    record.function = function;
+    if (display)
+        record.display = *display;
+    record.succeeded = static_cast<bool>(result);
+    record.durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                            .count();
+    recorded_calls.push_back(record);
+    return result;
+}
+
+/// Make a device info query (DisplayConfigGetDeviceInfo()). Requires topology_mutex.
+template<typename F> static auto DeviceInfoQuery(ApiFunction function, const DisplayId& display, F call)
+{
+    device_info_calls.fetch_add(1, std::memory_order_relaxed);
+    return BackendCall(function, &display, call);
+}
+
+/// Query status, color mode and bit depth of a display. Requires topology_mutex.
+static void QueryDisplayHDRStatus(DisplayConfigBackend& backend, Target& target)
+{
+    // Prefer GET_ADVANCED_COLOR_INFO_2, this reports the actual HDR mode if ACM is enabled
+    if (backend.HasHdrStateFunctions()) {
+        if (auto colorInfo2 = DeviceInfoQuery(ApiFunction::GetAdvancedColorInfo2, target.id,
+                                              [&] { return backend.GetAdvancedColorInfo2(target.id); })) {
+            target.colorMode = colorInfo2->activeColorMode;
+            target.bitsPerColorChannel = colorInfo2->bitsPerColorChannel;
+            if (!colorInfo2->highDynamicRangeSupported)
+                target.status = Status::Unsupported;
+            else // Only ColorMode::Hdr is true HDR.
+                target.status = colorInfo2->activeColorMode == ColorMode::Hdr ? Status::On : Status::Off;
+            return;
+        }
+    }
+
+    auto colorInfo = DeviceInfoQuery(ApiFunction::GetAdvancedColorInfo, target.id,
+                                     [&] { return backend.GetAdvancedColorInfo(target.id); });
+    if (!colorInfo) {
+        target.status = Status::Unsupported;
+        target.colorMode.reset();
+        target.bitsPerColorChannel.reset();
+        return;
+    }
+
+    if (!colorInfo->advancedColorEnabled)
+        target.colorMode = ColorMode::Sdr;
+    else
+        target.colorMode = colorInfo->wideColorEnforced ? ColorMode::Wcg : ColorMode::Hdr;
+    target.bitsPerColorChannel = colorInfo->bitsPerColorChannel;
+
+    if (!colorInfo->advancedColorSupported)
+        target.status = Status::Unsupported;
+    else
+        target.status = colorInfo->advancedColorEnabled ? Status::On : Status::Off;
+}
+
+static std::optional<bool> QueryInternalDisplay(DisplayConfigBackend& backend, const Target& target)
+{
+    return DeviceInfoQuery(ApiFunction::GetTargetBaseType, target.id,
+                           [&] { return backend.IsInternalDisplay(target.id); });
+}
+
+static const wchar_t* GetFallbackDisplayName(DisplayConfigBackend& backend, const Target& target)
+{
+    if (QueryInternalDisplay(backend, target).value_or(false))
+        return L"Internal Display";
+
+    return L"Unnamed";
+}
+
+static void QueryDisplayName(DisplayConfigBackend& backend, Target& target)
+{
+    auto deviceName = DeviceInfoQuery(ApiFunction::GetTargetName, target.id,
+                                      [&] { return backend.GetTargetName(target.id); });
+    target.hasName = deviceName.has_value();
+    if (!target.hasName)
+        return;
+
+    target.edidManufactureId = deviceName->edidManufactureId;
+    target.edidProductCode = deviceName->edidProductCodeId;
+    target.devicePath = std::move(deviceName->monitorDevicePath);
+    if (deviceName->friendlyNameFromEdid)
+        target.name = std::move(deviceName->monitorFriendlyDeviceName);
+    else
+        target.name = GetFallbackDisplayName(backend, target); // Seen with eg a laptop display.
+}
+
+/// Get the cached topology, querying it if it was invalidated. Requires topology_mutex.
+static Topology& CurrentTopology()
+{
+    const uint64_t generation = cache_generation.load(std::memory_order_acquire);
+    topology_lookups_metric.Add();
+    if (topology.generation == generation) {
+        cache_hits.fetch_add(1, std::memory_order_relaxed);
+        cache_hits_metric.Add();
+        return topology;
+    }
+
+    // Stays outdated if querying fails, so the next call tries again
+    topology.generation = 0;
+    topology.targets.clear();
+
+    auto* backend = CurrentBackend();
+    if (!backend)
+        return topology;
+
+    trace::Span span("hdr", "QueryTopology");
+    std::vector<DisplayId> ids;
+    topology_queries.fetch_add(1, std::memory_order_relaxed);
+    if (!BackendCall(ApiFunction::QueryDisplayConfig, nullptr, [&] { return backend->QueryActiveTargets(ids); }))
+        return topology;
+
+    topology.targets.reserve(ids.size());
+    for (const auto& id : ids) {
+        Target target = {};
+        target.id = id;
+        QueryDisplayHDRStatus(*backend, target);
+        QueryDisplayName(*backend, target);
+        topology.targets.emplace_back(std::move(target));
+    }
+    topology.generation = generation;
+    span.Arg("displays", static_cast<int64_t>(topology.targets.size()));
+    return topology;
+}
+
+void SetDisplayConfigBackend(DisplayConfigBackend* backend)
+{
+    std::lock_guard<std::mutex> lock(topology_mutex);
+    backend_override = backend;
+    topology.generation = 0;
+    topology.targets.clear();
+}
+
+void InvalidateDisplayCache()
+{
+    cache_generation.fetch_add(1, std::memory_order_acq_rel);
+}
+
+uint64_t GetDisplayCacheGeneration()
+{
+    return cache_generation.load(std::memory_order_acquire);
+}
+
+QueryStats GetQueryStats()
+{
+    QueryStats stats;
+    stats.topologyQueries = topology_queries.load(std::memory_order_relaxed);
+    stats.deviceInfoCalls = device_info_calls.load(std::memory_order_relaxed);
+    stats.cacheHits = cache_hits.load(std::memory_order_relaxed);
+    return stats;
+}
+
+static Status AggregateStatus(const Topology& displays)
+{
+    bool anySupported = false;
+    bool anyEnabled = false;
+
+    for (const auto& target : displays.targets) {
+        anySupported |= target.status != Status::Unsupported;
+        anyEnabled |= target.status == Status::On;
+    }
+
+    if (anySupported)
+        return anyEnabled ? Status::On : Status::Off;
+    else
+        return Status::Unsupported;
+}
+
+Status GetWindowsHDRStatus()
+{
+    std::lock_guard<std::mutex> lock(topology_mutex);
+    return AggregateStatus(CurrentTopology());
+}
+
+static std::optional<Status> SetDisplayHDRStatus(Target& target, bool enable)
+{
+    if (target.status == Status::Unsupported)
+        return std::nullopt;
+    auto* backend = CurrentBackend();
+    trace::Span span("hdr", "SetDisplayHDRStatus");
+    span.Arg("target", target.id.targetId).Arg("enable", enable);
+
+    /* Try SET_HDR_STATE first, if available (on Windows 11 >= 24H2).
+     * This seems to work better with ACM enabled (in which case "advanced color" is always
+     * enabled and changing it doesn't do much.) */
+    if (backend->HasHdrStateFunctions()
+        && BackendCall(ApiFunction::SetHdrState, &target.id, [&] { return backend->SetHdrState(target.id, enable); })) {
+        QueryDisplayHDRStatus(*backend, target);
+        return target.status;
+    }
+
+    if (!BackendCall(ApiFunction::SetAdvancedColorState, &target.id,
+                     [&] { return backend->SetAdvancedColorState(target.id, enable); }))
+        return std::nullopt;
+    // Don't assume changing the HDR mode was successful... re-query the status
+    QueryDisplayHDRStatus(*backend, target);
+    return target.status;
+}
+
+/// Whether a display already has the status SetDisplayHDRStatus() would set
+static bool HasRequestedStatus(const Target& target, bool enable)
+{
+    return target.status == (enable ? Status::On : Status::Off);
+}
+
+static std::optional<Status> SetHDRStatusLocked(Topology& displays, bool enable)
+{
+    std::optional<Status> status;
+
+    for (auto& target : displays.targets) {
+        auto new_status = HasRequestedStatus(target, enable) ? std::optional<Status>(target.status)
+                                                             : SetDisplayHDRStatus(target, enable);
+        if (!new_status)
+            continue;
+
+        if(!status)
+            status = *new_status;
+        else
+            status = static_cast<Status>(std::max(static_cast<int>(*status), static_cast<int>(*new_status)));
+    }
+
+    return status;
+}
+
+std::optional<Status> SetWindowsHDRStatus(bool enable)
+{
+    trace::Span span("hdr", "SetWindowsHDRStatus");
+    span.Arg("enable", enable);
+    std::lock_guard<std::mutex> lock(topology_mutex);
+    const auto status = SetHDRStatusLocked(CurrentTopology(), enable);
+    span.Arg("status", status ? static_cast<int64_t>(*status) : -1);
+    return status;
+}
+
+std::optional<Status> ToggleHDRStatus()
+{
+    // The direction depends on the current status, so don't trust the cache
+    InvalidateDisplayCache();
+    // Same topology for checking and changing the status
+    std::lock_guard<std::mutex> lock(topology_mutex);
+    auto& displays = CurrentTopology();
+    auto status = AggregateStatus(displays);
+    if (status == Status::Unsupported)
+        return Status::Unsupported;
+    return SetHDRStatusLocked(displays, status == Status::Off ? true : false);
+}
+
+std::wstring DisplayId::ToString() const
+{
+    wchar_t str[32];
+    std::swprintf(str, std::size(str), L"%08X%08X-%u", static_cast<uint32_t>(adapterHigh), adapterLow, targetId);
+    return str;
+}
+
+std::optional<DisplayId> DisplayId::FromString(std::wstring_view str)
+{
+    const size_t dash = str.find(L'-');
+    if (dash != 16 || dash + 1 >= str.size())
+        return std::nullopt;
+
+    uint64_t luid = 0;
+    for (wchar_t c : str.substr(0, dash)) {
+        int digit;
+        if (c >= L'0' && c <= L'9')
+            digit = c - L'0';
+        else if (c >= L'a' && c <= L'f')
+            digit = c - L'a' + 10;
+        else if (c >= L'A' && c <= L'F')
+            digit = c - L'A' + 10;
+        else
+            return std::nullopt;
+        luid = (luid << 4) | static_cast<uint64_t>(digit);
+    }
+    uint64_t target = 0;
+    for (wchar_t c : str.substr(dash + 1)) {
+        if (c < L'0' || c > L'9')
+            return std::nullopt;
+        target = target * 10 + static_cast<uint64_t>(c - L'0');
+        if (target > UINT32_MAX)
+            return std::nullopt;
+    }
+
+    DisplayId id;
+    id.adapterHigh = static_cast<int32_t>(luid >> 32);
+    id.adapterLow = static_cast<uint32_t>(luid);
+    id.targetId = static_cast<uint32_t>(target);
+    return id;
+}
+
+std::vector<DisplayResult> SetDisplaysHDRStatus(std::span<const DisplayId> displays, bool enable)
+{
+    trace::Span span("hdr", "SetDisplaysHDRStatus");
+    span.Arg("enable", enable).Arg("displays", static_cast<int64_t>(displays.size()));
+    std::vector<DisplayResult> results;
+    results.reserve(displays.size());
+
+    std::lock_guard<std::mutex> lock(topology_mutex);
+    auto& current = CurrentTopology();
+    for (const auto& id : displays) {
+        DisplayResult result;
+        result.id = id;
+
+        auto target = std::find_if(current.targets.begin(), current.targets.end(),
+                                   [&](const Target& t) { return t.id == id; });
+        if (target != current.targets.end()) {
+            result.unchanged = HasRequestedStatus(*target, enable);
+            result.status = result.unchanged ? std::optional<Status>(target->status)
+                                             : SetDisplayHDRStatus(*target, enable);
+        }
+        results.push_back(result);
+    }
+
+    return results;
+}
+
+std::vector<Display> GetDisplays()
+{
+    std::vector<Display> result;
+
+    std::lock_guard<std::mutex> lock(topology_mutex);
+    for (const auto& target : CurrentTopology().targets) {
+        if (!target.hasName)
+            continue;
+
+        Display new_disp;
+        new_disp.id = target.id;
+        new_disp.status = target.status;
+        new_disp.name = target.name;
+        result.emplace_back(std::move(new_disp));
+    }
+
+    return result;
+}
+
+std::wstring DisplayDetails::HardwareId() const
+{
+    if (edidManufacturer.empty() || !edidProductCode)
+        return {};
+    wchar_t product[8];
+    std::swprintf(product, std::size(product), L"%04X", static_cast<unsigned>(*edidProductCode));
+    return edidManufacturer + product;
+}
+
+/// Decode the three letter PnP id from the EDID manufacturer id
+static std::wstring DecodeManufacturerId(uint16_t id)
+{
+    std::wstring result;
+    for (int shift = 10; shift >= 0; shift -= 5) {
+        const unsigned letter = (id >> shift) & 0x1F;
+        if (letter < 1 || letter > 26)
+            return {};
+        result.push_back(static_cast<wchar_t>(L'A' + letter - 1));
+    }
+    return result;
+}
+
+std::vector<DisplayDetails> GetDisplayDetails()
+{
+    std::vector<DisplayDetails> result;
+
+    std::lock_guard<std::mutex> lock(topology_mutex);
+    auto* backend = CurrentBackend();
+    for (const auto& target : CurrentTopology().targets) {
+        if (!target.hasName)
+            continue;
+
+        DisplayDetails details;
+        details.id = target.id;
+        details.name = target.name;
+        details.status = target.status;
+        details.colorMode = target.colorMode;
+        details.bitsPerColorChannel = target.bitsPerColorChannel;
+        if (target.edidManufactureId)
+            details.edidManufacturer = DecodeManufacturerId(*target.edidManufactureId);
+        details.edidProductCode = target.edidProductCode;
+        details.devicePath = target.devicePath;
+        details.internal = QueryInternalDisplay(*backend, target).value_or(false);
+        if (auto white_level = DeviceInfoQuery(ApiFunction::GetSdrWhiteLevel, target.id,
+                                               [&] { return backend->GetSdrWhiteLevel(target.id); }))
+            details.sdrWhiteLevelNits = *white_level * 80.0 / 1000.0;
+        result.emplace_back(std::move(details));
+    }
+
+    return result;
+}
+
+const char* ToString(ApiFunction function)
+{
+    switch (function) {
+    case ApiFunction::QueryDisplayConfig:
+        return "QueryDisplayConfig";
+    case ApiFunction::GetAdvancedColorInfo:
+        return "GET_ADVANCED_COLOR_INFO";
+    case ApiFunction::GetAdvancedColorInfo2:
+        return "GET_ADVANCED_COLOR_INFO_2";
+    case ApiFunction::GetTargetName:
+        return "GET_TARGET_NAME";
+    case ApiFunction::GetTargetBaseType:
+        return "GET_TARGET_BASE_TYPE";
+    case ApiFunction::GetSdrWhiteLevel:
+        return "GET_SDR_WHITE_LEVEL";
+    case ApiFunction::SetHdrState:
+        return "SET_HDR_STATE";
+    case ApiFunction::SetAdvancedColorState:
+        return "SET_ADVANCED_COLOR_STATE";
+    }
+    return "?";
+}
+
+void StartCallRecording()
+{
+    std::lock_guard<std::mutex> lock(topology_mutex);
+    call_recording = true;
+    recorded_calls.clear();
+}
+
+std::vector<ApiCall> StopCallRecording()
+{
+    std::lock_guard<std::mutex> lock(topology_mutex);
+    call_recording = false;
+    return std::move(recorded_calls);
+}
+
+} // namespace hdr
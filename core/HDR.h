@@ -0,0 +1,166 @@
+/*
+ *  Copyright (C) 2005-2020 Team Kodi
+ *
+ *  This file is based on source code from Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#ifndef HDR_H_
+#define HDR_H_
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace hdr {
+
+enum class Status { Unsupported = 0, Off = 1, On = 2 };
+
+/// Active color mode of a display, as in DISPLAYCONFIG_ADVANCED_COLOR_MODE
+enum class ColorMode { Sdr, Wcg, Hdr };
+
+/// Identifies an active display by adapter LUID and target id, as used by the display configuration API
+struct DisplayId
+{
+    uint32_t adapterLow = 0;
+    int32_t adapterHigh = 0;
+    uint32_t targetId = 0;
+
+    bool operator==(const DisplayId&) const = default;
+
+    /// Format as "<adapter LUID>-<target id>", eg "0000000000012A4F-4352"
+    std::wstring ToString() const;
+    /// Parse the format produced by ToString() (case-insensitive)
+    static std::optional<DisplayId> FromString(std::wstring_view str);
+};
+
+/// Display information
+struct Display
+{
+    DisplayId id;
+    /// Display name
+    std::wstring name;
+    /// HDR status
+    Status status;
+};
+
+/// Result of changing the HDR status of a single display
+struct DisplayResult
+{
+    DisplayId id;
+    /// Status after the change; nothing if the display is not active, doesn't support HDR, or changing failed
+    std::optional<Status> status;
+    /// Set if the display already had the requested status, so it was left alone
+    bool unchanged = false;
+};
+
+Status GetWindowsHDRStatus();
+/// Turn HDR on or off on all supported displays; displays already in the requested state are skipped
+std::optional<Status> SetWindowsHDRStatus(bool enable);
+/// Turn HDR off if it's on on any display, on otherwise. Always queries the current status from the system
+std::optional<Status> ToggleHDRStatus();
+/// Get information for all displays
+std::vector<Display> GetDisplays();
+
+/// Detailed information about a display
+struct DisplayDetails
+{
+    DisplayId id;
+    std::wstring name;
+    Status status = Status::Unsupported;
+    bool internal = false;
+    /// Three letter PnP manufacturer id from the EDID, eg "DEL"; empty if unknown
+    std::wstring edidManufacturer;
+    /// Product code from the EDID
+    std::optional<uint16_t> edidProductCode;
+    /// Device interface path of the monitor
+    std::wstring devicePath;
+    /// Nothing if unknown
+    std::optional<ColorMode> colorMode;
+    std::optional<uint32_t> bitsPerColorChannel;
+    /// Brightness of SDR content in HDR mode, in nits
+    std::optional<double> sdrWhiteLevelNits;
+
+    /// Manufacturer and product code as in the Windows hardware id, eg "DEL4123"; empty if unknown
+    std::wstring HardwareId() const;
+};
+/**
+ * Get detailed information about the displays returned by GetDisplays(), in the same order.
+ * Status, color mode and EDID identity come from the display cache; whether a display is
+ * built in and the SDR white level are queried on each call.
+ */
+std::vector<DisplayDetails> GetDisplayDetails();
+
+/**
+ * Turn HDR on or off on the given displays only.
+ * Displays already in the requested state are skipped.
+ * @return One result per requested display, in the same order
+ */
+std::vector<DisplayResult> SetDisplaysHDRStatus(std::span<const DisplayId> displays, bool enable);
+
+/* The display topology (paths, modes, HDR status and names of all displays) is
+ * queried once and cached; the functions above answer from the cache until it is
+ * invalidated. Changes made through SetWindowsHDRStatus() are reflected in the
+ * cache, changes made elsewhere are not. So invalidate before acting on a user
+ * request: one topology query per click is cheap, toggling the wrong way is not. */
+
+/**
+ * Discard the cached display topology.
+ * Call when the display configuration may have changed, eg on WM_DISPLAYCHANGE.
+ * Cheap and safe to call from any thread; the topology is queried again on next use.
+ */
+void InvalidateDisplayCache();
+/// Number of times the display cache was invalidated
+uint64_t GetDisplayCacheGeneration();
+
+/// Display configuration API usage
+struct QueryStats
+{
+    /// QueryDisplayConfig() calls, ie topology refreshes
+    uint64_t topologyQueries = 0;
+    /// DisplayConfigGetDeviceInfo() calls
+    uint64_t deviceInfoCalls = 0;
+    /// Calls answered from the cached topology
+    uint64_t cacheHits = 0;
+};
+QueryStats GetQueryStats();
+
+/// Display configuration API request, for call recording
+enum class ApiFunction
+{
+    QueryDisplayConfig,
+    GetAdvancedColorInfo,
+    GetAdvancedColorInfo2,
+    GetTargetName,
+    GetTargetBaseType,
+    GetSdrWhiteLevel,
+    SetHdrState,
+    SetAdvancedColorState,
+};
+/// Name of the request, eg "GET_ADVANCED_COLOR_INFO"
+const char* ToString(ApiFunction function);
+
+/// A display configuration API call made by the hdr:: functions
+struct ApiCall
+{
+    ApiFunction function;
+    /// Display the call was made for; nothing for QueryDisplayConfig()
+    std::optional<DisplayId> display;
+    bool succeeded = false;
+    uint64_t durationNs = 0;
+};
+
+/// Start recording the display configuration API calls made by the hdr:: functions, on any thread
+void StartCallRecording();
+/// Stop recording and return the calls made since StartCallRecording()
+std::vector<ApiCall> StopCallRecording();
+
+} // namespace hdr
+
+#endif // HDR_H_
@@ -0,0 +1,449 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Configuration Management
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "IniDocument.hpp"
+
+#include "Unicode.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+namespace {
+
+void DecodeAnsi(std::string_view bytes, std::wstring& out)
+{
+#if defined(_WIN32)
+    out.clear();
+    if (bytes.empty())
+        return;
+    const int size = MultiByteToWideChar(CP_ACP, 0, bytes.data(), static_cast<int>(bytes.size()), nullptr, 0);
+    out.resize(size);
+    MultiByteToWideChar(CP_ACP, 0, bytes.data(), static_cast<int>(bytes.size()), out.data(), size);
+#else
+    out.assign(bytes.begin(), bytes.end());
+    for (auto& c : out)
+        c = static_cast<unsigned char>(c);
+#endif
+}
+
+void EncodeAnsi(std::wstring_view str, std::string& out)
+{
+#if defined(_WIN32)
+    if (str.empty())
+        return;
+    const int size = WideCharToMultiByte(CP_ACP, 0, str.data(), static_cast<int>(str.size()), nullptr, 0, nullptr, nullptr);
+    const size_t start = out.size();
+    out.resize(start + size);
+    WideCharToMultiByte(CP_ACP, 0, str.data(), static_cast<int>(str.size()), out.data() + start, size, nullptr, nullptr);
+#else
+    for (size_t i = 0; i < str.size();) {
+        const char32_t cp = unicode::NextCodePoint(str, i);
+        out.push_back(cp < 0x100 ? static_cast<char>(cp) : '?');
+    }
+#endif
+}
+
+bool IsSpace(wchar_t c)
+{
+    return c == L' ' || c == L'\t' || c == L'\r' || c == L'\v' || c == L'\f';
+}
+
+wchar_t FoldCase(wchar_t c)
+{
+    return (c >= L'A' && c <= L'Z') ? static_cast<wchar_t>(c - L'A' + L'a') : c;
+}
+
+bool EqualsNoCase(std::wstring_view a, std::wstring_view b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (FoldCase(a[i]) != FoldCase(b[i]))
+            return false;
+    }
+    return true;
+}
+
+std::wstring_view Trim(std::wstring_view str)
+{
+    while (!str.empty() && IsSpace(str.front()))
+        str.remove_prefix(1);
+    while (!str.empty() && IsSpace(str.back()))
+        str.remove_suffix(1);
+    return str;
+}
+
+} // namespace
+
+void IniDocument::ClassifyLine(Line& line)
+{
+    const std::wstring_view text = line.text;
+    const auto offset = [&](std::wstring_view part) { return static_cast<uint32_t>(part.data() - text.data()); };
+
+    const auto trimmed = Trim(text);
+    line.type = LineType::Other;
+    if (trimmed.empty() || trimmed.front() == L';')
+        return;
+
+    if (trimmed.front() == L'[') {
+        const size_t close = trimmed.find(L']');
+        if (close == std::wstring_view::npos)
+            return;
+        const auto name = Trim(trimmed.substr(1, close - 1));
+        line.type = LineType::Section;
+        line.nameBegin = offset(name);
+        line.nameEnd = line.nameBegin + static_cast<uint32_t>(name.size());
+        return;
+    }
+
+    const size_t equals = trimmed.find(L'=');
+    if (equals == std::wstring_view::npos)
+        return;
+    const auto key = Trim(trimmed.substr(0, equals));
+    auto value = Trim(trimmed.substr(equals + 1));
+    if (value.size() >= 2 && ((value.front() == L'"' && value.back() == L'"') || (value.front() == L'\'' && value.back() == L'\''))) {
+        value = value.substr(1, value.size() - 2);
+    }
+    line.type = LineType::KeyValue;
+    line.nameBegin = offset(key);
+    line.nameEnd = line.nameBegin + static_cast<uint32_t>(key.size());
+    // Empty value may point right past the end of the trimmed text
+    line.valueBegin = value.empty() ? static_cast<uint32_t>(offset(trimmed) + trimmed.size()) : offset(value);
+    line.valueEnd = line.valueBegin + static_cast<uint32_t>(value.size());
+}
+
+std::wstring_view IniDocument::Name(const Line& line)
+{
+    return std::wstring_view(line.text).substr(line.nameBegin, line.nameEnd - line.nameBegin);
+}
+
+std::wstring_view IniDocument::Value(const Line& line)
+{
+    return std::wstring_view(line.text).substr(line.valueBegin, line.valueEnd - line.valueBegin);
+}
+
+void IniDocument::Parse(std::string_view bytes)
+{
+    std::wstring text;
+    if (bytes.size() >= 2 && bytes[0] == '\xFF' && bytes[1] == '\xFE') {
+        m_encoding = Encoding::Utf16LE;
+        unicode::DecodeUtf16LE(bytes.substr(2), text);
+    } else if (bytes.size() >= 3 && bytes.substr(0, 3) == "\xEF\xBB\xBF") {
+        m_encoding = Encoding::Utf8Bom;
+        if (!unicode::DecodeUtf8(bytes.substr(3), text))
+            DecodeAnsi(bytes.substr(3), text);
+    } else if (bytes.size() >= 2 && bytes.size() % 2 == 0 && bytes[0] != 0 && bytes[1] == 0) {
+        // Looks like UTF-16 text starting with an ASCII character
+        m_encoding = Encoding::Utf16LENoBom;
+        unicode::DecodeUtf16LE(bytes, text);
+    } else if (unicode::DecodeUtf8(bytes, text)) {
+        m_encoding = Encoding::Utf8;
+    } else {
+        m_encoding = Encoding::Ansi;
+        DecodeAnsi(bytes, text);
+    }
+    SplitLines(text);
+}
+
+void IniDocument::ParseText(std::wstring_view text, Encoding encoding)
+{
+    m_encoding = encoding;
+    SplitLines(text);
+}
+
+void IniDocument::SplitLines(std::wstring_view text)
+{
+    m_lines.clear();
+    const size_t firstBreak = text.find(L'\n');
+    m_crlf = firstBreak == std::wstring_view::npos || (firstBreak > 0 && text[firstBreak - 1] == L'\r');
+
+    std::wstring_view rest = text;
+    while (!rest.empty()) {
+        const size_t end = rest.find(L'\n');
+        auto lineText = rest.substr(0, end);
+        if (!lineText.empty() && lineText.back() == L'\r')
+            lineText.remove_suffix(1);
+        Line line;
+        line.text.assign(lineText);
+        ClassifyLine(line);
+        m_lines.push_back(std::move(line));
+        rest = (end == std::wstring_view::npos) ? std::wstring_view() : rest.substr(end + 1);
+    }
+}
+
+std::string IniDocument::Serialize() const
+{
+    std::wstring text;
+    const wchar_t* eol = m_crlf ? L"\r\n" : L"\n";
+    for (const auto& line : m_lines) {
+        text.append(line.text);
+        text.append(eol);
+    }
+
+    std::string bytes;
+    switch (m_encoding) {
+    case Encoding::Utf8Bom:
+        bytes = "\xEF\xBB\xBF";
+        [[fallthrough]];
+    case Encoding::Utf8:
+        unicode::EncodeUtf8(text, bytes);
+        break;
+    case Encoding::Utf16LE:
+        bytes = "\xFF\xFE";
+        [[fallthrough]];
+    case Encoding::Utf16LENoBom:
+        unicode::EncodeUtf16LE(text, bytes);
+        break;
+    case Encoding::Ansi:
+        EncodeAnsi(text, bytes);
+        break;
+    }
+    return bytes;
+}
+
+bool IniDocument::ReadFile(const std::filesystem::path& path)
+{
+    const auto bytes = ReadBytes(path);
+    if (!bytes)
+        return false;
+    Parse(*bytes);
+    return true;
+}
+
+bool IniDocument::WriteFile(const std::filesystem::path& path) const
+{
+    return WriteBytes(path, Serialize());
+}
+
+std::optional<std::string> IniDocument::ReadBytes(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return std::nullopt;
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (file.bad())
+        return std::nullopt;
+    return bytes;
+}
+
+bool IniDocument::WriteBytes(const std::filesystem::path& path, std::string_view bytes)
+{
+    auto tempPath = path;
+    tempPath += L".tmp";
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        file.close();
+        if (!file) {
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::wstring_view> IniDocument::GetSectionNames() const
+{
+    std::vector<std::wstring_view> names;
+    for (const auto& line : m_lines) {
+        if (line.type == LineType::Section)
+            names.emplace_back(Name(line));
+    }
+    return names;
+}
+
+size_t IniDocument::FindSection(std::wstring_view section) const
+{
+    section = Trim(section);
+    for (size_t i = 0; i < m_lines.size(); i++) {
+        if (m_lines[i].type == LineType::Section && EqualsNoCase(Name(m_lines[i]), section))
+            return i;
+    }
+    return m_lines.size();
+}
+
+size_t IniDocument::FindKey(size_t sectionLine, std::wstring_view key) const
+{
+    key = Trim(key);
+    for (size_t i = sectionLine + 1; i < m_lines.size(); i++) {
+        const auto& line = m_lines[i];
+        if (line.type == LineType::Section)
+            break;
+        if (line.type == LineType::KeyValue && EqualsNoCase(Name(line), key))
+            return i;
+    }
+    return m_lines.size();
+}
+
+std::optional<std::wstring_view> IniDocument::Find(std::wstring_view section, std::wstring_view key) const
+{
+    const size_t sectionLine = FindSection(section);
+    if (sectionLine == m_lines.size())
+        return std::nullopt;
+    const size_t keyLine = FindKey(sectionLine, key);
+    if (keyLine == m_lines.size())
+        return std::nullopt;
+    return Value(m_lines[keyLine]);
+}
+
+std::wstring IniDocument::GetString(std::wstring_view section, std::wstring_view key,
+                                    std::wstring_view defaultValue) const
+{
+    return std::wstring(Find(section, key).value_or(defaultValue));
+}
+
+int IniDocument::GetInt(std::wstring_view section, std::wstring_view key, int defaultValue) const
+{
+    const auto value = Find(section, key);
+    if (!value)
+        return defaultValue;
+
+    // Like GetPrivateProfileInt(): leading decimal number, trailing garbage is ignored
+    size_t i = 0;
+    bool negative = false;
+    if (i < value->size() && ((*value)[i] == L'-' || (*value)[i] == L'+'))
+        negative = (*value)[i++] == L'-';
+    if (i >= value->size() || (*value)[i] < L'0' || (*value)[i] > L'9')
+        return defaultValue;
+    long long result = 0;
+    for (; i < value->size() && (*value)[i] >= L'0' && (*value)[i] <= L'9'; i++) {
+        if (result < 0x80000000LL)
+            result = result * 10 + ((*value)[i] - L'0');
+    }
+    if (negative)
+        result = -result;
+    if (result > 0x7FFFFFFFLL || result < -0x80000000LL)
+        return defaultValue;
+    return static_cast<int>(result);
+}
+
+bool IniDocument::GetBool(std::wstring_view section, std::wstring_view key, bool defaultValue) const
+{
+    return GetInt(section, key, defaultValue ? 1 : 0) != 0;
+}
+
+void IniDocument::Set(std::wstring_view section, std::wstring_view key, std::wstring_view value)
+{
+    const size_t sectionLine = FindSection(section);
+    if (sectionLine == m_lines.size()) {
+        // New section at the end, separated by a blank line
+        if (!m_lines.empty() && !Trim(m_lines.back().text).empty())
+            m_lines.emplace_back();
+        Line header;
+        header.text = L"[" + std::wstring(Trim(section)) + L"]";
+        ClassifyLine(header);
+        m_lines.push_back(std::move(header));
+    }
+
+    const size_t keyLine = FindKey(FindSection(section), key);
+    if (keyLine < m_lines.size()) {
+        auto& line = m_lines[keyLine];
+        line.text.replace(line.valueBegin, line.valueEnd - line.valueBegin, value);
+        ClassifyLine(line);
+        return;
+    }
+
+    // New key after the last non-blank line of the section
+    size_t insertAt = FindSection(section) + 1;
+    for (size_t i = insertAt; i < m_lines.size() && m_lines[i].type != LineType::Section; i++) {
+        if (!Trim(m_lines[i].text).empty())
+            insertAt = i + 1;
+    }
+    Line line;
+    line.text = std::wstring(Trim(key)) + L"=" + std::wstring(value);
+    ClassifyLine(line);
+    m_lines.insert(m_lines.begin() + insertAt, std::move(line));
+}
+
+void IniDocument::Set(std::span<const Assignment> values)
+{
+    // Values found are tracked in a bit mask, so larger sets are handled in chunks
+    constexpr size_t chunkSize = 64;
+    if (values.size() > chunkSize) {
+        for (size_t i = 0; i < values.size(); i += chunkSize)
+            Set(values.subspan(i, std::min(chunkSize, values.size() - i)));
+        return;
+    }
+
+    uint64_t found = 0;
+    std::wstring_view section;
+    // Lookups only see the first section of a name
+    bool lookupSection = false;
+    for (size_t i = 0; i < m_lines.size(); i++) {
+        auto& line = m_lines[i];
+        if (line.type == LineType::Section) {
+            section = Name(line);
+            lookupSection = FindSection(section) == i;
+            continue;
+        }
+        if (line.type != LineType::KeyValue || !lookupSection)
+            continue;
+
+        for (size_t v = 0; v < values.size(); v++) {
+            const uint64_t bit = uint64_t(1) << v;
+            if ((found & bit) != 0 || !EqualsNoCase(Trim(values[v].key), Name(line))
+                || !EqualsNoCase(Trim(values[v].section), section))
+                continue;
+            // Only the first occurrence of a key is seen by lookups
+            found |= bit;
+            if (Value(line) != values[v].value) {
+                line.text.replace(line.valueBegin, line.valueEnd - line.valueBegin, values[v].value);
+                ClassifyLine(line);
+            }
+            break;
+        }
+    }
+
+    for (size_t v = 0; v < values.size(); v++) {
+        if ((found & (uint64_t(1) << v)) == 0)
+            Set(values[v].section, values[v].key, values[v].value);
+    }
+}
+
+void IniDocument::SetInt(std::wstring_view section, std::wstring_view key, int value)
+{
+    Set(section, key, std::to_wstring(value));
+}
+
+void IniDocument::SetBool(std::wstring_view section, std::wstring_view key, bool value)
+{
+    Set(section, key, value ? L"1" : L"0");
+}
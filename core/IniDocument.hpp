@@ -0,0 +1,146 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Configuration Management
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * In-memory INI file.
+ * The file is parsed once; lookups and modifications work on the parsed lines.
+ * Lines that are not modified, including comments, are written back unchanged,
+ * as is the text encoding and line ending style.
+ *
+ * Lookups follow the rules of GetPrivateProfileString(): section and key names
+ * are case-insensitive, whitespace around them and values is ignored, and the
+ * first occurrence of a section or key wins.
+ */
+class IniDocument
+{
+public:
+    enum class Encoding
+    {
+        Utf8,
+        Utf8Bom,
+        /// UTF-16 little endian with byte order mark, understood by the Windows profile APIs
+        Utf16LE,
+        /// UTF-16 little endian without byte order mark
+        Utf16LENoBom,
+        /// System code page on Windows, Latin-1 elsewhere
+        Ansi
+    };
+
+    IniDocument() = default;
+
+    /// Parse INI contents from raw bytes, detecting the encoding
+    void Parse(std::string_view bytes);
+    /// Parse INI contents from text; serialization will use the given encoding
+    void ParseText(std::wstring_view text, Encoding encoding);
+    /// Get the INI contents as raw bytes, in the encoding they were read in
+    std::string Serialize() const;
+
+    /**
+     * Read and parse a file
+     * @return false if the file can't be read
+     */
+    bool ReadFile(const std::filesystem::path& path);
+    /**
+     * Write to a file.
+     * Contents are written to a temporary file first, which then replaces the target file,
+     * so readers never see a partially written file.
+     * @return true if successful
+     */
+    bool WriteFile(const std::filesystem::path& path) const;
+
+    /// Read the raw contents of a file, or nothing if it can't be read
+    static std::optional<std::string> ReadBytes(const std::filesystem::path& path);
+    /// Replace the contents of a file the same way WriteFile() does
+    static bool WriteBytes(const std::filesystem::path& path, std::string_view bytes);
+
+    /// Get a value, or nothing if it's not present. The view is valid until the document is modified.
+    std::optional<std::wstring_view> Find(std::wstring_view section, std::wstring_view key) const;
+    std::wstring GetString(std::wstring_view section, std::wstring_view key, std::wstring_view defaultValue) const;
+    /// Get an integer value; returns the default if the key is missing or doesn't start with a number
+    int GetInt(std::wstring_view section, std::wstring_view key, int defaultValue) const;
+    bool GetBool(std::wstring_view section, std::wstring_view key, bool defaultValue) const;
+
+    /// Set a value, adding the key and section if necessary
+    void Set(std::wstring_view section, std::wstring_view key, std::wstring_view value);
+    void SetInt(std::wstring_view section, std::wstring_view key, int value);
+    void SetBool(std::wstring_view section, std::wstring_view key, bool value);
+
+    struct Assignment
+    {
+        std::wstring_view section;
+        std::wstring_view key;
+        std::wstring_view value;
+    };
+    /**
+     * Set several values with a single pass over the document.
+     * Same result as calling Set() for each value, but lines that already have the
+     * value are left alone, and only missing keys need a lookup of their own.
+     */
+    void Set(std::span<const Assignment> values);
+
+    /// Get the names of all sections, in file order. The views are valid until the document is modified.
+    std::vector<std::wstring_view> GetSectionNames() const;
+
+    Encoding GetEncoding() const { return m_encoding; }
+    /// Set encoding to use for serialization
+    void SetEncoding(Encoding encoding) { m_encoding = encoding; }
+
+private:
+    enum class LineType : uint8_t
+    {
+        Other, // Blank, comment, or anything not understood
+        Section,
+        KeyValue
+    };
+    struct Line
+    {
+        std::wstring text;
+        LineType type = LineType::Other;
+        // Section name or key: offsets into text
+        uint32_t nameBegin = 0, nameEnd = 0;
+        // Value as seen by lookups (without enclosing quotes): offsets into text
+        uint32_t valueBegin = 0, valueEnd = 0;
+    };
+    std::vector<Line> m_lines;
+    Encoding m_encoding = Encoding::Utf16LE;
+    bool m_crlf = true;
+
+    /// Replace the document with the lines of text
+    void SplitLines(std::wstring_view text);
+    static void ClassifyLine(Line& line);
+    static std::wstring_view Name(const Line& line);
+    static std::wstring_view Value(const Line& line);
+
+    /// Find the line of a section header, m_lines.size() if not present
+    size_t FindSection(std::wstring_view section) const;
+    /// Find the line of a key in a section, m_lines.size() if not present
+    size_t FindKey(size_t sectionLine, std::wstring_view key) const;
+};
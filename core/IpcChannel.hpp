@@ -0,0 +1,88 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef IPCCHANNEL_HPP_
+#define IPCCHANNEL_HPP_
+
+#include "IpcProtocol.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+
+/**
+ * Local endpoint for the protocol in IpcProtocol.hpp.
+ * On Windows, a named pipe per session; elsewhere, a Unix domain socket per user.
+ * Only the current user can connect.
+ */
+namespace ipc {
+
+/// Endpoint of the current user session
+std::filesystem::path DefaultEndpoint();
+
+/**
+ * Accepts connections on a background thread, one at a time, and answers one request per connection.
+ * The handler runs on that thread.
+ */
+class Server
+{
+public:
+    using Handler = std::function<Response(const Request&)>;
+
+    struct Stats
+    {
+        /// Requests answered
+        uint64_t requests = 0;
+        /// Connections dropped because of a malformed request or an I/O error
+        uint64_t errors = 0;
+    };
+
+    Server();
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    /**
+     * Start listening.
+     * @return Whether the endpoint could be created. Fails if another server is already listening on it.
+     */
+    bool Start(const std::filesystem::path& endpoint, Handler handler);
+    /// Stop listening and wait for the background thread. A request being handled is finished first.
+    void Stop();
+
+    Stats GetStats() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+/**
+ * Send a request and wait for the response.
+ * @return Response; nothing if no server is listening, or the exchange failed or timed out.
+ */
+std::optional<Response> Call(const std::filesystem::path& endpoint, const Request& request,
+                             std::chrono::milliseconds timeout);
+
+} // namespace ipc
+
+#endif // IPCCHANNEL_HPP_
@@ -0,0 +1,263 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "IpcProtocol.hpp"
+
+namespace ipc {
+
+namespace {
+
+class Writer
+{
+    std::vector<uint8_t> m_data;
+
+public:
+    Writer()
+    {
+        // Length, filled in by Finish()
+        m_data.resize(kFrameHeaderSize);
+        U8(kVersion);
+    }
+
+    void U8(uint8_t value) { m_data.push_back(value); }
+    void U16(uint16_t value)
+    {
+        U8(static_cast<uint8_t>(value));
+        U8(static_cast<uint8_t>(value >> 8));
+    }
+    void U32(uint32_t value)
+    {
+        U16(static_cast<uint16_t>(value));
+        U16(static_cast<uint16_t>(value >> 16));
+    }
+    void String(const std::wstring& str)
+    {
+        const size_t length = std::min<size_t>(str.size(), UINT16_MAX);
+        U16(static_cast<uint16_t>(length));
+        for (size_t i = 0; i < length; i++)
+            U16(static_cast<uint16_t>(str[i]));
+    }
+    void Text(const std::string& text)
+    {
+        U32(static_cast<uint32_t>(text.size()));
+        m_data.insert(m_data.end(), text.begin(), text.end());
+    }
+    void Id(const hdr::DisplayId& id)
+    {
+        U32(id.adapterLow);
+        U32(static_cast<uint32_t>(id.adapterHigh));
+        U32(id.targetId);
+    }
+    void Status(const std::optional<hdr::Status>& status)
+    {
+        // 0xFF: none
+        U8(status ? static_cast<uint8_t>(*status) : 0xFF);
+    }
+
+    std::vector<uint8_t> Finish()
+    {
+        const uint32_t size = static_cast<uint32_t>(m_data.size() - kFrameHeaderSize);
+        for (size_t i = 0; i < kFrameHeaderSize; i++)
+            m_data[i] = static_cast<uint8_t>(size >> (i * 8));
+        return std::move(m_data);
+    }
+};
+
+class Reader
+{
+    std::span<const uint8_t> m_data;
+    bool m_ok = true;
+
+public:
+    explicit Reader(std::span<const uint8_t> data) : m_data(data) { }
+
+    /// Whether everything read so far was present, and all data was consumed
+    bool Done() const { return m_ok && m_data.empty(); }
+
+    uint8_t U8()
+    {
+        if (m_data.empty()) {
+            m_ok = false;
+            return 0;
+        }
+        const uint8_t value = m_data[0];
+        m_data = m_data.subspan(1);
+        return value;
+    }
+    uint16_t U16()
+    {
+        const uint16_t lo = U8();
+        return static_cast<uint16_t>(lo | (U8() << 8));
+    }
+    uint32_t U32()
+    {
+        const uint32_t lo = U16();
+        return lo | (static_cast<uint32_t>(U16()) << 16);
+    }
+    std::wstring String()
+    {
+        const uint16_t length = U16();
+        if (m_data.size() < length * 2u) {
+            m_ok = false;
+            return {};
+        }
+        std::wstring str(length, 0);
+        for (auto& c : str)
+            c = static_cast<wchar_t>(U16());
+        return str;
+    }
+    std::string Text()
+    {
+        const uint32_t length = U32();
+        if (m_data.size() < length) {
+            m_ok = false;
+            return {};
+        }
+        std::string text(m_data.begin(), m_data.begin() + length);
+        m_data = m_data.subspan(length);
+        return text;
+    }
+    hdr::DisplayId Id()
+    {
+        hdr::DisplayId id;
+        id.adapterLow = U32();
+        id.adapterHigh = static_cast<int32_t>(U32());
+        id.targetId = U32();
+        return id;
+    }
+    std::optional<hdr::Status> Status()
+    {
+        const uint8_t value = U8();
+        if (value == 0xFF)
+            return std::nullopt;
+        if (value > static_cast<uint8_t>(hdr::Status::On)) {
+            m_ok = false;
+            return std::nullopt;
+        }
+        return static_cast<hdr::Status>(value);
+    }
+    /// Number of following elements of the given minimum size; 0 and failure if there can't be that many
+    uint16_t Count(size_t elementSize)
+    {
+        const uint16_t count = U16();
+        if (m_data.size() < count * elementSize) {
+            m_ok = false;
+            return 0;
+        }
+        return count;
+    }
+};
+
+// Flag bits of a display entry
+constexpr uint8_t kEntryUnchanged = 1;
+
+} // namespace
+
+std::vector<uint8_t> EncodeFrame(const Request& request)
+{
+    Writer w;
+    w.U8(static_cast<uint8_t>(request.command));
+    w.U8(request.enable ? 1 : 0);
+    w.U16(static_cast<uint16_t>(request.displays.size()));
+    for (const auto& id : request.displays)
+        w.Id(id);
+    w.String(request.path);
+    return w.Finish();
+}
+
+std::vector<uint8_t> EncodeFrame(const Response& response)
+{
+    Writer w;
+    w.U8(static_cast<uint8_t>(response.result));
+    w.Status(response.status);
+    w.Status(response.changedStatus);
+    w.U16(static_cast<uint16_t>(response.displays.size()));
+    for (const auto& entry : response.displays) {
+        w.Id(entry.id);
+        w.Status(entry.status);
+        w.U8(entry.unchanged ? kEntryUnchanged : 0);
+        w.String(entry.name);
+    }
+    w.Text(response.metrics);
+    return w.Finish();
+}
+
+std::optional<uint32_t> PayloadSize(std::span<const uint8_t, kFrameHeaderSize> header)
+{
+    uint32_t size = 0;
+    for (size_t i = 0; i < kFrameHeaderSize; i++)
+        size |= static_cast<uint32_t>(header[i]) << (i * 8);
+    if (size == 0 || size > kMaxPayloadSize)
+        return std::nullopt;
+    return size;
+}
+
+std::optional<Request> DecodeRequest(std::span<const uint8_t> payload)
+{
+    Reader r(payload);
+    if (r.U8() != kVersion)
+        return std::nullopt;
+
+    Request request;
+    const uint8_t command = r.U8();
+    if (command < static_cast<uint8_t>(Command::GetStatus) || command > static_cast<uint8_t>(Command::GetMetrics))
+        return std::nullopt;
+    request.command = static_cast<Command>(command);
+    request.enable = r.U8() != 0;
+    const uint16_t count = r.Count(12);
+    request.displays.reserve(count);
+    for (uint16_t i = 0; i < count; i++)
+        request.displays.push_back(r.Id());
+    request.path = r.String();
+
+    if (!r.Done())
+        return std::nullopt;
+    return request;
+}
+
+std::optional<Response> DecodeResponse(std::span<const uint8_t> payload)
+{
+    Reader r(payload);
+    if (r.U8() != kVersion)
+        return std::nullopt;
+
+    Response response;
+    const uint8_t result = r.U8();
+    if (result > static_cast<uint8_t>(Result::Unavailable))
+        return std::nullopt;
+    response.result = static_cast<Result>(result);
+    response.status = r.Status().value_or(hdr::Status::Unsupported);
+    response.changedStatus = r.Status();
+    const uint16_t count = r.Count(16);
+    response.displays.reserve(count);
+    for (uint16_t i = 0; i < count; i++) {
+        DisplayEntry entry;
+        entry.id = r.Id();
+        entry.status = r.Status();
+        entry.unchanged = (r.U8() & kEntryUnchanged) != 0;
+        entry.name = r.String();
+        response.displays.push_back(std::move(entry));
+    }
+    response.metrics = r.Text();
+
+    if (!r.Done())
+        return std::nullopt;
+    return response;
+}
+
+} // namespace ipc
@@ -0,0 +1,118 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef IPCPROTOCOL_HPP_
+#define IPCPROTOCOL_HPP_
+
+#include "HDR.h"
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * Requests HDRCmd sends to a running HDRTray, and its responses.
+ *
+ * Each message is a frame: payload length (32 bit, little endian), then the payload,
+ * starting with the protocol version. Integers are little endian; strings are a 16 bit
+ * length followed by UTF-16 code units, text is a 32 bit length followed by bytes; a DisplayId
+ * is adapter LUID low and high part and target id, 32 bits each.
+ */
+namespace ipc {
+
+inline constexpr uint8_t kVersion = 3;
+/// Size of the length prefix
+inline constexpr size_t kFrameHeaderSize = 4;
+/// Largest payload accepted
+inline constexpr uint32_t kMaxPayloadSize = 64 * 1024;
+
+enum class Command : uint8_t
+{
+    /// Overall HDR status
+    GetStatus = 1,
+    /// Status, id and name of all displays
+    GetDisplays = 2,
+    /// Turn HDR on or off, on the given displays or on all if there are none
+    SetStatus = 3,
+    /// Write the spans recorded so far to a Chrome trace file
+    SaveTrace = 4,
+    /// Current metrics, see metrics::Format()
+    GetMetrics = 5,
+};
+
+struct Request
+{
+    Command command = Command::GetStatus;
+    /// SetStatus: whether to turn HDR on
+    bool enable = false;
+    /// SetStatus: displays to change
+    std::vector<hdr::DisplayId> displays {};
+    /// SaveTrace: absolute path of the file to write
+    std::wstring path {};
+};
+
+enum class Result : uint8_t
+{
+    Ok = 0,
+    /// The request was understood but couldn't be carried out
+    Failed = 1,
+    /// The request was not understood, eg from a newer HDRCmd
+    BadRequest = 2,
+    /// The server can't handle requests right now; the client should do the work itself
+    Unavailable = 3,
+};
+
+struct DisplayEntry
+{
+    hdr::DisplayId id;
+    std::wstring name;
+    /// Status; nothing if the display was not found or changing it failed
+    std::optional<hdr::Status> status;
+    /// SetStatus: the display already had the requested status
+    bool unchanged = false;
+};
+
+struct Response
+{
+    Result result = Result::Ok;
+    /// Overall status, after any change
+    hdr::Status status = hdr::Status::Unsupported;
+    /// SetStatus on all displays: result of SetWindowsHDRStatus()
+    std::optional<hdr::Status> changedStatus;
+    /// GetDisplays: all displays; SetStatus on some displays: one entry per requested display
+    std::vector<DisplayEntry> displays;
+    /// GetMetrics: metrics::Format() of the current metrics
+    std::string metrics;
+};
+
+/// Encode a request as a frame, including the length prefix
+std::vector<uint8_t> EncodeFrame(const Request& request);
+std::vector<uint8_t> EncodeFrame(const Response& response);
+
+/// Get the payload size from a frame header, nothing if it's too large
+std::optional<uint32_t> PayloadSize(std::span<const uint8_t, kFrameHeaderSize> header);
+
+/// Decode a payload (without the length prefix); nothing if it's malformed or of another version
+std::optional<Request> DecodeRequest(std::span<const uint8_t> payload);
+std::optional<Response> DecodeResponse(std::span<const uint8_t> payload);
+
+} // namespace ipc
+
+#endif // IPCPROTOCOL_HPP_
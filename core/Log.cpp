@@ -0,0 +1,709 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Log.hpp"
+
+#include "DebugOutput.hpp"
+#include "MappedFile.hpp"
+#include "Unicode.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace logging {
+
+namespace detail {
+
+std::atomic<Level> levels[kCategoryCount] = { Level::Info, Level::Info, Level::Info, Level::Info,
+                                              Level::Info, Level::Info, Level::Info };
+
+} // namespace detail
+
+namespace {
+
+/// Bytes of records waiting for the background thread
+constexpr size_t kQueueSize = 256 * 1024;
+/// How long records may wait before the background thread writes them
+constexpr auto kFlushInterval = std::chrono::milliseconds(250);
+
+struct RecordHeader
+{
+    uint16_t size;
+    Level level;
+    Category category;
+    uint32_t threadId;
+    /// Microseconds since the Unix epoch
+    int64_t timeUs;
+    const char* format;
+};
+static_assert(sizeof(RecordHeader) <= detail::kMaxRecordSize);
+static_assert(std::is_trivially_copyable_v<RecordHeader>);
+
+enum class ArgType : uint8_t
+{
+    Int,
+    UInt,
+    Double,
+    Bool,
+    String,
+    WString
+};
+
+uint32_t CurrentThreadId()
+{
+    static std::atomic<uint32_t> nextId { 1 };
+    thread_local const uint32_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+/// Log files: the current one, mapped into memory, and older ones with a number appended
+class LogFile
+{
+public:
+    bool Open(const FileOptions& options)
+    {
+        Close();
+        m_options = options;
+        m_options.fileSize = std::max<size_t>(m_options.fileSize, 4096);
+        Rotate();
+        return Begin();
+    }
+
+    void Close()
+    {
+        if (m_file.IsOpen())
+            m_file.Close(m_position);
+        m_position = 0;
+    }
+
+    /// Append text; starts a new file if it doesn't fit. @return Number of new files started
+    unsigned Write(std::string_view text)
+    {
+        if (!m_file.IsOpen())
+            return 0;
+        unsigned rotations = 0;
+        if (m_position + text.size() > m_file.Size() && m_position > 0) {
+            Close();
+            Rotate();
+            if (!Begin())
+                return 0;
+            rotations++;
+        }
+        const size_t length = std::min(text.size(), m_file.Size() - m_position);
+        std::memcpy(static_cast<char*>(m_file.Data()) + m_position, text.data(), length);
+        m_position += length;
+        return rotations;
+    }
+
+private:
+    FileOptions m_options;
+    MappedFile m_file;
+    /// Bytes written to the current file
+    size_t m_position = 0;
+
+    std::filesystem::path FilePath(unsigned index) const
+    {
+        auto name = m_options.baseName;
+        if (index > 0)
+            name += L"." + std::to_wstring(index);
+        return m_options.directory / (name + L".log");
+    }
+
+    bool Begin()
+    {
+        m_position = 0;
+        return m_file.Create(FilePath(0), m_options.fileSize);
+    }
+
+    /// Move the current file out of the way, dropping the oldest one
+    void Rotate()
+    {
+        std::error_code ec;
+        std::filesystem::remove(FilePath(m_options.keepFiles), ec);
+        for (unsigned i = m_options.keepFiles; i > 0; i--) {
+            if (std::filesystem::exists(FilePath(i - 1), ec))
+                std::filesystem::rename(FilePath(i - 1), FilePath(i), ec);
+        }
+    }
+};
+
+struct Logger
+{
+    /// Guards the queue and the thread state
+    std::mutex mutex;
+    std::condition_variable wake;
+    /// Records in order; written and read are byte positions, the offset is position % kQueueSize
+    std::vector<uint8_t> queue;
+    uint64_t written = 0;
+    uint64_t read = 0;
+    bool running = false;
+    bool stopping = false;
+    bool wakeRequested = false;
+    std::thread thread;
+
+    /// Serializes writing records out; guards everything below
+    std::mutex drainMutex;
+    LogFile file;
+    std::vector<uint8_t> pending;
+    std::wstring line;
+    std::string utf8;
+    uint64_t droppedReported = 0;
+
+    std::atomic<uint64_t> records { 0 };
+    std::atomic<uint64_t> dropped { 0 };
+    std::atomic<uint64_t> fileBytes { 0 };
+    std::atomic<uint64_t> rotations { 0 };
+};
+
+Logger& GetLogger()
+{
+    // Never destroyed: records may still be logged during process exit
+    static Logger* logger = new Logger;
+    return *logger;
+}
+
+/// Append ASCII text: format literals, numbers, time stamps
+void AppendAscii(std::wstring& out, std::string_view str)
+{
+    for (char c : str)
+        out += static_cast<wchar_t>(static_cast<unsigned char>(c));
+}
+
+/// Append a narrow string argument; text that isn't valid UTF-8 (eg in the ANSI code page) is taken as Latin-1
+void AppendUtf8(std::wstring& out, std::string_view str)
+{
+    std::wstring decoded;
+    if (unicode::DecodeUtf8(str, decoded))
+        out += decoded;
+    else
+        AppendAscii(out, str);
+}
+
+void AppendInteger(std::wstring& out, uint64_t magnitude, bool negative, std::string_view spec)
+{
+    bool zeroPad = false;
+    size_t width = 0;
+    unsigned base = 10;
+    bool upper = false;
+    size_t i = 0;
+    if (i < spec.size() && spec[i] == '0') {
+        zeroPad = true;
+        i++;
+    }
+    for (; i < spec.size() && spec[i] >= '0' && spec[i] <= '9'; i++)
+        width = width * 10 + (spec[i] - '0');
+    if (i < spec.size()) {
+        base = 16;
+        upper = spec[i] == 'X';
+    }
+
+    wchar_t digits[24];
+    size_t count = 0;
+    do {
+        const unsigned digit = static_cast<unsigned>(magnitude % base);
+        digits[count++] = static_cast<wchar_t>(digit < 10 ? L'0' + digit : (upper ? L'A' : L'a') + digit - 10);
+        magnitude /= base;
+    } while (magnitude != 0);
+
+    const size_t length = count + (negative ? 1 : 0);
+    if (!zeroPad && width > length)
+        out.append(width - length, L' ');
+    if (negative)
+        out += L'-';
+    if (zeroPad && width > length)
+        out.append(width - length, L'0');
+    while (count > 0)
+        out += digits[--count];
+}
+
+/// Reads the arguments of a record
+class ArgReader
+{
+public:
+    ArgReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) { }
+
+    /// Format the next argument; "?" if there's none
+    void Append(std::wstring& out, std::string_view spec)
+    {
+        if (m_size < 1) {
+            out += L'?';
+            return;
+        }
+        const auto type = static_cast<ArgType>(m_data[0]);
+        Skip(1);
+        switch (type) {
+        case ArgType::Int: {
+            const auto value = Read<int64_t>();
+            const uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+            AppendInteger(out, magnitude, value < 0, spec);
+            break;
+        }
+        case ArgType::UInt:
+            AppendInteger(out, Read<uint64_t>(), false, spec);
+            break;
+        case ArgType::Double: {
+            char number[32];
+            std::snprintf(number, sizeof(number), "%g", Read<double>());
+            AppendAscii(out, number);
+            break;
+        }
+        case ArgType::Bool:
+            out += Read<uint8_t>() ? L"true" : L"false";
+            break;
+        case ArgType::String: {
+            const auto length = Read<uint16_t>();
+            AppendUtf8(out, std::string_view(reinterpret_cast<const char*>(m_data), length));
+            Skip(length);
+            break;
+        }
+        case ArgType::WString: {
+            const auto length = Read<uint16_t>();
+            for (uint16_t i = 0; i < length; i++)
+                out += Read<wchar_t>();
+            break;
+        }
+        }
+    }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+
+    void Skip(size_t size)
+    {
+        m_data += size;
+        m_size -= size;
+    }
+
+    template<typename T>
+    T Read()
+    {
+        T value;
+        std::memcpy(&value, m_data, sizeof(T));
+        Skip(sizeof(T));
+        return value;
+    }
+};
+
+void AppendTimestamp(std::wstring& out, int64_t timeUs)
+{
+    // Converting to local time is slow, and records come in bursts: reuse the last second
+    thread_local std::time_t lastSeconds = -1;
+    thread_local char lastStamp[32];
+    const std::time_t seconds = static_cast<std::time_t>(timeUs / 1000000);
+    if (seconds != lastSeconds) {
+        std::tm local {};
+#if defined(_WIN32)
+        localtime_s(&local, &seconds);
+#else
+        localtime_r(&seconds, &local);
+#endif
+        std::strftime(lastStamp, sizeof(lastStamp), "%Y-%m-%d %H:%M:%S", &local);
+        lastSeconds = seconds;
+    }
+    char millis[8];
+    std::snprintf(millis, sizeof(millis), ".%03d", static_cast<int>(timeUs / 1000 % 1000));
+    AppendAscii(out, lastStamp);
+    AppendAscii(out, millis);
+}
+
+/// Format a record as a line of text
+void FormatRecord(const uint8_t* data, std::wstring& out)
+{
+    RecordHeader header;
+    std::memcpy(&header, data, sizeof(header));
+
+    out.clear();
+    AppendTimestamp(out, header.timeUs);
+    char prefix[48];
+    std::snprintf(prefix, sizeof(prefix), " %-7s %-10s [%u] ", LevelName(header.level), CategoryName(header.category),
+                  header.threadId);
+    AppendAscii(out, prefix);
+
+    ArgReader args(data + sizeof(header), header.size - sizeof(header));
+    const std::string_view format(header.format);
+    for (size_t i = 0; i < format.size(); i++) {
+        const char c = format[i];
+        if ((c == '{' || c == '}') && i + 1 < format.size() && format[i + 1] == c) {
+            out += static_cast<wchar_t>(c);
+            i++;
+        } else if (c == '{') {
+            const size_t end = format.find('}', i);
+            std::string_view spec = format.substr(i + 1, end - i - 1);
+            if (!spec.empty() && spec[0] == ':')
+                spec.remove_prefix(1);
+            args.Append(out, spec);
+            i = end;
+        } else {
+            out += static_cast<wchar_t>(static_cast<unsigned char>(c));
+        }
+    }
+    out += L'\n';
+}
+
+/// Write a line to the debug output and, if there is one, the log file; with drainMutex held
+void WriteLine(Logger& logger, const std::wstring& line)
+{
+    DebugOutput(line.c_str());
+    logger.utf8.clear();
+    unicode::EncodeUtf8(line, logger.utf8);
+    logger.rotations += logger.file.Write(logger.utf8);
+    logger.fileBytes += logger.utf8.size();
+}
+
+/// Format and write all queued records
+void Drain(Logger& logger)
+{
+    std::lock_guard drainLock(logger.drainMutex);
+    {
+        std::lock_guard lock(logger.mutex);
+        const size_t size = static_cast<size_t>(logger.written - logger.read);
+        logger.pending.resize(size);
+        if (size > 0) {
+            const size_t offset = static_cast<size_t>(logger.read % kQueueSize);
+            const size_t first = std::min(size, kQueueSize - offset);
+            std::memcpy(logger.pending.data(), logger.queue.data() + offset, first);
+            std::memcpy(logger.pending.data() + first, logger.queue.data(), size - first);
+        }
+        logger.read = logger.written;
+    }
+
+    for (size_t offset = 0; offset < logger.pending.size();) {
+        uint16_t size;
+        std::memcpy(&size, logger.pending.data() + offset, sizeof(size));
+        FormatRecord(logger.pending.data() + offset, logger.line);
+        WriteLine(logger, logger.line);
+        offset += size;
+    }
+
+    const uint64_t dropped = logger.dropped.load(std::memory_order_relaxed);
+    if (dropped != logger.droppedReported) {
+        logger.line = L"Log queue full, " + std::to_wstring(dropped - logger.droppedReported) + L" records dropped\n";
+        WriteLine(logger, logger.line);
+        logger.droppedReported = dropped;
+    }
+}
+
+void Run(Logger& logger)
+{
+    std::unique_lock lock(logger.mutex);
+    while (!logger.stopping) {
+        logger.wake.wait_for(lock, kFlushInterval, [&]() { return logger.stopping || logger.wakeRequested; });
+        logger.wakeRequested = false;
+        lock.unlock();
+        Drain(logger);
+        lock.lock();
+    }
+}
+
+} // namespace
+
+const char* LevelName(Level level)
+{
+    switch (level) {
+    case Level::Debug:
+        return "debug";
+    case Level::Info:
+        return "info";
+    case Level::Warning:
+        return "warning";
+    case Level::Error:
+        return "error";
+    case Level::Off:
+        break;
+    }
+    return "off";
+}
+
+const char* CategoryName(Category category)
+{
+    switch (category) {
+    case Category::General:
+        return "general";
+    case Category::Display:
+        return "display";
+    case Category::Profile:
+        return "profile";
+    case Category::Ddc:
+        return "ddc";
+    case Category::Transition:
+        return "transition";
+    case Category::Config:
+        return "config";
+    case Category::Ipc:
+        return "ipc";
+    }
+    return "?";
+}
+
+void SetLevel(Level level)
+{
+    for (auto& categoryLevel : detail::levels)
+        categoryLevel.store(level, std::memory_order_relaxed);
+}
+
+void SetLevel(Category category, Level level)
+{
+    detail::levels[static_cast<size_t>(category)].store(level, std::memory_order_relaxed);
+}
+
+static bool EqualsIgnoreCase(std::string_view a, std::string_view b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+               return (x >= 'A' && x <= 'Z' ? x - 'A' + 'a' : x) == y;
+           });
+}
+
+static std::string_view Trim(std::string_view str)
+{
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t'))
+        str.remove_prefix(1);
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t'))
+        str.remove_suffix(1);
+    return str;
+}
+
+bool Configure(std::string_view spec)
+{
+    while (!spec.empty()) {
+        const size_t comma = spec.find(',');
+        const auto item = Trim(spec.substr(0, comma));
+        spec = comma == std::string_view::npos ? std::string_view {} : spec.substr(comma + 1);
+        if (item.empty())
+            continue;
+
+        const size_t equals = item.find('=');
+        const auto levelName = Trim(equals == std::string_view::npos ? item : item.substr(equals + 1));
+        std::optional<Level> level;
+        for (auto candidate : { Level::Debug, Level::Info, Level::Warning, Level::Error, Level::Off }) {
+            if (EqualsIgnoreCase(levelName, LevelName(candidate)))
+                level = candidate;
+        }
+        if (!level)
+            return false;
+        if (equals == std::string_view::npos) {
+            SetLevel(*level);
+            continue;
+        }
+
+        const auto categoryName = Trim(item.substr(0, equals));
+        bool found = false;
+        for (size_t i = 0; i < kCategoryCount; i++) {
+            const auto category = static_cast<Category>(i);
+            if (EqualsIgnoreCase(categoryName, CategoryName(category))) {
+                SetLevel(category, *level);
+                found = true;
+            }
+        }
+        if (!found)
+            return false;
+    }
+    return true;
+}
+
+bool Start(const FileOptions& file)
+{
+    auto& logger = GetLogger();
+    bool fileOk = true;
+    {
+        std::lock_guard drainLock(logger.drainMutex);
+        if (!file.directory.empty())
+            fileOk = logger.file.Open(file);
+    }
+    std::lock_guard lock(logger.mutex);
+    if (logger.running)
+        return fileOk;
+    if (logger.queue.empty())
+        logger.queue.resize(kQueueSize);
+    logger.running = true;
+    logger.stopping = false;
+    logger.thread = std::thread([&logger]() { Run(logger); });
+    return fileOk;
+}
+
+void Stop()
+{
+    auto& logger = GetLogger();
+    {
+        std::lock_guard lock(logger.mutex);
+        if (!logger.running || logger.stopping)
+            return;
+        logger.stopping = true;
+    }
+    logger.wake.notify_one();
+    logger.thread.join();
+    {
+        // Records logged from now on are written right away
+        std::lock_guard lock(logger.mutex);
+        logger.running = false;
+    }
+    Drain(logger);
+    std::lock_guard drainLock(logger.drainMutex);
+    logger.file.Close();
+}
+
+void Flush()
+{
+    Drain(GetLogger());
+}
+
+Stats GetStats()
+{
+    auto& logger = GetLogger();
+    Stats stats;
+    stats.records = logger.records.load(std::memory_order_relaxed);
+    stats.dropped = logger.dropped.load(std::memory_order_relaxed);
+    stats.fileBytes = logger.fileBytes.load(std::memory_order_relaxed);
+    stats.rotations = logger.rotations.load(std::memory_order_relaxed);
+    return stats;
+}
+
+namespace detail {
+
+Record::Record(Level level, Category category, const char* format) : m_size(sizeof(RecordHeader))
+{
+    RecordHeader header;
+    header.size = 0;
+    header.level = level;
+    header.category = category;
+    header.threadId = CurrentThreadId();
+    header.timeUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::system_clock::now().time_since_epoch())
+                        .count();
+    header.format = format;
+    std::memcpy(m_data, &header, sizeof(header));
+}
+
+uint8_t* Record::Reserve(size_t size)
+{
+    if (m_size + size > kMaxRecordSize)
+        return nullptr;
+    uint8_t* data = m_data + m_size;
+    m_size += size;
+    return data;
+}
+
+template<typename T>
+static void AddValue(uint8_t* dest, ArgType type, T value)
+{
+    dest[0] = static_cast<uint8_t>(type);
+    std::memcpy(dest + 1, &value, sizeof(T));
+}
+
+void Record::Add(int64_t value)
+{
+    if (auto* dest = Reserve(1 + sizeof(value)))
+        AddValue(dest, ArgType::Int, value);
+}
+
+void Record::Add(uint64_t value)
+{
+    if (auto* dest = Reserve(1 + sizeof(value)))
+        AddValue(dest, ArgType::UInt, value);
+}
+
+void Record::Add(double value)
+{
+    if (auto* dest = Reserve(1 + sizeof(value)))
+        AddValue(dest, ArgType::Double, value);
+}
+
+void Record::Add(bool value)
+{
+    if (auto* dest = Reserve(2))
+        AddValue(dest, ArgType::Bool, static_cast<uint8_t>(value ? 1 : 0));
+}
+
+void Record::Add(std::string_view value)
+{
+    // Cut off to what's left, keeping room for later numbers
+    const size_t room = kMaxRecordSize - std::min(kMaxRecordSize, m_size + 3);
+    auto length = static_cast<uint16_t>(std::min({ value.size(), kMaxStringLength, room }));
+    // Don't cut a UTF-8 sequence in half
+    if (length < value.size()) {
+        while (length > 0 && (static_cast<unsigned char>(value[length]) & 0xC0) == 0x80)
+            length--;
+    }
+    if (auto* dest = Reserve(3 + length)) {
+        AddValue(dest, ArgType::String, length);
+        std::memcpy(dest + 3, value.data(), length);
+    }
+}
+
+void Record::Add(std::wstring_view value)
+{
+    const size_t room = (kMaxRecordSize - std::min(kMaxRecordSize, m_size + 3)) / sizeof(wchar_t);
+    const auto length = static_cast<uint16_t>(std::min({ value.size(), kMaxStringLength, room }));
+    if (auto* dest = Reserve(3 + length * sizeof(wchar_t))) {
+        AddValue(dest, ArgType::WString, length);
+        std::memcpy(dest + 3, value.data(), length * sizeof(wchar_t));
+    }
+}
+
+void Record::Submit()
+{
+    const auto size = static_cast<uint16_t>(m_size);
+    std::memcpy(m_data, &size, sizeof(size));
+    const auto level = static_cast<Level>(m_data[offsetof(RecordHeader, level)]);
+
+    auto& logger = GetLogger();
+    logger.records.fetch_add(1, std::memory_order_relaxed);
+    bool wake = false;
+    {
+        std::unique_lock lock(logger.mutex);
+        if (!logger.running) {
+            lock.unlock();
+            // Nobody formats records in the background, write it right away
+            std::wstring line;
+            FormatRecord(m_data, line);
+            DebugOutput(line.c_str());
+            return;
+        }
+        const size_t used = static_cast<size_t>(logger.written - logger.read);
+        if (kQueueSize - used < m_size) {
+            logger.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        const size_t offset = static_cast<size_t>(logger.written % kQueueSize);
+        const size_t first = std::min(m_size, kQueueSize - offset);
+        std::memcpy(logger.queue.data() + offset, m_data, first);
+        std::memcpy(logger.queue.data(), m_data + first, m_size - first);
+        logger.written += m_size;
+        // Warnings and errors are written soon, in case the process is about to crash
+        if (!logger.wakeRequested && (level >= Level::Warning || used + m_size > kQueueSize / 2)) {
+            logger.wakeRequested = true;
+            wake = true;
+        }
+    }
+    if (wake)
+        logger.wake.notify_one();
+}
+
+} // namespace detail
+
+} // namespace logging
@@ -0,0 +1,299 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOG_HPP_
+#define LOG_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+/**
+ * Logging with deferred formatting.
+ *
+ * A log call checks the level of its category, then stores the arguments in binary form,
+ * together with a pointer to the format string; no strings are built and nothing is
+ * allocated. Once Start() was called, a background thread formats the records and writes
+ * them to the debug output and a rotating log file. Without Start(), records are formatted
+ * and written to the debug output right away.
+ *
+ * Format strings are checked at compile time: one "{}" per argument, "{{" and "}}" for braces.
+ * Integers may have a spec like "{:x}", "{:02X}" or "{:4}": zero padding, width, hexadecimal.
+ * Arguments can be integers, enums, bools, floating point numbers, narrow and wide strings;
+ * long strings are cut off.
+ */
+namespace logging {
+
+enum class Level : uint8_t
+{
+    Debug,
+    Info,
+    Warning,
+    Error,
+    /// Only for filtering: nothing is logged
+    Off
+};
+
+enum class Category : uint8_t
+{
+    General,
+    /// HDR status and display changes
+    Display,
+    /// Color profiles and calibrations
+    Profile,
+    /// DDC/CI monitor control
+    Ddc,
+    /// HDR toggles, reapplies and prewarming
+    Transition,
+    /// HDRTray.ini
+    Config,
+    /// Requests from HDRCmd
+    Ipc,
+};
+inline constexpr size_t kCategoryCount = 7;
+
+#ifndef HDRTRAY_LOG_MIN_LEVEL
+#define HDRTRAY_LOG_MIN_LEVEL 0
+#endif
+/// Log calls below this level are compiled out
+inline constexpr Level kMinLevel = static_cast<Level>(HDRTRAY_LOG_MIN_LEVEL);
+
+const char* LevelName(Level level);
+const char* CategoryName(Category category);
+
+/// Log records of the category at the given level and above; all categories if there's none
+void SetLevel(Level level);
+void SetLevel(Category category, Level level);
+/**
+ * Set levels from a specification like "debug" or "info,ddc=debug,config=warning":
+ * a level for all categories, and levels for single categories.
+ * @return false if it's malformed; levels given before the error are set
+ */
+bool Configure(std::string_view spec);
+
+struct FileOptions
+{
+    std::filesystem::path directory;
+    /// Log file name without extension; older files get ".1", ".2" and so on appended
+    std::wstring baseName = L"HDRTray";
+    /// Size of each file
+    size_t fileSize = 1024 * 1024;
+    /// Older files kept besides the current one
+    unsigned keepFiles = 3;
+};
+
+/**
+ * Start formatting and writing records on a background thread.
+ * @param file Log file to write as well as the debug output; no file if directory is empty
+ * @return false if the log file couldn't be created; records still go to the debug output
+ */
+bool Start(const FileOptions& file);
+/// Write all pending records and stop the background thread
+void Stop();
+/// Write all records logged so far
+void Flush();
+
+struct Stats
+{
+    /// Records logged
+    uint64_t records = 0;
+    /// Records lost because the queue was full
+    uint64_t dropped = 0;
+    /// Bytes written to log files
+    uint64_t fileBytes = 0;
+    /// Log files started because the previous one was full
+    uint64_t rotations = 0;
+};
+Stats GetStats();
+
+namespace detail {
+
+extern std::atomic<Level> levels[kCategoryCount];
+
+/// Largest record, including the header; arguments that don't fit are left out
+inline constexpr size_t kMaxRecordSize = 512;
+/// Longer string arguments are cut off
+inline constexpr size_t kMaxStringLength = 200;
+
+template<typename T>
+concept Loggable = std::is_arithmetic_v<std::remove_cvref_t<T>> || std::is_enum_v<std::remove_cvref_t<T>>
+                   || std::is_convertible_v<const T&, std::string_view>
+                   || std::is_convertible_v<const T&, std::wstring_view>;
+
+/// Number of placeholders in a format string; throws (failing compilation) if it's malformed
+consteval size_t CountPlaceholders(std::string_view format)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < format.size(); i++) {
+        if (format[i] == '}') {
+            if (i + 1 >= format.size() || format[i + 1] != '}')
+                throw "Unmatched '}' in format string";
+            i++;
+            continue;
+        }
+        if (format[i] != '{')
+            continue;
+        if (i + 1 < format.size() && format[i + 1] == '{') {
+            i++;
+            continue;
+        }
+        i++;
+        if (i < format.size() && format[i] == ':') {
+            i++;
+            while (i < format.size() && format[i] >= '0' && format[i] <= '9')
+                i++;
+            if (i < format.size() && (format[i] == 'x' || format[i] == 'X'))
+                i++;
+        }
+        if (i >= format.size() || format[i] != '}')
+            throw "Invalid placeholder in format string";
+        count++;
+    }
+    return count;
+}
+
+/// Format string, checked against the argument types at compile time
+template<typename... Args>
+class FormatString
+{
+public:
+    template<size_t N>
+    consteval FormatString(const char (&str)[N]) : m_str(str)
+    {
+        if (CountPlaceholders(std::string_view(str, N - 1)) != sizeof...(Args))
+            throw "Number of placeholders doesn't match the number of arguments";
+    }
+
+    const char* Get() const { return m_str; }
+
+private:
+    const char* m_str;
+};
+
+/// Record being built on the stack
+class Record
+{
+public:
+    Record(Level level, Category category, const char* format);
+
+    void Add(int64_t value);
+    void Add(uint64_t value);
+    void Add(double value);
+    void Add(bool value);
+    void Add(std::string_view value);
+    void Add(std::wstring_view value);
+
+    template<typename T>
+    void AddArg(const T& value)
+    {
+        using U = std::remove_cvref_t<T>;
+        if constexpr (std::is_same_v<U, bool>)
+            Add(value);
+        else if constexpr (std::is_enum_v<U>)
+            AddArg(static_cast<std::underlying_type_t<U>>(value));
+        else if constexpr (std::is_floating_point_v<U>)
+            Add(static_cast<double>(value));
+        else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>)
+            Add(static_cast<int64_t>(value));
+        else if constexpr (std::is_integral_v<U>)
+            Add(static_cast<uint64_t>(value));
+        else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+            Add(std::string_view(value));
+        else
+            Add(std::wstring_view(value));
+    }
+
+    /// Queue the record, or write it if logging wasn't started
+    void Submit();
+
+private:
+    size_t m_size;
+    alignas(uint64_t) uint8_t m_data[kMaxRecordSize];
+
+    /// Reserve space for an argument; nullptr if it doesn't fit
+    uint8_t* Reserve(size_t size);
+};
+
+template<typename... Args>
+void Write(Level level, Category category, const char* format, const Args&... args)
+{
+    Record record(level, category, format);
+    (record.AddArg(args), ...);
+    record.Submit();
+}
+
+} // namespace detail
+
+/// Whether records of the level and category are logged
+inline bool IsEnabled(Level level, Category category)
+{
+    return level >= kMinLevel
+           && level >= detail::levels[static_cast<size_t>(category)].load(std::memory_order_relaxed);
+}
+
+template<detail::Loggable... Args>
+void Log(Level level, Category category, detail::FormatString<std::type_identity_t<Args>...> format,
+         const Args&... args)
+{
+    if (IsEnabled(level, category))
+        detail::Write(level, category, format.Get(), args...);
+}
+
+template<detail::Loggable... Args>
+void Debug(Category category, detail::FormatString<std::type_identity_t<Args>...> format, const Args&... args)
+{
+    if constexpr (Level::Debug >= kMinLevel) {
+        if (IsEnabled(Level::Debug, category))
+            detail::Write(Level::Debug, category, format.Get(), args...);
+    }
+}
+
+template<detail::Loggable... Args>
+void Info(Category category, detail::FormatString<std::type_identity_t<Args>...> format, const Args&... args)
+{
+    if constexpr (Level::Info >= kMinLevel) {
+        if (IsEnabled(Level::Info, category))
+            detail::Write(Level::Info, category, format.Get(), args...);
+    }
+}
+
+template<detail::Loggable... Args>
+void Warning(Category category, detail::FormatString<std::type_identity_t<Args>...> format, const Args&... args)
+{
+    if constexpr (Level::Warning >= kMinLevel) {
+        if (IsEnabled(Level::Warning, category))
+            detail::Write(Level::Warning, category, format.Get(), args...);
+    }
+}
+
+template<detail::Loggable... Args>
+void Error(Category category, detail::FormatString<std::type_identity_t<Args>...> format, const Args&... args)
+{
+    if constexpr (Level::Error >= kMinLevel) {
+        if (IsEnabled(Level::Error, category))
+            detail::Write(Level::Error, category, format.Get(), args...);
+    }
+}
+
+} // namespace logging
+
+#endif // LOG_HPP_
@@ -0,0 +1,58 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef MAPPEDFILE_HPP_
+#define MAPPEDFILE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+/**
+ * File of a fixed size, mapped into memory for writing.
+ * Data written to the mapping reaches the file even if the process crashes afterwards.
+ * On Windows, a file mapping of the file; elsewhere, mmap().
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /// Create the file, replacing an existing one, zero-filled to the given size, and map it
+    bool Create(const std::filesystem::path& path, size_t size);
+    /// Unmap the file, and cut it off after the given number of bytes
+    void Close(size_t length);
+
+    bool IsOpen() const { return m_data != nullptr; }
+    void* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    void* m_data = nullptr;
+    size_t m_size = 0;
+    // Platform handles: the file (INVALID_HANDLE_VALUE or a file descriptor, both -1 if there's none),
+    // and the HANDLE of the file mapping on Windows
+    intptr_t m_file = -1;
+    void* m_mapping = nullptr;
+};
+
+#endif // MAPPEDFILE_HPP_
@@ -0,0 +1,448 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Metrics.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <system_error>
+
+namespace metrics {
+
+static constexpr std::string_view kFormatHeader = "hdrtray-metrics";
+static constexpr unsigned kFormatVersion = 1;
+
+class Registry
+{
+public:
+    static Registry& Get()
+    {
+        // Never destroyed: metrics with static storage duration unregister during process exit
+        static Registry* registry = new Registry;
+        return *registry;
+    }
+
+    template<typename T>
+    void Add(std::vector<T*>& list, T* metric)
+    {
+        std::lock_guard lock(m_mutex);
+        list.push_back(metric);
+    }
+
+    template<typename T>
+    void Remove(std::vector<T*>& list, T* metric)
+    {
+        std::lock_guard lock(m_mutex);
+        std::erase(list, metric);
+    }
+
+    Snapshot Collect()
+    {
+        Snapshot snapshot;
+        snapshot.takenUnixMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                   std::chrono::system_clock::now().time_since_epoch())
+                                   .count();
+        std::lock_guard lock(m_mutex);
+        for (const auto* counter : m_counters)
+            snapshot.counters.push_back({ counter->m_name, counter->Get() });
+        for (const auto* gauge : m_gauges)
+            snapshot.gauges.push_back({ gauge->m_name, gauge->Get() });
+        for (const auto* histogram : m_histograms) {
+            HistogramValue value;
+            value.name = histogram->m_name;
+            // Count what's in the buckets, so percentiles add up while values are being recorded
+            for (size_t i = 0; i < kBucketCount; i++) {
+                const uint64_t count = histogram->m_buckets[i].load(std::memory_order_relaxed);
+                if (count == 0)
+                    continue;
+                value.buckets.emplace_back(static_cast<uint32_t>(i), count);
+                value.count += count;
+            }
+            if (value.count > 0) {
+                value.sum = histogram->m_sum.load(std::memory_order_relaxed);
+                value.min = histogram->m_min.load(std::memory_order_relaxed);
+                value.max = histogram->m_max.load(std::memory_order_relaxed);
+            }
+            snapshot.histograms.push_back(std::move(value));
+        }
+        return snapshot;
+    }
+
+    void Restore(const Snapshot& snapshot)
+    {
+        std::lock_guard lock(m_mutex);
+        for (const auto& value : snapshot.counters) {
+            if (auto* counter = Find(m_counters, value.name))
+                counter->Add(value.value);
+        }
+        for (const auto& value : snapshot.gauges) {
+            if (auto* gauge = Find(m_gauges, value.name))
+                gauge->Set(value.value);
+        }
+        for (const auto& value : snapshot.histograms) {
+            auto* histogram = Find(m_histograms, value.name);
+            if (!histogram || value.count == 0)
+                continue;
+            for (const auto& [index, count] : value.buckets) {
+                if (index < kBucketCount)
+                    histogram->m_buckets[index].fetch_add(count, std::memory_order_relaxed);
+            }
+            histogram->m_sum.fetch_add(value.sum, std::memory_order_relaxed);
+            histogram->UpdateRange(value.min);
+            histogram->UpdateRange(value.max);
+        }
+    }
+
+    void Reset()
+    {
+        std::lock_guard lock(m_mutex);
+        for (auto* counter : m_counters)
+            counter->m_value.store(0, std::memory_order_relaxed);
+        for (auto* gauge : m_gauges)
+            gauge->m_value.store(0, std::memory_order_relaxed);
+        for (auto* histogram : m_histograms) {
+            for (auto& bucket : histogram->m_buckets)
+                bucket.store(0, std::memory_order_relaxed);
+            histogram->m_sum.store(0, std::memory_order_relaxed);
+            histogram->m_min.store(UINT64_MAX, std::memory_order_relaxed);
+            histogram->m_max.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::vector<Counter*> m_counters;
+    std::vector<Gauge*> m_gauges;
+    std::vector<Histogram*> m_histograms;
+
+private:
+    std::mutex m_mutex;
+
+    template<typename T>
+    static T* Find(const std::vector<T*>& list, std::string_view name)
+    {
+        auto it = std::find_if(list.begin(), list.end(), [&](const T* metric) { return metric->m_name == name; });
+        return it != list.end() ? *it : nullptr;
+    }
+};
+
+Counter::Counter(const char* name) : m_name(name)
+{
+    auto& registry = Registry::Get();
+    registry.Add(registry.m_counters, this);
+}
+
+Counter::~Counter()
+{
+    auto& registry = Registry::Get();
+    registry.Remove(registry.m_counters, this);
+}
+
+Gauge::Gauge(const char* name) : m_name(name)
+{
+    auto& registry = Registry::Get();
+    registry.Add(registry.m_gauges, this);
+}
+
+Gauge::~Gauge()
+{
+    auto& registry = Registry::Get();
+    registry.Remove(registry.m_gauges, this);
+}
+
+Histogram::Histogram(const char* name) : m_name(name)
+{
+    auto& registry = Registry::Get();
+    registry.Add(registry.m_histograms, this);
+}
+
+Histogram::~Histogram()
+{
+    auto& registry = Registry::Get();
+    registry.Remove(registry.m_histograms, this);
+}
+
+void Histogram::Record(uint64_t value)
+{
+    value = std::min(value, kMaxValue);
+    m_buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    UpdateRange(value);
+}
+
+void Histogram::UpdateRange(uint64_t value)
+{
+    uint64_t current = m_min.load(std::memory_order_relaxed);
+    while (value < current && !m_min.compare_exchange_weak(current, value, std::memory_order_relaxed)) { }
+    current = m_max.load(std::memory_order_relaxed);
+    while (value > current && !m_max.compare_exchange_weak(current, value, std::memory_order_relaxed)) { }
+}
+
+uint64_t HistogramValue::Percentile(double percent) const
+{
+    if (count == 0)
+        return 0;
+    // Rank of the value, counting from 1
+    const double rank = std::clamp(percent, 0.0, 100.0) / 100.0 * static_cast<double>(count);
+    const uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(rank + 0.5));
+    uint64_t seen = 0;
+    for (const auto& [index, bucketCount] : buckets) {
+        seen += bucketCount;
+        if (seen >= target)
+            return std::clamp(BucketHighest(index), min, max);
+    }
+    return max;
+}
+
+template<typename T>
+static const T* FindByName(const std::vector<T>& list, std::string_view name)
+{
+    auto it = std::find_if(list.begin(), list.end(), [&](const T& value) { return value.name == name; });
+    return it != list.end() ? &*it : nullptr;
+}
+
+const CounterValue* Snapshot::FindCounter(std::string_view name) const
+{
+    return FindByName(counters, name);
+}
+
+const HistogramValue* Snapshot::FindHistogram(std::string_view name) const
+{
+    return FindByName(histograms, name);
+}
+
+template<typename T>
+static void SortByName(std::vector<T>& list)
+{
+    std::sort(list.begin(), list.end(), [](const T& a, const T& b) { return a.name < b.name; });
+}
+
+Snapshot Collect()
+{
+    auto snapshot = Registry::Get().Collect();
+    SortByName(snapshot.counters);
+    SortByName(snapshot.gauges);
+    SortByName(snapshot.histograms);
+    return snapshot;
+}
+
+void Restore(const Snapshot& snapshot)
+{
+    Registry::Get().Restore(snapshot);
+}
+
+void Reset()
+{
+    Registry::Get().Reset();
+}
+
+/// Append a number; formatting with a stream is several times slower
+template<typename T> static void AppendNumber(std::string& out, T value)
+{
+    char buffer[24];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+std::string Format(const Snapshot& snapshot)
+{
+    std::string out;
+    out.append(kFormatHeader).append(" ");
+    AppendNumber(out, kFormatVersion);
+    out.append("\ntaken ");
+    AppendNumber(out, snapshot.takenUnixMs);
+    out.push_back('\n');
+    for (const auto& counter : snapshot.counters) {
+        out.append("counter ").append(counter.name).append(" ");
+        AppendNumber(out, counter.value);
+        out.push_back('\n');
+    }
+    for (const auto& gauge : snapshot.gauges) {
+        out.append("gauge ").append(gauge.name).append(" ");
+        AppendNumber(out, gauge.value);
+        out.push_back('\n');
+    }
+    for (const auto& histogram : snapshot.histograms) {
+        out.append("histogram ").append(histogram.name);
+        for (uint64_t value : { histogram.count, histogram.sum, histogram.min, histogram.max }) {
+            out.push_back(' ');
+            AppendNumber(out, value);
+        }
+        for (const auto& [index, count] : histogram.buckets) {
+            out.push_back(' ');
+            AppendNumber(out, index);
+            out.push_back(':');
+            AppendNumber(out, count);
+        }
+        out.push_back('\n');
+    }
+    return out;
+}
+
+namespace {
+
+/// Splits a line into words separated by spaces
+class Words
+{
+public:
+    explicit Words(std::string_view line) : m_rest(line) { }
+
+    std::string_view Next()
+    {
+        while (!m_rest.empty() && m_rest.front() == ' ')
+            m_rest.remove_prefix(1);
+        const size_t end = std::min(m_rest.find(' '), m_rest.size());
+        const auto word = m_rest.substr(0, end);
+        m_rest.remove_prefix(end);
+        return word;
+    }
+
+    bool AtEnd()
+    {
+        while (!m_rest.empty() && m_rest.front() == ' ')
+            m_rest.remove_prefix(1);
+        return m_rest.empty();
+    }
+
+private:
+    std::string_view m_rest;
+};
+
+template<typename T>
+bool ParseNumber(std::string_view word, T& value)
+{
+    const auto result = std::from_chars(word.data(), word.data() + word.size(), value);
+    return result.ec == std::errc() && result.ptr == word.data() + word.size();
+}
+
+bool IsValidName(std::string_view name)
+{
+    return !name.empty() && std::all_of(name.begin(), name.end(), [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '.' || c == '_';
+    });
+}
+
+bool ParseHistogram(Words& words, HistogramValue& histogram)
+{
+    if (!ParseNumber(words.Next(), histogram.count) || !ParseNumber(words.Next(), histogram.sum)
+        || !ParseNumber(words.Next(), histogram.min) || !ParseNumber(words.Next(), histogram.max))
+        return false;
+    uint64_t total = 0;
+    while (!words.AtEnd()) {
+        const auto word = words.Next();
+        const size_t colon = word.find(':');
+        uint32_t index;
+        uint64_t count;
+        if (colon == std::string_view::npos || !ParseNumber(word.substr(0, colon), index)
+            || !ParseNumber(word.substr(colon + 1), count) || index >= kBucketCount || count == 0)
+            return false;
+        if (!histogram.buckets.empty() && histogram.buckets.back().first >= index)
+            return false;
+        histogram.buckets.emplace_back(index, count);
+        total += count;
+    }
+    return total == histogram.count && histogram.min <= histogram.max;
+}
+
+} // namespace
+
+std::optional<Snapshot> Parse(std::string_view text)
+{
+    Snapshot snapshot;
+    bool headerSeen = false;
+    while (!text.empty()) {
+        const size_t end = std::min(text.find('\n'), text.size());
+        auto line = text.substr(0, end);
+        text.remove_prefix(std::min(end + 1, text.size()));
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+
+        Words words(line);
+        const auto kind = words.Next();
+        if (kind.empty())
+            continue;
+        if (!headerSeen) {
+            unsigned version;
+            if (kind != kFormatHeader || !ParseNumber(words.Next(), version) || version != kFormatVersion)
+                return std::nullopt;
+            headerSeen = true;
+            continue;
+        }
+        if (kind == "taken") {
+            if (!ParseNumber(words.Next(), snapshot.takenUnixMs))
+                return std::nullopt;
+            continue;
+        }
+
+        const auto name = words.Next();
+        if (!IsValidName(name))
+            return std::nullopt;
+        bool ok = false;
+        if (kind == "counter") {
+            CounterValue counter { std::string(name) };
+            ok = ParseNumber(words.Next(), counter.value);
+            snapshot.counters.push_back(std::move(counter));
+        } else if (kind == "gauge") {
+            GaugeValue gauge { std::string(name) };
+            ok = ParseNumber(words.Next(), gauge.value);
+            snapshot.gauges.push_back(std::move(gauge));
+        } else if (kind == "histogram") {
+            HistogramValue histogram { std::string(name), 0, 0, 0, 0, {} };
+            ok = ParseHistogram(words, histogram);
+            snapshot.histograms.push_back(std::move(histogram));
+        } else {
+            // Kind of metric added later
+            continue;
+        }
+        if (!ok || !words.AtEnd())
+            return std::nullopt;
+    }
+    if (!headerSeen)
+        return std::nullopt;
+    return snapshot;
+}
+
+bool WriteFile(const std::filesystem::path& path)
+{
+    const auto text = Format(Collect());
+    auto temp = path;
+    temp += ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        file.write(text.data(), static_cast<std::streamsize>(text.size()));
+        if (!file.good())
+            return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp, path, ec);
+    return !ec;
+}
+
+std::optional<Snapshot> ReadFile(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return std::nullopt;
+    std::ostringstream text;
+    text << file.rdbuf();
+    return Parse(text.str());
+}
+
+} // namespace metrics
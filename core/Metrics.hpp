@@ -0,0 +1,207 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef METRICS_HPP_
+#define METRICS_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * Process wide metrics: counters, gauges and latency histograms.
+ *
+ * Metrics are objects with static storage duration that register themselves under their
+ * name; updating one is a relaxed atomic operation, without a lock or a lookup. Names must
+ * be string literals (or live as long as the process), made of letters, digits, '.' and '_';
+ * by convention, a unit goes last, as in "transition.toggle_ms".
+ *
+ * Histograms are log-linear, like HdrHistogram: values below 64 are counted exactly, larger
+ * ones in 32 buckets per power of two, so percentiles are within about 3% of the true value.
+ *
+ * A Snapshot is written as text, one metric per line, which is also how HDRTray keeps
+ * metrics across restarts and hands them to "HDRCmd stats".
+ */
+namespace metrics {
+
+/// Linear buckets per power of two are 2^kSubBucketBits
+inline constexpr unsigned kSubBucketBits = 5;
+inline constexpr uint64_t kSubBuckets = uint64_t(1) << kSubBucketBits;
+/// Larger values are counted as this
+inline constexpr uint64_t kMaxValue = (uint64_t(1) << 40) - 1;
+inline constexpr size_t kBucketCount = (40 - kSubBucketBits + 1) * kSubBuckets;
+
+/// Bucket a value is counted in
+constexpr size_t BucketIndex(uint64_t value)
+{
+    if (value > kMaxValue)
+        value = kMaxValue;
+    unsigned shift = 0;
+    while ((value >> shift) >= 2 * kSubBuckets)
+        shift++;
+    return shift * kSubBuckets + static_cast<size_t>(value >> shift);
+}
+/// Smallest value counted in a bucket
+constexpr uint64_t BucketLowest(size_t index)
+{
+    if (index < 2 * kSubBuckets)
+        return index;
+    const unsigned shift = static_cast<unsigned>(index / kSubBuckets - 1);
+    return static_cast<uint64_t>(index - shift * kSubBuckets) << shift;
+}
+/// Largest value counted in a bucket
+constexpr uint64_t BucketHighest(size_t index)
+{
+    return index + 1 < kBucketCount ? BucketLowest(index + 1) - 1 : kMaxValue;
+}
+
+class Counter
+{
+public:
+    explicit Counter(const char* name);
+    ~Counter();
+
+    Counter(const Counter&) = delete;
+    Counter& operator=(const Counter&) = delete;
+
+    void Add(uint64_t amount = 1) { m_value.fetch_add(amount, std::memory_order_relaxed); }
+    uint64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    friend class Registry;
+    const char* m_name;
+    std::atomic<uint64_t> m_value { 0 };
+};
+
+class Gauge
+{
+public:
+    explicit Gauge(const char* name);
+    ~Gauge();
+
+    Gauge(const Gauge&) = delete;
+    Gauge& operator=(const Gauge&) = delete;
+
+    void Set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+    void Add(int64_t amount) { m_value.fetch_add(amount, std::memory_order_relaxed); }
+    int64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    friend class Registry;
+    const char* m_name;
+    std::atomic<int64_t> m_value { 0 };
+};
+
+class Histogram
+{
+public:
+    explicit Histogram(const char* name);
+    ~Histogram();
+
+    Histogram(const Histogram&) = delete;
+    Histogram& operator=(const Histogram&) = delete;
+
+    void Record(uint64_t value);
+
+private:
+    friend class Registry;
+    const char* m_name;
+    std::atomic<uint64_t> m_sum { 0 };
+    /// UINT64_MAX and 0 while nothing was recorded
+    std::atomic<uint64_t> m_min { UINT64_MAX };
+    std::atomic<uint64_t> m_max { 0 };
+    std::atomic<uint64_t> m_buckets[kBucketCount] {};
+
+    void UpdateRange(uint64_t value);
+};
+
+struct CounterValue
+{
+    std::string name;
+    uint64_t value = 0;
+};
+
+struct GaugeValue
+{
+    std::string name;
+    int64_t value = 0;
+};
+
+struct HistogramValue
+{
+    std::string name;
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    /// Smallest and largest value recorded; both 0 if there are none
+    uint64_t min = 0;
+    uint64_t max = 0;
+    /// Bucket index and count of the buckets that aren't empty, by ascending index
+    std::vector<std::pair<uint32_t, uint64_t>> buckets;
+
+    /**
+     * Value below which the given percentage of the recorded values lie, within the bucket precision.
+     * @return 0 if nothing was recorded
+     */
+    uint64_t Percentile(double percent) const;
+};
+
+/// Values of all metrics at one point in time, each list sorted by name
+struct Snapshot
+{
+    /// When it was taken, milliseconds since the Unix epoch
+    uint64_t takenUnixMs = 0;
+    std::vector<CounterValue> counters;
+    std::vector<GaugeValue> gauges;
+    std::vector<HistogramValue> histograms;
+
+    const CounterValue* FindCounter(std::string_view name) const;
+    const HistogramValue* FindHistogram(std::string_view name) const;
+};
+
+/// Current values of all registered metrics
+Snapshot Collect();
+/**
+ * Add the values of a snapshot, eg one saved by an earlier run, to the registered metrics:
+ * counts and histograms are summed up, gauges are set. Metrics that aren't registered are ignored.
+ */
+void Restore(const Snapshot& snapshot);
+/// Set all registered metrics back to zero
+void Reset();
+
+/// Snapshot as text
+std::string Format(const Snapshot& snapshot);
+/// Parse text from Format(); nothing if it's malformed or of another version
+std::optional<Snapshot> Parse(std::string_view text);
+
+/// File HDRTray keeps its metrics in across restarts, next to the executable
+inline constexpr wchar_t kFileName[] = L"HDRTray.metrics";
+
+/// Write Format(Collect()) to a file, replacing it in one step
+bool WriteFile(const std::filesystem::path& path);
+/// Read a file written by WriteFile()
+std::optional<Snapshot> ReadFile(const std::filesystem::path& path);
+
+} // namespace metrics
+
+#endif // METRICS_HPP_
@@ -0,0 +1,108 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Configuration Management
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Color management settings for a monitor.
+ * Defaults, valid ranges and INI keys of the values are described in ConfigSchema.hpp.
+ */
+struct MonitorSettings
+{
+    /// Initializes all values with the defaults from the settings schema
+    MonitorSettings();
+
+    /// Display index as used by dispwin and winddcutil
+    int displayId;
+    /// EDID id of the display, if these settings are from a [Display.<id>] section
+    std::wstring edidId;
+
+    // Profile filenames
+    std::wstring sdrProfileName;
+    std::wstring hdrCalibrationName;
+
+    // Master toggle for all color management features
+    bool enableColorManagement;
+
+    // Profile enable/disable toggles
+    bool enableSdrProfile;
+    bool enableHdrProfile;
+    bool enableColorPresetChange;  // Enable changing monitor color preset for HDR
+
+    // SDR settings
+    int sdrBrightness;
+    int sdrRedGain;
+    int sdrGreenGain;
+    int sdrBlueGain;
+
+    // HDR settings
+    int hdrBrightness;
+    int hdrRedGain;
+    int hdrGreenGain;
+    int hdrBlueGain;
+    int hdrColorPreset;
+};
+
+/**
+ * Color management settings for all configured displays.
+ */
+struct ColorSettings
+{
+    /**
+     * Settings from the [Monitor], [Profiles], [SDR] and [HDR] sections.
+     * Apply to the display with index displayId, unless there are per-display settings.
+     * The enable toggles always come from here.
+     */
+    MonitorSettings defaults;
+    /**
+     * Settings from [Display.<EDID id>] sections, keyed by normalized EDID id.
+     * If there are any, displays are matched by EDID id only, and the defaults just
+     * provide values missing from a display section.
+     */
+    std::unordered_map<std::wstring, MonitorSettings> displays;
+};
+
+/**
+ * Immutable color settings.
+ * Changed settings are published as a new snapshot, so holders of a snapshot
+ * always see a consistent set of values.
+ */
+using SettingsSnapshot = std::shared_ptr<const ColorSettings>;
+
+/**
+ * Source of the current monitor settings.
+ * Implemented by ConfigManager; allows the color pipeline to run without an INI file.
+ */
+class SettingsSource
+{
+public:
+    virtual ~SettingsSource() = default;
+
+    /**
+     * Get the current settings snapshot.
+     * Cheap and safe to call from any thread; never returns nullptr.
+     */
+    virtual SettingsSnapshot GetSnapshot() const = 0;
+};
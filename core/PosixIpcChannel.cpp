@@ -0,0 +1,312 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* ipc::Server and ipc::Call() over a Unix domain socket, for the Linux build of
+ * the benchmarks and the simulator. */
+
+#include "IpcChannel.hpp"
+#include "Trace.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ipc {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Time a client has to send its request
+constexpr std::chrono::milliseconds kServerIoTimeout { 2000 };
+
+class Fd
+{
+    int m_fd = -1;
+
+public:
+    Fd() = default;
+    explicit Fd(int fd) : m_fd(fd) { }
+    Fd(Fd&& other) noexcept : m_fd(other.m_fd) { other.m_fd = -1; }
+    Fd& operator=(Fd&& other) noexcept
+    {
+        std::swap(m_fd, other.m_fd);
+        return *this;
+    }
+    ~Fd()
+    {
+        if (m_fd >= 0)
+            close(m_fd);
+    }
+
+    int get() const { return m_fd; }
+    explicit operator bool() const { return m_fd >= 0; }
+};
+
+bool MakeAddress(const std::filesystem::path& endpoint, sockaddr_un& addr)
+{
+    const std::string& path = endpoint.native();
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path))
+        return false;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+/**
+ * Wait for a socket to become readable or writable.
+ * @return false on timeout, error or if \a stopFd became readable.
+ */
+bool WaitReady(int fd, short events, int stopFd, Clock::time_point deadline)
+{
+    pollfd fds[2] = { { fd, events, 0 }, { stopFd, POLLIN, 0 } };
+    while (true) {
+        const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now());
+        if (remaining.count() <= 0)
+            return false;
+        const int result = poll(fds, stopFd >= 0 ? 2 : 1, static_cast<int>(remaining.count()));
+        if (result < 0 && errno == EINTR)
+            continue;
+        if (result <= 0 || (stopFd >= 0 && fds[1].revents != 0))
+            return false;
+        return (fds[0].revents & (events | POLLHUP | POLLERR)) != 0;
+    }
+}
+
+bool SendAll(int fd, std::span<const uint8_t> data, int stopFd, Clock::time_point deadline)
+{
+    while (!data.empty()) {
+        if (!WaitReady(fd, POLLOUT, stopFd, deadline))
+            return false;
+        const ssize_t n = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (n < 0 && (errno == EINTR || errno == EAGAIN))
+            continue;
+        if (n <= 0)
+            return false;
+        data = data.subspan(static_cast<size_t>(n));
+    }
+    return true;
+}
+
+bool ReceiveAll(int fd, std::span<uint8_t> data, int stopFd, Clock::time_point deadline)
+{
+    while (!data.empty()) {
+        if (!WaitReady(fd, POLLIN, stopFd, deadline))
+            return false;
+        const ssize_t n = recv(fd, data.data(), data.size(), 0);
+        if (n < 0 && (errno == EINTR || errno == EAGAIN))
+            continue;
+        if (n <= 0)
+            return false;
+        data = data.subspan(static_cast<size_t>(n));
+    }
+    return true;
+}
+
+/// Receive a frame, return its payload
+std::optional<std::vector<uint8_t>> ReceiveFrame(int fd, int stopFd, Clock::time_point deadline)
+{
+    uint8_t header[kFrameHeaderSize];
+    if (!ReceiveAll(fd, header, stopFd, deadline))
+        return std::nullopt;
+    auto size = PayloadSize(header);
+    if (!size)
+        return std::nullopt;
+    std::vector<uint8_t> payload(*size);
+    if (!ReceiveAll(fd, payload, stopFd, deadline))
+        return std::nullopt;
+    return payload;
+}
+
+} // namespace
+
+std::filesystem::path DefaultEndpoint()
+{
+    if (const char* runtime_dir = std::getenv("XDG_RUNTIME_DIR"); runtime_dir && *runtime_dir)
+        return std::filesystem::path(runtime_dir) / "hdrtray.sock";
+    return "/tmp/hdrtray-" + std::to_string(getuid()) + ".sock";
+}
+
+struct Server::Impl
+{
+    std::filesystem::path endpoint;
+    Handler handler;
+    Fd listenFd;
+    // Written to by Stop() to wake up the thread
+    Fd stopRead;
+    Fd stopWrite;
+    std::thread thread;
+    std::atomic<uint64_t> requests = 0;
+    std::atomic<uint64_t> errors = 0;
+
+    void Run();
+    void Serve(int fd);
+};
+
+void Server::Impl::Run()
+{
+    while (true) {
+        pollfd fds[2] = { { listenFd.get(), POLLIN, 0 }, { stopRead.get(), POLLIN, 0 } };
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        if (fds[1].revents != 0)
+            return;
+        Fd client(accept4(listenFd.get(), nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC));
+        if (client)
+            Serve(client.get());
+    }
+}
+
+void Server::Impl::Serve(int fd)
+{
+    const auto deadline = Clock::now() + kServerIoTimeout;
+    // Connections closed without a request, eg by Start() checking for a running server, are no error
+    uint8_t first;
+    if (WaitReady(fd, POLLIN, stopRead.get(), deadline) && recv(fd, &first, 1, MSG_PEEK) == 0)
+        return;
+    auto payload = ReceiveFrame(fd, stopRead.get(), deadline);
+    if (!payload) {
+        errors++;
+        return;
+    }
+    Response response;
+    if (auto request = DecodeRequest(*payload)) {
+        trace::Span span("ipc", "Request");
+        span.Arg("command", static_cast<int64_t>(request->command));
+        response = handler(*request);
+    } else
+        response.result = Result::BadRequest;
+    if (!SendAll(fd, EncodeFrame(response), stopRead.get(), Clock::now() + kServerIoTimeout)) {
+        errors++;
+        return;
+    }
+    requests++;
+}
+
+Server::Server() = default;
+
+Server::~Server()
+{
+    Stop();
+}
+
+bool Server::Start(const std::filesystem::path& endpoint, Handler handler)
+{
+    Stop();
+
+    sockaddr_un addr;
+    if (!MakeAddress(endpoint, addr))
+        return false;
+    Fd listenFd(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    if (!listenFd)
+        return false;
+
+    if (bind(listenFd.get(), reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+        if (errno != EADDRINUSE)
+            return false;
+        // Left behind by a server that didn't exit cleanly, unless someone is still listening
+        Fd probe(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+        if (connect(probe.get(), reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) == 0)
+            return false;
+        unlink(addr.sun_path);
+        if (bind(listenFd.get(), reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+            return false;
+    }
+    chmod(addr.sun_path, S_IRUSR | S_IWUSR);
+    if (listen(listenFd.get(), 8) != 0) {
+        unlink(addr.sun_path);
+        return false;
+    }
+
+    int stopFds[2];
+    if (pipe2(stopFds, O_CLOEXEC) != 0) {
+        unlink(addr.sun_path);
+        return false;
+    }
+
+    m_impl = std::make_unique<Impl>();
+    m_impl->endpoint = endpoint;
+    m_impl->handler = std::move(handler);
+    m_impl->listenFd = std::move(listenFd);
+    m_impl->stopRead = Fd(stopFds[0]);
+    m_impl->stopWrite = Fd(stopFds[1]);
+    m_impl->thread = std::thread([impl = m_impl.get()]() {
+        trace::SetThreadName("IpcServer");
+        impl->Run();
+    });
+    return true;
+}
+
+void Server::Stop()
+{
+    if (!m_impl)
+        return;
+    const uint8_t wake = 0;
+    [[maybe_unused]] auto written = write(m_impl->stopWrite.get(), &wake, 1);
+    m_impl->thread.join();
+    unlink(m_impl->endpoint.c_str());
+    m_impl.reset();
+}
+
+Server::Stats Server::GetStats() const
+{
+    Stats stats;
+    if (m_impl) {
+        stats.requests = m_impl->requests;
+        stats.errors = m_impl->errors;
+    }
+    return stats;
+}
+
+std::optional<Response> Call(const std::filesystem::path& endpoint, const Request& request,
+                             std::chrono::milliseconds timeout)
+{
+    const auto deadline = Clock::now() + timeout;
+    sockaddr_un addr;
+    if (!MakeAddress(endpoint, addr))
+        return std::nullopt;
+    Fd fd(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    if (!fd)
+        return std::nullopt;
+    // Connecting to a local socket doesn't block: either someone is listening or not
+    if (connect(fd.get(), reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+        return std::nullopt;
+    fcntl(fd.get(), F_SETFL, fcntl(fd.get(), F_GETFL) | O_NONBLOCK);
+
+    if (!SendAll(fd.get(), EncodeFrame(request), -1, deadline))
+        return std::nullopt;
+    auto payload = ReceiveFrame(fd.get(), -1, deadline);
+    if (!payload)
+        return std::nullopt;
+    return DecodeResponse(*payload);
+}
+
+} // namespace ipc
@@ -0,0 +1,70 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* MappedFile with mmap(), for the Linux build of the benchmarks and the simulator. */
+
+#include "MappedFile.hpp"
+
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile()
+{
+    if (m_data)
+        Close(m_size);
+}
+
+bool MappedFile::Create(const std::filesystem::path& path, size_t size)
+{
+    if (m_data)
+        Close(m_size);
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        return false;
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    m_file = fd;
+    m_data = data;
+    m_size = size;
+    return true;
+}
+
+void MappedFile::Close(size_t length)
+{
+    if (m_data)
+        munmap(m_data, m_size);
+    if (m_file >= 0) {
+        if (ftruncate(static_cast<int>(m_file), static_cast<off_t>(std::min(length, m_size))) != 0) {
+            // Keeps its full size; the rest is zeros
+        }
+        close(static_cast<int>(m_file));
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_file = -1;
+}
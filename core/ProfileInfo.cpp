@@ -0,0 +1,284 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Color Profile Management Extension
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ProfileInfo.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <system_error>
+
+namespace {
+
+/// Splits CGATS text into whitespace separated tokens; quoted strings are returned as one token
+class CgatsTokenizer
+{
+    std::string_view m_text;
+    size_t m_pos = 0;
+
+public:
+    explicit CgatsTokenizer(std::string_view text) : m_text(text) { }
+
+    bool Next(std::string_view& token)
+    {
+        while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos])))
+            m_pos++;
+        if (m_pos >= m_text.size())
+            return false;
+
+        const size_t start = m_pos;
+        if (m_text[m_pos] == '"') {
+            const size_t end = m_text.find('"', m_pos + 1);
+            m_pos = (end == std::string_view::npos) ? m_text.size() : end + 1;
+        } else {
+            while (m_pos < m_text.size() && !std::isspace(static_cast<unsigned char>(m_text[m_pos])))
+                m_pos++;
+        }
+        token = m_text.substr(start, m_pos - start);
+        return true;
+    }
+};
+
+bool ParseNumber(std::string_view token, double& value)
+{
+    // strtod() needs a terminated string; tokens are short
+    char buffer[64];
+    if (token.empty() || token.size() >= sizeof(buffer))
+        return false;
+    std::copy(token.begin(), token.end(), buffer);
+    buffer[token.size()] = 0;
+    char* end = nullptr;
+    value = std::strtod(buffer, &end);
+    return end == buffer + token.size();
+}
+
+ProfileInfo Invalid(ProfileInfo::Type type, std::string error)
+{
+    ProfileInfo info;
+    info.type = type;
+    info.error = std::move(error);
+    return info;
+}
+
+uint32_t ReadBE32(const uint8_t* p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+std::string ReadSignature(const uint8_t* p)
+{
+    std::string sig(reinterpret_cast<const char*>(p), 4);
+    // Signatures are space padded
+    while (!sig.empty() && (sig.back() == ' ' || sig.back() == 0))
+        sig.pop_back();
+    return sig;
+}
+
+} // namespace
+
+ProfileInfo ParseCalibration(std::string_view text)
+{
+    constexpr auto type = ProfileInfo::Type::Calibration;
+    CgatsTokenizer tokenizer(text);
+    std::string_view token;
+
+    if (!tokenizer.Next(token) || token != "CAL")
+        return Invalid(type, "Not an Argyll calibration file");
+
+    long numSets = -1;
+    std::vector<std::string_view> fields;
+    ProfileInfo info;
+    info.type = type;
+
+    while (tokenizer.Next(token)) {
+        if (token == "NUMBER_OF_SETS") {
+            double value = 0;
+            if (!tokenizer.Next(token) || !ParseNumber(token, value) || value < 2)
+                return Invalid(type, "Bad NUMBER_OF_SETS");
+            numSets = static_cast<long>(value);
+        } else if (token == "BEGIN_DATA_FORMAT") {
+            fields.clear();
+            while (tokenizer.Next(token) && token != "END_DATA_FORMAT")
+                fields.push_back(token);
+        } else if (token == "BEGIN_DATA") {
+            if (numSets < 0)
+                return Invalid(type, "BEGIN_DATA before NUMBER_OF_SETS");
+
+            // Column of each channel in the data rows
+            int column[4] = { -1, -1, -1, -1 };
+            const std::string_view names[4] = { "RGB_I", "RGB_R", "RGB_G", "RGB_B" };
+            for (size_t f = 0; f < fields.size(); f++) {
+                for (int c = 0; c < 4; c++) {
+                    if (fields[f] == names[c])
+                        column[c] = static_cast<int>(f);
+                }
+            }
+            if (std::find(std::begin(column), std::end(column), -1) != std::end(column))
+                return Invalid(type, "Data format lacks RGB_I/RGB_R/RGB_G/RGB_B");
+
+            info.red.reserve(numSets);
+            info.green.reserve(numSets);
+            info.blue.reserve(numSets);
+            std::vector<double> row(fields.size());
+            double prevInput = -1;
+            size_t f = 0;
+            while (tokenizer.Next(token) && token != "END_DATA") {
+                double value = 0;
+                if (!ParseNumber(token, value))
+                    return Invalid(type, "Bad number in data");
+                // Allow for some rounding noise in the written values
+                if (value < -1e-6 || value > 1 + 1e-6)
+                    return Invalid(type, "Value out of range");
+                row[f++] = value;
+                if (f < fields.size())
+                    continue;
+                f = 0;
+
+                if (row[column[0]] <= prevInput)
+                    return Invalid(type, "RGB_I is not increasing");
+                prevInput = row[column[0]];
+                info.red.push_back(static_cast<float>(row[column[1]]));
+                info.green.push_back(static_cast<float>(row[column[2]]));
+                info.blue.push_back(static_cast<float>(row[column[3]]));
+            }
+            if (token != "END_DATA" || f != 0)
+                return Invalid(type, "Truncated data");
+            if (static_cast<long>(info.red.size()) != numSets)
+                return Invalid(type, "Number of data rows doesn't match NUMBER_OF_SETS");
+
+            info.valid = true;
+            return info;
+        }
+    }
+    return Invalid(type, "No calibration data");
+}
+
+ProfileInfo ParseIccProfile(const uint8_t* data, size_t size)
+{
+    constexpr auto type = ProfileInfo::Type::IccProfile;
+    constexpr size_t kHeaderSize = 128;
+
+    if (size < kHeaderSize + 4)
+        return Invalid(type, "File too small for an ICC profile");
+    if (ReadSignature(data + 36) != "acsp")
+        return Invalid(type, "Missing 'acsp' signature");
+    const uint32_t declaredSize = ReadBE32(data);
+    if (declaredSize > size || declaredSize < kHeaderSize + 4)
+        return Invalid(type, "Declared profile size doesn't match file size");
+
+    ProfileInfo info;
+    info.type = type;
+    info.iccVersion = ReadBE32(data + 8);
+    info.iccDeviceClass = ReadSignature(data + 12);
+    info.iccColorSpace = ReadSignature(data + 16);
+
+    const uint32_t tagCount = ReadBE32(data + kHeaderSize);
+    if (tagCount > (declaredSize - kHeaderSize - 4) / 12)
+        return Invalid(type, "Tag table exceeds profile size");
+    for (uint32_t t = 0; t < tagCount; t++) {
+        const uint8_t* entry = data + kHeaderSize + 4 + t * 12;
+        const uint32_t offset = ReadBE32(entry + 4);
+        const uint32_t tagSize = ReadBE32(entry + 8);
+        if (offset > declaredSize || tagSize > declaredSize - offset)
+            return Invalid(type, "Tag data exceeds profile size");
+        if (ReadSignature(entry) == "vcgt")
+            info.iccHasVcgt = true;
+    }
+
+    info.valid = true;
+    return info;
+}
+
+std::vector<float> ResampleCurve(std::span<const float> curve, size_t size)
+{
+    std::vector<float> result;
+    if (curve.empty() || size == 0)
+        return result;
+    result.resize(size);
+    if (curve.size() == 1 || size == 1) {
+        std::fill(result.begin(), result.end(), curve.front());
+        return result;
+    }
+
+    // Entry i is at position i * step of the source curve
+    const double step = static_cast<double>(curve.size() - 1) / static_cast<double>(size - 1);
+    const size_t last = curve.size() - 1;
+    for (size_t i = 0; i < size; i++) {
+        const double pos = static_cast<double>(i) * step;
+        const size_t index = std::min(static_cast<size_t>(pos), last - 1);
+        const float frac = static_cast<float>(pos - static_cast<double>(index));
+        result[i] = curve[index] + (curve[index + 1] - curve[index]) * frac;
+    }
+    // Endpoints exactly, regardless of rounding
+    result.back() = curve.back();
+    return result;
+}
+
+ProfileInfo ParseProfile(const std::filesystem::path& path, const std::vector<uint8_t>& data)
+{
+    auto extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+
+    if (extension == ".cal")
+        return ParseCalibration(std::string_view(reinterpret_cast<const char*>(data.data()), data.size()));
+    if (extension == ".icc" || extension == ".icm")
+        return ParseIccProfile(data.data(), data.size());
+    return Invalid(ProfileInfo::Type::Unknown, "Unknown file extension");
+}
+
+std::shared_ptr<const ProfileInfo> ProfileCache::Get(const std::filesystem::path& path)
+{
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(path, ec);
+    if (ec)
+        return nullptr;
+    const auto modified = std::filesystem::last_write_time(path, ec);
+    if (ec)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.lookups++;
+
+    auto& entry = m_entries[path.native()];
+    if (entry.info && entry.size == size && entry.modified == modified)
+        return entry.info;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return nullptr;
+    std::vector<uint8_t> data(static_cast<size_t>(size));
+    if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())))
+        return nullptr;
+
+    m_stats.parses++;
+    entry.size = size;
+    entry.modified = modified;
+    entry.info = std::make_shared<const ProfileInfo>(ParseProfile(path, data));
+    return entry.info;
+}
+
+ProfileCache::Stats ProfileCache::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
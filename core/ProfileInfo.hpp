@@ -0,0 +1,123 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Color Profile Management Extension
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Result of parsing a calibration (.cal) or ICC profile (.icc/.icm) file.
+ * Only what's needed to decide whether dispwin can load the file is extracted.
+ */
+struct ProfileInfo
+{
+    enum class Type
+    {
+        Unknown,
+        Calibration,
+        IccProfile
+    };
+    Type type = Type::Unknown;
+
+    bool valid = false;
+    /// Reason why the file is not valid
+    std::string error;
+
+    // Calibration: per-channel ramps, indexed by input value
+    std::vector<float> red;
+    std::vector<float> green;
+    std::vector<float> blue;
+
+    // ICC profile: header fields
+    uint32_t iccVersion = 0;
+    std::string iccDeviceClass;
+    std::string iccColorSpace;
+    /// Whether the profile has a 'vcgt' (video card gamma table) tag, which is what dispwin loads
+    bool iccHasVcgt = false;
+};
+
+/**
+ * Parse an Argyll CGATS calibration file.
+ * Checks the RGB_I/RGB_R/RGB_G/RGB_B data format, the number of sets and the value ranges.
+ */
+ProfileInfo ParseCalibration(std::string_view text);
+
+/**
+ * Parse the header and tag table of an ICC profile.
+ */
+ProfileInfo ParseIccProfile(const uint8_t* data, size_t size);
+
+/**
+ * Resample a calibration curve, like ProfileInfo::red, to another number of entries by
+ * interpolating linearly between neighbouring entries; eg to the 256 entries per channel
+ * of the video card gamma table.
+ * @return Resampled curve; empty if the curve is empty or size is 0
+ */
+std::vector<float> ResampleCurve(std::span<const float> curve, size_t size);
+
+/**
+ * Parse a profile file's contents, choosing the format by file extension
+ */
+ProfileInfo ParseProfile(const std::filesystem::path& path, const std::vector<uint8_t>& data);
+
+/**
+ * Parsed profiles, keyed by path.
+ * Entries are re-parsed when the file size or modification time changes.
+ * Safe to use from multiple threads.
+ */
+class ProfileCache
+{
+public:
+    struct Stats
+    {
+        uint64_t lookups = 0;
+        uint64_t parses = 0;
+    };
+
+    /**
+     * Get information about a profile file, parsing it if necessary
+     * @return Parsed profile, or nullptr if the file doesn't exist or can't be read
+     */
+    std::shared_ptr<const ProfileInfo> Get(const std::filesystem::path& path);
+
+    Stats GetStats() const;
+
+private:
+    struct Entry
+    {
+        uintmax_t size = 0;
+        std::filesystem::file_time_type modified;
+        std::shared_ptr<const ProfileInfo> info;
+    };
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::filesystem::path::string_type, Entry> m_entries;
+    Stats m_stats;
+};
@@ -0,0 +1,201 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Color Profile Management Extension
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "RecordingBackends.hpp"
+
+#include <cwchar>
+
+namespace backend {
+
+Recorder::Recorder(Set inner, bool dryRun) : m_inner(inner), m_dryRun(dryRun) { }
+
+template<typename F>
+auto Recorder::Record(Operation op, F&& func)
+{
+    const uint64_t start = m_inner.clock.NowMs();
+    auto result = func(op);
+    op.durationMs += m_inner.clock.NowMs() - start;
+    m_operations.push_back(std::move(op));
+    return result;
+}
+
+std::vector<Recorder::Operation> Recorder::GetChanges() const
+{
+    std::vector<Operation> changes;
+    for (const auto& op : m_operations) {
+        const bool changing
+            = op.kind == OpKind::SetHDRStatus || op.kind == OpKind::SetVcp || op.kind == OpKind::LoadProfile;
+        if (changing && !op.redundant)
+            changes.push_back(op);
+    }
+    return changes;
+}
+
+std::wstring Recorder::Describe(const Operation& op)
+{
+    wchar_t vcpCode[8];
+    std::swprintf(vcpCode, sizeof(vcpCode) / sizeof(vcpCode[0]), L"0x%02X", op.vcpCode);
+    const std::wstring display = std::to_wstring(op.display);
+    switch (op.kind) {
+    case OpKind::GetHDRStatus:
+        return L"get HDR status";
+    case OpKind::SetHDRStatus:
+        return op.value ? L"turn HDR on" : L"turn HDR off";
+    case OpKind::GetEdidIds:
+        return L"enumerate monitors";
+    case OpKind::GetVcp:
+        return L"getvcp " + display + L" " + vcpCode + (op.succeeded ? L" = " + std::to_wstring(op.value) : L"");
+    case OpKind::SetVcp:
+        return L"setvcp " + display + L" " + vcpCode + L" " + std::to_wstring(op.value);
+    case OpKind::PrepareProfile:
+        return L"check profile " + op.profile;
+    case OpKind::LoadProfile:
+        return L"load profile " + op.profile + L" on display " + display;
+    case OpKind::Sleep:
+        return L"wait";
+    }
+    return L"???";
+}
+
+bool Recorder::RunsTool(OpKind kind)
+{
+    return kind == OpKind::GetVcp || kind == OpKind::SetVcp || kind == OpKind::LoadProfile;
+}
+
+void Recorder::RecordingClock::SleepMs(int milliseconds)
+{
+    Operation op { OpKind::Sleep };
+    op.value = milliseconds;
+    if (m_recorder.m_dryRun) {
+        const uint64_t skipped = milliseconds > 0 ? milliseconds : 0;
+        m_recorder.m_skippedMs += skipped;
+        op.durationMs = skipped;
+        m_recorder.m_operations.push_back(std::move(op));
+        return;
+    }
+    m_recorder.Record(std::move(op), [&](Operation&) {
+        m_recorder.m_inner.clock.SleepMs(milliseconds);
+        return true;
+    });
+}
+
+hdr::Status Recorder::RecordingDisplay::GetHDRStatus()
+{
+    return m_recorder.Record(Operation { OpKind::GetHDRStatus }, [&](Operation& op) {
+        const auto status = m_recorder.m_dryRun && m_recorder.m_hdrStatus ? *m_recorder.m_hdrStatus
+                                                                           : m_recorder.m_inner.display.GetHDRStatus();
+        op.value = status == hdr::Status::On ? 1 : 0;
+        op.succeeded = status != hdr::Status::Unsupported;
+        return status;
+    });
+}
+
+std::optional<hdr::Status> Recorder::RecordingDisplay::SetHDRStatus(bool enable)
+{
+    Operation op { OpKind::SetHDRStatus };
+    op.value = enable ? 1 : 0;
+    return m_recorder.Record(std::move(op), [&](Operation& op) -> std::optional<hdr::Status> {
+        const auto requested = enable ? hdr::Status::On : hdr::Status::Off;
+        if (!m_recorder.m_dryRun) {
+            const auto result = m_recorder.m_inner.display.SetHDRStatus(enable);
+            op.succeeded = result == requested;
+            return result;
+        }
+        const auto current = m_recorder.m_hdrStatus ? *m_recorder.m_hdrStatus
+                                                    : m_recorder.m_inner.display.GetHDRStatus();
+        if (current == hdr::Status::Unsupported) {
+            op.succeeded = false;
+            return current;
+        }
+        op.redundant = current == requested;
+        m_recorder.m_hdrStatus = requested;
+        return requested;
+    });
+}
+
+std::vector<std::wstring> Recorder::RecordingDisplay::GetEdidIds()
+{
+    return m_recorder.Record(Operation { OpKind::GetEdidIds },
+                             [&](Operation&) { return m_recorder.m_inner.display.GetEdidIds(); });
+}
+
+bool Recorder::RecordingDdc::SetVcp(int display, int vcpCode, int value)
+{
+    const auto key = std::make_pair(display, vcpCode);
+    if (m_recorder.m_dryRun && !m_recorder.m_vcpValues.contains(key)) {
+        // Find out whether the write would change anything
+        int currentValue = 0;
+        GetVcp(display, vcpCode, currentValue);
+    }
+
+    Operation op { OpKind::SetVcp, display, vcpCode, value };
+    return m_recorder.Record(std::move(op), [&](Operation& op) {
+        auto known = m_recorder.m_vcpValues.find(key);
+        op.redundant = known != m_recorder.m_vcpValues.end() && known->second == value;
+        if (!m_recorder.m_dryRun)
+            op.succeeded = m_recorder.m_inner.ddc.SetVcp(display, vcpCode, value);
+        if (op.succeeded)
+            m_recorder.m_vcpValues[key] = value;
+        return op.succeeded;
+    });
+}
+
+bool Recorder::RecordingDdc::GetVcp(int display, int vcpCode, int& currentValue)
+{
+    const auto key = std::make_pair(display, vcpCode);
+    Operation op { OpKind::GetVcp, display, vcpCode };
+    return m_recorder.Record(std::move(op), [&](Operation& op) {
+        auto known = m_recorder.m_vcpValues.find(key);
+        if (m_recorder.m_dryRun && known != m_recorder.m_vcpValues.end()) {
+            // Reading again wouldn't tell anything new, and a written value is only known here
+            currentValue = known->second;
+        } else {
+            op.succeeded = m_recorder.m_inner.ddc.GetVcp(display, vcpCode, currentValue);
+            if (op.succeeded)
+                m_recorder.m_vcpValues[key] = currentValue;
+        }
+        op.value = currentValue;
+        return op.succeeded;
+    });
+}
+
+bool Recorder::RecordingGamma::PrepareProfile(const std::wstring& profileName)
+{
+    Operation op { OpKind::PrepareProfile };
+    op.profile = profileName;
+    return m_recorder.Record(std::move(op), [&](Operation& op) {
+        op.succeeded = m_recorder.m_inner.gamma.PrepareProfile(profileName);
+        return op.succeeded;
+    });
+}
+
+bool Recorder::RecordingGamma::LoadProfile(int display, const std::wstring& profileName)
+{
+    Operation op { OpKind::LoadProfile, display };
+    op.profile = profileName;
+    return m_recorder.Record(std::move(op), [&](Operation& op) {
+        if (!m_recorder.m_dryRun)
+            op.succeeded = m_recorder.m_inner.gamma.LoadProfile(display, profileName);
+        return op.succeeded;
+    });
+}
+
+} // namespace backend
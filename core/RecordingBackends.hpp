@@ -0,0 +1,159 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Color Profile Management Extension
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "ColorBackends.hpp"
+
+#include <map>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace backend {
+
+/**
+ * Backends wrapping another set, recording every operation with its duration.
+ *
+ * In dry-run mode, operations that change something (HDR switch, VCP writes, profile loads)
+ * are recorded but not passed on, and reads see the values that would have been written.
+ * Waits don't sleep, time just skips ahead, so a dry run finishes right away.
+ * VCP writes of the value the monitor already has are marked as redundant; if the value
+ * wasn't read before, it's read for that, as reading doesn't change anything.
+ */
+class Recorder
+{
+public:
+    enum class OpKind
+    {
+        GetHDRStatus,
+        SetHDRStatus,
+        GetEdidIds,
+        GetVcp,
+        SetVcp,
+        PrepareProfile,
+        LoadProfile,
+        Sleep,
+    };
+
+    struct Operation
+    {
+        OpKind kind;
+        /// Display index, for VCP and profile operations
+        int display = 0;
+        int vcpCode = 0;
+        /// Value read or written; for SetHDRStatus, 1 to turn HDR on
+        int value = 0;
+        std::wstring profile {};
+        bool succeeded = true;
+        /// Would not change anything: writes the current value, or switches to the current HDR status
+        bool redundant = false;
+        /// Time spent; for a dry run, the time a skipped wait would have taken
+        uint64_t durationMs = 0;
+    };
+
+    Recorder(Set inner, bool dryRun);
+
+    Set GetBackends() { return Set { m_clock, m_display, m_ddc, m_gamma }; }
+    bool IsDryRun() const { return m_dryRun; }
+
+    const std::vector<Operation>& GetOperations() const { return m_operations; }
+    /// Operations that change something; for a dry run, what a real run would have done
+    std::vector<Operation> GetChanges() const;
+
+    /// Short description of an operation, eg "setvcp 1 0x10 50"
+    static std::wstring Describe(const Operation& op);
+    /// Whether an operation is carried out by an external tool (profile loader or DDC/CI)
+    static bool RunsTool(OpKind kind);
+
+private:
+    Set m_inner;
+    bool m_dryRun;
+    std::vector<Operation> m_operations;
+    /// Time skipped by dry-run waits
+    uint64_t m_skippedMs = 0;
+
+    /// Last known VCP values, by display and code
+    std::map<std::pair<int, int>, int> m_vcpValues;
+    /// HDR status after a dry-run switch
+    std::optional<hdr::Status> m_hdrStatus;
+
+    uint64_t NowMs() { return m_inner.clock.NowMs() + m_skippedMs; }
+    /// Record an operation, timing the function carrying it out
+    template<typename F>
+    auto Record(Operation op, F&& func);
+
+    class RecordingClock : public Clock
+    {
+    public:
+        explicit RecordingClock(Recorder& recorder) : m_recorder(recorder) { }
+        uint64_t NowMs() override { return m_recorder.NowMs(); }
+        void SleepMs(int milliseconds) override;
+
+    private:
+        Recorder& m_recorder;
+    };
+
+    class RecordingDisplay : public Display
+    {
+    public:
+        explicit RecordingDisplay(Recorder& recorder) : m_recorder(recorder) { }
+        hdr::Status GetHDRStatus() override;
+        std::optional<hdr::Status> SetHDRStatus(bool enable) override;
+        void Refresh() override { m_recorder.m_inner.display.Refresh(); }
+        std::vector<std::wstring> GetEdidIds() override;
+
+    private:
+        Recorder& m_recorder;
+    };
+
+    class RecordingDdc : public Ddc
+    {
+    public:
+        explicit RecordingDdc(Recorder& recorder) : m_recorder(recorder) { }
+        bool IsAvailable() const override { return m_recorder.m_inner.ddc.IsAvailable(); }
+        bool SetVcp(int display, int vcpCode, int value) override;
+        bool GetVcp(int display, int vcpCode, int& currentValue) override;
+
+    private:
+        Recorder& m_recorder;
+    };
+
+    class RecordingGamma : public Gamma
+    {
+    public:
+        explicit RecordingGamma(Recorder& recorder) : m_recorder(recorder) { }
+        bool IsAvailable() const override { return m_recorder.m_inner.gamma.IsAvailable(); }
+        bool PrepareProfile(const std::wstring& profileName) override;
+        bool LoadProfile(int display, const std::wstring& profileName) override;
+
+    private:
+        Recorder& m_recorder;
+    };
+
+    RecordingClock m_clock { *this };
+    RecordingDisplay m_display { *this };
+    RecordingDdc m_ddc { *this };
+    RecordingGamma m_gamma { *this };
+};
+
+} // namespace backend
@@ -0,0 +1,63 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SHAREDMEMORY_HPP_
+#define SHAREDMEMORY_HPP_
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Named memory shared between processes of the current user.
+ * On Windows, a file mapping in the session namespace; elsewhere, a POSIX shared memory object.
+ */
+class SharedMemory
+{
+public:
+    SharedMemory() = default;
+    ~SharedMemory();
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    /// Platform name for the given base name, visible to the current user session only
+    static std::string SessionName(const std::string& base);
+
+    /**
+     * Create the named memory, zero-filled, for writing. Fails if it exists already.
+     * The name is removed again when the creator closes it.
+     */
+    bool Create(const std::string& name, size_t size);
+    /// Open existing named memory of at least the given size for reading
+    bool Open(const std::string& name, size_t size);
+    void Close();
+
+    bool IsOpen() const { return m_data != nullptr; }
+    void* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    void* m_data = nullptr;
+    size_t m_size = 0;
+    // Platform handle: HANDLE of the file mapping on Windows, unused elsewhere
+    void* m_handle = nullptr;
+    /// Name to remove on Close(), if this is the creator
+    std::string m_ownedName;
+};
+
+#endif // SHAREDMEMORY_HPP_
@@ -0,0 +1,138 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Configuration Management
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/**
+ * Holds an immutable, reference counted value that is replaced as a whole.
+ *
+ * Readers get a std::shared_ptr to the current value without taking a lock:
+ * the value lives in one of a few slots, and a reader only announces itself on
+ * the slot for the duration of the reference count increment. A writer fills
+ * a slot that is not current and has no readers, then switches over. It never
+ * waits for readers that hold on to a value, eg for a whole HDR transition,
+ * and only waits for readers copying a pointer if they occupy all other slots
+ * (eg because they were preempted in the middle of it).
+ *
+ * Writers are serialized among themselves.
+ * (std::atomic<std::shared_ptr> would do, but common implementations use a
+ * lock internally, which readers would contend on.)
+ */
+template<typename T>
+class SnapshotCell
+{
+public:
+    using Snapshot = std::shared_ptr<const T>;
+
+    explicit SnapshotCell(Snapshot initial) { m_slots[0].value = std::move(initial); }
+
+    SnapshotCell(const SnapshotCell&) = delete;
+    SnapshotCell& operator=(const SnapshotCell&) = delete;
+
+    /// Get the current value. Lock-free; safe to call from any thread.
+    Snapshot Load() const
+    {
+        while (true) {
+            const unsigned index = m_current.load();
+            Slot& slot = m_slots[index];
+            slot.readers.fetch_add(1);
+            // Only use the slot if it's still current: a writer might have started filling it
+            if (m_current.load() == index) {
+                Snapshot value = slot.value;
+                slot.readers.fetch_sub(1, std::memory_order_release);
+                return value;
+            }
+            slot.readers.fetch_sub(1, std::memory_order_release);
+            m_readRetries.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /// Replace the value
+    void Store(Snapshot value)
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        Publish(std::move(value));
+    }
+
+    /**
+     * Replace the value with a modified copy of the current one.
+     * Other writers can't slip in between reading and replacing.
+     */
+    template<typename F>
+    void Update(F&& modify)
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        T copy = *m_slots[m_current.load(std::memory_order_relaxed)].value;
+        modify(copy);
+        Publish(std::make_shared<const T>(std::move(copy)));
+    }
+
+    struct Stats
+    {
+        /// Reads that had to start over because a writer switched slots at the same time
+        uint64_t readRetries = 0;
+        /// Times a writer had to wait for a reader to finish copying out of a slot
+        uint64_t writerWaits = 0;
+    };
+    Stats GetStats() const
+    {
+        return Stats { m_readRetries.load(std::memory_order_relaxed), m_writerWaits.load(std::memory_order_relaxed) };
+    }
+
+private:
+    // Own cache line per slot, so readers of the current slot don't contend with the writer
+    struct alignas(64) Slot
+    {
+        std::atomic<uint32_t> readers { 0 };
+        Snapshot value;
+    };
+    static constexpr unsigned kNumSlots = 3;
+    mutable Slot m_slots[kNumSlots];
+    std::atomic<unsigned> m_current { 0 };
+    std::mutex m_writeMutex;
+    mutable std::atomic<uint64_t> m_readRetries { 0 };
+    std::atomic<uint64_t> m_writerWaits { 0 };
+
+    /// Fill an unused slot and make it current; m_writeMutex must be held
+    void Publish(Snapshot value)
+    {
+        const unsigned current = m_current.load(std::memory_order_relaxed);
+        unsigned next = (current + 1) % kNumSlots;
+        while (m_slots[next].readers.load() != 0) {
+            next = (next + 1) % kNumSlots;
+            if (next == current) {
+                // All other slots still have readers, give them time to finish
+                m_writerWaits.fetch_add(1, std::memory_order_relaxed);
+                std::this_thread::yield();
+                next = (current + 1) % kNumSlots;
+            }
+        }
+        // Drops an older value; readers still using it hold their own reference
+        m_slots[next].value = std::move(value);
+        m_current.store(next);
+    }
+};
@@ -0,0 +1,235 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "StatusBoard.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace board {
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Seqlock counter must be usable across processes");
+static_assert(sizeof(layout::Payload) == layout::kPayloadWords * sizeof(uint64_t), "Payload is copied in 64 bit words");
+static_assert(std::is_trivially_copyable_v<layout::Payload>);
+static_assert(offsetof(layout::Segment, payload) % alignof(uint64_t) == 0);
+
+using layout::kPayloadWords;
+static constexpr uint8_t kNoStatus = 0xFF;
+
+std::string DefaultName()
+{
+    return SharedMemory::SessionName("HDRTray.StatusBoard");
+}
+
+/* The payload is copied word by word with relaxed atomic accesses: a reader may see a
+ * mix of old and new words while the publisher writes, but the sequence counter tells it
+ * to discard that copy. The words go through a local buffer, as a Payload can't be
+ * accessed as uint64_t directly. */
+static void StorePayload(uint64_t (&dest)[kPayloadWords], const layout::Payload& src)
+{
+    uint64_t words[kPayloadWords];
+    std::memcpy(words, &src, sizeof(words));
+    for (size_t i = 0; i < kPayloadWords; i++)
+        std::atomic_ref<uint64_t>(dest[i]).store(words[i], std::memory_order_relaxed);
+}
+
+static void LoadPayload(layout::Payload& dest, const uint64_t (&src)[kPayloadWords])
+{
+    uint64_t words[kPayloadWords];
+    for (size_t i = 0; i < kPayloadWords; i++) {
+        // Only read; atomic_ref needs a non-const object
+        words[i] = std::atomic_ref<uint64_t>(const_cast<uint64_t&>(src[i])).load(std::memory_order_relaxed);
+    }
+    std::memcpy(&dest, words, sizeof(words));
+}
+
+static void Encode(const State& state, layout::Payload& payload)
+{
+    std::memset(&payload, 0, sizeof(payload));
+    payload.publishedUnixMs = state.publishedUnixMs;
+    payload.status = static_cast<uint8_t>(state.status);
+
+    payload.displayCount = static_cast<uint8_t>(std::min(state.displays.size(), kMaxDisplays));
+    for (size_t i = 0; i < payload.displayCount; i++) {
+        const auto& disp = state.displays[i];
+        auto& slot = payload.displays[i];
+        slot.adapterLow = disp.id.adapterLow;
+        slot.adapterHigh = disp.id.adapterHigh;
+        slot.targetId = disp.id.targetId;
+        slot.status = static_cast<uint8_t>(disp.status);
+        slot.nameLength = static_cast<uint8_t>(std::min(disp.name.size(), kMaxNameLength));
+        for (size_t c = 0; c < slot.nameLength; c++)
+            slot.name[c] = static_cast<char16_t>(disp.name[c]);
+    }
+
+    payload.monitorCount = static_cast<uint8_t>(std::min(state.monitors.size(), kMaxMonitors));
+    for (size_t i = 0; i < payload.monitorCount; i++) {
+        const auto& monitor = state.monitors[i];
+        auto& slot = payload.monitors[i];
+        slot.index = monitor.index;
+        slot.hdr = monitor.hdr ? 1 : 0;
+        slot.profileHash = monitor.profileHash;
+        slot.vcpCount = static_cast<uint8_t>(std::min(monitor.vcp.size(), kMaxVcpValues));
+        for (size_t v = 0; v < slot.vcpCount; v++) {
+            slot.vcp[v].code = monitor.vcp[v].code;
+            slot.vcp[v].value = monitor.vcp[v].value;
+            slot.vcp[v].ageMs = monitor.vcp[v].ageMs;
+        }
+    }
+
+    const auto& transition = state.lastTransition;
+    payload.transition.count = transition.count;
+    payload.transition.finishedUnixMs = transition.finishedUnixMs;
+    payload.transition.durationMs = transition.durationMs;
+    payload.transition.kind = static_cast<uint8_t>(transition.kind);
+    payload.transition.succeeded = transition.succeeded ? 1 : 0;
+    payload.transition.status = transition.status ? static_cast<uint8_t>(*transition.status) : kNoStatus;
+}
+
+static std::optional<hdr::Status> DecodeStatus(uint8_t value)
+{
+    if (value > static_cast<uint8_t>(hdr::Status::On))
+        return std::nullopt;
+    return static_cast<hdr::Status>(value);
+}
+
+static State Decode(const layout::Payload& payload)
+{
+    State state;
+    state.publishedUnixMs = payload.publishedUnixMs;
+    state.status = DecodeStatus(payload.status).value_or(hdr::Status::Unsupported);
+
+    const size_t displayCount = std::min<size_t>(payload.displayCount, kMaxDisplays);
+    state.displays.reserve(displayCount);
+    for (size_t i = 0; i < displayCount; i++) {
+        const auto& slot = payload.displays[i];
+        Display disp;
+        disp.id.adapterLow = slot.adapterLow;
+        disp.id.adapterHigh = slot.adapterHigh;
+        disp.id.targetId = slot.targetId;
+        disp.status = DecodeStatus(slot.status).value_or(hdr::Status::Unsupported);
+        const size_t nameLength = std::min<size_t>(slot.nameLength, kMaxNameLength);
+        disp.name.assign(slot.name, slot.name + nameLength);
+        state.displays.push_back(std::move(disp));
+    }
+
+    const size_t monitorCount = std::min<size_t>(payload.monitorCount, kMaxMonitors);
+    state.monitors.reserve(monitorCount);
+    for (size_t i = 0; i < monitorCount; i++) {
+        const auto& slot = payload.monitors[i];
+        Monitor monitor;
+        monitor.index = slot.index;
+        monitor.hdr = slot.hdr != 0;
+        monitor.profileHash = slot.profileHash;
+        const size_t vcpCount = std::min<size_t>(slot.vcpCount, kMaxVcpValues);
+        for (size_t v = 0; v < vcpCount; v++)
+            monitor.vcp.push_back({ slot.vcp[v].code, slot.vcp[v].value, slot.vcp[v].ageMs });
+        state.monitors.push_back(std::move(monitor));
+    }
+
+    const auto& transition = payload.transition;
+    state.lastTransition.count = transition.count;
+    state.lastTransition.finishedUnixMs = transition.finishedUnixMs;
+    state.lastTransition.durationMs = transition.durationMs;
+    state.lastTransition.kind = transition.kind <= static_cast<uint8_t>(TransitionKind::Reapply)
+                                    ? static_cast<TransitionKind>(transition.kind)
+                                    : TransitionKind::None;
+    state.lastTransition.succeeded = transition.succeeded != 0;
+    state.lastTransition.status = DecodeStatus(transition.status);
+    return state;
+}
+
+bool Publisher::Open(const std::string& name)
+{
+    if (!m_memory.Create(name, sizeof(layout::Segment)))
+        return false;
+    auto& header = GetSegment()->header;
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.headerSize = sizeof(layout::Header);
+    header.payloadSize = sizeof(layout::Payload);
+    m_publishCount = 0;
+    return true;
+}
+
+void Publisher::Publish(const State& state)
+{
+    auto* segment = GetSegment();
+    if (!segment)
+        return;
+
+    // Encode first, to keep the time the sequence is odd short
+    layout::Payload payload;
+    Encode(state, payload);
+
+    auto& sequence = segment->header.sequence;
+    const uint64_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    // Odd sequence must be visible before any payload word
+    std::atomic_thread_fence(std::memory_order_release);
+    StorePayload(segment->payload, payload);
+    sequence.store(seq + 2, std::memory_order_release);
+    m_publishCount++;
+}
+
+bool Reader::Open(const std::string& name)
+{
+    if (!m_memory.Open(name, sizeof(layout::Segment)))
+        return false;
+    const auto& header = GetSegment()->header;
+    if (header.magic != kMagic || header.version != kVersion || header.headerSize != sizeof(layout::Header)
+        || header.payloadSize != sizeof(layout::Payload)) {
+        m_memory.Close();
+        return false;
+    }
+    return true;
+}
+
+std::optional<State> Reader::Read(unsigned maxAttempts)
+{
+    const auto* segment = GetSegment();
+    if (!segment)
+        return std::nullopt;
+    m_stats.reads++;
+
+    auto& sequence = segment->header.sequence;
+    layout::Payload payload {};
+    for (unsigned attempt = 0; attempt < maxAttempts; attempt++) {
+        const uint64_t before = sequence.load(std::memory_order_acquire);
+        if (before == 0)
+            return std::nullopt;
+        if (before & 1) {
+            // Publisher is writing; it only takes a few microseconds
+            m_stats.retries++;
+            std::this_thread::yield();
+            continue;
+        }
+        LoadPayload(payload, segment->payload);
+        // Payload loads must complete before the sequence is checked again
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before)
+            return Decode(payload);
+        m_stats.retries++;
+    }
+    return std::nullopt;
+}
+
+} // namespace board
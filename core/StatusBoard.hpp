@@ -0,0 +1,250 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef STATUSBOARD_HPP_
+#define STATUSBOARD_HPP_
+
+#include "HDR.h"
+#include "SharedMemory.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * State HDRTray publishes in shared memory, for HDRCmd and other tools to read without
+ * querying the display configuration.
+ *
+ * The segment starts with a header (magic, layout version, size) followed by a
+ * sequence counter and the fixed-size payload. The counter is a seqlock: the publisher
+ * makes it odd while it writes and even again when it's done; a reader copies the payload
+ * and retries if the counter was odd or changed meanwhile. Readers never block the publisher.
+ * All fields are little endian, at fixed offsets; see the Layout structs.
+ */
+namespace board {
+
+inline constexpr uint32_t kMagic = 0x42524448; // "HDRB"
+inline constexpr uint16_t kVersion = 1;
+inline constexpr size_t kMaxDisplays = 16;
+inline constexpr size_t kMaxMonitors = 16;
+/// Display names are cut off after this many UTF-16 code units
+inline constexpr size_t kMaxNameLength = 64;
+/// VCP values per monitor
+inline constexpr size_t kMaxVcpValues = 8;
+
+/// Name of the board of the current user session
+std::string DefaultName();
+
+struct Display
+{
+    hdr::DisplayId id;
+    std::wstring name;
+    hdr::Status status = hdr::Status::Unsupported;
+};
+
+/// Cached VCP value
+struct VcpValue
+{
+    uint8_t code = 0;
+    uint16_t value = 0;
+    /// Time between reading the value from the monitor and publishing it
+    uint32_t ageMs = 0;
+};
+
+/// A monitor as addressed by the profile loader and DDC/CI (display index)
+struct Monitor
+{
+    int32_t index = 0;
+    /// Whether HDR or SDR settings were applied last
+    bool hdr = false;
+    /// Hash of the profile and monitor settings applied last; 0 if none were applied yet
+    uint64_t profileHash = 0;
+    std::vector<VcpValue> vcp;
+};
+
+enum class TransitionKind : uint8_t
+{
+    None = 0,
+    /// HDR toggle with profile switch
+    Toggle = 1,
+    /// Color correction reapplied after a monitor reconnection
+    Reapply = 2,
+};
+
+struct Transition
+{
+    TransitionKind kind = TransitionKind::None;
+    /// Number of transitions so far
+    uint64_t count = 0;
+    bool succeeded = false;
+    /// HDR status after a toggle
+    std::optional<hdr::Status> status;
+    uint32_t durationMs = 0;
+    /// Time the transition finished, in ms since the Unix epoch
+    uint64_t finishedUnixMs = 0;
+};
+
+struct State
+{
+    /// Overall status, as returned by GetWindowsHDRStatus()
+    hdr::Status status = hdr::Status::Unsupported;
+    std::vector<Display> displays;
+    std::vector<Monitor> monitors;
+    Transition lastTransition;
+    /// Time of publishing, in ms since the Unix epoch
+    uint64_t publishedUnixMs = 0;
+};
+
+namespace layout {
+
+struct Header
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    /// Size of the payload
+    uint32_t payloadSize;
+    uint32_t reserved;
+    /// Seqlock counter: odd while the payload is written; 0 if nothing was published yet
+    std::atomic<uint64_t> sequence;
+};
+
+struct DisplaySlot
+{
+    uint32_t adapterLow;
+    int32_t adapterHigh;
+    uint32_t targetId;
+    uint8_t status;
+    uint8_t nameLength;
+    uint16_t reserved;
+    char16_t name[kMaxNameLength];
+};
+
+struct VcpSlot
+{
+    uint8_t code;
+    uint8_t reserved;
+    uint16_t value;
+    uint32_t ageMs;
+};
+
+struct MonitorSlot
+{
+    int32_t index;
+    uint8_t hdr;
+    uint8_t vcpCount;
+    uint16_t reserved;
+    uint64_t profileHash;
+    VcpSlot vcp[kMaxVcpValues];
+};
+
+struct TransitionSlot
+{
+    uint64_t count;
+    uint64_t finishedUnixMs;
+    uint32_t durationMs;
+    uint8_t kind;
+    uint8_t succeeded;
+    /// 0xFF: none
+    uint8_t status;
+    uint8_t reserved;
+};
+
+struct alignas(8) Payload
+{
+    uint64_t publishedUnixMs;
+    uint8_t status;
+    uint8_t displayCount;
+    uint8_t monitorCount;
+    uint8_t reserved[5];
+    DisplaySlot displays[kMaxDisplays];
+    MonitorSlot monitors[kMaxMonitors];
+    TransitionSlot transition;
+};
+
+/// Size of the payload in 64 bit words, the unit it's copied in
+inline constexpr size_t kPayloadWords = (sizeof(Payload) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+struct Segment
+{
+    Header header;
+    /// Payload, as words that are accessed atomically
+    uint64_t payload[kPayloadWords];
+};
+
+} // namespace layout
+
+/// Writes the board. Owned by HDRTray.
+class Publisher
+{
+public:
+    /// Create the board. Fails if it exists already, eg created by another HDRTray instance.
+    bool Open(const std::string& name);
+    void Close() { m_memory.Close(); }
+    bool IsOpen() const { return m_memory.IsOpen(); }
+
+    /// Publish a new state. Lists longer than the board holds are cut off.
+    void Publish(const State& state);
+
+    /// Number of states published
+    uint64_t GetPublishCount() const { return m_publishCount; }
+
+private:
+    SharedMemory m_memory;
+    uint64_t m_publishCount = 0;
+
+    layout::Segment* GetSegment() const { return static_cast<layout::Segment*>(m_memory.Data()); }
+};
+
+/// Reads the board
+class Reader
+{
+public:
+    /// Open the board. Fails if it doesn't exist or is of another layout version.
+    bool Open(const std::string& name);
+    void Close() { m_memory.Close(); }
+    bool IsOpen() const { return m_memory.IsOpen(); }
+
+    /**
+     * Read a consistent copy of the published state.
+     * @return State; nothing if nothing was published yet, or the publisher kept
+     *   writing during all attempts.
+     */
+    std::optional<State> Read(unsigned maxAttempts = 1000);
+
+    struct Stats
+    {
+        uint64_t reads = 0;
+        /// Copies discarded because the publisher was writing
+        uint64_t retries = 0;
+    };
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    SharedMemory m_memory;
+    Stats m_stats;
+
+    const layout::Segment* GetSegment() const { return static_cast<const layout::Segment*>(m_memory.Data()); }
+};
+
+} // namespace board
+
+#endif // STATUSBOARD_HPP_
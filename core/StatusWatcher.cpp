@@ -0,0 +1,123 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "StatusWatcher.hpp"
+
+#include <algorithm>
+
+namespace hdr {
+
+bool StatusWatcher::StatusMayLag(Event event)
+{
+    switch (event) {
+    case Event::DisplayChange:
+    case Event::DisplayOn:
+    case Event::Resume:
+        // Displays may still be coming up, and the HDR status is not always current on WM_DISPLAYCHANGE
+        return true;
+    case Event::Refresh:
+        break;
+    }
+    return false;
+}
+
+void StatusWatcher::Start(uint64_t nowMs)
+{
+    m_recheck.reset();
+    Check(nowMs);
+    // Not a reaction to an event, so it doesn't make later events part of a burst
+    m_lastCheckMs.reset();
+    m_stats.changes = 0;
+}
+
+std::vector<StatusWatcher::Change> StatusWatcher::Notify(Event event, uint64_t nowMs)
+{
+    m_stats.events++;
+    InvalidateDisplayCache();
+
+    if (StatusMayLag(event))
+        m_recheck = Recheck { nowMs + kFirstRecheckMs, kFirstRecheckMs, kMaxRechecks };
+
+    // Part of a burst: the re-checks will pick up whatever changed
+    if (m_recheck && m_lastCheckMs && nowMs - *m_lastCheckMs < kMinCheckIntervalMs) {
+        m_stats.coalescedEvents++;
+        return {};
+    }
+    auto changes = Check(nowMs);
+    if (!changes.empty())
+        m_recheck.reset();
+    return changes;
+}
+
+uint32_t StatusWatcher::MsUntilDue(uint64_t nowMs) const
+{
+    if (!m_recheck || m_recheck->dueMs <= nowMs)
+        return 0;
+    return static_cast<uint32_t>(m_recheck->dueMs - nowMs);
+}
+
+std::vector<StatusWatcher::Change> StatusWatcher::Poll(uint64_t nowMs)
+{
+    if (!m_recheck || nowMs < m_recheck->dueMs)
+        return {};
+
+    auto& recheck = *m_recheck;
+    recheck.remaining--;
+    recheck.intervalMs *= 2;
+    recheck.dueMs = nowMs + recheck.intervalMs;
+
+    m_stats.rechecks++;
+    InvalidateDisplayCache();
+    auto changes = Check(nowMs);
+    // The OS caught up, no need to look again
+    if (!changes.empty() || recheck.remaining == 0)
+        m_recheck.reset();
+    return changes;
+}
+
+std::vector<StatusWatcher::Change> StatusWatcher::Check(uint64_t nowMs)
+{
+    m_stats.checks++;
+    m_lastCheckMs = nowMs;
+
+    auto displays = hdr::GetDisplays();
+    // Answered from the cache filled by GetDisplays()
+    m_status = GetWindowsHDRStatus();
+
+    std::vector<Change> changes;
+    for (const auto& disp : displays) {
+        auto prev = std::find_if(m_displays.begin(), m_displays.end(),
+                                 [&](const Display& d) { return d.id == disp.id; });
+        if (prev == m_displays.end())
+            changes.push_back(Change { disp.id, disp.name, std::nullopt, disp.status });
+        else if (prev->status != disp.status)
+            changes.push_back(Change { disp.id, disp.name, prev->status, disp.status });
+    }
+    for (const auto& prev : m_displays) {
+        auto still_present = std::any_of(displays.begin(), displays.end(),
+                                         [&](const Display& d) { return d.id == prev.id; });
+        if (!still_present)
+            changes.push_back(Change { prev.id, prev.name, prev.status, std::nullopt });
+    }
+
+    m_displays = std::move(displays);
+    m_stats.changes += changes.size();
+    return changes;
+}
+
+} // namespace hdr
@@ -0,0 +1,139 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef STATUSWATCHER_HPP_
+#define STATUSWATCHER_HPP_
+
+#include "HDR.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace hdr {
+
+/**
+ * Keeps track of the HDR status of all displays and reports changes.
+ *
+ * The owner forwards OS notifications (WM_DISPLAYCHANGE, resume, monitor power on)
+ * with Notify(). Each one refreshes the display cache and compares the per-display
+ * status with the previous snapshot; only actual differences are reported.
+ * For notifications the HDR status is known to lag behind, if no change showed up
+ * right away, the status is checked again a few times with exponentially growing
+ * intervals, until a change shows up.
+ * Notifications arriving in quick succession share a single check.
+ *
+ * Like DisplayEventDebouncer, the class is purely time-driven (all timestamps are
+ * passed in): the owner arms a timer for MsUntilDue() and calls Poll() when it fires.
+ */
+class StatusWatcher
+{
+public:
+    enum class Event
+    {
+        /// WM_DISPLAYCHANGE; the HDR status may not be up to date yet
+        DisplayChange,
+        /// Monitor turned on
+        DisplayOn,
+        /// System resumed from standby
+        Resume,
+        /// Anything else that may have changed the status, eg HDR being changed by this process
+        Refresh,
+    };
+
+    /// Status change of a single display
+    struct Change
+    {
+        DisplayId id;
+        std::wstring name;
+        /// Previous status; nothing if the display was added
+        std::optional<Status> previous;
+        /// New status; nothing if the display was removed
+        std::optional<Status> current;
+    };
+
+    /// Cumulative statistics
+    struct Stats
+    {
+        /// Notifications received
+        uint64_t events = 0;
+        /// Notifications that didn't cause a check of their own, as one was just done
+        uint64_t coalescedEvents = 0;
+        /// Status checks (each one refreshes the display cache)
+        uint64_t checks = 0;
+        /// Checks made because the status may have lagged behind a notification
+        uint64_t rechecks = 0;
+        /// Changes reported
+        uint64_t changes = 0;
+    };
+
+    /// Take the initial snapshot of the displays, without reporting changes
+    void Start(uint64_t nowMs);
+
+    /**
+     * Handle an OS notification.
+     * @return Displays whose status changed
+     */
+    std::vector<Change> Notify(Event event, uint64_t nowMs);
+
+    /// Whether a re-check is scheduled
+    bool IsPending() const { return m_recheck.has_value(); }
+    /// Milliseconds until the next re-check. Only meaningful if \c IsPending().
+    uint32_t MsUntilDue(uint64_t nowMs) const;
+    /**
+     * Run the scheduled re-check if it's due.
+     * @return Displays whose status changed
+     */
+    std::vector<Change> Poll(uint64_t nowMs);
+
+    /// Displays as of the last check
+    const std::vector<Display>& GetDisplays() const { return m_displays; }
+    /// Overall status as of the last check, as returned by GetWindowsHDRStatus()
+    Status GetStatus() const { return m_status; }
+
+    const Stats& GetStats() const { return m_stats; }
+
+    /// Whether the HDR status may lag behind an event, so it has to be checked again later
+    static bool StatusMayLag(Event event);
+
+private:
+    /// Interval of the first re-check, doubled for each further one
+    static constexpr uint32_t kFirstRecheckMs = 100;
+    /// Re-checks after an event; with the interval doubling, the last one is 6.3 s after the event
+    static constexpr uint32_t kMaxRechecks = 6;
+    /// Events less than this long after a check only restart the re-checks
+    static constexpr uint32_t kMinCheckIntervalMs = 50;
+
+    struct Recheck
+    {
+        uint64_t dueMs;
+        uint32_t intervalMs;
+        uint32_t remaining;
+    };
+    std::optional<Recheck> m_recheck;
+    std::optional<uint64_t> m_lastCheckMs;
+    std::vector<Display> m_displays;
+    Status m_status = Status::Unsupported;
+    Stats m_stats;
+
+    std::vector<Change> Check(uint64_t nowMs);
+};
+
+} // namespace hdr
+
+#endif // STATUSWATCHER_HPP_
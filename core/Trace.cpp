@@ -0,0 +1,375 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+namespace trace {
+
+static_assert(std::is_trivially_copyable_v<Event>, "Events are copied word by word");
+static_assert(sizeof(Event) % sizeof(uint64_t) == 0, "Events are copied in 64 bit words");
+
+static constexpr size_t kEventWords = sizeof(Event) / sizeof(uint64_t);
+/* One slot more than spans kept: the slot being written holds no span a reader may
+ * still need, so a full buffer always has kBufferCapacity intact spans. */
+static constexpr size_t kSlots = kBufferCapacity + 1;
+
+static std::atomic<bool> enabled { true };
+
+static uint64_t NowNs()
+{
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+namespace {
+
+/// Ring buffer of one thread. Only that thread writes; anyone holding the registry lock may read.
+struct Buffer
+{
+    /// Index of the next span; the slot is index % kSlots
+    std::atomic<uint64_t> head { 0 };
+    /// Spans before this index were cleared
+    std::atomic<uint64_t> clearedAt { 0 };
+    Event events[kSlots];
+};
+
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+    /// Buffers of threads that ended, for threads started later
+    std::vector<Buffer*> unused;
+    std::map<uint32_t, std::string> threadNames;
+    uint32_t nextThreadId = 1;
+};
+
+Registry& GetRegistry()
+{
+    // Never destroyed: threads may still end, and give back their buffer, during process exit
+    static Registry* registry = new Registry;
+    return *registry;
+}
+
+struct ThreadState
+{
+    Buffer* buffer = nullptr;
+    uint32_t threadId = 0;
+
+    ~ThreadState()
+    {
+        if (!buffer)
+            return;
+        auto& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        registry.unused.push_back(buffer);
+    }
+};
+
+thread_local ThreadState thread_state;
+
+ThreadState& CurrentThread()
+{
+    if (!thread_state.buffer) {
+        auto& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        thread_state.threadId = registry.nextThreadId++;
+        if (!registry.unused.empty()) {
+            // Spans already in it stay, they have the id of the thread that recorded them
+            thread_state.buffer = registry.unused.back();
+            registry.unused.pop_back();
+        } else {
+            registry.buffers.push_back(std::make_unique<Buffer>());
+            thread_state.buffer = registry.buffers.back().get();
+        }
+    }
+    return thread_state;
+}
+
+} // namespace
+
+/* Like the status board, spans are copied word by word with relaxed atomic accesses:
+ * a reader may see a mix of an old and a new span in a slot being reused, but the
+ * head index tells it to discard that copy. */
+static void StoreEvent(Event& dest, const Event& src)
+{
+    auto* destWords = reinterpret_cast<uint64_t*>(&dest);
+    auto* srcWords = reinterpret_cast<const uint64_t*>(&src);
+    for (size_t i = 0; i < kEventWords; i++)
+        std::atomic_ref<uint64_t>(destWords[i]).store(srcWords[i], std::memory_order_relaxed);
+}
+
+static void LoadEvent(Event& dest, Event& src)
+{
+    auto* destWords = reinterpret_cast<uint64_t*>(&dest);
+    auto* srcWords = reinterpret_cast<uint64_t*>(&src);
+    for (size_t i = 0; i < kEventWords; i++)
+        destWords[i] = std::atomic_ref<uint64_t>(srcWords[i]).load(std::memory_order_relaxed);
+}
+
+static void Record(const Event& event)
+{
+    auto* buffer = CurrentThread().buffer;
+    const uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    // A reader seeing any word of the new span must also see the head it's written at
+    std::atomic_thread_fence(std::memory_order_release);
+    StoreEvent(buffer->events[head % kSlots], event);
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void SetEnabled(bool enable)
+{
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool IsEnabled()
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void SetThreadName(const char* name)
+{
+    const uint32_t threadId = CurrentThread().threadId;
+    auto& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    registry.threadNames[threadId] = name;
+}
+
+Span::Span(const char* category, const char* name) : m_active(enabled.load(std::memory_order_relaxed))
+{
+    if (!m_active)
+        return;
+    m_event.category = category;
+    m_event.name = name;
+    m_event.argCount = 0;
+    m_event.startNs = NowNs();
+}
+
+Span::~Span()
+{
+    if (!m_active)
+        return;
+    m_event.durationNs = NowNs() - m_event.startNs;
+    m_event.threadId = CurrentThread().threadId;
+    Record(m_event);
+}
+
+Arg* Span::AddArg(const char* key)
+{
+    if (!m_active || m_event.argCount >= kMaxArgs)
+        return nullptr;
+    auto* arg = &m_event.args[m_event.argCount++];
+    arg->key = key;
+    arg->reserved = 0;
+    return arg;
+}
+
+Span& Span::Arg(const char* key, int64_t value)
+{
+    if (auto* arg = AddArg(key)) {
+        arg->isText = 0;
+        arg->number = value;
+    }
+    return *this;
+}
+
+Span& Span::Arg(const char* key, std::string_view value)
+{
+    if (auto* arg = AddArg(key)) {
+        arg->isText = 1;
+        arg->number = 0;
+        const size_t length = std::min(value.size(), kMaxTextLength);
+        std::copy_n(value.begin(), length, arg->text);
+        arg->text[length] = 0;
+    }
+    return *this;
+}
+
+Span& Span::Arg(const char* key, std::wstring_view value)
+{
+    if (auto* arg = AddArg(key)) {
+        arg->isText = 1;
+        arg->number = 0;
+        const size_t length = std::min(value.size(), kMaxTextLength);
+        for (size_t i = 0; i < length; i++)
+            arg->text[i] = value[i] < 0x80 ? static_cast<char>(value[i]) : '?';
+        arg->text[length] = 0;
+    }
+    return *this;
+}
+
+static void CollectBuffer(Buffer& buffer, std::vector<Event>& events)
+{
+    const uint64_t head = buffer.head.load(std::memory_order_acquire);
+    const uint64_t oldest = head > kBufferCapacity ? head - kBufferCapacity : 0;
+    const uint64_t first = std::max(buffer.clearedAt.load(std::memory_order_relaxed), oldest);
+    if (first >= head)
+        return;
+    const size_t start = events.size();
+    events.resize(start + (head - first));
+    for (uint64_t i = first; i < head; i++)
+        LoadEvent(events[start + (i - first)], buffer.events[i % kSlots]);
+
+    // Span loads must complete before the head is checked again
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t headAfter = buffer.head.load(std::memory_order_relaxed);
+    // The writer may have reused the slots of these meanwhile, including the one it's writing right now
+    const uint64_t valid = headAfter + 1 > kSlots ? headAfter + 1 - kSlots : 0;
+    if (valid > first) {
+        const auto dropped = static_cast<size_t>(std::min(valid, head) - first);
+        events.erase(events.begin() + start, events.begin() + start + dropped);
+    }
+}
+
+std::vector<Event> Collect()
+{
+    std::vector<Event> events;
+    auto& registry = GetRegistry();
+    {
+        std::lock_guard lock(registry.mutex);
+        for (auto& buffer : registry.buffers)
+            CollectBuffer(*buffer, events);
+    }
+    std::stable_sort(events.begin(), events.end(),
+                     [](const Event& a, const Event& b) { return a.startNs < b.startNs; });
+    return events;
+}
+
+static void AppendString(std::string& out, std::string_view str)
+{
+    out += '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+/// Microseconds with nanosecond precision, as Chrome traces take them
+static void AppendMicroseconds(std::string& out, uint64_t ns)
+{
+    char number[32];
+    std::snprintf(number, sizeof(number), "%llu.%03u", static_cast<unsigned long long>(ns / 1000),
+                  static_cast<unsigned>(ns % 1000));
+    out += number;
+}
+
+std::string Export()
+{
+    const auto events = Collect();
+    std::map<uint32_t, std::string> threadNames;
+    {
+        auto& registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        threadNames = registry.threadNames;
+    }
+
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    const auto beginEvent = [&]() {
+        out += first ? "\n" : ",\n";
+        first = false;
+    };
+    for (const auto& [threadId, name] : threadNames) {
+        beginEvent();
+        out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(threadId)
+               + ",\"args\":{\"name\":";
+        AppendString(out, name);
+        out += "}}";
+    }
+    for (const auto& event : events) {
+        beginEvent();
+        out += "{\"name\":";
+        AppendString(out, event.name);
+        out += ",\"cat\":";
+        AppendString(out, event.category);
+        out += ",\"ph\":\"X\",\"ts\":";
+        AppendMicroseconds(out, event.startNs);
+        out += ",\"dur\":";
+        AppendMicroseconds(out, event.durationNs);
+        out += ",\"pid\":1,\"tid\":" + std::to_string(event.threadId);
+        if (event.argCount > 0) {
+            out += ",\"args\":{";
+            for (uint32_t i = 0; i < std::min<size_t>(event.argCount, kMaxArgs); i++) {
+                const auto& arg = event.args[i];
+                if (i > 0)
+                    out += ',';
+                AppendString(out, arg.key);
+                out += ':';
+                if (arg.isText)
+                    AppendString(out, arg.text);
+                else
+                    out += std::to_string(arg.number);
+            }
+            out += '}';
+        }
+        out += '}';
+    }
+    out += "\n]}\n";
+    return out;
+}
+
+bool WriteFile(const std::filesystem::path& path)
+{
+    const auto json = Export();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(json.data(), static_cast<std::streamsize>(json.size()));
+    return file.good();
+}
+
+void Clear()
+{
+    auto& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    for (auto& buffer : registry.buffers)
+        buffer->clearedAt.store(buffer->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+Stats GetStats()
+{
+    Stats stats;
+    auto& registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    for (auto& buffer : registry.buffers) {
+        const uint64_t head = buffer->head.load(std::memory_order_relaxed);
+        stats.recorded += head;
+        if (head > kBufferCapacity)
+            stats.overwritten += head - kBufferCapacity;
+    }
+    stats.threads = registry.nextThreadId - 1;
+    return stats;
+}
+
+} // namespace trace
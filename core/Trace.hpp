@@ -0,0 +1,125 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_HPP_
+#define TRACE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Span tracing: records how long things took, on which thread, with a few arguments,
+ * for export as Chrome trace JSON (chrome://tracing, https://ui.perfetto.dev).
+ *
+ * Every thread writes finished spans to a ring buffer of its own without taking a lock;
+ * the buffer keeps the most recent spans. Export() copies all buffers while threads keep
+ * recording, dropping spans that were overwritten during the copy.
+ *
+ * Categories, names and argument keys must be string literals (or live as long as the
+ * process): only the pointers are stored.
+ */
+namespace trace {
+
+/// Spans kept per thread
+inline constexpr size_t kBufferCapacity = 2048;
+inline constexpr size_t kMaxArgs = 4;
+/// Longer text arguments are cut off
+inline constexpr size_t kMaxTextLength = 23;
+
+struct Arg
+{
+    const char* key;
+    /// Whether the value is \c text, rather than \c number
+    uint32_t isText;
+    uint32_t reserved;
+    int64_t number;
+    char text[kMaxTextLength + 1];
+};
+
+/// A finished span
+struct Event
+{
+    const char* category;
+    const char* name;
+    /// Start, in nanoseconds since the trace clock started
+    uint64_t startNs;
+    uint64_t durationNs;
+    /// Small number identifying the recording thread
+    uint32_t threadId;
+    uint32_t argCount;
+    Arg args[kMaxArgs];
+};
+
+/// Turn recording on or off (it's on by default). Spans started while off are not recorded.
+void SetEnabled(bool enabled);
+bool IsEnabled();
+
+/// Name the current thread in exported traces
+void SetThreadName(const char* name);
+
+/// Scoped span; records an Event when it goes out of scope
+class Span
+{
+public:
+    Span(const char* category, const char* name);
+    ~Span();
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+    /// Add an argument; ignored once kMaxArgs are there
+    Span& Arg(const char* key, int64_t value);
+    Span& Arg(const char* key, std::string_view value);
+    /// Characters outside of ASCII are replaced with '?'
+    Span& Arg(const char* key, std::wstring_view value);
+
+private:
+    Event m_event;
+    bool m_active;
+
+    trace::Arg* AddArg(const char* key);
+};
+
+/// Spans currently in all buffers, ordered by start time
+std::vector<Event> Collect();
+/// Collect() as Chrome trace JSON, including thread names
+std::string Export();
+/// Write Export() to a file
+bool WriteFile(const std::filesystem::path& path);
+
+/// Forget recorded spans; only affects later Collect() calls, not spans being recorded right now
+void Clear();
+
+struct Stats
+{
+    /// Spans recorded since the start
+    uint64_t recorded = 0;
+    /// Spans overwritten by newer ones of the same thread
+    uint64_t overwritten = 0;
+    /// Threads that recorded spans
+    size_t threads = 0;
+};
+Stats GetStats();
+
+} // namespace trace
+
+#endif // TRACE_HPP_
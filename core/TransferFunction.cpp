@@ -0,0 +1,287 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "TransferFunction.hpp"
+
+#include "TransferKernels.hpp"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define TRANSFER_HAVE_NEON
+#include <arm_neon.h>
+#endif
+#if defined(HDRTRAY_HAVE_AVX2) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace transfer {
+
+// The PQ kernels rely on this
+static_assert(pq::kC2 - pq::kC3 == 1.0 - pq::kC1);
+
+static_assert(PqEotf(1.0) > 9999.99 && PqEotf(1.0) < 10000.01);
+static_assert(PqInverseEotf(100.0) > 0.50807 && PqInverseEotf(100.0) < 0.50809);
+static_assert(HlgOetf(1.0 / 12.0) > 0.49999 && HlgOetf(1.0 / 12.0) < 0.50001);
+static_assert(HlgInverseOetf(1.0) > 0.99999 && HlgInverseOetf(1.0) < 1.00001);
+
+/* Tables of 4097 entries, evenly spaced in a domain where the function is close to a straight
+ * line, so linear interpolation is accurate. */
+static constexpr size_t kTableSize = 4096;
+using Table = std::array<float, kTableSize + 1>;
+
+template<typename F> static constexpr Table MakeTable(F f)
+{
+    Table table {};
+    for (size_t i = 0; i <= kTableSize; i++)
+        table[i] = static_cast<float>(f(static_cast<double>(i) / kTableSize));
+    return table;
+}
+
+static constexpr Table pq_eotf_table = MakeTable([](double signal) { return PqEotf(signal); });
+// Indexed by (nits / 10000)^(1/8): close to black, the inverse EOTF is too steep otherwise
+static constexpr Table pq_inverse_eotf_table = MakeTable([](double u) {
+    const double u2 = u * u;
+    const double u4 = u2 * u2;
+    return PqInverseEotf(pq::kPeakNits * u4 * u4);
+});
+// Indexed by sqrt(scene), which turns the square root part of the OETF into a straight line
+static constexpr Table hlg_oetf_table = MakeTable([](double u) { return HlgOetf(u * u); });
+static constexpr Table hlg_inverse_oetf_table = MakeTable([](double signal) { return HlgInverseOetf(signal); });
+
+/// Interpolate in a table, at x in [0, 1]
+static float Lookup(const Table& table, float x)
+{
+    // Also maps NaN to 0
+    x = x > 0 ? std::min(x, 1.0f) * kTableSize : 0.0f;
+    const size_t i = std::min(static_cast<size_t>(x), kTableSize - 1);
+    const float frac = x - static_cast<float>(i);
+    return table[i] + (table[i + 1] - table[i]) * frac;
+}
+
+namespace kernels {
+
+struct ScalarOps
+{
+    using V = float;
+    static constexpr size_t kWidth = 1;
+
+    static V Load(const float* p) { return *p; }
+    static void Store(float* p, V v) { *p = v; }
+    static V Set(float v) { return v; }
+    static V Add(V a, V b) { return a + b; }
+    static V Sub(V a, V b) { return a - b; }
+    static V Mul(V a, V b) { return a * b; }
+    static V MulAdd(V a, V b, V c) { return a * b + c; }
+    static V Div(V a, V b) { return a / b; }
+    // Like the SIMD instructions: with a NaN in a, return b
+    static V Min(V a, V b) { return a < b ? a : b; }
+    static V Max(V a, V b) { return a > b ? a : b; }
+    static V Sqrt(V a) { return std::sqrt(a); }
+    // Only called with |a| <= 127; std::nearbyint() is a library call without SSE 4.1
+    static V Round(V a) { return static_cast<float>(static_cast<int>(a + (a < 0 ? -0.5f : 0.5f))); }
+    static V SelectGreater(V a, V b, V x, V y) { return a > b ? x : y; }
+    static V Exponent(V x, V& m)
+    {
+        const auto bits = std::bit_cast<uint32_t>(x);
+        m = std::bit_cast<float>((bits & 0x007FFFFF) | 0x3F800000);
+        return static_cast<float>(static_cast<int>(bits >> 23) - 127);
+    }
+    static V Pow2(V n) { return std::bit_cast<float>(static_cast<uint32_t>(static_cast<int>(n) + 127) << 23); }
+};
+
+#if defined(TRANSFER_HAVE_NEON)
+struct NeonOps
+{
+    using V = float32x4_t;
+    static constexpr size_t kWidth = 4;
+
+    static V Load(const float* p) { return vld1q_f32(p); }
+    static void Store(float* p, V v) { vst1q_f32(p, v); }
+    static V Set(float v) { return vdupq_n_f32(v); }
+    static V Add(V a, V b) { return vaddq_f32(a, b); }
+    static V Sub(V a, V b) { return vsubq_f32(a, b); }
+    static V Mul(V a, V b) { return vmulq_f32(a, b); }
+    static V MulAdd(V a, V b, V c) { return vfmaq_f32(c, a, b); }
+    static V Div(V a, V b) { return vdivq_f32(a, b); }
+    // vminq/vmaxq propagate NaN; select instead, to clamp NaN like the other paths
+    static V Min(V a, V b) { return vbslq_f32(vcltq_f32(a, b), a, b); }
+    static V Max(V a, V b) { return vbslq_f32(vcgtq_f32(a, b), a, b); }
+    static V Sqrt(V a) { return vsqrtq_f32(a); }
+    static V Round(V a) { return vrndnq_f32(a); }
+    static V SelectGreater(V a, V b, V x, V y) { return vbslq_f32(vcgtq_f32(a, b), x, y); }
+    static V Exponent(V x, V& m)
+    {
+        const uint32x4_t bits = vreinterpretq_u32_f32(x);
+        m = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x007FFFFF)), vdupq_n_u32(0x3F800000)));
+        return vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), vdupq_n_s32(127)));
+    }
+    static V Pow2(V n)
+    {
+        const int32x4_t biased = vaddq_s32(vcvtq_s32_f32(n), vdupq_n_s32(127));
+        return vreinterpretq_f32_s32(vshlq_n_s32(biased, 23));
+    }
+};
+#endif
+
+} // namespace kernels
+
+using BatchFunction = void (*)(const float* in, float* out, size_t count);
+
+template<typename Ops> static void PqEotfBatch(const float* in, float* out, size_t count)
+{
+    kernels::Apply<Ops>(in, out, count, [](typename Ops::V x) { return kernels::PqEotf<Ops>(x); });
+}
+
+template<typename Ops> static void PqInverseEotfBatch(const float* in, float* out, size_t count)
+{
+    kernels::Apply<Ops>(in, out, count, [](typename Ops::V x) { return kernels::PqInverseEotf<Ops>(x); });
+}
+
+template<typename Ops> static void HlgOetfBatch(const float* in, float* out, size_t count)
+{
+    kernels::Apply<Ops>(in, out, count, [](typename Ops::V x) { return kernels::HlgOetf<Ops>(x); });
+}
+
+template<typename Ops> static void HlgInverseOetfBatch(const float* in, float* out, size_t count)
+{
+    kernels::Apply<Ops>(in, out, count, [](typename Ops::V x) { return kernels::HlgInverseOetf<Ops>(x); });
+}
+
+struct VectorKernels
+{
+    const char* isa;
+    BatchFunction pqEotf;
+    BatchFunction pqInverseEotf;
+    BatchFunction hlgOetf;
+    BatchFunction hlgInverseOetf;
+};
+
+#if defined(HDRTRAY_HAVE_AVX2)
+static bool HasAvx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    // The OS must save the AVX registers on context switches
+    if (!fma || !osxsave || (_xgetbv(0) & 6) != 6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+#endif
+
+static VectorKernels SelectVectorKernels()
+{
+#if defined(HDRTRAY_HAVE_AVX2)
+    if (HasAvx2()) {
+        return { "AVX2", kernels::avx2::PqEotf, kernels::avx2::PqInverseEotf, kernels::avx2::HlgOetf,
+                 kernels::avx2::HlgInverseOetf };
+    }
+#endif
+#if defined(TRANSFER_HAVE_NEON)
+    using Ops = kernels::NeonOps;
+    return { "NEON", PqEotfBatch<Ops>, PqInverseEotfBatch<Ops>, HlgOetfBatch<Ops>, HlgInverseOetfBatch<Ops> };
+#else
+    using Ops = kernels::ScalarOps;
+    return { "scalar", PqEotfBatch<Ops>, PqInverseEotfBatch<Ops>, HlgOetfBatch<Ops>, HlgInverseOetfBatch<Ops> };
+#endif
+}
+
+static const VectorKernels& GetVectorKernels()
+{
+    static const VectorKernels kernels = SelectVectorKernels();
+    return kernels;
+}
+
+const char* VectorIsa()
+{
+    return GetVectorKernels().isa;
+}
+
+/// Convert with the given method; reference and mapTable map one value for the reference and table methods
+template<typename Reference, typename MapTable>
+static void Convert(std::span<const float> in, std::span<float> out, Method method, Reference reference,
+                    MapTable mapTable, BatchFunction polynomial, BatchFunction vector)
+{
+    const size_t count = std::min(in.size(), out.size());
+    switch (method) {
+    case Method::Reference:
+        for (size_t i = 0; i < count; i++)
+            out[i] = static_cast<float>(reference(static_cast<double>(in[i])));
+        break;
+    case Method::Table:
+        for (size_t i = 0; i < count; i++)
+            out[i] = mapTable(in[i]);
+        break;
+    case Method::Polynomial:
+        polynomial(in.data(), out.data(), count);
+        break;
+    case Method::Vector:
+        vector(in.data(), out.data(), count);
+        break;
+    }
+}
+
+void PqEotf(std::span<const float> signal, std::span<float> nits, Method method)
+{
+    Convert(
+        signal, nits, method, [](double x) { return PqEotf(x); },
+        [](float x) { return Lookup(pq_eotf_table, x); }, PqEotfBatch<kernels::ScalarOps>,
+        GetVectorKernels().pqEotf);
+}
+
+void PqInverseEotf(std::span<const float> nits, std::span<float> signal, Method method)
+{
+    Convert(
+        nits, signal, method, [](double x) { return PqInverseEotf(x); },
+        [](float x) {
+            const float y = x > 0 ? x * static_cast<float>(1.0 / pq::kPeakNits) : 0.0f;
+            return Lookup(pq_inverse_eotf_table, std::sqrt(std::sqrt(std::sqrt(y))));
+        },
+        PqInverseEotfBatch<kernels::ScalarOps>, GetVectorKernels().pqInverseEotf);
+}
+
+void HlgOetf(std::span<const float> scene, std::span<float> signal, Method method)
+{
+    Convert(
+        scene, signal, method, [](double x) { return HlgOetf(x); },
+        [](float x) { return Lookup(hlg_oetf_table, std::sqrt(x > 0 ? x : 0.0f)); }, HlgOetfBatch<kernels::ScalarOps>,
+        GetVectorKernels().hlgOetf);
+}
+
+void HlgInverseOetf(std::span<const float> signal, std::span<float> scene, Method method)
+{
+    Convert(
+        signal, scene, method, [](double x) { return HlgInverseOetf(x); },
+        [](float x) { return Lookup(hlg_inverse_oetf_table, x); }, HlgInverseOetfBatch<kernels::ScalarOps>,
+        GetVectorKernels().hlgInverseOetf);
+}
+
+} // namespace transfer
@@ -0,0 +1,234 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRANSFERFUNCTION_HPP_
+#define TRANSFERFUNCTION_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <type_traits>
+
+/**
+ * Transfer functions of HDR signals: the SMPTE ST 2084 perceptual quantizer (PQ) and
+ * Hybrid Log-Gamma (HLG) from ITU-R BT.2100.
+ *
+ * The scalar functions are the reference implementation: they follow the formulas of the
+ * standards in double precision, and can be evaluated at compile time. The batch functions
+ * convert arrays of floats with one of the methods below, trading accuracy for speed.
+ */
+namespace transfer {
+
+/// Constants of the PQ EOTF, from ST 2084
+namespace pq {
+constexpr double kM1 = 2610.0 / 16384.0;
+constexpr double kM2 = 2523.0 / 4096.0 * 128.0;
+constexpr double kC1 = 3424.0 / 4096.0;
+constexpr double kC2 = 2413.0 / 4096.0 * 32.0;
+constexpr double kC3 = 2392.0 / 4096.0 * 32.0;
+/// Luminance of signal value 1, in cd/m^2
+constexpr double kPeakNits = 10000.0;
+} // namespace pq
+
+/// Constants of the HLG OETF, from BT.2100
+namespace hlg {
+constexpr double kA = 0.17883277;
+constexpr double kB = 1.0 - 4.0 * kA;
+constexpr double kC = 0.55991073;
+/// Peak luminance of the display the HLG system gamma of 1.2 is defined for, in cd/m^2
+constexpr double kReferenceNits = 1000.0;
+} // namespace hlg
+
+namespace detail {
+
+constexpr double kLn2 = 0.693147180559945309417;
+
+/// exp() for constant evaluation: reduction to |r| <= ln(2)/2, then a Taylor series
+constexpr double ConstExp(double x)
+{
+    const double kf = x / kLn2;
+    long long k = static_cast<long long>(kf < 0 ? kf - 0.5 : kf + 0.5);
+    const double r = x - static_cast<double>(k) * kLn2;
+    double term = 1;
+    double sum = 1;
+    for (int n = 1; n < 20; n++) {
+        term *= r / n;
+        sum += term;
+    }
+    for (; k > 0; k--)
+        sum *= 2;
+    for (; k < 0; k++)
+        sum *= 0.5;
+    return sum;
+}
+
+/// log() for constant evaluation: x = m * 2^e with m in [sqrt(1/2), sqrt(2)), then an atanh series
+constexpr double ConstLog(double x)
+{
+    int e = 0;
+    for (; x >= 1.4142135623730951; e++)
+        x *= 0.5;
+    for (; x < 0.7071067811865476; e--)
+        x *= 2;
+    const double z = (x - 1) / (x + 1);
+    const double z2 = z * z;
+    double term = z;
+    double sum = 0;
+    for (int n = 1; n < 25; n += 2) {
+        sum += term / n;
+        term *= z2;
+    }
+    return 2 * sum + e * kLn2;
+}
+
+// Math functions that use the standard library at run time, but work in constant evaluation, too
+
+constexpr double Exp(double x)
+{
+    if (std::is_constant_evaluated()) {
+        return ConstExp(x);
+    } else {
+        return std::exp(x);
+    }
+}
+
+constexpr double Log(double x)
+{
+    if (std::is_constant_evaluated()) {
+        return ConstLog(x);
+    } else {
+        return std::log(x);
+    }
+}
+
+/// x^y for x >= 0 and y > 0
+constexpr double Pow(double x, double y)
+{
+    if (std::is_constant_evaluated()) {
+        return x > 0 ? ConstExp(y * ConstLog(x)) : 0.0;
+    } else {
+        return std::pow(x, y);
+    }
+}
+
+constexpr double Sqrt(double x)
+{
+    if (std::is_constant_evaluated()) {
+        return Pow(x, 0.5);
+    } else {
+        return std::sqrt(x);
+    }
+}
+
+} // namespace detail
+
+/// PQ EOTF: signal value in [0, 1] to luminance in cd/m^2
+constexpr double PqEotf(double signal)
+{
+    const double p = detail::Pow(std::clamp(signal, 0.0, 1.0), 1.0 / pq::kM2);
+    const double num = std::max(p - pq::kC1, 0.0);
+    return pq::kPeakNits * detail::Pow(num / (pq::kC2 - pq::kC3 * p), 1.0 / pq::kM1);
+}
+
+/// Inverse PQ EOTF: luminance in cd/m^2, up to 10000, to signal value in [0, 1]
+constexpr double PqInverseEotf(double nits)
+{
+    const double y = detail::Pow(std::clamp(nits / pq::kPeakNits, 0.0, 1.0), pq::kM1);
+    return detail::Pow((pq::kC1 + pq::kC2 * y) / (1.0 + pq::kC3 * y), pq::kM2);
+}
+
+/// HLG OETF: relative scene light in [0, 1] to signal value in [0, 1]
+constexpr double HlgOetf(double scene)
+{
+    scene = std::clamp(scene, 0.0, 1.0);
+    if (scene <= 1.0 / 12.0)
+        return detail::Sqrt(3.0 * scene);
+    return hlg::kA * detail::Log(12.0 * scene - hlg::kB) + hlg::kC;
+}
+
+/// Inverse HLG OETF: signal value in [0, 1] to relative scene light in [0, 1]
+constexpr double HlgInverseOetf(double signal)
+{
+    signal = std::clamp(signal, 0.0, 1.0);
+    if (signal <= 0.5)
+        return signal * signal / 3.0;
+    return (detail::Exp((signal - hlg::kC) / hlg::kA) + hlg::kB) / 12.0;
+}
+
+/// HLG system gamma for a display with the given peak luminance in cd/m^2
+constexpr double HlgSystemGamma(double peakNits)
+{
+    return 1.2 + 0.42 * detail::Log(peakNits / hlg::kReferenceNits) / detail::Log(10.0);
+}
+
+/**
+ * HLG EOTF of a neutral color (R = G = B), on a display with the given peak luminance and
+ * a black level of 0: signal value in [0, 1] to luminance in cd/m^2
+ */
+constexpr double HlgEotf(double signal, double peakNits)
+{
+    return peakNits * detail::Pow(HlgInverseOetf(signal), HlgSystemGamma(peakNits));
+}
+
+/// Inverse of HlgEotf(): luminance in cd/m^2, up to peakNits, to signal value in [0, 1]
+constexpr double HlgInverseEotf(double nits, double peakNits)
+{
+    const double scene = std::clamp(nits / peakNits, 0.0, 1.0);
+    return HlgOetf(detail::Pow(scene, 1.0 / HlgSystemGamma(peakNits)));
+}
+
+/**
+ * How the batch functions compute their results.
+ * Maximum errors against the reference, over all float inputs in the valid range; for PqEotf(),
+ * relative to the larger of the result and 0.001 cd/m^2, for the others absolute:
+ *
+ *   Function          Table     Polynomial, Vector
+ *   PqEotf            1e-3      4e-6
+ *   PqInverseEotf     2e-7      3e-7
+ *   HlgOetf           2e-7      1e-7
+ *   HlgInverseOetf    3e-7      3e-7
+ *
+ * The float result of the reference itself is off by up to half a unit in the last place.
+ */
+enum class Method
+{
+    /// The reference functions, in double precision
+    Reference,
+    /// Linear interpolation in tables of 4097 entries, computed at compile time from the reference
+    Table,
+    /// Polynomial approximations of log2() and exp2(), one value at a time
+    Polynomial,
+    /// The polynomial approximations, 8 values at a time with AVX2 or 4 with NEON if the CPU has them
+    Vector,
+};
+
+/// Instruction set used by Method::Vector: "AVX2", "NEON", or "scalar" if there is none
+const char* VectorIsa();
+
+/*
+ * Batch conversions, as the scalar functions of the same name.
+ * Convert as many values as both spans hold; input and output may be the same.
+ */
+void PqEotf(std::span<const float> signal, std::span<float> nits, Method method = Method::Vector);
+void PqInverseEotf(std::span<const float> nits, std::span<float> signal, Method method = Method::Vector);
+void HlgOetf(std::span<const float> scene, std::span<float> signal, Method method = Method::Vector);
+void HlgInverseOetf(std::span<const float> signal, std::span<float> scene, Method method = Method::Vector);
+
+} // namespace transfer
+
+#endif // TRANSFERFUNCTION_HPP_
@@ -0,0 +1,85 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* AVX2 and FMA kernels of the transfer functions. This file is compiled for those instruction
+ * sets, and only called after checking the CPU has them; so it must not use any inline function
+ * from elsewhere, which the linker could pick over a copy that runs everywhere. */
+
+#include "TransferKernels.hpp"
+
+#include <immintrin.h>
+
+namespace transfer::kernels::avx2 {
+
+struct Ops
+{
+    using V = __m256;
+    static constexpr size_t kWidth = 8;
+
+    static V Load(const float* p) { return _mm256_loadu_ps(p); }
+    static void Store(float* p, V v) { _mm256_storeu_ps(p, v); }
+    static V Set(float v) { return _mm256_set1_ps(v); }
+    static V Add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static V MulAdd(V a, V b, V c) { return _mm256_fmadd_ps(a, b, c); }
+    static V Div(V a, V b) { return _mm256_div_ps(a, b); }
+    // With a NaN in a, these return b, so NaNs end up clamped
+    static V Min(V a, V b) { return _mm256_min_ps(a, b); }
+    static V Max(V a, V b) { return _mm256_max_ps(a, b); }
+    static V Sqrt(V a) { return _mm256_sqrt_ps(a); }
+    static V Round(V a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    /// a > b ? x : y
+    static V SelectGreater(V a, V b, V x, V y) { return _mm256_blendv_ps(y, x, _mm256_cmp_ps(a, b, _CMP_GT_OQ)); }
+    /// Exponent of positive normal floats; the mantissa, in [1, 2), is stored in m
+    static V Exponent(V x, V& m)
+    {
+        const __m256i bits = _mm256_castps_si256(x);
+        m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)),
+                                                _mm256_set1_epi32(0x3F800000)));
+        return _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+    }
+    /// 2^n for integral n in [-126, 127]
+    static V Pow2(V n)
+    {
+        const __m256i biased = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(biased, 23));
+    }
+};
+
+void PqEotf(const float* in, float* out, size_t count)
+{
+    Apply<Ops>(in, out, count, [](Ops::V x) { return kernels::PqEotf<Ops>(x); });
+}
+
+void PqInverseEotf(const float* in, float* out, size_t count)
+{
+    Apply<Ops>(in, out, count, [](Ops::V x) { return kernels::PqInverseEotf<Ops>(x); });
+}
+
+void HlgOetf(const float* in, float* out, size_t count)
+{
+    Apply<Ops>(in, out, count, [](Ops::V x) { return kernels::HlgOetf<Ops>(x); });
+}
+
+void HlgInverseOetf(const float* in, float* out, size_t count)
+{
+    Apply<Ops>(in, out, count, [](Ops::V x) { return kernels::HlgInverseOetf<Ops>(x); });
+}
+
+} // namespace transfer::kernels::avx2
@@ -0,0 +1,186 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* Polynomial kernels of the transfer functions, written once for the scalar, AVX2 and NEON
+ * code paths. The Ops parameter supplies the vector type V, its width and its operations.
+ * Everything here has internal linkage: a copy compiled for AVX2 must never be picked by
+ * the linker for code that runs on a CPU without it. */
+
+#ifndef TRANSFERKERNELS_HPP_
+#define TRANSFERKERNELS_HPP_
+
+#include "TransferFunction.hpp"
+
+#include <cstddef>
+
+namespace transfer::kernels {
+
+constexpr float kMinNormal = 1.17549435e-38f;
+constexpr float kSqrt2 = 1.41421356f;
+constexpr float kLog2e = 1.44269504f;
+
+/// log2(1 + z) for z in [sqrt(1/2) - 1, sqrt(2) - 1]
+template<typename Ops> static inline typename Ops::V Log2OnePlus(typename Ops::V z)
+{
+    using V = typename Ops::V;
+    // ln(1 + z) = z - z^2 / 2 + z^3 P(z), with the coefficients of Cephes logf()
+    V p = Ops::Set(7.0376836292e-2f);
+    p = Ops::MulAdd(p, z, Ops::Set(-1.1514610310e-1f));
+    p = Ops::MulAdd(p, z, Ops::Set(1.1676998740e-1f));
+    p = Ops::MulAdd(p, z, Ops::Set(-1.2420140846e-1f));
+    p = Ops::MulAdd(p, z, Ops::Set(1.4249322787e-1f));
+    p = Ops::MulAdd(p, z, Ops::Set(-1.6668057665e-1f));
+    p = Ops::MulAdd(p, z, Ops::Set(2.0000714765e-1f));
+    p = Ops::MulAdd(p, z, Ops::Set(-2.4999993993e-1f));
+    p = Ops::MulAdd(p, z, Ops::Set(3.3333331174e-1f));
+    const V z2 = Ops::Mul(z, z);
+    const V ln = Ops::MulAdd(Ops::Mul(z2, z), p, Ops::MulAdd(z2, Ops::Set(-0.5f), z));
+    return Ops::Mul(ln, Ops::Set(kLog2e));
+}
+
+/// log2(x) for x > 0; smaller values are treated as the smallest normal float
+template<typename Ops> static inline typename Ops::V Log2(typename Ops::V x)
+{
+    using V = typename Ops::V;
+    V m;
+    V e = Ops::Exponent(Ops::Max(x, Ops::Set(kMinNormal)), m);
+    // Move the mantissa from [1, 2) to [sqrt(1/2), sqrt(2)), where the polynomial is accurate
+    e = Ops::SelectGreater(m, Ops::Set(kSqrt2), Ops::Add(e, Ops::Set(1.0f)), e);
+    m = Ops::SelectGreater(m, Ops::Set(kSqrt2), Ops::Mul(m, Ops::Set(0.5f)), m);
+    return Ops::Add(Log2OnePlus<Ops>(Ops::Sub(m, Ops::Set(1.0f))), e);
+}
+
+/// P(f) with 2^f = 1 + f P(f) for f in [-1/2, 1/2], with the coefficients of Cephes exp2f()
+template<typename Ops> static inline typename Ops::V Exp2Poly(typename Ops::V f)
+{
+    using V = typename Ops::V;
+    V p = Ops::Set(1.535336188319500e-4f);
+    p = Ops::MulAdd(p, f, Ops::Set(1.339887440266574e-3f));
+    p = Ops::MulAdd(p, f, Ops::Set(9.618437357674640e-3f));
+    p = Ops::MulAdd(p, f, Ops::Set(5.550332471162809e-2f));
+    p = Ops::MulAdd(p, f, Ops::Set(2.402264791363012e-1f));
+    return Ops::MulAdd(p, f, Ops::Set(6.931472028550421e-1f));
+}
+
+/// 2^x, for x clamped to [-126, 127]
+template<typename Ops> static inline typename Ops::V Exp2(typename Ops::V x)
+{
+    using V = typename Ops::V;
+    x = Ops::Min(Ops::Max(x, Ops::Set(-126.0f)), Ops::Set(127.0f));
+    const V n = Ops::Round(x);
+    const V f = Ops::Sub(x, n);
+    return Ops::Mul(Ops::MulAdd(Exp2Poly<Ops>(f), f, Ops::Set(1.0f)), Ops::Pow2(n));
+}
+
+/// 2^x - 1 for x in [-1/2, 1/2], accurate also where the result is close to 0
+template<typename Ops> static inline typename Ops::V Exp2Minus1(typename Ops::V x)
+{
+    return Ops::Mul(Exp2Poly<Ops>(x), x);
+}
+
+/// x^y for x >= 0
+template<typename Ops> static inline typename Ops::V Pow(typename Ops::V x, float y)
+{
+    return Exp2<Ops>(Ops::Mul(Log2<Ops>(x), Ops::Set(y)));
+}
+
+template<typename Ops> static inline typename Ops::V Clamp01(typename Ops::V x)
+{
+    return Ops::Min(Ops::Max(x, Ops::Set(0.0f)), Ops::Set(1.0f));
+}
+
+template<typename Ops> static inline typename Ops::V PqEotf(typename Ops::V signal)
+{
+    using V = typename Ops::V;
+    /* p = signal^(1/m2) is close to 1, where c2 - c3 * p cancels: work with q = p - 1 instead,
+     * which 2^t - 1 gives to full precision. Below t = -1/2, p is less than c1 and the result 0. */
+    const V t = Ops::Mul(Log2<Ops>(Clamp01<Ops>(signal)), Ops::Set(static_cast<float>(1.0 / pq::kM2)));
+    const V q = Exp2Minus1<Ops>(Ops::Max(t, Ops::Set(-0.5f)));
+    const V num = Ops::Max(Ops::Add(q, Ops::Set(static_cast<float>(1.0 - pq::kC1))), Ops::Set(0.0f));
+    const V den = Ops::MulAdd(q, Ops::Set(static_cast<float>(-pq::kC3)),
+                              Ops::Set(static_cast<float>(pq::kC2 - pq::kC3)));
+    const V y = Pow<Ops>(Ops::Div(num, den), static_cast<float>(1.0 / pq::kM1));
+    return Ops::Mul(y, Ops::Set(static_cast<float>(pq::kPeakNits)));
+}
+
+template<typename Ops> static inline typename Ops::V PqInverseEotf(typename Ops::V nits)
+{
+    using V = typename Ops::V;
+    const V scaled = Ops::Mul(nits, Ops::Set(static_cast<float>(1.0 / pq::kPeakNits)));
+    const V y = Pow<Ops>(Clamp01<Ops>(scaled), static_cast<float>(pq::kM1));
+    /* The ratio r = (c1 + c2 y) / (1 + c3 y) is raised to the power of m2 = 78.8, which magnifies its
+     * rounding errors. As c2 - c3 = 1 - c1, r - 1 = (1 - c1) (y - 1) / (1 + c3 y), which can be
+     * computed to full precision, and goes straight into the logarithm. */
+    const V one = Ops::Set(1.0f);
+    const V w = Ops::Div(Ops::Mul(Ops::Sub(y, one), Ops::Set(static_cast<float>(1.0 - pq::kC1))),
+                         Ops::MulAdd(y, Ops::Set(static_cast<float>(pq::kC3)), one));
+    return Exp2<Ops>(Ops::Mul(Log2OnePlus<Ops>(w), Ops::Set(static_cast<float>(pq::kM2))));
+}
+
+template<typename Ops> static inline typename Ops::V HlgOetf(typename Ops::V scene)
+{
+    using V = typename Ops::V;
+    const V e = Clamp01<Ops>(scene);
+    const V low = Ops::Sqrt(Ops::Mul(e, Ops::Set(3.0f)));
+    // a * ln(x) = a * ln(2) * log2(x)
+    const V log = Log2<Ops>(Ops::MulAdd(e, Ops::Set(12.0f), Ops::Set(static_cast<float>(-hlg::kB))));
+    const V high = Ops::MulAdd(log, Ops::Set(static_cast<float>(hlg::kA * detail::kLn2)),
+                               Ops::Set(static_cast<float>(hlg::kC)));
+    return Ops::SelectGreater(e, Ops::Set(1.0f / 12.0f), high, low);
+}
+
+template<typename Ops> static inline typename Ops::V HlgInverseOetf(typename Ops::V signal)
+{
+    using V = typename Ops::V;
+    const V e = Clamp01<Ops>(signal);
+    const V low = Ops::Mul(Ops::Mul(e, e), Ops::Set(1.0f / 3.0f));
+    // exp(x / a) = 2^(x * log2(e) / a)
+    const V x = Ops::Mul(Ops::Sub(e, Ops::Set(static_cast<float>(hlg::kC))),
+                         Ops::Set(static_cast<float>(kLog2e / hlg::kA)));
+    const V high = Ops::Mul(Ops::Add(Exp2<Ops>(x), Ops::Set(static_cast<float>(hlg::kB))), Ops::Set(1.0f / 12.0f));
+    return Ops::SelectGreater(e, Ops::Set(0.5f), high, low);
+}
+
+/// Run a kernel over an array, the remainder that doesn't fill a vector through a padded copy
+template<typename Ops, typename Kernel>
+static inline void Apply(const float* in, float* out, size_t count, Kernel kernel)
+{
+    size_t i = 0;
+    for (; i + Ops::kWidth <= count; i += Ops::kWidth)
+        Ops::Store(out + i, kernel(Ops::Load(in + i)));
+    if (i < count) {
+        float buffer[Ops::kWidth] = {};
+        for (size_t j = 0; i + j < count; j++)
+            buffer[j] = in[i + j];
+        Ops::Store(buffer, kernel(Ops::Load(buffer)));
+        for (size_t j = 0; i + j < count; j++)
+            out[i + j] = buffer[j];
+    }
+}
+
+/// Kernels with AVX2 and FMA, in their own source file built for those instruction sets
+namespace avx2 {
+void PqEotf(const float* in, float* out, size_t count);
+void PqInverseEotf(const float* in, float* out, size_t count);
+void HlgOetf(const float* in, float* out, size_t count);
+void HlgInverseOetf(const float* in, float* out, size_t count);
+} // namespace avx2
+
+} // namespace transfer::kernels
+
+#endif // TRANSFERKERNELS_HPP_
@@ -0,0 +1,364 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Color Profile Management Extension
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "TransitionController.hpp"
+#include "Log.hpp"
+#include "Metrics.hpp"
+#include "Trace.hpp"
+
+#include <iterator>
+#include <string>
+
+using logging::Category;
+
+/// Duration of each phase, in the order of TransitionPhase
+static metrics::Histogram phase_ms[] = {
+    metrics::Histogram("transition.set_hdr_status_ms"),
+    metrics::Histogram("transition.prepare_for_hdr_ms"),
+    metrics::Histogram("transition.apply_hdr_calibration_ms"),
+    metrics::Histogram("transition.apply_sdr_profile_ms"),
+    metrics::Histogram("transition.reapply_ms"),
+    metrics::Histogram("transition.toggle_ms"),
+    metrics::Histogram("transition.apply_ms"),
+};
+static_assert(std::size(phase_ms) == static_cast<size_t>(TransitionPhase::NumPhases));
+
+static metrics::Counter transition_failures("transition.failures");
+static metrics::Counter warm_toggles("transition.warm_toggles");
+static metrics::Counter cold_toggles("transition.cold_toggles");
+static metrics::Histogram prewarm_ms("transition.prewarm_ms");
+
+/// Outcomes of reapplying color correction after a reconnection
+struct ReconnectionOutcomes
+{
+    metrics::Counter succeeded;
+    /// Failed, with a retry scheduled
+    metrics::Counter retried;
+    /// Failed, without a retry
+    metrics::Counter failed;
+};
+/// Outcomes per MonitorReapplyReason, except None
+static ReconnectionOutcomes reconnection_outcomes[] = {
+    { metrics::Counter("reconnect.display_change.succeeded"), metrics::Counter("reconnect.display_change.retried"),
+      metrics::Counter("reconnect.display_change.failed") },
+    { metrics::Counter("reconnect.display_on.succeeded"), metrics::Counter("reconnect.display_on.retried"),
+      metrics::Counter("reconnect.display_on.failed") },
+    { metrics::Counter("reconnect.system_resume.succeeded"), metrics::Counter("reconnect.system_resume.retried"),
+      metrics::Counter("reconnect.system_resume.failed") },
+};
+static_assert(std::size(reconnection_outcomes) == static_cast<size_t>(MonitorReapplyReason::SystemResume));
+
+const char* TransitionPhaseName(TransitionPhase phase)
+{
+    switch (phase) {
+    case TransitionPhase::SetHDRStatus:
+        return "SetHDRStatus";
+    case TransitionPhase::PrepareForHDR:
+        return "PrepareForHDR";
+    case TransitionPhase::ApplyHDRCalibration:
+        return "ApplyHDRCalibration";
+    case TransitionPhase::ApplySDRProfile:
+        return "ApplySDRProfile";
+    case TransitionPhase::Reapply:
+        return "Reapply";
+    case TransitionPhase::Toggle:
+        return "Toggle";
+    case TransitionPhase::Apply:
+        return "Apply";
+    case TransitionPhase::NumPhases:
+        break;
+    }
+    return "???";
+}
+
+TransitionController::TransitionController(ColorPipeline& pipeline, SettingsSource& settings)
+    : m_pipeline(pipeline)
+    , m_settings(settings)
+{
+}
+
+template<typename F>
+auto TransitionController::RunPhase(TransitionPhase phase, F&& func)
+{
+    trace::Span span("transition", TransitionPhaseName(phase));
+    auto& clock = m_pipeline.GetBackends().clock;
+    const uint64_t start = clock.NowMs();
+    auto result = func();
+    const uint64_t duration = clock.NowMs() - start;
+    phase_ms[static_cast<size_t>(phase)].Record(duration);
+    if (m_phaseCallback)
+        m_phaseCallback(phase, duration);
+    return result;
+}
+
+void TransitionController::RecordTransition(bool reapply, bool succeeded, std::optional<hdr::Status> status,
+                                            uint64_t startMs)
+{
+    const uint64_t now = m_pipeline.GetBackends().clock.NowMs();
+    m_lastTransition.count++;
+    m_lastTransition.reapply = reapply;
+    m_lastTransition.succeeded = succeeded;
+    m_lastTransition.status = status;
+    m_lastTransition.durationMs = now - startMs;
+    m_lastTransition.finishedMs = now;
+    if (!succeeded)
+        transition_failures.Add();
+}
+
+std::optional<hdr::Status> TransitionController::SetHDRStatus(bool enable)
+{
+    auto result = RunPhase(TransitionPhase::SetHDRStatus,
+                           [&]() { return m_pipeline.GetBackends().display.SetHDRStatus(enable); });
+    // Video signal changed, monitor may have changed VCP values on its own
+    m_pipeline.InvalidateVcpCache();
+    return result;
+}
+
+std::optional<hdr::Status> TransitionController::ToggleHDR()
+{
+    const uint64_t startMs = m_pipeline.GetBackends().clock.NowMs();
+    bool colorApplied = true;
+    const auto newStatus = RunPhase(TransitionPhase::Toggle, [&]() -> std::optional<hdr::Status> {
+        const uint64_t now = m_pipeline.GetBackends().clock.NowMs();
+        const bool warm = m_prewarmStartMs != 0 && now - m_prewarmStartMs < kPrewarmValidMs;
+        m_prewarmStartMs = 0;
+        if (warm) {
+            m_prewarmStats.warmToggles++;
+            warm_toggles.Add();
+            logging::Info(Category::Transition, "ToggleHDR: Warm start, pre-warm took {}ms", m_lastPrewarmMs.load());
+        } else {
+            m_prewarmStats.coldToggles++;
+            cold_toggles.Add();
+        }
+        const auto pipelineStats = m_pipeline.GetStats();
+        logging::Debug(Category::Transition,
+                       "Prewarm stats: {} runs, {} warm/{} cold toggles, {} of {} VCP reads from cache",
+                       m_prewarmStats.runs, m_prewarmStats.warmToggles, m_prewarmStats.coldToggles,
+                       pipelineStats.vcpCacheHits, pipelineStats.vcpReads);
+
+        // The status may have been changed outside of HDRTray: re-fetch it from the system
+        m_pipeline.GetBackends().display.Refresh();
+        const auto hdrStatus = m_pipeline.GetBackends().display.GetHDRStatus();
+        logging::Info(Category::Transition, "ToggleHDR: Current HDR status from system: {}", hdrStatus);
+
+        // Determine target state (opposite of current)
+        bool enabling_hdr = (hdrStatus != hdr::Status::On);
+
+        logging::Info(Category::Transition, "ToggleHDR: Target state - enabling_hdr: {}", enabling_hdr);
+
+        return SwitchMode(enabling_hdr, hdrStatus, {}, colorApplied);
+    });
+    RecordTransition(false, newStatus.has_value() && colorApplied, newStatus, startMs);
+    return newStatus;
+}
+
+std::optional<hdr::Status> TransitionController::Apply(bool enableHDR, const DisplayFilter& filter)
+{
+    const uint64_t startMs = m_pipeline.GetBackends().clock.NowMs();
+    bool colorApplied = true;
+    const auto newStatus = RunPhase(TransitionPhase::Apply, [&]() -> std::optional<hdr::Status> {
+        const auto hdrStatus = m_pipeline.GetBackends().display.GetHDRStatus();
+        logging::Info(Category::Transition, "Apply: Current HDR status {}, applying {}", hdrStatus,
+                      enableHDR ? "HDR" : "SDR");
+        return SwitchMode(enableHDR, hdrStatus, filter, colorApplied);
+    });
+    RecordTransition(false, newStatus.has_value() && colorApplied, newStatus, startMs);
+    return newStatus;
+}
+
+std::optional<hdr::Status> TransitionController::SwitchMode(bool enableHDR, hdr::Status hdrStatus,
+                                                            const DisplayFilter& filter, bool& colorApplied)
+{
+    // Use the current settings snapshot; changes to the .ini are picked up in the background.
+    // The snapshot stays unchanged for the whole transition, even if the file changes meanwhile.
+    const auto snapshot = m_settings.GetSnapshot();
+    const auto& settings = snapshot->defaults;
+
+    // Apply color profile and calibration based on the INTENDED state
+    if (!settings.enableColorManagement || !m_pipeline.AreToolsAvailable()) {
+        // No color tools available (or color management is off), just switch HDR normally
+        if (hdrStatus == hdr::Status::Unsupported)
+            return hdr::Status::Unsupported;
+        return SetHDRStatus(enableHDR);
+    }
+
+    // Displays don't move while toggling HDR, so match them to their settings once
+    auto displays = m_pipeline.ResolveDisplays(*snapshot);
+    if (filter)
+        std::erase_if(displays, [&](const MonitorSettings& display) { return !filter(display); });
+
+    if (enableHDR) {
+        // Switching to HDR - apply HDR calibration
+        logging::Info(Category::Transition, "Enabling HDR with calibration...");
+
+        // Following the exact order from the batch file:
+        // 1. First toggle to HDR
+        SetHDRStatus(true);
+
+        if (settings.enableColorPresetChange) {
+            // 2. Wait 3 seconds and set color preset (0x14)
+            if (!RunPhase(TransitionPhase::PrepareForHDR, [&]() { return m_pipeline.PrepareForHDR(displays); })) {
+                logging::Warning(Category::Transition, "Failed to prepare monitor for HDR");
+                colorApplied = false;
+            }
+
+            // 3. Toggle HDR OFF then ON again (required for color preset to take effect)
+            logging::Info(Category::Transition, "Toggling HDR OFF/ON for calibration");
+            SetHDRStatus(false);
+            SetHDRStatus(true);
+        } else {
+            logging::Info(Category::Transition, "Color preset change disabled, skipping HDR toggle");
+        }
+
+        // 4. Apply calibration file and color settings
+        if (!RunPhase(TransitionPhase::ApplyHDRCalibration, [&]() { return m_pipeline.ApplyHDRCalibration(displays); })) {
+            logging::Warning(Category::Transition, "Failed to apply HDR calibration");
+            colorApplied = false;
+        }
+
+        return hdr::Status::On;
+    } else {
+        // Switching to SDR - apply SDR profile
+        logging::Info(Category::Transition, "Disabling HDR, applying SDR profile...");
+
+        // First toggle to SDR
+        SetHDRStatus(false);
+
+        // Apply SDR profile (includes sleep, ICC profile load, and calibrations)
+        if (!RunPhase(TransitionPhase::ApplySDRProfile, [&]() { return m_pipeline.ApplySDRProfile(displays); })) {
+            logging::Warning(Category::Transition, "Failed to apply SDR profile");
+            colorApplied = false;
+        }
+
+        return hdr::Status::Off;
+    }
+}
+
+bool TransitionController::NeedsPrewarm()
+{
+    return m_prewarmStartMs == 0 || m_pipeline.GetBackends().clock.NowMs() - m_prewarmStartMs >= kPrewarmValidMs;
+}
+
+SettingsSnapshot TransitionController::BeginPrewarm()
+{
+    m_prewarmStartMs = m_pipeline.GetBackends().clock.NowMs();
+
+    auto settings = m_settings.GetSnapshot();
+    if (!settings->defaults.enableColorManagement || !m_pipeline.AreToolsAvailable())
+        return nullptr;
+    m_prewarmStats.runs++;
+    return settings;
+}
+
+void TransitionController::RunPrewarm(const ColorSettings& settings)
+{
+    auto& clock = m_pipeline.GetBackends().clock;
+    const uint64_t start = clock.NowMs();
+    m_pipeline.Prewarm(m_pipeline.ResolveDisplays(settings));
+    const uint64_t duration = clock.NowMs() - start;
+    m_lastPrewarmMs = duration;
+    m_totalPrewarmMs += duration;
+    prewarm_ms.Record(duration);
+    logging::Info(Category::Transition, "Prewarm: done in {}ms", duration);
+}
+
+TransitionController::PrewarmStats TransitionController::GetPrewarmStats() const
+{
+    auto stats = m_prewarmStats;
+    stats.prewarmMs = m_totalPrewarmMs;
+    return stats;
+}
+
+void TransitionController::QueueMonitorReconnection(MonitorReapplyReason reason)
+{
+    if (static_cast<int>(reason) > static_cast<int>(m_pendingReapplyReason))
+        m_pendingReapplyReason = reason;
+
+    // New event: allow retries again (monitor might still be stabilizing)
+    m_reapplyRetryCount = 0;
+}
+
+int TransitionController::HandleMonitorReconnection(hdr::Status hdrStatus)
+{
+    const auto reason = m_pendingReapplyReason;
+    m_pendingReapplyReason = MonitorReapplyReason::None;
+
+    // Monitor lost signal or power, cached VCP values can't be trusted
+    m_pipeline.InvalidateVcpCache();
+
+    // Check if color management is enabled
+    const auto snapshot = m_settings.GetSnapshot();
+    if (!snapshot->defaults.enableColorManagement)
+        return 0;
+
+    if (reason == MonitorReapplyReason::None)
+        return 0;
+
+    // Displays may have come back in a different order
+    const auto displays = m_pipeline.ResolveDisplays(*snapshot);
+
+    const bool forceReapply = (reason != MonitorReapplyReason::DisplayChange);
+    const uint64_t startMs = m_pipeline.GetBackends().clock.NowMs();
+    bool success = true;
+
+    // Reapply color correction based on current mode
+    if (hdrStatus == hdr::Status::On)
+    {
+        logging::Info(Category::Transition, "Monitor reconnected in HDR mode - reapplying color correction");
+        success = RunPhase(TransitionPhase::Reapply,
+                           [&]() { return m_pipeline.ReapplyHDRColorCorrection(displays, forceReapply); });
+    }
+    else if (hdrStatus == hdr::Status::Off)
+    {
+        logging::Info(Category::Transition, "Monitor reconnected in SDR mode - reapplying color correction");
+        success = RunPhase(TransitionPhase::Reapply,
+                           [&]() { return m_pipeline.ReapplySDRColorCorrection(displays, forceReapply); });
+    }
+    if (hdrStatus == hdr::Status::On || hdrStatus == hdr::Status::Off)
+        RecordTransition(true, success, std::nullopt, startMs);
+
+    auto& outcomes = reconnection_outcomes[static_cast<size_t>(reason) - 1];
+    if (success)
+    {
+        outcomes.succeeded.Add();
+        m_reapplyRetryCount = 0;
+        return 0;
+    }
+
+    // If we got a "strong" event (display on/resume), the monitor may just not be ready yet.
+    // After a plain display change, the monitor is usually gone if the reapply failed; but if it
+    // answered DDC/CI (values were read and are still cached), writing them failed and is worth a retry.
+    // Schedule a few retries with a small backoff.
+    const bool monitorAnswered = !m_pipeline.GetVcpCache().empty();
+    if ((forceReapply || monitorAnswered) && m_reapplyRetryCount < kMaxReapplyRetries)
+    {
+        m_reapplyRetryCount++;
+        m_pendingReapplyReason = reason;
+        const int delayMs = 1500 + (m_reapplyRetryCount * 750);
+        logging::Warning(Category::Transition, "Monitor reapply failed, scheduling retry in {}ms", delayMs);
+        outcomes.retried.Add();
+        return delayMs;
+    }
+
+    outcomes.failed.Add();
+    m_reapplyRetryCount = 0;
+    return 0;
+}
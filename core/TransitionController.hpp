@@ -0,0 +1,166 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Color Profile Management Extension
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "ColorPipeline.hpp"
+#include "DisplayEventDebouncer.hpp"
+
+#include <atomic>
+#include <functional>
+#include <optional>
+
+/// Phases of an HDR/SDR transition, reported to the phase callback
+enum class TransitionPhase
+{
+    SetHDRStatus,
+    PrepareForHDR,
+    ApplyHDRCalibration,
+    ApplySDRProfile,
+    Reapply,
+    Toggle,
+    Apply,
+
+    NumPhases
+};
+
+/// Get a human-readable name for a phase
+const char* TransitionPhaseName(TransitionPhase phase);
+
+/**
+ * Sequencing of HDR toggles and monitor reconnection handling.
+ * Decides which pipeline steps run, and in what order, when HDR is switched
+ * or a monitor comes back after signal loss.
+ */
+class TransitionController
+{
+public:
+    /// Receives the duration of every phase that ran
+    using PhaseCallback = std::function<void(TransitionPhase phase, uint64_t durationMs)>;
+    /// Selects the displays color settings are applied to
+    using DisplayFilter = std::function<bool(const MonitorSettings& display)>;
+
+    TransitionController(ColorPipeline& pipeline, SettingsSource& settings);
+
+    void SetPhaseCallback(PhaseCallback callback) { m_phaseCallback = std::move(callback); }
+
+    /**
+     * Toggle HDR and apply the matching color profile and monitor settings.
+     * @return New HDR status, or empty if switching failed
+     */
+    std::optional<hdr::Status> ToggleHDR();
+    /**
+     * Switch to HDR or SDR mode and apply the matching color profile and monitor settings,
+     * the same way as a toggle does, but even if the mode is already the requested one.
+     * @param filter If given, only displays it accepts get color settings applied;
+     *   the HDR switch itself is system wide
+     * @return New HDR status, or empty if switching failed
+     */
+    std::optional<hdr::Status> Apply(bool enableHDR, const DisplayFilter& filter = {});
+
+    /**
+     * Whether a pre-warm would be useful right now (none ran recently).
+     * Call on the thread that also toggles.
+     */
+    bool NeedsPrewarm();
+    /**
+     * Start a speculative pre-warm, eg when the mouse hovers over the tray icon.
+     * Call on the thread that also toggles.
+     * @return Settings to pass to RunPrewarm(), or nullptr if there's nothing to prepare
+     */
+    SettingsSnapshot BeginPrewarm();
+    /**
+     * Prepare the pipeline for a transition with the given settings.
+     * May run on a background thread; it must have finished before the next ToggleHDR()
+     * or HandleMonitorReconnection() call.
+     */
+    void RunPrewarm(const ColorSettings& settings);
+
+    struct PrewarmStats
+    {
+        uint64_t runs = 0;
+        /// Toggles that started with prepared caches
+        uint64_t warmToggles = 0;
+        uint64_t coldToggles = 0;
+        /// Total time spent pre-warming; for warm toggles, that work is off the click-to-apply path
+        uint64_t prewarmMs = 0;
+    };
+    PrewarmStats GetPrewarmStats() const;
+
+    void QueueMonitorReconnection(MonitorReapplyReason reason);
+    /**
+     * Reapply color correction for a queued monitor reconnection.
+     * @param hdrStatus Current HDR status
+     * @return Delay in milliseconds after which to call again for a retry, or 0
+     */
+    int HandleMonitorReconnection(hdr::Status hdrStatus);
+
+    /// Outcome of the last toggle or reconnection reapply
+    struct LastTransition
+    {
+        /// Number of transitions so far; 0 if none ran yet
+        uint64_t count = 0;
+        /// Whether it was a reapply after a reconnection, rather than a toggle
+        bool reapply = false;
+        /// Whether the HDR status could be switched and all color settings were applied
+        bool succeeded = false;
+        /// HDR status after a toggle
+        std::optional<hdr::Status> status;
+        uint64_t durationMs = 0;
+        /// Clock time the transition finished
+        uint64_t finishedMs = 0;
+    };
+    const LastTransition& GetLastTransition() const { return m_lastTransition; }
+
+private:
+    ColorPipeline& m_pipeline;
+    SettingsSource& m_settings;
+    PhaseCallback m_phaseCallback;
+
+    /// Time of the last pre-warm start, 0 if none since the last toggle
+    uint64_t m_prewarmStartMs = 0;
+    /// A toggle within this time after a pre-warm uses its results
+    static constexpr uint64_t kPrewarmValidMs = 10000;
+    PrewarmStats m_prewarmStats;
+    /// Duration of the last pre-warm; written by the pre-warm thread
+    std::atomic<uint64_t> m_lastPrewarmMs { 0 };
+    std::atomic<uint64_t> m_totalPrewarmMs { 0 };
+
+    MonitorReapplyReason m_pendingReapplyReason = MonitorReapplyReason::None;
+    int m_reapplyRetryCount = 0;
+    static constexpr int kMaxReapplyRetries = 6;
+
+    LastTransition m_lastTransition;
+    void RecordTransition(bool reapply, bool succeeded, std::optional<hdr::Status> status, uint64_t startMs);
+
+    /// Set the HDR status, reported as a phase
+    std::optional<hdr::Status> SetHDRStatus(bool enable);
+    /**
+     * Run the steps switching from the current status to HDR or SDR.
+     * @param colorApplied Receives whether all color settings were applied
+     */
+    std::optional<hdr::Status> SwitchMode(bool enableHDR, hdr::Status hdrStatus, const DisplayFilter& filter,
+                                          bool& colorApplied);
+
+    /// Run a function, reporting its duration as the given phase
+    template<typename F>
+    auto RunPhase(TransitionPhase phase, F&& func);
+};
@@ -0,0 +1,154 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Unicode.hpp"
+
+namespace unicode {
+
+namespace {
+
+void AppendCodePoint(std::wstring& out, char32_t cp)
+{
+    if constexpr (sizeof(wchar_t) == 2) {
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            out.push_back(static_cast<wchar_t>(0xD800 + (cp >> 10)));
+            out.push_back(static_cast<wchar_t>(0xDC00 + (cp & 0x3FF)));
+            return;
+        }
+    }
+    out.push_back(static_cast<wchar_t>(cp));
+}
+
+} // namespace
+
+char32_t NextCodePoint(std::wstring_view str, size_t& i)
+{
+    char32_t cp = static_cast<char32_t>(str[i++]);
+    if (cp >= 0xD800 && cp < 0xDC00 && i < str.size()) {
+        const char32_t low = static_cast<char32_t>(str[i]);
+        if (low >= 0xDC00 && low < 0xE000) {
+            i++;
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+        }
+    }
+    return cp;
+}
+
+bool DecodeUtf8(std::string_view bytes, std::wstring& out)
+{
+    out.clear();
+    out.reserve(bytes.size());
+    size_t i = 0;
+    while (i < bytes.size()) {
+        const auto b = static_cast<unsigned char>(bytes[i]);
+        if (b < 0x80) {
+            out.push_back(static_cast<wchar_t>(b));
+            i++;
+            continue;
+        }
+        int extra;
+        char32_t cp;
+        if ((b & 0xE0) == 0xC0) {
+            extra = 1;
+            cp = b & 0x1F;
+        } else if ((b & 0xF0) == 0xE0) {
+            extra = 2;
+            cp = b & 0x0F;
+        } else if ((b & 0xF8) == 0xF0) {
+            extra = 3;
+            cp = b & 0x07;
+        } else {
+            return false;
+        }
+        if (i + extra >= bytes.size())
+            return false;
+        for (int k = 1; k <= extra; k++) {
+            const auto c = static_cast<unsigned char>(bytes[i + k]);
+            if ((c & 0xC0) != 0x80)
+                return false;
+            cp = (cp << 6) | (c & 0x3F);
+        }
+        // Reject overlong encodings, surrogates and out of range values
+        static const char32_t kMinValue[] = { 0, 0x80, 0x800, 0x10000 };
+        if (cp < kMinValue[extra] || cp > 0x10FFFF || (cp >= 0xD800 && cp < 0xE000))
+            return false;
+        AppendCodePoint(out, cp);
+        i += extra + 1;
+    }
+    return true;
+}
+
+void DecodeUtf16LE(std::string_view bytes, std::wstring& out)
+{
+    out.clear();
+    out.reserve(bytes.size() / 2);
+    std::wstring units;
+    for (size_t i = 0; i + 1 < bytes.size(); i += 2) {
+        units.push_back(static_cast<wchar_t>(static_cast<unsigned char>(bytes[i])
+                                             | (static_cast<unsigned char>(bytes[i + 1]) << 8)));
+    }
+    if constexpr (sizeof(wchar_t) == 2) {
+        out = std::move(units);
+    } else {
+        for (size_t i = 0; i < units.size();)
+            AppendCodePoint(out, NextCodePoint(units, i));
+    }
+}
+
+void EncodeUtf8(std::wstring_view str, std::string& out)
+{
+    for (size_t i = 0; i < str.size();) {
+        const char32_t cp = NextCodePoint(str, i);
+        if (cp < 0x80) {
+            out.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+}
+
+void EncodeUtf16LE(std::wstring_view str, std::string& out)
+{
+    auto put = [&](char32_t unit) {
+        out.push_back(static_cast<char>(unit & 0xFF));
+        out.push_back(static_cast<char>(unit >> 8));
+    };
+    for (size_t i = 0; i < str.size();) {
+        char32_t cp = NextCodePoint(str, i);
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            put(0xD800 + (cp >> 10));
+            put(0xDC00 + (cp & 0x3FF));
+        } else {
+            put(cp);
+        }
+    }
+}
+
+} // namespace unicode
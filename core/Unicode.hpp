@@ -0,0 +1,49 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef UNICODE_HPP_
+#define UNICODE_HPP_
+
+#include <string>
+#include <string_view>
+
+/**
+ * Conversion between wide strings and UTF-8 or UTF-16 bytes, without depending on the platform.
+ * Wide strings are UTF-16 where wchar_t is 16 bits (Windows) and UTF-32 elsewhere.
+ */
+namespace unicode {
+
+/// Get the code point at position i of a wide string, advancing i; unpaired surrogates are returned as they are
+char32_t NextCodePoint(std::wstring_view str, size_t& i);
+
+/**
+ * Decode UTF-8 bytes, replacing the contents of out.
+ * @return false on invalid UTF-8: bad sequences, overlong encodings, surrogates
+ */
+bool DecodeUtf8(std::string_view bytes, std::wstring& out);
+/// Decode UTF-16 little endian bytes, replacing the contents of out; a trailing odd byte is ignored
+void DecodeUtf16LE(std::string_view bytes, std::wstring& out);
+
+/// Append the UTF-8 encoding of a wide string; unpaired surrogates are encoded as they are
+void EncodeUtf8(std::wstring_view str, std::string& out);
+/// Append the UTF-16 little endian encoding of a wide string
+void EncodeUtf16LE(std::wstring_view str, std::string& out);
+
+} // namespace unicode
+
+#endif // UNICODE_HPP_
@@ -0,0 +1,87 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Color Profile Management Extension
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "VcpBatch.hpp"
+
+#include <chrono>
+#include <map>
+#include <set>
+#include <thread>
+
+size_t VcpBatch::GetDisplayCount() const
+{
+    std::set<int> displays;
+    for (const auto& request : m_requests)
+        displays.insert(request.display);
+    return displays.size();
+}
+
+std::vector<VcpBatch::Result> VcpBatch::Run(backend::Ddc& ddc, bool concurrent) const
+{
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    const auto sinceStartUs = [start](Clock::time_point time) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(time - start).count());
+    };
+
+    std::vector<Result> results(m_requests.size());
+    // Each result slot is written by exactly one thread, so no locking is needed
+    const auto runRequest = [&](size_t index) {
+        const auto& request = m_requests[index];
+        auto& result = results[index];
+        result.display = request.display;
+        result.vcpCode = request.vcpCode;
+        result.write = request.value.has_value();
+        const auto begin = Clock::now();
+        if (request.value) {
+            result.value = *request.value;
+            result.succeeded = ddc.SetVcp(request.display, request.vcpCode, *request.value);
+        } else {
+            result.value = 0;
+            result.succeeded = ddc.GetVcp(request.display, request.vcpCode, result.value);
+        }
+        const auto end = Clock::now();
+        result.startUs = sinceStartUs(begin);
+        result.durationUs = sinceStartUs(end) - result.startUs;
+    };
+
+    // Request indices per display, in order
+    std::map<int, std::vector<size_t>> queues;
+    for (size_t i = 0; i < m_requests.size(); i++)
+        queues[m_requests[i].display].push_back(i);
+
+    if (!concurrent || queues.size() < 2) {
+        for (size_t i = 0; i < m_requests.size(); i++)
+            runRequest(i);
+        return results;
+    }
+
+    std::vector<std::jthread> workers;
+    workers.reserve(queues.size());
+    for (const auto& [display, queue] : queues) {
+        workers.emplace_back([&runRequest, &queue]() {
+            for (size_t index : queue)
+                runRequest(index);
+        });
+    }
+    workers.clear(); // joins
+    return results;
+}
@@ -0,0 +1,78 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2022 Frank Richter
+
+    Color Profile Management Extension
+    Copyright (C) 2025 Mattia Burati
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "ColorBackends.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/**
+ * A list of DDC/CI reads and writes, run as one batch.
+ *
+ * Each monitor sits on its own DDC/CI bus, and every transaction waits for the monitor to
+ * answer (40-50 ms per the DDC/CI spec). So the transactions for one monitor run back to back,
+ * in the order they were added, while different monitors are served concurrently, one thread each.
+ * This needs a Ddc backend that allows calls for different displays at the same time.
+ */
+class VcpBatch
+{
+public:
+    struct Request
+    {
+        int display;
+        int vcpCode;
+        /// Value to write; nothing to read the current value
+        std::optional<int> value;
+    };
+
+    struct Result
+    {
+        int display;
+        int vcpCode;
+        bool write;
+        bool succeeded;
+        /// Value read or written
+        int value;
+        /// Start of the transaction, relative to the start of the batch
+        uint64_t startUs;
+        uint64_t durationUs;
+    };
+
+    void Get(int display, int vcpCode) { m_requests.push_back({ display, vcpCode, std::nullopt }); }
+    void Set(int display, int vcpCode, int value) { m_requests.push_back({ display, vcpCode, value }); }
+
+    const std::vector<Request>& GetRequests() const { return m_requests; }
+    /// Number of different displays in the batch
+    size_t GetDisplayCount() const;
+
+    /**
+     * Run all transactions.
+     * @param concurrent Serve different displays at the same time; otherwise, run everything in order
+     * @return One result per request, in the order they were added
+     */
+    std::vector<Result> Run(backend::Ddc& ddc, bool concurrent = true) const;
+
+private:
+    std::vector<Request> m_requests;
+};
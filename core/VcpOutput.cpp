@@ -0,0 +1,55 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "VcpOutput.hpp"
+
+#include <regex>
+
+/// Parse a decimal or "0x" prefixed hexadecimal number
+static bool ParseNumber(const std::wstring& token, int& value)
+{
+    try {
+        if (token.rfind(L"0x", 0) == 0 || token.rfind(L"0X", 0) == 0)
+            value = std::stoi(token, nullptr, 16);
+        else
+            value = std::stoi(token, nullptr, 10);
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+bool ParseVcpCurrentValue(const std::wstring& output, int& currentValue)
+{
+    // Formats in order of preference; the first one found decides
+    static const std::wregex patterns[] = {
+        // "current value = 50", "current=50", "current value: 0x0032"
+        std::wregex(LR"((?:^|\s)current(?:\s+value)?\s*[:=]?\s*(0x[0-9a-fA-F]+|\d+))", std::regex_constants::icase),
+        // "VCP 0x10 50", "VCP 0x10 0x32": "VCP <code> <current> [max]" without labels
+        std::wregex(LR"((?:^|\s)VCP\s+0x[0-9a-fA-F]+\s+(0x[0-9a-fA-F]+|\d+)(?:\s|$))", std::regex_constants::icase),
+        // "VCP ...: value = X, max = Y"
+        std::wregex(LR"((?:^|\s)(?:value|val)\s*[:=]\s*(0x[0-9a-fA-F]+|\d+))", std::regex_constants::icase),
+    };
+
+    std::wsmatch match;
+    for (const auto& pattern : patterns) {
+        if (std::regex_search(output, match, pattern) && match.size() >= 2)
+            return ParseNumber(match[1].str(), currentValue);
+    }
+    return false;
+}
@@ -0,0 +1,33 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef VCPOUTPUT_HPP_
+#define VCPOUTPUT_HPP_
+
+#include <string>
+
+/**
+ * Get the current value from the output of a DDC/CI command line tool's "getvcp".
+ * Understands labelled output ("current value = 50", "current=50", "current value: 0x0032"),
+ * terse output ("VCP 0x10 50 100") and "value = X" without "current", so it doesn't rely on
+ * a specific tool (winddcutil vs renamed alternatives).
+ * @return false if no value was found
+ */
+bool ParseVcpCurrentValue(const std::wstring& output, int& currentValue);
+
+#endif // VCPOUTPUT_HPP_
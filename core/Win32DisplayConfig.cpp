@@ -0,0 +1,163 @@
+/*
+ *  Copyright (C) 2005-2018 Team Kodi
+ *
+ *  This file is based on source code from Kodi - https://kodi.tv
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSES/README.md for more information.
+ */
+
+#include "Win32DisplayConfig.hpp"
+
+#include <cstdint>
+
+#include "framework.h"
+#include "WinVerCheck.hpp"
+
+#if !defined(NTDDI_WIN11_GA) || WDK_NTDDI_VERSION < NTDDI_WIN11_GA
+#error Windows SDK too old: Version >= 10.0.26100 required
+#endif
+
+namespace hdr {
+
+template<typename Info> static void InitDeviceInfo(Info& info, DISPLAYCONFIG_DEVICE_INFO_TYPE type, const DisplayId& target)
+{
+    info.header.type = type;
+    info.header.size = sizeof(info);
+    info.header.adapterId.LowPart = target.adapterLow;
+    info.header.adapterId.HighPart = target.adapterHigh;
+    info.header.id = target.targetId;
+}
+
+Win32DisplayConfig::Win32DisplayConfig() : use_win11_24h2_color_functions(IsWindows11_24H2OrGreater()) { }
+
+bool Win32DisplayConfig::QueryActiveTargets(std::vector<DisplayId>& targets)
+{
+    uint32_t pathCount = 0;
+    uint32_t modeCount = 0;
+
+    if (GetDisplayConfigBufferSizes(QDC_ONLY_ACTIVE_PATHS, &pathCount, &modeCount) != ERROR_SUCCESS)
+        return false;
+
+    std::vector<DISPLAYCONFIG_PATH_INFO> paths(pathCount);
+    std::vector<DISPLAYCONFIG_MODE_INFO> modes(modeCount);
+
+    if (QueryDisplayConfig(QDC_ONLY_ACTIVE_PATHS, &pathCount, paths.data(), &modeCount, modes.data(), 0) != ERROR_SUCCESS)
+        return false;
+    paths.resize(pathCount);
+
+    targets.clear();
+    for (const auto& path : paths) {
+        const auto& mode = modes.at(path.targetInfo.modeInfoIdx);
+
+        DisplayId id;
+        id.adapterLow = mode.adapterId.LowPart;
+        id.adapterHigh = mode.adapterId.HighPart;
+        id.targetId = mode.id;
+        targets.push_back(id);
+    }
+    return true;
+}
+
+std::optional<AdvancedColorInfo> Win32DisplayConfig::GetAdvancedColorInfo(const DisplayId& target)
+{
+    DISPLAYCONFIG_GET_ADVANCED_COLOR_INFO getColorInfo = {};
+    InitDeviceInfo(getColorInfo, DISPLAYCONFIG_DEVICE_INFO_GET_ADVANCED_COLOR_INFO, target);
+    if (DisplayConfigGetDeviceInfo(&getColorInfo.header) != ERROR_SUCCESS)
+        return std::nullopt;
+
+    AdvancedColorInfo info;
+    info.advancedColorSupported = getColorInfo.advancedColorSupported;
+    info.advancedColorEnabled = getColorInfo.advancedColorEnabled;
+    info.wideColorEnforced = getColorInfo.wideColorEnforced;
+    info.bitsPerColorChannel = getColorInfo.bitsPerColorChannel;
+    return info;
+}
+
+std::optional<AdvancedColorInfo2> Win32DisplayConfig::GetAdvancedColorInfo2(const DisplayId& target)
+{
+    if (!use_win11_24h2_color_functions)
+        return std::nullopt;
+
+    DISPLAYCONFIG_GET_ADVANCED_COLOR_INFO_2 getColorInfo2 = {};
+    InitDeviceInfo(getColorInfo2, DISPLAYCONFIG_DEVICE_INFO_GET_ADVANCED_COLOR_INFO_2, target);
+    if (DisplayConfigGetDeviceInfo(&getColorInfo2.header) != ERROR_SUCCESS)
+        return std::nullopt;
+
+    AdvancedColorInfo2 info;
+    info.highDynamicRangeSupported = getColorInfo2.highDynamicRangeSupported;
+    info.bitsPerColorChannel = getColorInfo2.bitsPerColorChannel;
+    switch (getColorInfo2.activeColorMode) {
+    case DISPLAYCONFIG_ADVANCED_COLOR_MODE_HDR:
+        info.activeColorMode = ColorMode::Hdr;
+        break;
+    case DISPLAYCONFIG_ADVANCED_COLOR_MODE_WCG:
+        info.activeColorMode = ColorMode::Wcg;
+        break;
+    default:
+        info.activeColorMode = ColorMode::Sdr;
+        break;
+    }
+    return info;
+}
+
+std::optional<TargetName> Win32DisplayConfig::GetTargetName(const DisplayId& target)
+{
+    DISPLAYCONFIG_TARGET_DEVICE_NAME deviceName = {};
+    InitDeviceInfo(deviceName, DISPLAYCONFIG_DEVICE_INFO_GET_TARGET_NAME, target);
+    if (DisplayConfigGetDeviceInfo(&deviceName.header) != ERROR_SUCCESS)
+        return std::nullopt;
+
+    TargetName name;
+    name.monitorFriendlyDeviceName = deviceName.monitorFriendlyDeviceName;
+    name.friendlyNameFromEdid = deviceName.flags.friendlyNameFromEdid;
+    if (deviceName.flags.edidIdsValid) {
+        // Stored with bytes swapped
+        name.edidManufactureId = _byteswap_ushort(deviceName.edidManufactureId);
+        name.edidProductCodeId = deviceName.edidProductCodeId;
+    }
+    name.monitorDevicePath = deviceName.monitorDevicePath;
+    return name;
+}
+
+std::optional<bool> Win32DisplayConfig::IsInternalDisplay(const DisplayId& target)
+{
+    DISPLAYCONFIG_TARGET_BASE_TYPE target_base = {};
+    InitDeviceInfo(target_base, DISPLAYCONFIG_DEVICE_INFO_GET_TARGET_BASE_TYPE, target);
+    if (DisplayConfigGetDeviceInfo(&target_base.header) != ERROR_SUCCESS)
+        return std::nullopt;
+
+    return (target_base.baseOutputTechnology != DISPLAYCONFIG_OUTPUT_TECHNOLOGY_OTHER)
+           && (target_base.baseOutputTechnology & DISPLAYCONFIG_OUTPUT_TECHNOLOGY_INTERNAL);
+}
+
+std::optional<uint32_t> Win32DisplayConfig::GetSdrWhiteLevel(const DisplayId& target)
+{
+    DISPLAYCONFIG_SDR_WHITE_LEVEL white_level = {};
+    InitDeviceInfo(white_level, DISPLAYCONFIG_DEVICE_INFO_GET_SDR_WHITE_LEVEL, target);
+    if (DisplayConfigGetDeviceInfo(&white_level.header) != ERROR_SUCCESS)
+        return std::nullopt;
+
+    return white_level.SDRWhiteLevel;
+}
+
+bool Win32DisplayConfig::SetHdrState(const DisplayId& target, bool enable)
+{
+    if (!use_win11_24h2_color_functions)
+        return false;
+
+    DISPLAYCONFIG_SET_HDR_STATE setHdrState = {};
+    InitDeviceInfo(setHdrState, DISPLAYCONFIG_DEVICE_INFO_SET_HDR_STATE, target);
+    setHdrState.enableHdr = enable;
+    return DisplayConfigSetDeviceInfo(&setHdrState.header) == ERROR_SUCCESS;
+}
+
+bool Win32DisplayConfig::SetAdvancedColorState(const DisplayId& target, bool enable)
+{
+    DISPLAYCONFIG_SET_ADVANCED_COLOR_STATE setColorState = {};
+    InitDeviceInfo(setColorState, DISPLAYCONFIG_DEVICE_INFO_SET_ADVANCED_COLOR_STATE, target);
+    setColorState.enableAdvancedColor = enable;
+    return DisplayConfigSetDeviceInfo(&setColorState.header) == ERROR_SUCCESS;
+}
+
+} // namespace hdr
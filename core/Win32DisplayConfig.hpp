@@ -0,0 +1,48 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef WIN32DISPLAYCONFIG_HPP_
+#define WIN32DISPLAYCONFIG_HPP_
+
+#include "DisplayConfigBackend.hpp"
+
+namespace hdr {
+
+/// Display configuration backend using the Windows display configuration API
+class Win32DisplayConfig : public DisplayConfigBackend
+{
+public:
+    Win32DisplayConfig();
+
+    bool HasHdrStateFunctions() const override { return use_win11_24h2_color_functions; }
+    bool QueryActiveTargets(std::vector<DisplayId>& targets) override;
+    std::optional<AdvancedColorInfo> GetAdvancedColorInfo(const DisplayId& target) override;
+    std::optional<AdvancedColorInfo2> GetAdvancedColorInfo2(const DisplayId& target) override;
+    std::optional<TargetName> GetTargetName(const DisplayId& target) override;
+    std::optional<bool> IsInternalDisplay(const DisplayId& target) override;
+    std::optional<uint32_t> GetSdrWhiteLevel(const DisplayId& target) override;
+    bool SetHdrState(const DisplayId& target, bool enable) override;
+    bool SetAdvancedColorState(const DisplayId& target, bool enable) override;
+
+private:
+    bool use_win11_24h2_color_functions;
+};
+
+} // namespace hdr
+
+#endif // WIN32DISPLAYCONFIG_HPP_
@@ -0,0 +1,315 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* ipc::Server and ipc::Call() over a named pipe. */
+
+#include "IpcChannel.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "framework.h"
+#include <sddl.h>
+
+namespace ipc {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/// Time a client has to send its request, and to pick up the response
+constexpr std::chrono::milliseconds kServerIoTimeout { 2000 };
+constexpr DWORD kPipeBufferSize = 4096;
+
+class Handle
+{
+    HANDLE m_handle = nullptr;
+
+public:
+    Handle() = default;
+    explicit Handle(HANDLE handle) : m_handle(handle == INVALID_HANDLE_VALUE ? nullptr : handle) { }
+    Handle(Handle&& other) noexcept : m_handle(other.m_handle) { other.m_handle = nullptr; }
+    Handle& operator=(Handle&& other) noexcept
+    {
+        std::swap(m_handle, other.m_handle);
+        return *this;
+    }
+    ~Handle()
+    {
+        if (m_handle)
+            CloseHandle(m_handle);
+    }
+
+    HANDLE get() const { return m_handle; }
+    explicit operator bool() const { return m_handle != nullptr; }
+};
+
+DWORD RemainingMs(Clock::time_point deadline)
+{
+    const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - Clock::now());
+    return remaining.count() > 0 ? static_cast<DWORD>(remaining.count()) : 0;
+}
+
+/**
+ * Wait for overlapped I/O to complete.
+ * @return false on timeout, error or if \a stopEvent got signaled; the I/O is cancelled then.
+ */
+bool WaitIo(HANDLE pipe, OVERLAPPED& ov, HANDLE stopEvent, DWORD timeoutMs, DWORD& transferred)
+{
+    HANDLE events[2] = { ov.hEvent, stopEvent };
+    const DWORD wait = WaitForMultipleObjects(stopEvent ? 2 : 1, events, FALSE, timeoutMs);
+    if (wait != WAIT_OBJECT_0) {
+        CancelIoEx(pipe, &ov);
+        GetOverlappedResult(pipe, &ov, &transferred, TRUE);
+        return false;
+    }
+    return GetOverlappedResult(pipe, &ov, &transferred, FALSE) != FALSE;
+}
+
+/// Read or write all of \a data, with a pipe opened for overlapped I/O
+bool TransferAll(HANDLE pipe, bool write, uint8_t* data, size_t size, HANDLE ioEvent, HANDLE stopEvent,
+                 Clock::time_point deadline)
+{
+    while (size > 0) {
+        OVERLAPPED ov = {};
+        ov.hEvent = ioEvent;
+        ResetEvent(ioEvent);
+        const DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, kPipeBufferSize));
+        const BOOL result = write ? WriteFile(pipe, data, chunk, nullptr, &ov) : ReadFile(pipe, data, chunk, nullptr, &ov);
+        if (!result && GetLastError() != ERROR_IO_PENDING)
+            return false;
+        DWORD transferred = 0;
+        if (!WaitIo(pipe, ov, stopEvent, RemainingMs(deadline), transferred) || transferred == 0)
+            return false;
+        data += transferred;
+        size -= transferred;
+    }
+    return true;
+}
+
+bool SendFrame(HANDLE pipe, std::vector<uint8_t> frame, HANDLE ioEvent, HANDLE stopEvent, Clock::time_point deadline)
+{
+    return TransferAll(pipe, true, frame.data(), frame.size(), ioEvent, stopEvent, deadline);
+}
+
+/// Receive a frame, return its payload
+std::optional<std::vector<uint8_t>> ReceiveFrame(HANDLE pipe, HANDLE ioEvent, HANDLE stopEvent,
+                                                 Clock::time_point deadline)
+{
+    uint8_t header[kFrameHeaderSize];
+    if (!TransferAll(pipe, false, header, sizeof(header), ioEvent, stopEvent, deadline))
+        return std::nullopt;
+    auto size = PayloadSize(header);
+    if (!size)
+        return std::nullopt;
+    std::vector<uint8_t> payload(*size);
+    if (!TransferAll(pipe, false, payload.data(), payload.size(), ioEvent, stopEvent, deadline))
+        return std::nullopt;
+    return payload;
+}
+
+/// SDDL allowing access to the current user and the system only
+std::wstring PipeSecurity()
+{
+    HANDLE token;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &token))
+        return {};
+    Handle token_handle(token);
+    DWORD size = 0;
+    GetTokenInformation(token, TokenUser, nullptr, 0, &size);
+    std::vector<uint8_t> buffer(size);
+    if (size == 0 || !GetTokenInformation(token, TokenUser, buffer.data(), size, &size))
+        return {};
+    wchar_t* sid_string;
+    if (!ConvertSidToStringSidW(reinterpret_cast<TOKEN_USER*>(buffer.data())->User.Sid, &sid_string))
+        return {};
+    std::wstring sddl = L"D:P(A;;GA;;;" + std::wstring(sid_string) + L")(A;;GA;;;SY)";
+    LocalFree(sid_string);
+    return sddl;
+}
+
+} // namespace
+
+std::filesystem::path DefaultEndpoint()
+{
+    DWORD session = 0;
+    ProcessIdToSessionId(GetCurrentProcessId(), &session);
+    return L"\\\\.\\pipe\\HDRTray-" + std::to_wstring(session);
+}
+
+struct Server::Impl
+{
+    Handler handler;
+    Handle pipe;
+    Handle ioEvent;
+    Handle stopEvent;
+    std::thread thread;
+    std::atomic<uint64_t> requests = 0;
+    std::atomic<uint64_t> errors = 0;
+
+    void Run();
+    void Serve();
+};
+
+void Server::Impl::Run()
+{
+    while (true) {
+        OVERLAPPED ov = {};
+        ov.hEvent = ioEvent.get();
+        ResetEvent(ioEvent.get());
+        DWORD error = ConnectNamedPipe(pipe.get(), &ov) ? ERROR_SUCCESS : GetLastError();
+        if (error == ERROR_IO_PENDING) {
+            HANDLE events[2] = { ioEvent.get(), stopEvent.get() };
+            DWORD transferred = 0;
+            if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0) {
+                CancelIoEx(pipe.get(), &ov);
+                GetOverlappedResult(pipe.get(), &ov, &transferred, TRUE);
+                return;
+            }
+            error = GetOverlappedResult(pipe.get(), &ov, &transferred, FALSE) ? ERROR_SUCCESS : GetLastError();
+        }
+        if (error == ERROR_SUCCESS || error == ERROR_PIPE_CONNECTED)
+            Serve();
+        else
+            errors++;
+        DisconnectNamedPipe(pipe.get());
+        if (WaitForSingleObject(stopEvent.get(), 0) == WAIT_OBJECT_0)
+            return;
+    }
+}
+
+void Server::Impl::Serve()
+{
+    auto payload = ReceiveFrame(pipe.get(), ioEvent.get(), stopEvent.get(), Clock::now() + kServerIoTimeout);
+    if (!payload) {
+        errors++;
+        return;
+    }
+    Response response;
+    if (auto request = DecodeRequest(*payload)) {
+        trace::Span span("ipc", "Request");
+        span.Arg("command", static_cast<int64_t>(request->command));
+        response = handler(*request);
+    } else
+        response.result = Result::BadRequest;
+    const auto deadline = Clock::now() + kServerIoTimeout;
+    if (!SendFrame(pipe.get(), EncodeFrame(response), ioEvent.get(), stopEvent.get(), deadline)) {
+        errors++;
+        return;
+    }
+    requests++;
+    /* DisconnectNamedPipe() discards data the client hasn't read yet,
+     * so wait for the client to close its end */
+    uint8_t dummy;
+    TransferAll(pipe.get(), false, &dummy, 1, ioEvent.get(), stopEvent.get(), deadline);
+}
+
+Server::Server() = default;
+
+Server::~Server()
+{
+    Stop();
+}
+
+bool Server::Start(const std::filesystem::path& endpoint, Handler handler)
+{
+    Stop();
+
+    // Only the user running the server (and the system) may connect
+    const std::wstring sddl = PipeSecurity();
+    SECURITY_ATTRIBUTES sa = { sizeof(sa) };
+    if (sddl.empty()
+        || !ConvertStringSecurityDescriptorToSecurityDescriptorW(sddl.c_str(), SDDL_REVISION_1,
+                                                                 &sa.lpSecurityDescriptor, nullptr))
+        return false;
+    Handle pipe(CreateNamedPipeW(endpoint.c_str(),
+                                 PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                                 PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS, 1,
+                                 kPipeBufferSize, kPipeBufferSize, 0, &sa));
+    LocalFree(sa.lpSecurityDescriptor);
+    // Fails if another instance already created the pipe
+    if (!pipe)
+        return false;
+
+    auto impl = std::make_unique<Impl>();
+    impl->handler = std::move(handler);
+    impl->pipe = std::move(pipe);
+    impl->ioEvent = Handle(CreateEventW(nullptr, TRUE, FALSE, nullptr));
+    impl->stopEvent = Handle(CreateEventW(nullptr, TRUE, FALSE, nullptr));
+    if (!impl->ioEvent || !impl->stopEvent)
+        return false;
+    m_impl = std::move(impl);
+    m_impl->thread = std::thread([impl = m_impl.get()]() {
+        trace::SetThreadName("IpcServer");
+        impl->Run();
+    });
+    return true;
+}
+
+void Server::Stop()
+{
+    if (!m_impl)
+        return;
+    SetEvent(m_impl->stopEvent.get());
+    m_impl->thread.join();
+    m_impl.reset();
+}
+
+Server::Stats Server::GetStats() const
+{
+    Stats stats;
+    if (m_impl) {
+        stats.requests = m_impl->requests;
+        stats.errors = m_impl->errors;
+    }
+    return stats;
+}
+
+std::optional<Response> Call(const std::filesystem::path& endpoint, const Request& request,
+                             std::chrono::milliseconds timeout)
+{
+    const auto deadline = Clock::now() + timeout;
+    Handle pipe;
+    while (true) {
+        pipe = Handle(CreateFileW(endpoint.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING,
+                                  FILE_FLAG_OVERLAPPED | SECURITY_SQOS_PRESENT | SECURITY_IDENTIFICATION, nullptr));
+        if (pipe)
+            break;
+        // No server at all fails right away; a busy one (serving another client) is waited for
+        if (GetLastError() != ERROR_PIPE_BUSY)
+            return std::nullopt;
+        const DWORD remaining = RemainingMs(deadline);
+        if (remaining == 0 || !WaitNamedPipeW(endpoint.c_str(), remaining))
+            return std::nullopt;
+    }
+
+    Handle ioEvent(CreateEventW(nullptr, TRUE, FALSE, nullptr));
+    if (!ioEvent)
+        return std::nullopt;
+    if (!SendFrame(pipe.get(), EncodeFrame(request), ioEvent.get(), nullptr, deadline))
+        return std::nullopt;
+    auto payload = ReceiveFrame(pipe.get(), ioEvent.get(), nullptr, deadline);
+    if (!payload)
+        return std::nullopt;
+    return DecodeResponse(*payload);
+}
+
+} // namespace ipc
@@ -0,0 +1,82 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* MappedFile with a file mapping. */
+
+#include "MappedFile.hpp"
+
+#include <algorithm>
+
+#include "framework.h"
+
+MappedFile::~MappedFile()
+{
+    if (m_data)
+        Close(m_size);
+}
+
+bool MappedFile::Create(const std::filesystem::path& path, size_t size)
+{
+    if (m_data)
+        Close(m_size);
+    // Others may read the file, or rename it away, while it's written
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                              nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    // Extends the file to the mapping size, zero-filled
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                        static_cast<DWORD>(size), nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    m_file = reinterpret_cast<intptr_t>(file);
+    m_mapping = mapping;
+    m_data = data;
+    m_size = size;
+    return true;
+}
+
+void MappedFile::Close(size_t length)
+{
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+    HANDLE file = reinterpret_cast<HANDLE>(m_file);
+    if (file != INVALID_HANDLE_VALUE) {
+        // Only possible once the file isn't mapped anymore
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>(std::min(length, m_size));
+        if (SetFilePointerEx(file, end, nullptr, FILE_BEGIN))
+            SetEndOfFile(file);
+        CloseHandle(file);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_file = -1;
+    m_mapping = nullptr;
+}
@@ -0,0 +1,97 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* SharedMemory with a file mapping backed by the page file. */
+
+#include "SharedMemory.hpp"
+
+#include <cstdint>
+
+#include "framework.h"
+
+static std::wstring widen(const std::string& str)
+{
+    // Names are plain ASCII
+    return std::wstring(str.begin(), str.end());
+}
+
+std::string SharedMemory::SessionName(const std::string& base)
+{
+    return "Local\\" + base;
+}
+
+SharedMemory::~SharedMemory()
+{
+    Close();
+}
+
+bool SharedMemory::Create(const std::string& name, size_t size)
+{
+    Close();
+    /* Default security: the creating user and the system. The mapping goes away with the
+     * last handle, so nothing is left behind if the creator crashes. */
+    HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                        static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+                                        static_cast<DWORD>(size), widen(name).c_str());
+    if (!mapping)
+        return false;
+    if (GetLastError() == ERROR_ALREADY_EXISTS) {
+        CloseHandle(mapping);
+        return false;
+    }
+    void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (!data) {
+        CloseHandle(mapping);
+        return false;
+    }
+    m_handle = mapping;
+    m_data = data;
+    m_size = size;
+    m_ownedName = name;
+    return true;
+}
+
+bool SharedMemory::Open(const std::string& name, size_t size)
+{
+    Close();
+    HANDLE mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, widen(name).c_str());
+    if (!mapping)
+        return false;
+    // Fails if the mapping is smaller than requested
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+    if (!data) {
+        CloseHandle(mapping);
+        return false;
+    }
+    m_handle = mapping;
+    m_data = data;
+    m_size = size;
+    return true;
+}
+
+void SharedMemory::Close()
+{
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_handle)
+        CloseHandle(m_handle);
+    m_data = nullptr;
+    m_size = 0;
+    m_handle = nullptr;
+    m_ownedName.clear();
+}
@@ -0,0 +1,497 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* End-to-end HDR/SDR transition simulator.
+ * Runs the TransitionController/ColorPipeline/DisplayEventDebouncer logic used by HDRTray
+ * against simulated backends and a virtual clock, over randomized sequences of
+ * toggles, monitor wakes, resumes and cable pulls, and reports per-phase latencies.
+ * Also checks that a dry run of "HDRCmd apply" leaves the monitor alone and reports
+ * the changes a real run makes. */
+
+#include "SimBackends.hpp"
+
+#include "DisplayEventDebouncer.hpp"
+#include "RecordingBackends.hpp"
+#include "TransitionController.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options
+{
+    unsigned sequences = 2000;
+    unsigned steps = 8;
+    uint64_t seed = 1;
+    const char* baseline = nullptr;
+    const char* writeBaseline = nullptr;
+    double tolerancePct = 10;
+    /// Fraction of toggles where the mouse hovers over the icon before clicking
+    double hoverRate = 0.7;
+    bool histograms = true;
+    /// Worlds in which to check a dry run of "HDRCmd apply"
+    unsigned dryRuns = 200;
+};
+
+class Histogram
+{
+    std::vector<uint64_t> m_samples;
+    bool m_sorted = true;
+
+public:
+    void Add(uint64_t value)
+    {
+        m_samples.push_back(value);
+        m_sorted = false;
+    }
+    size_t Count() const { return m_samples.size(); }
+
+    uint64_t Percentile(double p)
+    {
+        if (m_samples.empty())
+            return 0;
+        if (!m_sorted) {
+            std::sort(m_samples.begin(), m_samples.end());
+            m_sorted = true;
+        }
+        size_t idx = static_cast<size_t>(std::ceil(p / 100.0 * m_samples.size()));
+        return m_samples[std::clamp<size_t>(idx, 1, m_samples.size()) - 1];
+    }
+
+    /// Print a histogram with power-of-two buckets
+    void Print()
+    {
+        if (m_samples.empty())
+            return;
+        std::map<int, size_t> buckets;
+        for (auto v : m_samples)
+            buckets[v > 0 ? static_cast<int>(std::log2(static_cast<double>(v))) : -1]++;
+        size_t max_count = 0;
+        for (const auto& [bucket, count] : buckets)
+            max_count = std::max(max_count, count);
+        for (const auto& [bucket, count] : buckets) {
+            const uint64_t lo = bucket < 0 ? 0 : uint64_t(1) << bucket;
+            const int bar = static_cast<int>((count * 50 + max_count - 1) / max_count);
+            std::printf("    %8llu ms | %-50.*s %zu\n", static_cast<unsigned long long>(lo), bar,
+                        "##################################################", count);
+        }
+    }
+};
+
+struct Results
+{
+    std::map<std::string, Histogram> phases;
+    uint64_t topologyQueries = 0;
+    uint64_t ddcTransactions = 0;
+    uint64_t coldSpawns = 0;
+    TransitionController::PrewarmStats prewarm;
+    uint64_t vcpReads = 0;
+    uint64_t vcpCacheHits = 0;
+    uint64_t debouncedEvents = 0;
+    uint64_t reconnectionJobs = 0;
+    uint64_t mismatches = 0;
+    uint64_t checks = 0;
+};
+
+struct DryRunResults
+{
+    uint64_t runs = 0;
+    /// Dry runs that changed the monitor or the HDR status
+    uint64_t touched = 0;
+    /// Dry runs reporting a change the real run didn't make
+    uint64_t missed = 0;
+    uint64_t changes = 0;
+    uint64_t redundantWrites = 0;
+    /// Time skipped by not waiting
+    uint64_t skippedMs = 0;
+};
+
+enum class Event { Toggle, Wake, Resume, CablePull };
+
+/// One simulated machine: monitor, display, tools, and the HDRTray logic on top
+class World
+{
+    sim::Random& m_random;
+    Results& m_results;
+    double m_hoverRate;
+    sim::Timings m_timings;
+    sim::VirtualClock m_clock;
+    sim::SimulatedMonitor m_monitor;
+    sim::FakeDisplay m_display;
+    sim::FakeGamma m_gamma;
+    sim::FixedSettings m_settings;
+    ColorPipeline m_pipeline;
+    TransitionController m_controller;
+    DisplayEventDebouncer m_debouncer;
+
+    static ColorSettings RandomSettings(sim::Random& random)
+    {
+        ColorSettings settings;
+        settings.defaults.enableColorPresetChange = random.Chance(0.3);
+        // Half of the users have a [Display.<id>] section for their monitor
+        if (random.Chance(0.5)) {
+            MonitorSettings display = settings.defaults;
+            display.edidId = sim::FakeDisplay::kEdidId;
+            display.sdrBrightness = 35;
+            display.hdrBrightness = 90;
+            settings.displays.emplace(display.edidId, display);
+        }
+        return settings;
+    }
+
+public:
+    World(sim::Random& random, Results& results, double hoverRate)
+        : m_random(random)
+        , m_results(results)
+        , m_hoverRate(hoverRate)
+        , m_monitor(m_clock, random, m_timings)
+        , m_display(m_clock, random, m_timings, m_monitor)
+        , m_gamma(m_clock, random, m_timings)
+        , m_settings(RandomSettings(random))
+        , m_pipeline(backend::Set { m_clock, m_display, m_monitor, m_gamma })
+        , m_controller(m_pipeline, m_settings)
+    {
+        m_controller.SetPhaseCallback([this](TransitionPhase phase, uint64_t durationMs) {
+            m_results.phases[TransitionPhaseName(phase)].Add(durationMs);
+        });
+        if (random.Chance(0.5))
+            m_display.SetHDRStatus(true);
+    }
+
+    ~World()
+    {
+        m_results.topologyQueries += m_display.GetTopologyQueries();
+        m_results.ddcTransactions += m_monitor.GetTransactions();
+        m_results.coldSpawns += m_monitor.GetColdSpawns() + m_gamma.GetColdSpawns();
+        const auto prewarm = m_controller.GetPrewarmStats();
+        m_results.prewarm.runs += prewarm.runs;
+        m_results.prewarm.warmToggles += prewarm.warmToggles;
+        m_results.prewarm.coldToggles += prewarm.coldToggles;
+        m_results.prewarm.prewarmMs += prewarm.prewarmMs;
+        const auto pipeline = m_pipeline.GetStats();
+        m_results.vcpReads += pipeline.vcpReads;
+        m_results.vcpCacheHits += pipeline.vcpCacheHits;
+        m_results.debouncedEvents += m_debouncer.GetStats().rawEvents;
+        m_results.reconnectionJobs += m_debouncer.GetStats().jobsEmitted;
+    }
+
+    void Run(Event event)
+    {
+        // Idle time between user/system actions
+        m_clock.Advance(m_random.Between(2000, 60000));
+
+        switch (event) {
+        case Event::Toggle:
+            Click();
+            // Mode switch causes display change notifications, handled once the toggle returned
+            Burst(MonitorReapplyReason::None, m_random.Between(1, 2), "Reconnect.AfterToggle");
+            break;
+        case Event::Wake:
+            m_monitor.Unreachable(m_random.Between(2000, 8000));
+            Burst(MonitorReapplyReason::DisplayOn, m_random.Between(1, 4), "Reconnect.Wake");
+            break;
+        case Event::Resume:
+            m_monitor.Unreachable(m_random.Between(3000, 12000));
+            Burst(MonitorReapplyReason::SystemResume, m_random.Between(0, 3), "Reconnect.Resume");
+            break;
+        case Event::CablePull:
+            m_monitor.FactoryReset();
+            m_monitor.Unreachable(m_random.Between(1000, 5000));
+            Burst(MonitorReapplyReason::None, m_random.Between(1, 3), "Reconnect.CablePull");
+            break;
+        }
+
+        CheckMonitorState();
+    }
+
+    /// Apply a mode as a dry run, then for real, like "HDRCmd apply --dry-run" followed by "HDRCmd apply"
+    void CheckDryRun(bool hdr, DryRunResults& results)
+    {
+        static constexpr int vcpCodes[] = { 0x10, 0x14, 0x16, 0x18, 0x1A };
+        std::map<int, int> registers;
+        for (int code : vcpCodes)
+            registers[code] = m_monitor.Peek(code);
+        const auto status = m_display.GetHDRStatus();
+
+        backend::Recorder dryRun(backend::Set { m_clock, m_display, m_monitor, m_gamma }, true);
+        ColorPipeline dryPipeline(dryRun.GetBackends());
+        TransitionController(dryPipeline, m_settings).Apply(hdr);
+
+        bool touched = m_display.GetHDRStatus() != status;
+        for (int code : vcpCodes)
+            touched |= m_monitor.Peek(code) != registers[code];
+
+        backend::Recorder real(backend::Set { m_clock, m_display, m_monitor, m_gamma }, false);
+        ColorPipeline realPipeline(real.GetBackends());
+        TransitionController(realPipeline, m_settings).Apply(hdr);
+
+        // The real run may retry, and write values it didn't read before, but it must make every reported change
+        const auto& realOps = real.GetOperations();
+        bool missed = false;
+        for (const auto& change : dryRun.GetChanges()) {
+            missed |= std::none_of(realOps.begin(), realOps.end(), [&](const backend::Recorder::Operation& op) {
+                return op.kind == change.kind && op.display == change.display && op.vcpCode == change.vcpCode
+                       && op.value == change.value && op.profile == change.profile;
+            });
+            results.changes++;
+        }
+        for (const auto& op : dryRun.GetOperations()) {
+            if (op.kind == backend::Recorder::OpKind::SetVcp && op.redundant)
+                results.redundantWrites++;
+            if (op.kind == backend::Recorder::OpKind::Sleep)
+                results.skippedMs += op.durationMs;
+        }
+        results.runs++;
+        results.touched += touched ? 1 : 0;
+        results.missed += missed ? 1 : 0;
+    }
+
+private:
+    /// User clicks the icon, possibly hovering over it a moment before
+    void Click()
+    {
+        uint64_t clickMs = m_clock.NowMs();
+        const bool hover = m_random.Chance(m_hoverRate);
+        if (hover) {
+            // Pre-warm runs in the background while the user moves to click
+            clickMs += m_random.Between(300, 2000);
+            if (auto settings = m_controller.BeginPrewarm()) {
+                const uint64_t start = m_clock.NowMs();
+                m_controller.RunPrewarm(*settings);
+                m_results.phases["Prewarm"].Add(m_clock.NowMs() - start);
+            }
+            // If the pre-warm isn't done by the time of the click, the toggle waits for it
+            if (m_clock.NowMs() < clickMs)
+                m_clock.Advance(static_cast<int>(clickMs - m_clock.NowMs()));
+        }
+        m_controller.ToggleHDR();
+        m_results.phases[hover ? "Click.Warm" : "Click.Cold"].Add(m_clock.NowMs() - clickMs);
+    }
+
+    /// Deliver a burst of display change events, plus an optional power event, and run the reconnection
+    void Burst(MonitorReapplyReason powerEvent, int displayChanges, const char* phaseName)
+    {
+        const uint64_t start = m_clock.NowMs();
+        if (powerEvent != MonitorReapplyReason::None)
+            m_debouncer.Record(powerEvent, m_clock.NowMs());
+        for (int i = 0; i < displayChanges; i++) {
+            m_clock.Advance(m_random.Between(50, 900));
+            if (m_debouncer.Record(MonitorReapplyReason::DisplayChange, m_clock.NowMs()))
+                m_display.GetHDRStatus(); // Immediate status refresh for the first event
+        }
+        if (!m_debouncer.IsPending())
+            return;
+
+        std::optional<DisplayEventDebouncer::Job> job;
+        while (!(job = m_debouncer.Poll(m_clock.NowMs())))
+            m_clock.Advance(std::max(1u, m_debouncer.MsUntilDue(m_clock.NowMs())));
+        m_results.phases["Debounce"].Add(m_clock.NowMs() - start);
+
+        m_controller.QueueMonitorReconnection(job->reason);
+        int retryDelayMs = m_controller.HandleMonitorReconnection(m_display.GetHDRStatus());
+        while (retryDelayMs > 0) {
+            m_clock.Advance(retryDelayMs);
+            retryDelayMs = m_controller.HandleMonitorReconnection(m_display.GetHDRStatus());
+        }
+        m_results.phases[phaseName].Add(m_clock.NowMs() - start);
+    }
+
+    /// Check whether the monitor ended up with the settings for the current mode
+    void CheckMonitorState()
+    {
+        const auto snapshot = m_settings.GetSnapshot();
+        const auto& settings = snapshot->displays.empty() ? snapshot->defaults : snapshot->displays.begin()->second;
+        const bool hdr = m_display.GetHDRStatus() == hdr::Status::On;
+        const int expected[][2] = {
+            { 0x10, hdr ? settings.hdrBrightness : settings.sdrBrightness },
+            { 0x16, hdr ? settings.hdrRedGain : settings.sdrRedGain },
+            { 0x18, hdr ? settings.hdrGreenGain : settings.sdrGreenGain },
+            { 0x1A, hdr ? settings.hdrBlueGain : settings.sdrBlueGain },
+        };
+        m_results.checks++;
+        for (const auto& item : expected) {
+            if (m_monitor.Peek(item[0]) != item[1]) {
+                m_results.mismatches++;
+                break;
+            }
+        }
+    }
+};
+
+Event RandomEvent(sim::Random& random)
+{
+    const int roll = random.Between(0, 99);
+    if (roll < 40)
+        return Event::Toggle;
+    if (roll < 65)
+        return Event::Wake;
+    if (roll < 80)
+        return Event::Resume;
+    return Event::CablePull;
+}
+
+std::map<std::string, double> ReadBaseline(const char* path)
+{
+    std::map<std::string, double> baseline;
+    std::ifstream in(path);
+    std::string phase;
+    double p95;
+    while (in >> phase >> p95)
+        baseline[phase] = p95;
+    return baseline;
+}
+
+void Usage(const char* argv0)
+{
+    std::fprintf(stderr,
+                 "Usage: %s [--sequences N] [--steps N] [--seed N] [--baseline FILE] [--tolerance PCT]\n"
+                 "          [--write-baseline FILE] [--hover-rate FRACTION] [--no-histograms] [--dry-runs N]\n",
+                 argv0);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        auto arg = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                Usage(argv[0]);
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (std::strcmp(argv[i], "--sequences") == 0)
+            options.sequences = static_cast<unsigned>(std::strtoul(arg(), nullptr, 10));
+        else if (std::strcmp(argv[i], "--steps") == 0)
+            options.steps = static_cast<unsigned>(std::strtoul(arg(), nullptr, 10));
+        else if (std::strcmp(argv[i], "--seed") == 0)
+            options.seed = std::strtoull(arg(), nullptr, 10);
+        else if (std::strcmp(argv[i], "--baseline") == 0)
+            options.baseline = arg();
+        else if (std::strcmp(argv[i], "--write-baseline") == 0)
+            options.writeBaseline = arg();
+        else if (std::strcmp(argv[i], "--tolerance") == 0)
+            options.tolerancePct = std::strtod(arg(), nullptr);
+        else if (std::strcmp(argv[i], "--hover-rate") == 0)
+            options.hoverRate = std::strtod(arg(), nullptr);
+        else if (std::strcmp(argv[i], "--dry-runs") == 0)
+            options.dryRuns = static_cast<unsigned>(std::strtoul(arg(), nullptr, 10));
+        else if (std::strcmp(argv[i], "--no-histograms") == 0)
+            options.histograms = false;
+        else {
+            Usage(argv[0]);
+            return 2;
+        }
+    }
+
+    sim::Random random(options.seed);
+    Results results;
+    for (unsigned seq = 0; seq < options.sequences; seq++) {
+        World world(random, results, options.hoverRate);
+        for (unsigned step = 0; step < options.steps; step++)
+            world.Run(RandomEvent(random));
+    }
+
+    // Separate random sequence and results, so the dry runs don't change the numbers above
+    sim::Random dryRunRandom(options.seed + 1);
+    Results dryRunWorldResults;
+    DryRunResults dryRuns;
+    for (unsigned run = 0; run < options.dryRuns; run++) {
+        World world(dryRunRandom, dryRunWorldResults, options.hoverRate);
+        for (unsigned step = 0; step < options.steps / 2; step++)
+            world.Run(RandomEvent(dryRunRandom));
+        world.CheckDryRun(dryRunRandom.Chance(0.5), dryRuns);
+    }
+
+    std::printf("%u sequences x %u steps, seed %llu\n\n", options.sequences, options.steps,
+                static_cast<unsigned long long>(options.seed));
+    std::printf("%-24s %8s %8s %8s %8s %8s\n", "Phase", "Count", "p50", "p95", "p99", "Max");
+    for (auto& [name, histogram] : results.phases) {
+        std::printf("%-24s %8zu %8llu %8llu %8llu %8llu\n", name.c_str(), histogram.Count(),
+                    static_cast<unsigned long long>(histogram.Percentile(50)),
+                    static_cast<unsigned long long>(histogram.Percentile(95)),
+                    static_cast<unsigned long long>(histogram.Percentile(99)),
+                    static_cast<unsigned long long>(histogram.Percentile(100)));
+    }
+    std::printf("\nTopology queries: %llu, DDC/CI transactions: %llu\n",
+                static_cast<unsigned long long>(results.topologyQueries),
+                static_cast<unsigned long long>(results.ddcTransactions));
+    std::printf("Cold tool starts: %llu\n", static_cast<unsigned long long>(results.coldSpawns));
+    std::printf("Pre-warms: %llu (%llu ms total), warm toggles: %llu, cold toggles: %llu\n",
+                static_cast<unsigned long long>(results.prewarm.runs),
+                static_cast<unsigned long long>(results.prewarm.prewarmMs),
+                static_cast<unsigned long long>(results.prewarm.warmToggles),
+                static_cast<unsigned long long>(results.prewarm.coldToggles));
+    std::printf("VCP reads: %llu, answered from cache: %llu\n", static_cast<unsigned long long>(results.vcpReads),
+                static_cast<unsigned long long>(results.vcpCacheHits));
+    std::printf("Display events: %llu, reconnection jobs: %llu\n",
+                static_cast<unsigned long long>(results.debouncedEvents),
+                static_cast<unsigned long long>(results.reconnectionJobs));
+    std::printf("Monitor state wrong after %llu of %llu steps\n", static_cast<unsigned long long>(results.mismatches),
+                static_cast<unsigned long long>(results.checks));
+    std::printf("Dry runs: %llu, %llu changes reported, %llu redundant writes, %llu ms of waits skipped; "
+                "touched the monitor: %llu, missed by the real run: %llu\n",
+                static_cast<unsigned long long>(dryRuns.runs), static_cast<unsigned long long>(dryRuns.changes),
+                static_cast<unsigned long long>(dryRuns.redundantWrites),
+                static_cast<unsigned long long>(dryRuns.skippedMs), static_cast<unsigned long long>(dryRuns.touched),
+                static_cast<unsigned long long>(dryRuns.missed));
+
+    if (options.histograms) {
+        for (auto& [name, histogram] : results.phases) {
+            std::printf("\n  %s\n", name.c_str());
+            histogram.Print();
+        }
+    }
+
+    if (options.writeBaseline) {
+        std::ofstream out(options.writeBaseline);
+        for (auto& [name, histogram] : results.phases)
+            out << name << ' ' << histogram.Percentile(95) << '\n';
+    }
+
+    int result = results.mismatches == 0 && dryRuns.touched == 0 && dryRuns.missed == 0 ? 0 : 1;
+    if (options.baseline) {
+        auto baseline = ReadBaseline(options.baseline);
+        if (baseline.empty()) {
+            std::fprintf(stderr, "Could not read baseline from %s\n", options.baseline);
+            return 2;
+        }
+        for (auto& [name, p95] : baseline) {
+            auto it = results.phases.find(name);
+            if (it == results.phases.end())
+                continue;
+            const double current = static_cast<double>(it->second.Percentile(95));
+            if (current > p95 * (1 + options.tolerancePct / 100)) {
+                std::fprintf(stderr, "REGRESSION: %s p95 %.0f ms exceeds baseline %.0f ms by more than %.0f%%\n",
+                             name.c_str(), current, p95, options.tolerancePct);
+                result = 1;
+            }
+        }
+    }
+    return result;
+}
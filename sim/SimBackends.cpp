@@ -0,0 +1,168 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "SimBackends.hpp"
+
+#include <algorithm>
+
+namespace sim {
+
+ToolSpawner::ToolSpawner(VirtualClock& clock, Random& random, const Timings& timings)
+    : m_clock(clock)
+    , m_random(random)
+    , m_timings(timings)
+{
+}
+
+void ToolSpawner::Spawn()
+{
+    if (!m_lastSpawnMs || m_clock.NowMs() - *m_lastSpawnMs > static_cast<uint64_t>(m_timings.coldAfterMs)) {
+        m_coldSpawns++;
+        m_clock.Advance(m_random.Between(m_timings.coldSpawnMin, m_timings.coldSpawnMax));
+    }
+    m_clock.Advance(m_random.Between(m_timings.spawnMin, m_timings.spawnMax));
+    m_lastSpawnMs = m_clock.NowMs();
+}
+
+SimulatedMonitor::SimulatedMonitor(VirtualClock& clock, Random& random, const Timings& timings)
+    : m_clock(clock)
+    , m_random(random)
+    , m_timings(timings)
+    , m_tool(clock, random, timings)
+{
+    FactoryReset();
+}
+
+void SimulatedMonitor::FactoryReset()
+{
+    m_vcp[0x10] = 80; // Brightness
+    m_vcp[0x14] = 1;  // Color preset
+    m_vcp[0x16] = 50; // Video gain red
+    m_vcp[0x18] = 50; // Video gain green
+    m_vcp[0x1A] = 50; // Video gain blue
+}
+
+void SimulatedMonitor::Unreachable(int durationMs)
+{
+    m_readyAtMs = std::max(m_readyAtMs, m_clock.NowMs() + durationMs);
+}
+
+bool SimulatedMonitor::Transact()
+{
+    m_transactions++;
+    m_tool.Spawn();
+    if (m_clock.NowMs() < m_readyAtMs)
+        return false;
+    m_clock.Advance(m_random.Between(m_timings.ddcMin, m_timings.ddcMax));
+    return true;
+}
+
+bool SimulatedMonitor::SetVcp(int /*display*/, int vcpCode, int value)
+{
+    if (!Transact() || m_random.Chance(m_timings.setFailure))
+        return false;
+    auto reg = m_vcp.find(vcpCode);
+    if (reg == m_vcp.end())
+        return false;
+    if (m_random.Chance(m_timings.setDropped))
+        return true;
+
+    const bool presetChange = vcpCode == 0x14 && reg->second != value;
+    reg->second = value;
+    if (presetChange) {
+        // Switching the color preset restores the preset's gains
+        m_vcp[0x16] = m_vcp[0x18] = m_vcp[0x1A] = 50;
+    }
+    return true;
+}
+
+bool SimulatedMonitor::GetVcp(int /*display*/, int vcpCode, int& currentValue)
+{
+    if (!Transact())
+        return false;
+    auto reg = m_vcp.find(vcpCode);
+    if (reg == m_vcp.end())
+        return false;
+    currentValue = reg->second;
+    return true;
+}
+
+FakeDisplay::FakeDisplay(VirtualClock& clock, Random& random, const Timings& timings, SimulatedMonitor& monitor)
+    : m_clock(clock)
+    , m_random(random)
+    , m_timings(timings)
+    , m_monitor(monitor)
+{
+}
+
+hdr::Status FakeDisplay::GetHDRStatus()
+{
+    m_topologyQueries++;
+    m_clock.Advance(m_random.Between(1, 4));
+    return m_status;
+}
+
+std::optional<hdr::Status> FakeDisplay::SetHDRStatus(bool enable)
+{
+    // Like hdr::SetWindowsHDRStatus: enumerate, query, set, re-query
+    m_topologyQueries++;
+    const auto new_status = enable ? hdr::Status::On : hdr::Status::Off;
+    if (new_status != m_status) {
+        m_clock.Advance(m_random.Between(m_timings.modeSetMin, m_timings.modeSetMax));
+        m_monitor.Unreachable(m_random.Between(m_timings.resyncMin, m_timings.resyncMax));
+        m_status = new_status;
+    } else {
+        m_clock.Advance(m_random.Between(2, 8));
+    }
+    return m_status;
+}
+
+std::vector<std::wstring> FakeDisplay::GetEdidIds()
+{
+    // Monitor enumeration plus a registry read
+    m_clock.Advance(m_random.Between(1, 3));
+    return { kEdidId };
+}
+
+FakeGamma::FakeGamma(VirtualClock& clock, Random& random, const Timings& timings)
+    : m_clock(clock)
+    , m_random(random)
+    , m_timings(timings)
+    , m_tool(clock, random, timings)
+{
+}
+
+bool FakeGamma::PrepareProfile(const std::wstring& profileName)
+{
+    if (profileName.empty())
+        return false;
+    // File system check for changes
+    m_clock.Advance(1);
+    if (m_parsed.insert(profileName).second)
+        m_clock.Advance(m_random.Between(m_timings.parseMin, m_timings.parseMax));
+    return true;
+}
+
+bool FakeGamma::LoadProfile(int /*display*/, const std::wstring& /*profileName*/)
+{
+    m_tool.Spawn();
+    m_clock.Advance(m_random.Between(m_timings.gammaMin, m_timings.gammaMax));
+    return true;
+}
+
+} // namespace sim
@@ -0,0 +1,195 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SIM_SIMBACKENDS_HPP_
+#define SIM_SIMBACKENDS_HPP_
+
+#include "ColorBackends.hpp"
+#include "MonitorSettings.hpp"
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <set>
+
+namespace sim {
+
+/// Random number source shared by all simulated components
+class Random
+{
+    std::mt19937_64 m_engine;
+
+public:
+    explicit Random(uint64_t seed) : m_engine(seed) { }
+
+    /// Uniformly distributed integer in [lo, hi]
+    int Between(int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(m_engine); }
+    /// Returns true with the given probability
+    bool Chance(double p) { return std::bernoulli_distribution(p)(m_engine); }
+};
+
+/// Clock that only advances when something sleeps or spends time
+class VirtualClock : public backend::Clock
+{
+    uint64_t m_nowMs = 0;
+
+public:
+    uint64_t NowMs() override { return m_nowMs; }
+    void SleepMs(int milliseconds) override { Advance(milliseconds); }
+    void Advance(int milliseconds) { m_nowMs += milliseconds > 0 ? milliseconds : 0; }
+};
+
+/// Timing model, all values in milliseconds
+struct Timings
+{
+    /// Cost of spawning an external tool process
+    int spawnMin = 25, spawnMax = 60;
+    /// Extra cost of spawning a tool that didn't run for a while (evicted from file cache, rescanned)
+    int coldSpawnMin = 150, coldSpawnMax = 450;
+    int coldAfterMs = 20000;
+    /// Reading and parsing a profile file
+    int parseMin = 10, parseMax = 45;
+    /// DDC/CI transaction time
+    int ddcMin = 40, ddcMax = 90;
+    /// Time the display driver needs to switch HDR mode
+    int modeSetMin = 500, modeSetMax = 1800;
+    /// Time the monitor ignores DDC/CI after the video signal changed
+    int resyncMin = 1200, resyncMax = 4000;
+    /// Time to load a calibration into the video card gamma table
+    int gammaMin = 120, gammaMax = 350;
+    /// Probability of a DDC/CI write failing with an error
+    double setFailure = 0.03;
+    /// Probability of a DDC/CI write being silently dropped
+    double setDropped = 0.02;
+};
+
+/// An external tool executable, slower to start when it didn't run recently
+class ToolSpawner
+{
+public:
+    ToolSpawner(VirtualClock& clock, Random& random, const Timings& timings);
+
+    /// Spend the time of starting the tool
+    void Spawn();
+    uint64_t GetColdSpawns() const { return m_coldSpawns; }
+
+private:
+    VirtualClock& m_clock;
+    Random& m_random;
+    const Timings& m_timings;
+    std::optional<uint64_t> m_lastSpawnMs;
+    uint64_t m_coldSpawns = 0;
+};
+
+/// A monitor reachable via DDC/CI
+class SimulatedMonitor : public backend::Ddc
+{
+public:
+    SimulatedMonitor(VirtualClock& clock, Random& random, const Timings& timings);
+
+    bool IsAvailable() const override { return true; }
+    bool SetVcp(int display, int vcpCode, int value) override;
+    bool GetVcp(int display, int vcpCode, int& currentValue) override;
+
+    /// Monitor doesn't answer DDC/CI until the given time
+    void Unreachable(int durationMs);
+    /// Reset VCP registers to factory values (eg power loss, cable pull)
+    void FactoryReset();
+
+    /// Read a register without spending any time, for checking results
+    int Peek(int vcpCode) const { return m_vcp.at(vcpCode); }
+    uint64_t GetTransactions() const { return m_transactions; }
+    uint64_t GetColdSpawns() const { return m_tool.GetColdSpawns(); }
+
+private:
+    VirtualClock& m_clock;
+    Random& m_random;
+    const Timings& m_timings;
+    ToolSpawner m_tool;
+    uint64_t m_readyAtMs = 0;
+    uint64_t m_transactions = 0;
+    std::map<int, int> m_vcp;
+
+    /// Spend the time of a tool spawn plus DDC/CI transaction. Returns whether the monitor responded.
+    bool Transact();
+};
+
+/// "Use HDR" switch of a single HDR capable display, connected to a SimulatedMonitor
+class FakeDisplay : public backend::Display
+{
+public:
+    FakeDisplay(VirtualClock& clock, Random& random, const Timings& timings, SimulatedMonitor& monitor);
+
+    hdr::Status GetHDRStatus() override;
+    std::optional<hdr::Status> SetHDRStatus(bool enable) override;
+    /// Nothing to do, the simulated status is never cached
+    void Refresh() override {}
+    std::vector<std::wstring> GetEdidIds() override;
+
+    /// EDID id of the simulated monitor
+    static constexpr const wchar_t* kEdidId = L"SIM0001-00000001";
+
+    uint64_t GetTopologyQueries() const { return m_topologyQueries; }
+
+private:
+    VirtualClock& m_clock;
+    Random& m_random;
+    const Timings& m_timings;
+    SimulatedMonitor& m_monitor;
+    hdr::Status m_status = hdr::Status::Off;
+    uint64_t m_topologyQueries = 0;
+};
+
+/// Gamma table loader (dispwin)
+class FakeGamma : public backend::Gamma
+{
+public:
+    FakeGamma(VirtualClock& clock, Random& random, const Timings& timings);
+
+    bool IsAvailable() const override { return true; }
+    bool PrepareProfile(const std::wstring& profileName) override;
+    bool LoadProfile(int display, const std::wstring& profileName) override;
+
+    uint64_t GetColdSpawns() const { return m_tool.GetColdSpawns(); }
+
+private:
+    VirtualClock& m_clock;
+    Random& m_random;
+    const Timings& m_timings;
+    ToolSpawner m_tool;
+    /// Profiles parsed so far; like ProfileCache, they stay cached
+    std::set<std::wstring> m_parsed;
+};
+
+/// Fixed settings
+class FixedSettings : public SettingsSource
+{
+    SettingsSnapshot m_settings;
+
+public:
+    explicit FixedSettings(const ColorSettings& settings)
+        : m_settings(std::make_shared<const ColorSettings>(settings))
+    {
+    }
+
+    SettingsSnapshot GetSnapshot() const override { return m_settings; }
+};
+
+} // namespace sim
+
+#endif // SIM_SIMBACKENDS_HPP_
@@ -0,0 +1,299 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Test.hpp"
+
+#include "ConfigManager.hpp"
+#include "ConfigSchema.hpp"
+#include "IniDocument.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace {
+
+const char sample_config[] = "; HDRTray Configuration File\r\n"
+                             "; Edit these values to customize your monitor settings\r\n"
+                             "\r\n"
+                             "[Monitor]\r\n"
+                             "; Display ID (usually 1 for primary monitor)\r\n"
+                             "DisplayId=1\r\n"
+                             "\r\n"
+                             "[Profiles]\r\n"
+                             "EnableColorManagement=1\r\n"
+                             "SDRProfile=Xiaomi 27i Pro_Rtings.icm\r\n"
+                             "HDRCalibration=xiaomi_miniled_1d.cal\r\n"
+                             "EnableSDRProfile=1\r\n"
+                             "EnableHDRProfile=1\r\n"
+                             "EnableColorPresetChange=0\r\n"
+                             "\r\n"
+                             "[SDR]\r\n"
+                             "; SDR Mode Settings (VCP codes: 0x10=Brightness, 0x16=Red, 0x18=Green, 0x1A=Blue)\r\n"
+                             "Brightness=50\r\n"
+                             "RedGain=50\r\n"
+                             "GreenGain=49\r\n"
+                             "BlueGain=49\r\n"
+                             "\r\n"
+                             "[HDR]\r\n"
+                             "Brightness=100\r\n"
+                             "RedGain=46\r\n"
+                             "ColorPreset=12\r\n"
+                             "\r\n"
+                             "; Settings for a second monitor, matched by EDID id\r\n"
+                             "[Display.del4123-0000abcd]\r\n"
+                             "SDRProfile=U2723QE.icm\r\n"
+                             "SDRBrightness=30\r\n";
+
+/// Write the sample config in the given encoding, returning its path
+std::filesystem::path WriteSample(IniDocument::Encoding encoding)
+{
+    const auto path = test::TempDirectory() / "HDRTray.ini";
+    IniDocument doc;
+    doc.Parse(sample_config);
+    doc.SetEncoding(encoding);
+    doc.WriteFile(path);
+    return path;
+}
+
+/// Count comment lines, to check they are preserved
+size_t CountComments(const std::filesystem::path& path)
+{
+    IniDocument doc;
+    doc.ReadFile(path);
+    doc.SetEncoding(IniDocument::Encoding::Utf8);
+    const std::string text = "\n" + doc.Serialize();
+    size_t count = 0;
+    for (size_t pos = 0; (pos = text.find("\n;", pos)) != std::string::npos; pos++)
+        count++;
+    return count;
+}
+
+/// Compare all values described by the settings schema
+bool SameSettings(const MonitorSettings& a, const MonitorSettings& b)
+{
+    for (const auto& setting : schema::kSettings) {
+        switch (setting.type) {
+        case schema::Type::Int:
+            if (a.*setting.intMember != b.*setting.intMember)
+                return false;
+            break;
+        case schema::Type::Bool:
+            if (a.*setting.boolMember != b.*setting.boolMember)
+                return false;
+            break;
+        case schema::Type::String:
+            if (a.*setting.stringMember != b.*setting.stringMember)
+                return false;
+            break;
+        }
+    }
+    return true;
+}
+
+/// Change a value in the file, like a user editing it
+void EditFile(const std::filesystem::path& path, const wchar_t* section, const wchar_t* key, int value)
+{
+    IniDocument doc;
+    doc.ReadFile(path);
+    doc.SetInt(section, key, value);
+    doc.WriteFile(path);
+}
+
+/// Wait until a condition holds, or two seconds passed
+template<typename Condition> bool WaitFor(Condition condition)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() >= deadline)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+void CheckRoundTrip(IniDocument::Encoding encoding)
+{
+    const auto path = WriteSample(encoding);
+    const auto comments = CountComments(path);
+
+    ConfigManager config(path.wstring());
+    REQUIRE(config.Load());
+    CHECK(config.GetMonitorSettings().sdrGreenGain == 49);
+    CHECK(config.GetMonitorSettings().hdrColorPreset == 12);
+    auto settings = config.GetMonitorSettings();
+    settings.sdrProfileName = L"Profile with spaces.icm";
+    settings.hdrBrightness = 87;
+    config.SetMonitorSettings(settings);
+    REQUIRE(config.Save());
+
+    ConfigManager reloaded(path.wstring());
+    REQUIRE(reloaded.Load());
+    CHECK(reloaded.GetMonitorSettings().sdrProfileName == L"Profile with spaces.icm");
+    CHECK(reloaded.GetMonitorSettings().hdrBrightness == 87);
+    CHECK(reloaded.GetMonitorSettings().sdrRedGain == 50);
+
+    const auto displays = reloaded.GetSnapshot()->displays;
+    const auto display = displays.find(L"DEL4123-0000ABCD");
+    REQUIRE(displays.size() == 1 && display != displays.end());
+    CHECK(display->second.sdrProfileName == L"U2723QE.icm");
+    CHECK(display->second.sdrBrightness == 30);
+    CHECK(display->second.hdrBrightness == 87);
+
+    CHECK(CountComments(path) == comments);
+    IniDocument saved;
+    REQUIRE(saved.ReadFile(path));
+    CHECK(saved.GetEncoding() == encoding);
+}
+
+} // namespace
+
+TEST_CASE(ConfigManager, RoundTrip)
+{
+    CheckRoundTrip(IniDocument::Encoding::Utf8);
+}
+
+TEST_CASE(ConfigManager, RoundTripUtf16)
+{
+    CheckRoundTrip(IniDocument::Encoding::Utf16LE);
+}
+
+TEST_CASE(ConfigManager, LoadUnchanged)
+{
+    ConfigManager config(WriteSample(IniDocument::Encoding::Utf8).wstring());
+    REQUIRE(config.Load());
+    const auto snapshot = config.GetSnapshot();
+    CHECK(config.Load());
+    CHECK(config.Save());
+    CHECK(config.Load());
+    CHECK(config.GetStats().loads == 3);
+    CHECK(config.GetStats().parses == 1);
+    CHECK(config.GetSnapshot() == snapshot);
+}
+
+TEST_CASE(ConfigManager, Clamp)
+{
+    ConfigManager config(WriteSample(IniDocument::Encoding::Utf8).wstring());
+    REQUIRE(config.Load());
+    auto settings = config.GetMonitorSettings();
+    settings.sdrBrightness = 500;
+    settings.hdrColorPreset = -1;
+    config.SetMonitorSettings(settings);
+    CHECK(config.GetMonitorSettings().sdrBrightness == 100);
+    CHECK(config.GetMonitorSettings().hdrColorPreset == 0);
+
+    std::wstring error;
+    CHECK(!ConfigManager::Validate(settings, error));
+    CHECK(!error.empty());
+    CHECK(ConfigManager::Validate(MonitorSettings(), error));
+}
+
+TEST_CASE(ConfigManager, NewFileDefaults)
+{
+    const auto path = test::TempDirectory() / "New.ini";
+    ConfigManager created(path.wstring());
+    created.Load();
+    REQUIRE(std::filesystem::exists(path));
+    CHECK(CountComments(path) > 0);
+
+    ConfigManager reloaded(path.wstring());
+    REQUIRE(reloaded.Load());
+    CHECK(SameSettings(reloaded.GetMonitorSettings(), MonitorSettings()));
+}
+
+TEST_CASE(ConfigManager, Watch)
+{
+    const auto path = WriteSample(IniDocument::Encoding::Utf8);
+    ConfigManager config(path.wstring());
+    REQUIRE(config.Load());
+    REQUIRE(config.StartWatching());
+
+    EditFile(path, L"SDR", L"Brightness", 40);
+    CHECK(WaitFor([&]() { return config.GetMonitorSettings().sdrBrightness == 40; }));
+
+    // An out of range value is clamped
+    const auto correctedBefore = config.GetStats().corrected;
+    EditFile(path, L"SDR", L"Brightness", 500);
+    CHECK(WaitFor([&]() { return config.GetStats().corrected > correctedBefore; }));
+    CHECK(WaitFor([&]() { return config.GetMonitorSettings().sdrBrightness == 100; }));
+    config.StopWatching();
+}
+
+TEST_CASE(ConfigManager, InvalidValue)
+{
+    // One broken value must not cost the other edits in the file
+    const auto path = WriteSample(IniDocument::Encoding::Utf8);
+    ConfigManager config(path.wstring());
+    REQUIRE(config.Load());
+    IniDocument doc;
+    REQUIRE(doc.ReadFile(path));
+    doc.Set(L"Profiles", L"SDRProfile", L"mine.icm");
+    doc.Set(L"Profiles", L"HDRCalibration", L"");
+    doc.SetInt(L"SDR", L"Brightness", 150);
+    doc.SetInt(L"HDR", L"RedGain", 40);
+    REQUIRE(doc.WriteFile(path));
+
+    for (int load = 0; load < 2; load++) {
+        CHECK(config.Load());
+        const auto settings = config.GetMonitorSettings();
+        CHECK(settings.sdrProfileName == L"mine.icm");
+        CHECK(settings.sdrBrightness == 100);
+        CHECK(settings.hdrRedGain == 40);
+        CHECK(!settings.enableHdrProfile);
+        CHECK(settings.enableSdrProfile);
+    }
+    CHECK(config.GetStats().parses == 2);
+    CHECK(config.GetStats().corrected == 1);
+    // The display section gets the corrected values as well
+    const auto displays = config.GetSnapshot()->displays;
+    REQUIRE(displays.size() == 1);
+    CHECK(displays.begin()->second.sdrBrightness == 30);
+    CHECK(displays.begin()->second.hdrRedGain == 40);
+    CHECK(!displays.begin()->second.enableHdrProfile);
+
+    // A menu toggle writes what it changed, not the whole snapshot
+    REQUIRE(config.UpdateMonitorSettings([](MonitorSettings& settings) { settings.enableColorPresetChange = true; }));
+    IniDocument saved;
+    REQUIRE(saved.ReadFile(path));
+    CHECK(saved.GetBool(L"Profiles", L"EnableColorPresetChange", false));
+    CHECK(saved.Find(L"Profiles", L"SDRProfile") == std::optional<std::wstring_view>(L"mine.icm"));
+    CHECK(saved.GetInt(L"SDR", L"Brightness", 0) == 150);
+    CHECK(saved.GetInt(L"HDR", L"RedGain", 0) == 40);
+    CHECK(saved.GetBool(L"Profiles", L"EnableHDRProfile", false));
+}
+
+TEST_CASE(ConfigManager, SaveKeepsEdits)
+{
+    // An edit the watcher didn't pass on yet survives a menu toggle, and is loaded afterwards
+    const auto path = WriteSample(IniDocument::Encoding::Utf8);
+    ConfigManager config(path.wstring());
+    REQUIRE(config.Load());
+    EditFile(path, L"SDR", L"RedGain", 20);
+    REQUIRE(config.UpdateMonitorSettings([](MonitorSettings& settings) { settings.hdrBrightness = 80; }));
+
+    IniDocument saved;
+    REQUIRE(saved.ReadFile(path));
+    CHECK(saved.GetInt(L"SDR", L"RedGain", 0) == 20);
+    CHECK(saved.GetInt(L"HDR", L"Brightness", 0) == 80);
+    REQUIRE(config.Load());
+    CHECK(config.GetMonitorSettings().sdrRedGain == 20);
+    CHECK(config.GetMonitorSettings().hdrBrightness == 80);
+}
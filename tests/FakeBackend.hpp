@@ -0,0 +1,61 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FAKEBACKEND_HPP_
+#define FAKEBACKEND_HPP_
+
+#include "DisplayConfigBackend.hpp"
+#include "FakeDisplayConfig.hpp"
+#include "HDR.h"
+
+#include <cstdint>
+#include <vector>
+
+/// Fake display configuration with 2 adapters of 4 displays each, used by hdr:: while it exists
+struct FakeBackend
+{
+    hdr::FakeDisplayConfig fake;
+    std::vector<hdr::DisplayId> ids;
+
+    explicit FakeBackend(bool legacy = false) : fake(MakeOptions(legacy))
+    {
+        fake.AddSyntheticTopology(2, 4);
+        hdr::SetDisplayConfigBackend(&fake);
+        hdr::InvalidateDisplayCache();
+        for (const auto& display : hdr::GetDisplays())
+            ids.push_back(display.id);
+    }
+    ~FakeBackend() { hdr::SetDisplayConfigBackend(nullptr); }
+
+    /// Display configuration calls made so far
+    uint64_t Calls() const
+    {
+        const auto stats = fake.GetStats();
+        return stats.topologyQueries + stats.deviceInfoGets + stats.deviceInfoSets;
+    }
+
+private:
+    static hdr::FakeDisplayConfig::Options MakeOptions(bool legacy)
+    {
+        hdr::FakeDisplayConfig::Options options;
+        options.hdrStateFunctions = !legacy;
+        return options;
+    }
+};
+
+#endif // FAKEBACKEND_HPP_
@@ -0,0 +1,132 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FAKEDDC_HPP_
+#define FAKEDDC_HPP_
+
+#include "ColorBackends.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * DDC/CI backend of monitors with a register map each, on a bus that only takes one transaction at a time.
+ * Each transaction takes a fixed time, like a monitor does (40 ms per read, 50 ms per write per the DDC/CI
+ * spec). Counts transactions that started while another one was running on the same monitor.
+ */
+class FakeDdc : public backend::Ddc
+{
+public:
+    FakeDdc(int monitors, std::chrono::microseconds getLatency, std::chrono::microseconds setLatency)
+        : m_getLatency(getLatency), m_setLatency(setLatency)
+    {
+        for (int i = 0; i < monitors; i++)
+            m_monitors.push_back(std::make_unique<Monitor>());
+    }
+
+    bool IsAvailable() const override { return true; }
+
+    bool SetVcp(int display, int vcpCode, int value) override
+    {
+        auto* monitor = GetMonitor(display);
+        if (!monitor)
+            return false;
+        Transaction transaction(*this, *monitor, m_setLatency);
+        std::lock_guard lock(monitor->mutex);
+        monitor->values[vcpCode] = value;
+        return true;
+    }
+
+    bool GetVcp(int display, int vcpCode, int& currentValue) override
+    {
+        auto* monitor = GetMonitor(display);
+        if (!monitor)
+            return false;
+        Transaction transaction(*this, *monitor, m_getLatency);
+        std::lock_guard lock(monitor->mutex);
+        auto it = monitor->values.find(vcpCode);
+        currentValue = it != monitor->values.end() ? it->second : DefaultValue(display, vcpCode);
+        return true;
+    }
+
+    /// Value of a register that wasn't written yet
+    static int DefaultValue(int display, int vcpCode) { return (display * 31 + vcpCode * 7) % 101; }
+
+    /// Transactions that started while another one was running on the same monitor
+    uint64_t GetCollisions() const { return m_collisions; }
+    /// Largest number of monitors busy at the same time
+    int GetMaxBusyMonitors() const { return m_maxBusy; }
+    void ResetStats()
+    {
+        m_collisions = 0;
+        m_maxBusy = 0;
+    }
+
+private:
+    struct Monitor
+    {
+        std::atomic<bool> busy { false };
+        std::mutex mutex;
+        std::map<int, int> values;
+    };
+    std::vector<std::unique_ptr<Monitor>> m_monitors;
+    std::chrono::microseconds m_getLatency;
+    std::chrono::microseconds m_setLatency;
+    std::atomic<int> m_busy { 0 };
+    std::atomic<int> m_maxBusy { 0 };
+    std::atomic<uint64_t> m_collisions { 0 };
+
+    Monitor* GetMonitor(int display)
+    {
+        if (display < 1 || display > static_cast<int>(m_monitors.size()))
+            return nullptr;
+        return m_monitors[display - 1].get();
+    }
+
+    /// Occupies the monitor's bus for the duration of a transaction
+    class Transaction
+    {
+    public:
+        Transaction(FakeDdc& ddc, Monitor& monitor, std::chrono::microseconds latency) : m_ddc(ddc), m_monitor(monitor)
+        {
+            if (m_monitor.busy.exchange(true))
+                m_ddc.m_collisions++;
+            const int busy = ++m_ddc.m_busy;
+            int max = m_ddc.m_maxBusy.load();
+            while (busy > max && !m_ddc.m_maxBusy.compare_exchange_weak(max, busy)) { }
+            std::this_thread::sleep_for(latency);
+        }
+        ~Transaction()
+        {
+            m_ddc.m_busy--;
+            m_monitor.busy = false;
+        }
+
+    private:
+        FakeDdc& m_ddc;
+        Monitor& m_monitor;
+    };
+};
+
+#endif // FAKEDDC_HPP_
@@ -0,0 +1,219 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Test.hpp"
+
+#include "FakeBackend.hpp"
+#include "StatusWatcher.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace {
+
+/**
+ * Whether all HDR capable targets are in the given mode (WCG instead of SDR with ACM).
+ * Before 24H2, WCG can't be told apart from HDR, so displays with ACM may stay in WCG
+ * when HDR is turned on.
+ */
+bool AllInMode(const hdr::FakeDisplayConfig& fake, bool hdr, bool legacy)
+{
+    for (const auto& target : fake.GetTargets()) {
+        if (!target.hdrSupported)
+            continue;
+        const auto sdrMode = target.acm ? hdr::ColorMode::Wcg : hdr::ColorMode::Sdr;
+        if (hdr && legacy && target.acm && target.mode == sdrMode)
+            continue;
+        if (target.mode != (hdr ? hdr::ColorMode::Hdr : sdrMode))
+            return false;
+    }
+    return true;
+}
+
+void CheckOnOff(bool legacy)
+{
+    FakeBackend backend(legacy);
+    CHECK(hdr::SetWindowsHDRStatus(true) == hdr::Status::On);
+    CHECK(AllInMode(backend.fake, true, legacy));
+
+    // Displays that are already in the mode are left alone
+    const auto setsBefore = backend.fake.GetStats().deviceInfoSets;
+    hdr::SetWindowsHDRStatus(true);
+    CHECK(backend.fake.GetStats().deviceInfoSets == setsBefore);
+
+    // Before 24H2, displays with ACM still report advanced color after HDR is turned off
+    hdr::SetWindowsHDRStatus(false);
+    hdr::InvalidateDisplayCache();
+    const auto status = hdr::GetWindowsHDRStatus();
+    CHECK(AllInMode(backend.fake, false, legacy));
+    CHECK(legacy || status == hdr::Status::Off);
+}
+
+/**
+ * Simulate a WM_DISPLAYCHANGE at time 0 after which the OS reports HDR on for the first
+ * display only after lagMs (never, if nothing), handled by a StatusWatcher.
+ * @return Time the change was seen, if it was
+ */
+std::optional<uint64_t> WatchDisplayChange(FakeBackend& backend, std::optional<uint64_t> lagMs,
+                                           uint64_t& topologyQueries)
+{
+    hdr::SetWindowsHDRStatus(false);
+    hdr::InvalidateDisplayCache();
+    hdr::StatusWatcher watcher;
+    watcher.Start(0);
+    const auto queriesBefore = hdr::GetQueryStats().topologyQueries;
+
+    std::optional<uint64_t> detectedMs;
+    bool applied = false;
+    uint64_t now = 0;
+    while (true) {
+        if (!applied && lagMs && now >= *lagMs) {
+            backend.fake.Modify(backend.ids.front(),
+                                [](hdr::FakeDisplayConfig::Target& target) { target.mode = hdr::ColorMode::Hdr; });
+            applied = true;
+        }
+        const bool changed = now == 0 ? !watcher.Notify(hdr::StatusWatcher::Event::DisplayChange, now).empty()
+                                      : !watcher.Poll(now).empty();
+        if (changed && !detectedMs)
+            detectedMs = now;
+        if (!watcher.IsPending())
+            break;
+        now += watcher.MsUntilDue(now);
+    }
+    topologyQueries = hdr::GetQueryStats().topologyQueries - queriesBefore;
+    return detectedMs;
+}
+
+} // namespace
+
+TEST_CASE(HDR, OnOff)
+{
+    CheckOnOff(false);
+}
+
+TEST_CASE(HDR, OnOffLegacy)
+{
+    CheckOnOff(true);
+}
+
+TEST_CASE(HDR, Toggle)
+{
+    FakeBackend backend;
+    hdr::SetWindowsHDRStatus(false);
+    CHECK(hdr::ToggleHDRStatus() == hdr::Status::On);
+    CHECK(AllInMode(backend.fake, true, false));
+    CHECK(hdr::ToggleHDRStatus() == hdr::Status::Off);
+    CHECK(AllInMode(backend.fake, false, false));
+}
+
+TEST_CASE(HDR, ToggleExternalChange)
+{
+    // HDR turned on behind the cache's back, eg in the Windows settings: toggling turns it off
+    FakeBackend backend;
+    hdr::SetWindowsHDRStatus(false);
+    for (const auto& id : backend.ids)
+        backend.fake.Modify(id, [](hdr::FakeDisplayConfig::Target& target) { target.mode = hdr::ColorMode::Hdr; });
+    CHECK(hdr::ToggleHDRStatus() == hdr::Status::Off);
+    CHECK(AllInMode(backend.fake, false, false));
+}
+
+TEST_CASE(HDR, SetOne)
+{
+    FakeBackend backend;
+    hdr::SetWindowsHDRStatus(false);
+    const hdr::DisplayId id = backend.ids.front();
+    hdr::SetDisplaysHDRStatus(std::span(&id, 1), true);
+    const auto targets = backend.fake.GetTargets();
+    REQUIRE(targets.size() == 8);
+    CHECK(targets[0].mode == hdr::ColorMode::Hdr);
+    CHECK(targets[1].mode != hdr::ColorMode::Hdr);
+}
+
+TEST_CASE(HDR, Cache)
+{
+    FakeBackend backend;
+    hdr::GetWindowsHDRStatus();
+    const auto callsBefore = backend.Calls();
+    hdr::GetWindowsHDRStatus();
+    CHECK(backend.Calls() == callsBefore);
+
+    // External change: only visible after invalidation
+    backend.fake.Modify(backend.ids.front(), [](hdr::FakeDisplayConfig::Target& target) { target.active = false; });
+    CHECK(hdr::GetDisplays().size() == backend.ids.size());
+    hdr::InvalidateDisplayCache();
+    CHECK(hdr::GetDisplays().size() == backend.ids.size() - 1);
+}
+
+TEST_CASE(HDR, Retry)
+{
+    // A failed topology query is retried on the next call
+    FakeBackend backend;
+    hdr::InvalidateDisplayCache();
+    backend.fake.FailNextCalls(1);
+    CHECK(hdr::GetWindowsHDRStatus() == hdr::Status::Unsupported);
+    CHECK(hdr::GetWindowsHDRStatus() != hdr::Status::Unsupported);
+}
+
+TEST_CASE(HDR, Details)
+{
+    FakeBackend backend;
+    const auto displays = hdr::GetDisplays();
+    REQUIRE(displays.size() == 8);
+    CHECK(displays.front().name == L"Internal Display");
+
+    // Display 1 is the second synthetic display
+    hdr::InvalidateDisplayCache();
+    hdr::StartCallRecording();
+    const auto details = hdr::GetDisplayDetails();
+    const auto calls = hdr::StopCallRecording();
+    REQUIRE(details.size() == displays.size());
+    CHECK(details[0].internal);
+    CHECK(details[1].HardwareId() == L"FAK1001");
+    CHECK(details[1].sdrWhiteLevelNits == 160.0);
+    CHECK(details[1].bitsPerColorChannel == 10u);
+    CHECK(details[1].colorMode.has_value());
+
+    REQUIRE(!calls.empty());
+    CHECK(calls.front().function == hdr::ApiFunction::QueryDisplayConfig);
+    for (const auto& display : details) {
+        CHECK(std::any_of(calls.begin(), calls.end(), [&](const hdr::ApiCall& call) {
+            return call.display == display.id && call.function == hdr::ApiFunction::GetSdrWhiteLevel
+                   && call.succeeded;
+        }));
+    }
+}
+
+TEST_CASE(HDR, Watcher)
+{
+    // HDR reported on after a lag is seen, but not before the lag
+    FakeBackend backend;
+    for (const uint64_t lag : { 0, 250, 1000, 3000 }) {
+        uint64_t queries = 0;
+        const auto detected = WatchDisplayChange(backend, lag, queries);
+        REQUIRE(detected.has_value());
+        CHECK(*detected >= lag);
+    }
+
+    // Without a change, the watcher gives up with fewer queries than the 11 of polling every 500 ms
+    uint64_t queries = 0;
+    CHECK(!WatchDisplayChange(backend, std::nullopt, queries));
+    CHECK(queries > 1 && queries < 11);
+}
@@ -0,0 +1,105 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Test.hpp"
+
+#include "IniDocument.hpp"
+#include "Samples.hpp"
+#include "Unicode.hpp"
+
+#include <string>
+
+TEST_CASE(IniDocument, RoundTrip)
+{
+    const auto text = samples::MakeIni(8);
+    IniDocument doc;
+    doc.Parse(text);
+    CHECK(doc.GetEncoding() == IniDocument::Encoding::Utf8);
+    CHECK(doc.Serialize() == text);
+    CHECK(doc.GetSectionNames().size() == 13);
+    CHECK(doc.GetInt(L"display.dela007-00001007", L"hdrbrightness", 0) == 97);
+}
+
+TEST_CASE(IniDocument, RoundTripUtf16)
+{
+    std::wstring wide;
+    REQUIRE(unicode::DecodeUtf8(samples::MakeIni(8), wide));
+    std::string text = "\xFF\xFE";
+    unicode::EncodeUtf16LE(wide, text);
+
+    IniDocument doc;
+    doc.Parse(text);
+    CHECK(doc.GetEncoding() == IniDocument::Encoding::Utf16LE);
+    CHECK(doc.Serialize() == text);
+    CHECK(doc.GetInt(L"Display.DELA007-00001007", L"HDRBrightness", 0) == 97);
+    CHECK(doc.GetString(L"Display.DELA000-00001000", L"SDRProfile", L"") == L"Monitor 1 SDR.icm");
+}
+
+TEST_CASE(IniDocument, Lookup)
+{
+    IniDocument doc;
+    doc.Parse("[SDR]\r\n Brightness = 35 \r\nBrightness=40\r\nName=\"Quoted \"\r\n[sdr]\r\nContrast=1\r\n");
+    CHECK(doc.GetInt(L"sdr", L"BRIGHTNESS", 0) == 35);
+    CHECK(doc.GetString(L"SDR", L"Name", L"") == L"Quoted ");
+    CHECK(!doc.Find(L"SDR", L"Contrast"));
+    CHECK(doc.GetInt(L"SDR", L"Missing", -1) == -1);
+    CHECK(doc.GetBool(L"Missing", L"Brightness", true));
+}
+
+TEST_CASE(IniDocument, Set)
+{
+    const std::string text = "; Settings\r\n[SDR]\r\nBrightness=35\r\n\r\n[HDR]\r\nBrightness=100\r\n";
+    IniDocument doc;
+    doc.Parse(text);
+    doc.SetInt(L"sdr", L"brightness", 35);
+    CHECK(doc.Serialize() == text);
+
+    doc.SetInt(L"HDR", L"Brightness", 80);
+    doc.SetBool(L"Features", L"EnableHDRProfile", true);
+    CHECK(doc.GetInt(L"HDR", L"Brightness", 0) == 80);
+    CHECK(doc.GetBool(L"Features", L"EnableHDRProfile", false));
+    const auto serialized = doc.Serialize();
+    CHECK(serialized.starts_with("; Settings\r\n[SDR]\r\nBrightness=35\r\n"));
+    CHECK(serialized.find("Brightness=80\r\n") != std::string::npos);
+
+    const IniDocument::Assignment values[] = { { L"SDR", L"Brightness", L"35" },
+                                               { L"SDR", L"RedGain", L"49" },
+                                               { L"Monitor", L"DisplayId", L"2" } };
+    doc.Set(values);
+    CHECK(doc.GetInt(L"SDR", L"RedGain", 0) == 49);
+    CHECK(doc.GetInt(L"Monitor", L"DisplayId", 0) == 2);
+    CHECK(doc.GetInt(L"SDR", L"Brightness", 0) == 35);
+}
+
+TEST_CASE(IniDocument, Files)
+{
+    const auto path = test::TempDirectory() / "HDRTray.ini";
+    IniDocument missing;
+    CHECK(!missing.ReadFile(path));
+
+    IniDocument doc;
+    doc.Parse(samples::MakeIni(2));
+    doc.SetInt(L"SDR", L"Brightness", 40);
+    REQUIRE(doc.WriteFile(path));
+    CHECK(IniDocument::ReadBytes(path) == doc.Serialize());
+
+    IniDocument read;
+    REQUIRE(read.ReadFile(path));
+    CHECK(read.GetInt(L"SDR", L"Brightness", 0) == 40);
+    CHECK(read.Serialize() == doc.Serialize());
+}
@@ -0,0 +1,194 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Test.hpp"
+
+#include "FakeBackend.hpp"
+#include "IpcChannel.hpp"
+#include "IpcProtocol.hpp"
+#include "Metrics.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace {
+
+constexpr std::chrono::milliseconds kTimeout { 1000 };
+
+/// Answer a request like HDRTray does, minus the color profile handling
+ipc::Response Handle(const ipc::Request& request)
+{
+    ipc::Response response;
+    switch (request.command) {
+    case ipc::Command::GetStatus:
+        break;
+    case ipc::Command::GetDisplays:
+        for (auto& display : hdr::GetDisplays())
+            response.displays.push_back({ display.id, std::move(display.name), display.status });
+        break;
+    case ipc::Command::SetStatus:
+        if (request.displays.empty()) {
+            response.changedStatus = hdr::SetWindowsHDRStatus(request.enable);
+            if (!response.changedStatus)
+                response.result = ipc::Result::Failed;
+        } else {
+            for (const auto& result : hdr::SetDisplaysHDRStatus(request.displays, request.enable))
+                response.displays.push_back({ result.id, {}, result.status, result.unchanged });
+        }
+        break;
+    case ipc::Command::SaveTrace:
+        response.result = ipc::Result::Failed;
+        break;
+    case ipc::Command::GetMetrics:
+        response.metrics = metrics::Format(metrics::Collect());
+        break;
+    }
+    response.status = hdr::GetWindowsHDRStatus();
+    return response;
+}
+
+/// Decode a frame produced by EncodeFrame()
+template<typename Decoded>
+std::optional<Decoded> DecodeFrame(const std::vector<uint8_t>& frame,
+                                   std::optional<Decoded> (*decode)(std::span<const uint8_t>))
+{
+    if (frame.size() < ipc::kFrameHeaderSize)
+        return std::nullopt;
+    auto size = ipc::PayloadSize(std::span<const uint8_t, ipc::kFrameHeaderSize>(frame.data(), ipc::kFrameHeaderSize));
+    if (!size || *size != frame.size() - ipc::kFrameHeaderSize)
+        return std::nullopt;
+    return decode(std::span(frame).subspan(ipc::kFrameHeaderSize));
+}
+
+bool SameDisplays(const std::vector<ipc::DisplayEntry>& entries, const std::vector<hdr::Display>& displays)
+{
+    if (entries.size() != displays.size())
+        return false;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (entries[i].id != displays[i].id || entries[i].name != displays[i].name
+            || entries[i].status != displays[i].status)
+            return false;
+    }
+    return true;
+}
+
+/// Endpoint next to the one of HDRTray, so it works with named pipes as well as sockets
+std::filesystem::path TestEndpoint(const char* suffix)
+{
+    auto endpoint = ipc::DefaultEndpoint();
+    endpoint += suffix;
+    return endpoint;
+}
+
+/// Call, requiring a successful response
+ipc::Response Call(const std::filesystem::path& endpoint, const ipc::Request& request)
+{
+    auto response = ipc::Call(endpoint, request, kTimeout);
+    if (!response || response->result != ipc::Result::Ok) {
+        test::Fail(__FILE__, __LINE__, "call succeeds");
+        return {};
+    }
+    return *response;
+}
+
+} // namespace
+
+TEST_CASE(Ipc, Codec)
+{
+    FakeBackend backend;
+    const ipc::Request request { ipc::Command::SetStatus, true, backend.ids };
+    const auto requestFrame = ipc::EncodeFrame(request);
+    const auto decodedRequest = DecodeFrame<ipc::Request>(requestFrame, &ipc::DecodeRequest);
+    REQUIRE(decodedRequest);
+    CHECK(decodedRequest->command == request.command);
+    CHECK(decodedRequest->enable);
+    CHECK(decodedRequest->displays == backend.ids);
+
+    ipc::Response response;
+    const auto displays = hdr::GetDisplays();
+    for (const auto& display : displays)
+        response.displays.push_back({ display.id, display.name, display.status });
+    const auto responseFrame = ipc::EncodeFrame(response);
+    const auto decodedResponse = DecodeFrame<ipc::Response>(responseFrame, &ipc::DecodeResponse);
+    REQUIRE(decodedResponse);
+    CHECK(SameDisplays(decodedResponse->displays, displays));
+
+    // Malformed payloads
+    auto truncated = responseFrame;
+    truncated.pop_back();
+    CHECK(!ipc::DecodeResponse(std::span(truncated).subspan(ipc::kFrameHeaderSize)));
+    auto otherVersion = requestFrame;
+    otherVersion[ipc::kFrameHeaderSize] = ipc::kVersion + 1;
+    CHECK(!ipc::DecodeRequest(std::span(otherVersion).subspan(ipc::kFrameHeaderSize)));
+    const uint8_t hugeHeader[ipc::kFrameHeaderSize] = { 0xFF, 0xFF, 0xFF, 0x7F };
+    CHECK(!ipc::PayloadSize(hugeHeader));
+}
+
+TEST_CASE(Ipc, Server)
+{
+    FakeBackend backend;
+    const auto endpoint = TestEndpoint("-test");
+    ipc::Server server;
+    REQUIRE(server.Start(endpoint, &Handle));
+    // A second server on the same endpoint must be refused
+    ipc::Server second;
+    CHECK(!second.Start(endpoint, &Handle));
+
+    hdr::InvalidateDisplayCache();
+    CHECK(Call(endpoint, { ipc::Command::GetStatus }).status == hdr::GetWindowsHDRStatus());
+    CHECK(SameDisplays(Call(endpoint, { ipc::Command::GetDisplays }).displays, hdr::GetDisplays()));
+
+    const auto on = Call(endpoint, { ipc::Command::SetStatus, true });
+    CHECK(on.changedStatus == hdr::Status::On);
+    CHECK(on.status == hdr::Status::On);
+    const auto offOne = Call(endpoint, { ipc::Command::SetStatus, false, { backend.ids.back() } });
+    REQUIRE(offOne.displays.size() == 1);
+    CHECK(offOne.displays[0].status == hdr::Status::Off);
+    CHECK(!offOne.displays[0].unchanged);
+    const auto offAgain = Call(endpoint, { ipc::Command::SetStatus, false, { backend.ids.back() } });
+    REQUIRE(offAgain.displays.size() == 1);
+    CHECK(offAgain.displays[0].unchanged);
+
+    // The display cache lookups of the requests show up in the metrics
+    const auto snapshot = metrics::Parse(Call(endpoint, { ipc::Command::GetMetrics }).metrics);
+    REQUIRE(snapshot);
+    const auto* lookups = snapshot->FindCounter("display.lookups");
+    REQUIRE(lookups);
+    CHECK(lookups->value >= 5);
+
+    // Requests are counted after the response went out, so only the errors are exact here
+    CHECK(server.GetStats().errors == 0);
+
+    server.Stop();
+#ifndef _WIN32
+    CHECK(!std::filesystem::exists(endpoint));
+#endif
+    CHECK(!ipc::Call(endpoint, { ipc::Command::GetStatus }, kTimeout));
+}
+
+TEST_CASE(Ipc, NoServer)
+{
+    // Noticed right away, not after the timeout
+    const auto start = std::chrono::steady_clock::now();
+    CHECK(!ipc::Call(TestEndpoint("-missing"), { ipc::Command::GetStatus }, kTimeout));
+    CHECK(std::chrono::steady_clock::now() - start < kTimeout / 2);
+}
@@ -0,0 +1,173 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Test.hpp"
+
+#include "Log.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using logging::Category;
+
+namespace {
+
+/// Threads and records each in Log.Threads, more than the queue holds
+constexpr unsigned kThreads = 4;
+constexpr unsigned kRecords = 20000;
+
+std::string ReadText(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+size_t CountOccurrences(const std::string& str, const char* needle)
+{
+    size_t count = 0;
+    for (size_t pos = str.find(needle); pos != std::string::npos; pos = str.find(needle, pos + 1))
+        count++;
+    return count;
+}
+
+/// Log file "test.log" in the temporary directory of the test case
+logging::FileOptions TestFile(size_t fileSize, unsigned keepFiles)
+{
+    logging::FileOptions options;
+    options.directory = test::TempDirectory();
+    options.baseName = L"test";
+    options.fileSize = fileSize;
+    options.keepFiles = keepFiles;
+    return options;
+}
+
+} // namespace
+
+TEST_CASE(Log, Disabled)
+{
+    logging::SetLevel(logging::Level::Info);
+    const auto before = logging::GetStats();
+    for (int n = 0; n < 100; n++)
+        logging::Debug(Category::Ddc, "Setting VCP {:02X} on display {} to {}", 0x14, n, 50);
+    CHECK(logging::GetStats().records == before.records);
+    logging::Info(Category::Ddc, "Setting VCP {:02X} on display {} to {}", 0x14, 1, 50);
+    CHECK(logging::GetStats().records == before.records + 1);
+}
+
+TEST_CASE(Log, Format)
+{
+    REQUIRE(logging::Start(TestFile(1024 * 1024, 1)));
+    // Every kind of argument, and a string that doesn't fit
+    logging::Info(Category::General, "args {} {:x} {:04X} {:5}|{} {} {} {} {{literal}}", -42, 255u, 0xBEEF, 7, true,
+                  2.5, "narrow", L"wide \u00E9");
+    const std::string longString(1000, 'x');
+    logging::Warning(Category::Profile, "long {} after {}", longString, 1);
+    logging::Stop();
+
+    const auto text = ReadText(test::TempDirectory() / "test.log");
+    CHECK(text.find(" info    general    [") != std::string::npos);
+    CHECK(text.find("args -42 ff BEEF     7|true 2.5 narrow wide \xC3\xA9 {literal}\n") != std::string::npos);
+    CHECK(text.find(" warning profile    [") != std::string::npos);
+    CHECK(text.find("long " + std::string(logging::detail::kMaxStringLength, 'x') + " after 1\n")
+          != std::string::npos);
+}
+
+TEST_CASE(Log, Utf8)
+{
+    REQUIRE(logging::Start(TestFile(1024 * 1024, 1)));
+    logging::Info(Category::General, "utf8 {}", "caf\xC3\xA9 \xE2\x82\xAC");
+    // Not UTF-8: taken as Latin-1
+    logging::Info(Category::General, "latin1 {}", "caf\xE9");
+    // Cut off between characters
+    std::string longString = "x";
+    for (int n = 0; n < 150; n++)
+        longString += "\xC3\xA9";
+    logging::Info(Category::General, "long {}", longString);
+    logging::Stop();
+
+    const auto text = ReadText(test::TempDirectory() / "test.log");
+    CHECK(text.find("utf8 caf\xC3\xA9 \xE2\x82\xAC\n") != std::string::npos);
+    CHECK(text.find("latin1 caf\xC3\xA9\n") != std::string::npos);
+    CHECK(text.find("long " + longString.substr(0, logging::detail::kMaxStringLength - 1) + "\n") != std::string::npos);
+}
+
+TEST_CASE(Log, Rotation)
+{
+    // Small files: each rotation keeps the configured number of older files
+    const auto options = TestFile(4096, 2);
+    REQUIRE(logging::Start(options));
+    const auto before = logging::GetStats();
+    for (unsigned n = 0; n < 500; n++)
+        logging::Info(Category::Transition, "rotation record {}", n);
+    logging::Stop();
+
+    CHECK(logging::GetStats().rotations - before.rotations > 2);
+    CHECK(!std::filesystem::exists(options.directory / "test.3.log"));
+    for (const char* name : { "test.log", "test.1.log", "test.2.log" }) {
+        REQUIRE(std::filesystem::exists(options.directory / name));
+        CHECK(std::filesystem::file_size(options.directory / name) <= options.fileSize);
+    }
+    CHECK(ReadText(options.directory / "test.log").find("rotation record 499\n") != std::string::npos);
+}
+
+TEST_CASE(Log, Threads)
+{
+    // Several threads at once: every record is written or counted as dropped
+    REQUIRE(logging::Start(TestFile(64 * 1024 * 1024, 0)));
+    const auto before = logging::GetStats();
+    std::vector<std::thread> writers;
+    for (unsigned t = 0; t < kThreads; t++) {
+        writers.emplace_back([t]() {
+            for (unsigned n = 0; n < kRecords; n++)
+                logging::Info(Category::Ipc, "thread {} record {} of {}", t, n, kRecords);
+        });
+    }
+    for (auto& writer : writers)
+        writer.join();
+    logging::Stop();
+
+    const auto after = logging::GetStats();
+    const auto text = ReadText(test::TempDirectory() / "test.log");
+    const uint64_t logged = after.records - before.records;
+    const uint64_t dropped = after.dropped - before.dropped;
+    CHECK(logged == uint64_t(kThreads) * kRecords);
+    CHECK(CountOccurrences(text, " of 20000\n") + dropped == logged);
+    CHECK(dropped == 0 || text.find("records dropped") != std::string::npos);
+}
+
+TEST_CASE(Log, Configure)
+{
+    CHECK(logging::Configure("warning, ddc=debug ,CONFIG=error"));
+    CHECK(logging::IsEnabled(logging::Level::Debug, Category::Ddc));
+    CHECK(!logging::IsEnabled(logging::Level::Info, Category::Display));
+    CHECK(logging::IsEnabled(logging::Level::Warning, Category::Display));
+    CHECK(!logging::IsEnabled(logging::Level::Warning, Category::Config));
+    CHECK(logging::Configure("off"));
+    CHECK(!logging::IsEnabled(logging::Level::Error, Category::General));
+    CHECK(!logging::Configure("loud"));
+    CHECK(!logging::Configure("ddc=loud"));
+    CHECK(!logging::Configure("monitor=info"));
+    logging::SetLevel(logging::Level::Info);
+}
@@ -0,0 +1,195 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Test.hpp"
+
+#include "Metrics.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+metrics::Counter testCounter("test.counter");
+metrics::Gauge testGauge("test.gauge");
+metrics::Histogram testLatency("test.latency_ns");
+metrics::Histogram testContended("test.contended_ns");
+
+/// Deterministic values spread over several powers of ten, like latencies
+std::vector<uint64_t> LatencyValues(size_t count)
+{
+    std::vector<uint64_t> values;
+    values.reserve(count);
+    uint64_t state = 0x2545F4914F6CDD1D;
+    for (size_t i = 0; i < count; i++) {
+        state = state * 6364136223846793005 + 1442695040888963407;
+        const unsigned magnitude = static_cast<unsigned>(state >> 61); // 0..7
+        values.push_back((state >> 20) % (uint64_t(10) << (magnitude * 3 / 2)));
+    }
+    return values;
+}
+
+/// Exact value with the same rank HistogramValue::Percentile() looks for
+uint64_t ExactPercentile(const std::vector<uint64_t>& sorted, double percent)
+{
+    const double rank = percent / 100.0 * static_cast<double>(sorted.size());
+    const size_t target = std::max<size_t>(1, static_cast<size_t>(rank + 0.5));
+    return sorted[target - 1];
+}
+
+bool SameHistogram(const metrics::HistogramValue& a, const metrics::HistogramValue& b)
+{
+    return a.name == b.name && a.count == b.count && a.sum == b.sum && a.min == b.min && a.max == b.max
+           && a.buckets == b.buckets;
+}
+
+const metrics::GaugeValue* FindGauge(const metrics::Snapshot& snapshot, std::string_view name)
+{
+    for (const auto& gauge : snapshot.gauges) {
+        if (gauge.name == name)
+            return &gauge;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+TEST_CASE(Metrics, Contended)
+{
+    // Several threads record into the same histogram; no update may get lost
+    metrics::Reset();
+    constexpr unsigned kThreads = 4;
+    constexpr uint64_t kValues = 20000;
+    std::vector<std::thread> writers;
+    for (unsigned t = 0; t < kThreads; t++) {
+        writers.emplace_back([t]() {
+            for (uint64_t n = 0; n < kValues; n++) {
+                testContended.Record(1000 + (n + t) % 5000);
+                testCounter.Add();
+            }
+        });
+    }
+    for (auto& writer : writers)
+        writer.join();
+
+    const auto snapshot = metrics::Collect();
+    const auto* contended = snapshot.FindHistogram("test.contended_ns");
+    REQUIRE(contended);
+    CHECK(contended->count == kThreads * kValues);
+    CHECK(contended->min == 1000);
+    CHECK(contended->max == 5999);
+    const auto* counter = snapshot.FindCounter("test.counter");
+    REQUIRE(counter);
+    CHECK(counter->value == kThreads * kValues);
+}
+
+TEST_CASE(Metrics, Percentiles)
+{
+    // Percentiles against the exact ones, from a fresh histogram
+    metrics::Reset();
+    auto values = LatencyValues(200000);
+    for (uint64_t value : values)
+        testLatency.Record(value);
+    std::sort(values.begin(), values.end());
+
+    const auto snapshot = metrics::Collect();
+    const auto* latency = snapshot.FindHistogram("test.latency_ns");
+    REQUIRE(latency);
+    CHECK(latency->count == values.size());
+    CHECK(latency->min == values.front());
+    CHECK(latency->max == values.back());
+    for (double percent : { 1.0, 10.0, 50.0, 90.0, 95.0, 99.0, 99.9, 100.0 }) {
+        const uint64_t exact = ExactPercentile(values, percent);
+        const uint64_t estimate = latency->Percentile(percent);
+        // Reported as the highest value of the bucket, at most 1/32 above the lowest
+        CHECK(estimate >= exact);
+        CHECK(estimate <= exact + exact / metrics::kSubBuckets);
+    }
+}
+
+TEST_CASE(Metrics, RoundTrip)
+{
+    metrics::Reset();
+    testCounter.Add(42);
+    testGauge.Set(-7);
+    for (uint64_t value : LatencyValues(1000))
+        testLatency.Record(value);
+
+    const auto before = metrics::Collect();
+    const auto parsed = metrics::Parse(metrics::Format(before));
+    REQUIRE(parsed);
+    CHECK(parsed->takenUnixMs == before.takenUnixMs);
+    REQUIRE(parsed->counters.size() == before.counters.size());
+    REQUIRE(parsed->gauges.size() == before.gauges.size());
+    REQUIRE(parsed->histograms.size() == before.histograms.size());
+    for (size_t i = 0; i < before.counters.size(); i++) {
+        CHECK(parsed->counters[i].name == before.counters[i].name);
+        CHECK(parsed->counters[i].value == before.counters[i].value);
+    }
+    for (size_t i = 0; i < before.gauges.size(); i++) {
+        CHECK(parsed->gauges[i].name == before.gauges[i].name);
+        CHECK(parsed->gauges[i].value == before.gauges[i].value);
+    }
+    for (size_t i = 0; i < before.histograms.size(); i++)
+        CHECK(SameHistogram(parsed->histograms[i], before.histograms[i]));
+}
+
+TEST_CASE(Metrics, Reject)
+{
+    CHECK(!metrics::Parse(""));
+    CHECK(!metrics::Parse("hdrtray-metrics 2\n"));
+    CHECK(!metrics::Parse("hdrtray-metrics 1\ncounter test.counter\n"));
+    CHECK(!metrics::Parse("hdrtray-metrics 1\ncounter bad-name 1\n"));
+    CHECK(!metrics::Parse("hdrtray-metrics 1\nhistogram h 2 3 1 2 1:1\n"));
+    CHECK(!metrics::Parse("hdrtray-metrics 1\nhistogram h 2 3 1 2 2:1 1:1\n"));
+}
+
+TEST_CASE(Metrics, Restore)
+{
+    metrics::Reset();
+    testCounter.Add(42);
+    testGauge.Set(-7);
+    testLatency.Record(100);
+    testLatency.Record(200);
+    const auto saved = metrics::Collect();
+
+    // A restart: values start at zero, then the saved ones are added back
+    metrics::Reset();
+    testCounter.Add(8);
+    testLatency.Record(300);
+    metrics::Restore(saved);
+
+    const auto restored = metrics::Collect();
+    const auto* counter = restored.FindCounter("test.counter");
+    REQUIRE(counter);
+    CHECK(counter->value == 50);
+    const auto* latency = restored.FindHistogram("test.latency_ns");
+    REQUIRE(latency);
+    CHECK(latency->count == 3);
+    CHECK(latency->min == 100);
+    CHECK(latency->max == 300);
+    const auto* gauge = FindGauge(restored, "test.gauge");
+    REQUIRE(gauge);
+    CHECK(gauge->value == -7);
+    metrics::Reset();
+}
@@ -0,0 +1,155 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Test.hpp"
+
+#include "ProfileInfo.hpp"
+#include "Samples.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool IsMonotonic(const std::vector<float>& curve)
+{
+    return std::is_sorted(curve.begin(), curve.end());
+}
+
+void WriteFile(const std::filesystem::path& path, const std::string& contents)
+{
+    std::ofstream out(path, std::ios::binary);
+    out << contents;
+}
+
+} // namespace
+
+TEST_CASE(ProfileInfo, Calibration)
+{
+    const auto info = ParseCalibration(samples::MakeCalibration(256));
+    REQUIRE(info.valid);
+    CHECK(info.type == ProfileInfo::Type::Calibration);
+    REQUIRE(info.red.size() == 256);
+    CHECK(info.green.size() == 256);
+    CHECK(info.blue.size() == 256);
+    CHECK(info.red.front() == 0.0f);
+    CHECK(info.red.back() == 1.0f);
+    CHECK(std::abs(info.green.back() - 0.97f) < 1e-6f);
+    CHECK(IsMonotonic(info.red) && IsMonotonic(info.green) && IsMonotonic(info.blue));
+
+    CHECK(ParseCalibration(samples::MakeCalibration(1024)).red.size() == 1024);
+}
+
+TEST_CASE(ProfileInfo, CalibrationInvalid)
+{
+    const auto calibration = samples::MakeCalibration(16);
+    const auto truncated = ParseCalibration(calibration.substr(0, calibration.size() / 2));
+    CHECK(!truncated.valid);
+    CHECK(!truncated.error.empty());
+
+    auto outOfRange = calibration;
+    outOfRange.replace(outOfRange.rfind("0.97000"), 7, "1.97000");
+    CHECK(ParseCalibration(outOfRange).error == "Value out of range");
+
+    CHECK(ParseCalibration("ICC profile, really").error == "Not an Argyll calibration file");
+    CHECK(!ParseCalibration("").valid);
+}
+
+TEST_CASE(ProfileInfo, IccProfile)
+{
+    const auto profile = samples::MakeIccProfile();
+    const auto info = ParseIccProfile(profile.data(), profile.size());
+    REQUIRE(info.valid);
+    CHECK(info.type == ProfileInfo::Type::IccProfile);
+    CHECK(info.iccVersion == 0x02200000);
+    CHECK(info.iccDeviceClass == "mntr");
+    CHECK(info.iccHasVcgt);
+}
+
+TEST_CASE(ProfileInfo, IccProfileInvalid)
+{
+    auto profile = samples::MakeIccProfile();
+    CHECK(ParseIccProfile(profile.data(), profile.size() - 4).error
+          == "Declared profile size doesn't match file size");
+    CHECK(!ParseIccProfile(profile.data(), 64).valid);
+
+    profile[36] = 'x';
+    CHECK(ParseIccProfile(profile.data(), profile.size()).error == "Missing 'acsp' signature");
+}
+
+TEST_CASE(ProfileInfo, ParseProfileByExtension)
+{
+    const auto calibration = samples::MakeCalibration(16);
+    const std::vector<uint8_t> calibrationData(calibration.begin(), calibration.end());
+    CHECK(ParseProfile("HDR.CAL", calibrationData).type == ProfileInfo::Type::Calibration);
+    CHECK(ParseProfile("SDR.icm", samples::MakeIccProfile()).type == ProfileInfo::Type::IccProfile);
+    CHECK(ParseProfile("SDR.icc", samples::MakeIccProfile()).valid);
+    CHECK(ParseProfile("HDR.txt", calibrationData).error == "Unknown file extension");
+}
+
+TEST_CASE(ProfileInfo, Resample)
+{
+    const auto small = ParseCalibration(samples::MakeCalibration(256));
+    const auto large = ParseCalibration(samples::MakeCalibration(1024));
+
+    const auto downsampled = ResampleCurve(large.red, 256);
+    REQUIRE(downsampled.size() == 256);
+    CHECK(IsMonotonic(downsampled));
+    CHECK(downsampled.front() == large.red.front());
+    CHECK(downsampled.back() == large.red.back());
+
+    const auto upsampled = ResampleCurve(small.red, 4096);
+    REQUIRE(upsampled.size() == 4096);
+    CHECK(IsMonotonic(upsampled));
+    CHECK(upsampled[4095] == small.red[255]);
+    CHECK(std::abs(upsampled[4095 / 3] - small.red[85]) < 1e-6f);
+
+    const std::vector<float> identity = { 0.0f, 1.0f };
+    const auto linear = ResampleCurve(identity, 256);
+    REQUIRE(linear.size() == 256);
+    for (size_t i = 0; i < linear.size(); i++)
+        CHECK(std::abs(linear[i] - static_cast<float>(i) / 255) < 1e-6f);
+
+    CHECK(ResampleCurve({}, 256).empty());
+    CHECK(ResampleCurve(identity, 0).empty());
+    CHECK(ResampleCurve(std::vector<float> { 0.5f }, 4) == std::vector<float>(4, 0.5f));
+}
+
+TEST_CASE(ProfileInfo, Cache)
+{
+    const auto path = test::TempDirectory() / "HDR.cal";
+    ProfileCache cache;
+    CHECK(cache.Get(path) == nullptr);
+
+    WriteFile(path, samples::MakeCalibration(16));
+    const auto first = cache.Get(path);
+    REQUIRE(first != nullptr);
+    CHECK(first->valid);
+    CHECK(cache.Get(path) == first);
+    CHECK(cache.GetStats().parses == 1);
+
+    WriteFile(path, samples::MakeCalibration(32));
+    const auto changed = cache.Get(path);
+    REQUIRE(changed != nullptr);
+    CHECK(changed->red.size() == 32);
+    CHECK(cache.GetStats().parses == 2);
+    CHECK(cache.GetStats().lookups == 3);
+}
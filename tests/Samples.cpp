@@ -0,0 +1,153 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Samples.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+
+namespace samples {
+
+std::string MakeCalibration(int sets)
+{
+    std::string text = "CAL    \n\nDESCRIPTOR \"Argyll Device Calibration State\"\nORIGINATOR \"Argyll dispcal\"\n"
+                       "CREATED \"Sat Oct 18 12:00:00 2025\"\nKEYWORD \"DEVICE_CLASS\"\nDEVICE_CLASS \"DISPLAY\"\n"
+                       "KEYWORD \"COLOR_REP\"\nCOLOR_REP \"RGB\"\n\nKEYWORD \"RGB_I\"\nNUMBER_OF_FIELDS 4\n"
+                       "BEGIN_DATA_FORMAT\nRGB_I RGB_R RGB_G RGB_B \nEND_DATA_FORMAT\n\n";
+    text += "NUMBER_OF_SETS " + std::to_string(sets) + "\nBEGIN_DATA\n";
+    for (int i = 0; i < sets; i++) {
+        const double input = static_cast<double>(i) / (sets - 1);
+        char line[128];
+        std::snprintf(line, sizeof(line), "%.5f %.5f %.5f %.5f \n", input, std::pow(input, 1.04),
+                      std::pow(input, 0.98) * 0.97, std::pow(input, 1.02) * 0.99);
+        text += line;
+    }
+    text += "END_DATA\n";
+    return text;
+}
+
+namespace {
+
+void PutBE32(std::vector<uint8_t>& data, size_t offset, uint32_t value)
+{
+    for (int b = 0; b < 4; b++)
+        data[offset + b] = static_cast<uint8_t>(value >> (24 - 8 * b));
+}
+
+void PutSignature(std::vector<uint8_t>& data, size_t offset, const char* sig)
+{
+    std::memcpy(&data[offset], sig, 4);
+}
+
+} // namespace
+
+std::vector<uint8_t> MakeIccProfile()
+{
+    struct Tag
+    {
+        const char* sig;
+        uint32_t size;
+    };
+    static const Tag tags[] = { { "desc", 96 }, { "cprt", 64 }, { "wtpt", 20 }, { "rXYZ", 20 },
+                                { "gXYZ", 20 }, { "bXYZ", 20 }, { "rTRC", 526 }, { "gTRC", 526 },
+                                { "bTRC", 526 }, { "vcgt", 18 + 3 * 256 * 2 } };
+    constexpr size_t kHeaderSize = 128;
+    size_t size = kHeaderSize + 4 + std::size(tags) * 12;
+    for (const auto& tag : tags)
+        size += (tag.size + 3) & ~3u;
+
+    std::vector<uint8_t> data(size);
+    PutBE32(data, 0, static_cast<uint32_t>(size));
+    PutBE32(data, 8, 0x02200000);
+    PutSignature(data, 12, "mntr");
+    PutSignature(data, 16, "RGB ");
+    PutSignature(data, 20, "XYZ ");
+    PutSignature(data, 36, "acsp");
+    PutBE32(data, kHeaderSize, static_cast<uint32_t>(std::size(tags)));
+    size_t offset = kHeaderSize + 4 + std::size(tags) * 12;
+    for (size_t t = 0; t < std::size(tags); t++) {
+        const size_t entry = kHeaderSize + 4 + t * 12;
+        PutSignature(data, entry, tags[t].sig);
+        PutBE32(data, entry + 4, static_cast<uint32_t>(offset));
+        PutBE32(data, entry + 8, tags[t].size);
+        offset += (tags[t].size + 3) & ~3u;
+    }
+    return data;
+}
+
+std::string MakeIni(int displays)
+{
+    std::string text = "; HDRTray settings\n[Monitor]\nDisplayId=1\n\n[Profiles]\nSDRProfile=SDR Calibrated.icm\n"
+                       "HDRCalibration=HDR Calibrated.cal\n\n[Features]\nEnableColorManagement=1\n"
+                       "EnableSDRProfile=1\nEnableHDRProfile=1\nEnableColorPresetChange=0\n\n"
+                       "[SDR]\nBrightness=35\nRedGain=50\nGreenGain=50\nBlueGain=50\n\n"
+                       "[HDR]\nBrightness=100\nRedGain=50\nGreenGain=50\nBlueGain=50\nColorPreset=12\n";
+    for (int d = 0; d < displays; d++) {
+        char section[512];
+        std::snprintf(section, sizeof(section),
+                      "\n; Monitor %d, \xC3\x9C" "berpr\xC3\xBC" "ft\n[Display.DEL%04X-%08X]\n"
+                      "SDRProfile=Monitor %d SDR.icm\nHDRCalibration=Monitor %d HDR.cal\n"
+                      "SDRBrightness=%d\nHDRBrightness=%d\nSDRRedGain=50\nSDRGreenGain=49\nSDRBlueGain=48\nHDRColorPreset=12\n",
+                      d + 1, 0xA000 + d, 0x1000 + d, d + 1, d + 1, 30 + d, 90 + d);
+        text += section;
+    }
+    return text;
+}
+
+std::wstring MakeText(size_t length)
+{
+    static const wchar_t* const words[] = { L"Calibrated ", L"\u00DCberpr\u00FCft ", L"\u8272\u57DF ",
+                                            L"\u30E2\u30CB\u30BF\u30FC ", L"Profile_01 ", L"\U0001F5A5 ",
+                                            L"sRGB ", L"R\u00E9glage " };
+    std::wstring text;
+    for (size_t i = 0; text.size() < length; i++)
+        text += words[(i * 7 + i / 3) % std::size(words)];
+    return text;
+}
+
+board::State MakeBoardState(const std::vector<hdr::Display>& displays, unsigned monitors, uint64_t generation)
+{
+    board::State state;
+    state.publishedUnixMs = generation;
+    state.status = generation % 2 == 0 ? hdr::Status::On : hdr::Status::Off;
+    for (const auto& disp : displays)
+        state.displays.push_back({ disp.id, disp.name, state.status });
+    for (unsigned i = 0; i < monitors; i++) {
+        board::Monitor monitor;
+        monitor.index = static_cast<int32_t>(i);
+        monitor.hdr = state.status == hdr::Status::On;
+        monitor.profileHash = generation * 1000003 + i;
+        // Brightness, RGB gains, color preset
+        for (uint8_t code : { 0x10, 0x16, 0x18, 0x1A, 0x14 }) {
+            monitor.vcp.push_back(
+                { code, static_cast<uint16_t>(generation + code), static_cast<uint32_t>(generation) });
+        }
+        state.monitors.push_back(std::move(monitor));
+    }
+    state.lastTransition.kind = board::TransitionKind::Toggle;
+    state.lastTransition.count = generation;
+    state.lastTransition.succeeded = true;
+    state.lastTransition.status = state.status;
+    state.lastTransition.durationMs = static_cast<uint32_t>(generation);
+    state.lastTransition.finishedUnixMs = generation;
+    return state;
+}
+
+} // namespace samples
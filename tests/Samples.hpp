@@ -0,0 +1,58 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SAMPLES_HPP_
+#define SAMPLES_HPP_
+
+#include "HDR.h"
+#include "StatusBoard.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Generated input files and text, as HDRTray sees them, for the unit tests and hdrtray_bench.
+ */
+namespace samples {
+
+/// Argyll calibration with the given number of entries per channel, as written by dispcal
+std::string MakeCalibration(int sets);
+
+/// Display profile with the usual matrix/TRC tags and a 'vcgt' tag of 256 entries per channel
+std::vector<uint8_t> MakeIccProfile();
+
+/**
+ * HDRTray.ini with the global sections, a number of [Display.<id>] sections and comments.
+ * Display d (counting from 0) has the ID DEL<A000+d>-<00001000+d> in hex, and an HDR brightness of 90+d.
+ */
+std::string MakeIni(int displays);
+
+/**
+ * Status board state as HDRTray publishes it, for the given displays and a number of monitors with
+ * 5 VCP values each. Every value is derived from the generation, which is also the publishing time.
+ */
+board::State MakeBoardState(const std::vector<hdr::Display>& displays, unsigned monitors, uint64_t generation);
+
+/// Text with ASCII, Latin-1, CJK and characters outside the BMP, as in profile and display names
+std::wstring MakeText(size_t length);
+
+} // namespace samples
+
+#endif // SAMPLES_HPP_
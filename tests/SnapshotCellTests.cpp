@@ -0,0 +1,120 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Test.hpp"
+
+#include "SnapshotCell.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Payload
+{
+    uint64_t generation = 0;
+    std::array<uint64_t, 15> values {};
+};
+
+std::shared_ptr<const Payload> MakePayload(uint64_t generation)
+{
+    auto payload = std::make_shared<Payload>();
+    payload->generation = generation;
+    payload->values.fill(generation);
+    return payload;
+}
+
+} // namespace
+
+TEST_CASE(SnapshotCell, LoadStore)
+{
+    SnapshotCell<Payload> cell(MakePayload(1));
+    const auto first = cell.Load();
+    CHECK(first->generation == 1);
+
+    cell.Store(MakePayload(2));
+    CHECK(cell.Load()->generation == 2);
+    // Snapshots stay valid and unchanged while they're held
+    CHECK(first->generation == 1);
+    CHECK(first->values.back() == 1);
+
+    cell.Update([](Payload& payload) { payload.values[0] = 7; });
+    CHECK(cell.Load()->generation == 2);
+    CHECK(cell.Load()->values[0] == 7);
+}
+
+TEST_CASE(SnapshotCell, ConcurrentReaders)
+{
+    // Readers must only ever see complete snapshots that never go back in time
+    SnapshotCell<Payload> cell(MakePayload(0));
+    std::atomic<bool> stop { false };
+    std::atomic<uint64_t> reads { 0 }, inconsistent { 0 };
+    std::vector<std::thread> readers;
+    for (unsigned r = 0; r < 4; r++) {
+        readers.emplace_back([&]() {
+            uint64_t lastGeneration = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                const auto snapshot = cell.Load();
+                const uint64_t generation = snapshot->generation;
+                if (generation < lastGeneration
+                    || std::any_of(snapshot->values.begin(), snapshot->values.end(),
+                                   [&](uint64_t v) { return v != generation; }))
+                    inconsistent++;
+                lastGeneration = generation;
+                reads++;
+            }
+        });
+    }
+
+    const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    uint64_t generation = 0;
+    while (std::chrono::steady_clock::now() < end) {
+        cell.Store(MakePayload(++generation));
+        std::this_thread::yield();
+    }
+    stop = true;
+    for (auto& reader : readers)
+        reader.join();
+
+    CHECK(inconsistent == 0);
+    CHECK(reads > 0);
+    CHECK(cell.Load()->generation == generation);
+}
+
+TEST_CASE(SnapshotCell, ConcurrentUpdates)
+{
+    // Writers are serialized, so no update gets lost
+    SnapshotCell<Payload> cell(MakePayload(0));
+    constexpr unsigned kUpdates = 2000;
+    std::vector<std::thread> writers;
+    for (unsigned w = 0; w < 4; w++) {
+        writers.emplace_back([&]() {
+            for (unsigned i = 0; i < kUpdates; i++)
+                cell.Update([](Payload& payload) { payload.generation++; });
+        });
+    }
+    for (auto& writer : writers)
+        writer.join();
+    CHECK(cell.Load()->generation == 4 * kUpdates);
+}
@@ -0,0 +1,188 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Test.hpp"
+
+#include "FakeBackend.hpp"
+#include "Samples.hpp"
+#include "SharedMemory.hpp"
+#include "StatusBoard.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr unsigned kMonitors = 4;
+
+/// Board name of its own, so the tests can run next to a tray and each other
+std::string UniqueName()
+{
+    std::random_device random;
+    return SharedMemory::SessionName("HDRTray.Tests-" + std::to_string(random()) + std::to_string(random()));
+}
+
+/// Whether a state read back is exactly the one MakeBoardState() produces for its generation
+bool IsConsistent(const board::State& state, const std::vector<hdr::Display>& displays)
+{
+    const auto expected = samples::MakeBoardState(displays, kMonitors, state.publishedUnixMs);
+    if (state.status != expected.status || state.displays.size() != expected.displays.size()
+        || state.monitors.size() != expected.monitors.size())
+        return false;
+    for (size_t i = 0; i < state.displays.size(); i++) {
+        const auto& a = state.displays[i];
+        const auto& b = expected.displays[i];
+        if (a.id != b.id || a.name != b.name || a.status != b.status)
+            return false;
+    }
+    for (size_t i = 0; i < state.monitors.size(); i++) {
+        const auto& a = state.monitors[i];
+        const auto& b = expected.monitors[i];
+        if (a.index != b.index || a.hdr != b.hdr || a.profileHash != b.profileHash || a.vcp.size() != b.vcp.size())
+            return false;
+        for (size_t v = 0; v < a.vcp.size(); v++) {
+            if (a.vcp[v].code != b.vcp[v].code || a.vcp[v].value != b.vcp[v].value
+                || a.vcp[v].ageMs != b.vcp[v].ageMs)
+                return false;
+        }
+    }
+    const auto& ta = state.lastTransition;
+    const auto& tb = expected.lastTransition;
+    return ta.kind == tb.kind && ta.count == tb.count && ta.succeeded == tb.succeeded && ta.status == tb.status
+           && ta.durationMs == tb.durationMs && ta.finishedUnixMs == tb.finishedUnixMs;
+}
+
+} // namespace
+
+TEST_CASE(StatusBoard, PublishRead)
+{
+    FakeBackend backend;
+    const auto displays = hdr::GetDisplays();
+    const auto name = UniqueName();
+
+    board::Publisher publisher;
+    REQUIRE(publisher.Open(name));
+    board::Publisher second;
+    CHECK(!second.Open(name));
+
+    board::Reader reader;
+    REQUIRE(reader.Open(name));
+    // Nothing published yet
+    CHECK(!reader.Read());
+
+    for (uint64_t generation = 1; generation <= 3; generation++) {
+        publisher.Publish(samples::MakeBoardState(displays, kMonitors, generation));
+        const auto state = reader.Read();
+        REQUIRE(state);
+        CHECK(state->publishedUnixMs == generation);
+        CHECK(IsConsistent(*state, displays));
+    }
+    // As HDRCmd does it
+    board::Reader invocation;
+    REQUIRE(invocation.Open(name));
+    const auto state = invocation.Read();
+    CHECK(state && state->publishedUnixMs == 3);
+    CHECK(publisher.GetPublishCount() == 3);
+
+    reader.Close();
+    invocation.Close();
+    publisher.Close();
+    board::Reader afterClose;
+    CHECK(!afterClose.Open(name));
+}
+
+TEST_CASE(StatusBoard, Truncate)
+{
+    const auto name = UniqueName();
+    board::Publisher publisher;
+    REQUIRE(publisher.Open(name));
+    board::Reader reader;
+    REQUIRE(reader.Open(name));
+
+    // Lists longer than the board are cut off, names too
+    board::State big;
+    for (unsigned i = 0; i < board::kMaxDisplays + 4; i++)
+        big.displays.push_back({ { i, 0, i }, std::wstring(board::kMaxNameLength + 10, L'x'), hdr::Status::On });
+    big.publishedUnixMs = 1;
+    publisher.Publish(big);
+    const auto state = reader.Read();
+    REQUIRE(state);
+    CHECK(state->displays.size() == board::kMaxDisplays);
+    CHECK(state->displays.back().name.size() == board::kMaxNameLength);
+}
+
+TEST_CASE(StatusBoard, Refused)
+{
+    const auto name = UniqueName();
+    board::Reader missing;
+    CHECK(!missing.Open(name));
+
+    // A board of another layout version
+    SharedMemory other;
+    REQUIRE(other.Create(name, sizeof(board::layout::Segment)));
+    auto* segment = static_cast<board::layout::Segment*>(other.Data());
+    segment->header.magic = board::kMagic;
+    segment->header.version = board::kVersion + 1;
+    segment->header.headerSize = sizeof(board::layout::Header);
+    segment->header.payloadSize = sizeof(board::layout::Payload);
+    segment->header.sequence = 2;
+    board::Reader reader;
+    CHECK(!reader.Open(name));
+}
+
+TEST_CASE(StatusBoard, Contended)
+{
+    FakeBackend backend;
+    const auto displays = hdr::GetDisplays();
+    const auto name = UniqueName();
+    board::Publisher publisher;
+    REQUIRE(publisher.Open(name));
+    board::Reader reader;
+    REQUIRE(reader.Open(name));
+    publisher.Publish(samples::MakeBoardState(displays, kMonitors, 1));
+
+    // The publisher writes as fast as it can, so every read overlaps a write; none may see a mix of two states
+    std::vector<board::State> states;
+    for (uint64_t generation = 2; generation < 2 + 64; generation++)
+        states.push_back(samples::MakeBoardState(displays, kMonitors, generation));
+    std::atomic<bool> stop { false };
+    uint64_t published = 0;
+    std::thread publishThread([&]() {
+        while (!stop.load(std::memory_order_relaxed))
+            publisher.Publish(states[published++ % states.size()]);
+    });
+    unsigned reads = 0;
+    unsigned torn = 0;
+    for (int i = 0; i < 20000; i++) {
+        if (auto state = reader.Read()) {
+            reads++;
+            if (!IsConsistent(*state, displays))
+                torn++;
+        }
+    }
+    stop = true;
+    publishThread.join();
+
+    CHECK(reads > 0);
+    CHECK(torn == 0);
+    CHECK(publisher.GetPublishCount() == 1 + published);
+}
@@ -0,0 +1,67 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TEST_HPP_
+#define TEST_HPP_
+
+#include <filesystem>
+
+/**
+ * Minimal unit test framework for hdrcore_tests.
+ *
+ * A test case is a function defined with TEST_CASE(suite, name), which registers itself on
+ * startup. CHECK() records a failure and carries on; REQUIRE() records it and returns from the
+ * test case. Each suite is run as a test of its own by ctest.
+ */
+namespace test {
+
+using Function = void (*)();
+
+/// Registers a test case; used by TEST_CASE()
+struct Registration
+{
+    Registration(const char* suite, const char* name, Function function);
+};
+
+/// Record a failed check in the running test case
+void Fail(const char* file, int line, const char* expression);
+
+/**
+ * Empty directory for files of the running test case, created on first use.
+ * It's removed with its contents when the test case is done.
+ */
+std::filesystem::path TempDirectory();
+
+} // namespace test
+
+#define TEST_CASE(suite, name)                                                                                         \
+    static void suite##_##name();                                                                                      \
+    static const test::Registration suite##_##name##_registration(#suite, #name, &suite##_##name);                     \
+    static void suite##_##name()
+
+#define CHECK(expression) ((expression) ? static_cast<void>(0) : test::Fail(__FILE__, __LINE__, #expression))
+
+#define REQUIRE(expression)                                                                                            \
+    do {                                                                                                               \
+        if (!(expression)) {                                                                                           \
+            test::Fail(__FILE__, __LINE__, #expression);                                                               \
+            return;                                                                                                    \
+        }                                                                                                              \
+    } while (false)
+
+#endif // TEST_HPP_
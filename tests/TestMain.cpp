@@ -0,0 +1,154 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* Runner of the hdrcore unit tests: runs all registered test cases, or those of the given
+ * suites or cases, and prints a line per test case. The exit code is 1 if any check failed. */
+
+#include "Test.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace {
+
+struct TestCase
+{
+    const char* suite;
+    const char* name;
+    test::Function function;
+};
+
+std::vector<TestCase>& Registry()
+{
+    static std::vector<TestCase> registry;
+    return registry;
+}
+
+/// State of the running test case
+struct Current
+{
+    unsigned failures = 0;
+    std::filesystem::path tempDirectory;
+};
+Current current;
+
+/// Whether a command line argument selects a test case: "suite" or "suite.name"
+bool Selects(const std::string& arg, const TestCase& tc)
+{
+    const std::string suite = tc.suite;
+    return arg == suite || arg == suite + "." + tc.name;
+}
+
+void Usage(const char* argv0)
+{
+    std::fprintf(stderr, "Usage: %s [--list] [SUITE | SUITE.CASE]...\n", argv0);
+}
+
+} // namespace
+
+namespace test {
+
+Registration::Registration(const char* suite, const char* name, Function function)
+{
+    Registry().push_back({ suite, name, function });
+}
+
+void Fail(const char* file, int line, const char* expression)
+{
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    current.failures++;
+}
+
+std::filesystem::path TempDirectory()
+{
+    if (current.tempDirectory.empty()) {
+        std::random_device random;
+        const auto name = "hdrcore_tests-" + std::to_string(random()) + std::to_string(random());
+        current.tempDirectory = std::filesystem::temp_directory_path() / name;
+        std::filesystem::create_directories(current.tempDirectory);
+    }
+    return current.tempDirectory;
+}
+
+} // namespace test
+
+int main(int argc, char* argv[])
+{
+    bool list = false;
+    std::vector<std::string> selection;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--list") == 0)
+            list = true;
+        else if (argv[i][0] == '-') {
+            Usage(argv[0]);
+            return 2;
+        } else
+            selection.emplace_back(argv[i]);
+    }
+
+    std::vector<const TestCase*> selected;
+    for (const auto& tc : Registry()) {
+        bool match = selection.empty();
+        for (const auto& arg : selection)
+            match = match || Selects(arg, tc);
+        if (match)
+            selected.push_back(&tc);
+    }
+    // Catch typos, eg in the test list of CMakeLists.txt
+    for (const auto& arg : selection) {
+        bool used = false;
+        for (const auto& tc : Registry())
+            used = used || Selects(arg, tc);
+        if (!used) {
+            std::fprintf(stderr, "No test case matches %s\n", arg.c_str());
+            return 2;
+        }
+    }
+
+    if (list) {
+        for (const auto* tc : selected)
+            std::printf("%s.%s\n", tc->suite, tc->name);
+        return 0;
+    }
+
+    unsigned failed = 0;
+    for (const auto* tc : selected) {
+        current = {};
+        try {
+            tc->function();
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "%s.%s: exception: %s\n", tc->suite, tc->name, e.what());
+            current.failures++;
+        }
+        if (!current.tempDirectory.empty()) {
+            std::error_code ec;
+            std::filesystem::remove_all(current.tempDirectory, ec);
+        }
+        std::printf("%s.%s %s\n", tc->suite, tc->name, current.failures == 0 ? "ok" : "FAILED");
+        std::fflush(stdout);
+        if (current.failures != 0)
+            failed++;
+    }
+    std::printf("\n%zu test cases, %u failed\n", selected.size(), failed);
+    return failed == 0 ? 0 : 1;
+}
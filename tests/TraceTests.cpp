@@ -0,0 +1,147 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Test.hpp"
+
+#include "Trace.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/// Span as a writer thread records it, with every argument derived from the sequence number
+void RecordChecked(unsigned thread, uint64_t seq)
+{
+    trace::Span span("test", "Checked");
+    span.Arg("thread", static_cast<int64_t>(thread))
+        .Arg("seq", static_cast<int64_t>(seq))
+        .Arg("check", static_cast<int64_t>(seq * 1000003 + thread))
+        .Arg("text", std::to_string(seq));
+}
+
+bool IsConsistent(const trace::Event& event)
+{
+    if (std::strcmp(event.name, "Checked") != 0)
+        return true;
+    if (event.argCount != 4)
+        return false;
+    const auto thread = event.args[0].number;
+    const auto seq = event.args[1].number;
+    return event.args[2].number == seq * 1000003 + thread && std::to_string(seq) == event.args[3].text;
+}
+
+size_t CountOccurrences(const std::string& str, const char* needle)
+{
+    size_t count = 0;
+    for (size_t pos = str.find(needle); pos != std::string::npos; pos = str.find(needle, pos + 1))
+        count++;
+    return count;
+}
+
+} // namespace
+
+TEST_CASE(Trace, Disabled)
+{
+    trace::SetEnabled(false);
+    const auto before = trace::GetStats();
+    for (int n = 0; n < 100; n++) {
+        trace::Span span("test", "Disabled");
+        span.Arg("n", n);
+    }
+    const auto after = trace::GetStats();
+    trace::SetEnabled(true);
+    CHECK(after.recorded == before.recorded);
+
+    {
+        trace::Span span("test", "Enabled");
+    }
+    CHECK(trace::GetStats().recorded == before.recorded + 1);
+}
+
+TEST_CASE(Trace, Contended)
+{
+    // Writers record as fast as they can, overwriting spans while they're being collected
+    trace::Clear();
+    constexpr unsigned kWriters = 4;
+    std::atomic<bool> stop { false };
+    std::atomic<unsigned> started { 0 };
+    std::vector<std::thread> writers;
+    for (unsigned t = 0; t < kWriters; t++) {
+        writers.emplace_back([&stop, &started, t]() {
+            RecordChecked(t, 0);
+            started++;
+            for (uint64_t seq = 1; !stop.load(std::memory_order_relaxed); seq++)
+                RecordChecked(t, seq);
+        });
+    }
+    while (started < kWriters)
+        std::this_thread::yield();
+    size_t collected = 0;
+    unsigned torn = 0;
+    for (int i = 0; i < 50; i++) {
+        for (const auto& event : trace::Collect()) {
+            collected++;
+            if (!IsConsistent(event))
+                torn++;
+        }
+    }
+    stop = true;
+    for (auto& writer : writers)
+        writer.join();
+    CHECK(collected > 0);
+    CHECK(torn == 0);
+}
+
+TEST_CASE(Trace, Wraparound)
+{
+    // A buffer that wrapped around keeps the most recent spans, in order
+    trace::Clear();
+    constexpr uint64_t kSpans = trace::kBufferCapacity * 3 + 17;
+    std::thread([]() {
+        for (uint64_t seq = 0; seq < kSpans; seq++)
+            RecordChecked(0, seq);
+    }).join();
+    const auto events = trace::Collect();
+    REQUIRE(events.size() == trace::kBufferCapacity);
+    for (size_t i = 0; i < events.size(); i++) {
+        REQUIRE(IsConsistent(events[i]));
+        REQUIRE(events[i].args[1].number == static_cast<int64_t>(kSpans - trace::kBufferCapacity + i));
+    }
+}
+
+TEST_CASE(Trace, Export)
+{
+    // Every collected span ends up in the export, escaped, and thread names with it
+    trace::Clear();
+    trace::SetThreadName("Main");
+    constexpr size_t kSpans = 100;
+    for (size_t n = 0; n < kSpans; n++) {
+        trace::Span span("test", "Export \"quoted\"");
+        span.Arg("n", static_cast<int64_t>(n));
+    }
+    const auto json = trace::Export();
+    CHECK(CountOccurrences(json, "\"ph\":\"X\"") == kSpans);
+    CHECK(CountOccurrences(json, "Export \\\"quoted\\\"") == kSpans);
+    CHECK(json.find("\"name\":\"Main\"") != std::string::npos);
+    trace::Clear();
+}
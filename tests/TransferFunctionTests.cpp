@@ -0,0 +1,142 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Test.hpp"
+
+#include "TransferFunction.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <vector>
+
+namespace {
+
+/// Batch function with its reference, inputs and documented maximum errors
+struct Function
+{
+    void (*batch)(std::span<const float>, std::span<float>, transfer::Method);
+    double (*reference)(double);
+    std::vector<float> input;
+    /// Errors are relative to the larger of the result and this
+    double errorFloor;
+    double tableError;
+    double polynomialError;
+};
+
+/// Inputs evenly spread over [0, 1], with a count that's not a multiple of the vector width
+std::vector<float> Signals()
+{
+    constexpr size_t kValues = 4099;
+    std::vector<float> signals(kValues);
+    for (size_t i = 0; i < kValues; i++)
+        signals[i] = static_cast<float>(i) / (kValues - 1);
+    return signals;
+}
+
+std::vector<Function> Functions()
+{
+    const auto signals = Signals();
+    std::vector<float> nits(signals.size());
+    std::vector<float> scenes(signals.size());
+    for (size_t i = 0; i < signals.size(); i++) {
+        nits[i] = static_cast<float>(transfer::PqEotf(signals[i]));
+        scenes[i] = static_cast<float>(transfer::HlgInverseOetf(signals[i]));
+    }
+    return {
+        { transfer::PqEotf, transfer::PqEotf, signals, 0.001, 1e-3, 4e-6 },
+        { transfer::PqInverseEotf, transfer::PqInverseEotf, nits, 1, 2e-7, 3e-7 },
+        { transfer::HlgOetf, transfer::HlgOetf, scenes, 1, 2e-7, 1e-7 },
+        { transfer::HlgInverseOetf, transfer::HlgInverseOetf, signals, 1, 3e-7, 3e-7 },
+    };
+}
+
+/// Largest error of a batch conversion against the reference
+double MaxError(const Function& function, const std::vector<float>& output)
+{
+    double maxError = 0;
+    for (size_t i = 0; i < output.size(); i++) {
+        const double expected = function.reference(function.input[i]);
+        maxError = std::max(maxError, std::abs(output[i] - expected) / std::max(std::abs(expected), function.errorFloor));
+    }
+    return maxError;
+}
+
+void CheckMethod(transfer::Method method)
+{
+    for (const auto& function : Functions()) {
+        std::vector<float> output(function.input.size());
+        function.batch(function.input, output, method);
+        const double maxError = method == transfer::Method::Reference ? 1e-6
+                                : method == transfer::Method::Table   ? function.tableError
+                                                                      : function.polynomialError;
+        CHECK(MaxError(function, output) <= maxError);
+
+        // In place
+        auto inPlace = function.input;
+        function.batch(inPlace, inPlace, method);
+        CHECK(inPlace == output);
+    }
+}
+
+} // namespace
+
+TEST_CASE(TransferFunction, Reference)
+{
+    CHECK(transfer::PqEotf(0.0) == 0);
+    CHECK(std::abs(transfer::PqEotf(1.0) - 10000) < 1e-6);
+    CHECK(std::abs(transfer::PqInverseEotf(100) - 0.508078) < 1e-6);
+    CHECK(std::abs(transfer::PqInverseEotf(transfer::PqEotf(0.75)) - 0.75) < 1e-12);
+    CHECK(std::abs(transfer::HlgOetf(1.0 / 12) - 0.5) < 1e-12);
+    CHECK(std::abs(transfer::HlgOetf(1.0) - 1) < 1e-6);
+    CHECK(std::abs(transfer::HlgInverseOetf(transfer::HlgOetf(0.3)) - 0.3) < 1e-12);
+    CHECK(std::abs(transfer::HlgSystemGamma(1000) - 1.2) < 1e-12);
+    CHECK(std::abs(transfer::HlgInverseEotf(transfer::HlgEotf(0.6, 600), 600) - 0.6) < 1e-12);
+}
+
+TEST_CASE(TransferFunction, ConstantEvaluation)
+{
+    constexpr double pq = transfer::PqEotf(0.5);
+    constexpr double pqInverse = transfer::PqInverseEotf(203);
+    constexpr double hlg = transfer::HlgOetf(0.5);
+    constexpr double hlgInverse = transfer::HlgInverseOetf(0.75);
+    CHECK(std::abs(pq - transfer::PqEotf(0.5)) < 1e-9 * pq);
+    CHECK(std::abs(pqInverse - transfer::PqInverseEotf(203)) < 1e-12);
+    CHECK(std::abs(hlg - transfer::HlgOetf(0.5)) < 1e-12);
+    CHECK(std::abs(hlgInverse - transfer::HlgInverseOetf(0.75)) < 1e-12);
+}
+
+TEST_CASE(TransferFunction, MethodReference)
+{
+    CheckMethod(transfer::Method::Reference);
+}
+
+TEST_CASE(TransferFunction, MethodTable)
+{
+    CheckMethod(transfer::Method::Table);
+}
+
+TEST_CASE(TransferFunction, MethodPolynomial)
+{
+    CheckMethod(transfer::Method::Polynomial);
+}
+
+TEST_CASE(TransferFunction, MethodVector)
+{
+    CheckMethod(transfer::Method::Vector);
+}
@@ -0,0 +1,76 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Test.hpp"
+
+#include "Samples.hpp"
+#include "Unicode.hpp"
+
+#include <string>
+
+TEST_CASE(Unicode, RoundTrip)
+{
+    const auto text = samples::MakeText(16 * 1024);
+    std::string utf8;
+    unicode::EncodeUtf8(text, utf8);
+    std::wstring decoded;
+    CHECK(unicode::DecodeUtf8(utf8, decoded));
+    CHECK(decoded == text);
+
+    std::string utf16;
+    unicode::EncodeUtf16LE(text, utf16);
+    unicode::DecodeUtf16LE(utf16, decoded);
+    CHECK(decoded == text);
+}
+
+TEST_CASE(Unicode, Encoding)
+{
+    std::string utf8;
+    unicode::EncodeUtf8(L"A\u00DC\u8272\U0001F5A5", utf8);
+    CHECK(utf8 == "A\xC3\x9C\xE8\x89\xB2\xF0\x9F\x96\xA5");
+
+    std::string utf16;
+    unicode::EncodeUtf16LE(L"A\U0001F5A5", utf16);
+    CHECK(utf16 == std::string("A\0\x3D\xD8\xA5\xDD", 6));
+
+    std::wstring decoded;
+    unicode::DecodeUtf16LE(std::string("A\0B", 3), decoded);
+    CHECK(decoded == L"A");
+}
+
+TEST_CASE(Unicode, InvalidUtf8)
+{
+    std::wstring decoded;
+    CHECK(!unicode::DecodeUtf8("\xC0\x80", decoded));
+    CHECK(!unicode::DecodeUtf8("\xED\xA0\x80", decoded));
+    CHECK(!unicode::DecodeUtf8("\xE8\x89", decoded));
+    CHECK(!unicode::DecodeUtf8("\x80", decoded));
+    CHECK(!unicode::DecodeUtf8("\xF4\x90\x80\x80", decoded));
+    CHECK(unicode::DecodeUtf8("", decoded));
+    CHECK(decoded.empty());
+}
+
+TEST_CASE(Unicode, NextCodePoint)
+{
+    const std::wstring text = L"A\U0001F5A5B";
+    size_t i = 0;
+    CHECK(unicode::NextCodePoint(text, i) == U'A');
+    CHECK(unicode::NextCodePoint(text, i) == U'\U0001F5A5');
+    CHECK(unicode::NextCodePoint(text, i) == U'B');
+    CHECK(i == text.size());
+}
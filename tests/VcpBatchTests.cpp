@@ -0,0 +1,135 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Test.hpp"
+
+#include "FakeDdc.hpp"
+#include "VcpBatch.hpp"
+
+#include <chrono>
+
+namespace {
+
+constexpr int kMonitors = 4;
+constexpr int kCodes = 8;
+// Short transactions, long enough for the monitors of a concurrent batch to overlap
+constexpr std::chrono::microseconds kGetLatency { 2000 };
+constexpr std::chrono::microseconds kSetLatency { 2500 };
+
+/// Codes from brightness (0x10) on, like a register dump would
+int Code(int index)
+{
+    return 0x10 + index;
+}
+
+int Written(int display, int vcpCode)
+{
+    return (display + vcpCode) % 100;
+}
+
+VcpBatch MakeReads()
+{
+    VcpBatch batch;
+    for (int display = 1; display <= kMonitors; display++) {
+        for (int i = 0; i < kCodes; i++)
+            batch.Get(display, Code(i));
+    }
+    return batch;
+}
+
+VcpBatch MakeWrites()
+{
+    VcpBatch batch;
+    for (int display = 1; display <= kMonitors; display++) {
+        for (int i = 0; i < kCodes; i++)
+            batch.Set(display, Code(i), Written(display, Code(i)));
+    }
+    return batch;
+}
+
+/// Number of results that failed, or don't match their request or the expected value
+template<typename Expected> int CountWrong(FakeDdc& ddc, const VcpBatch& batch, bool concurrent, Expected expected)
+{
+    const auto results = batch.Run(ddc, concurrent);
+    if (results.size() != batch.GetRequests().size())
+        return -1;
+    int wrong = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& result = results[i];
+        const auto& request = batch.GetRequests()[i];
+        if (!result.succeeded || result.display != request.display || result.vcpCode != request.vcpCode
+            || result.write != request.value.has_value() || result.value != expected(result.display, result.vcpCode))
+            wrong++;
+    }
+    return wrong;
+}
+
+} // namespace
+
+TEST_CASE(VcpBatch, ReadSequential)
+{
+    FakeDdc ddc(kMonitors, kGetLatency, kSetLatency);
+    const auto reads = MakeReads();
+    CHECK(reads.GetDisplayCount() == kMonitors);
+    CHECK(CountWrong(ddc, reads, false, &FakeDdc::DefaultValue) == 0);
+    CHECK(ddc.GetMaxBusyMonitors() == 1);
+    CHECK(ddc.GetCollisions() == 0);
+}
+
+TEST_CASE(VcpBatch, ReadConcurrent)
+{
+    FakeDdc ddc(kMonitors, kGetLatency, kSetLatency);
+    CHECK(CountWrong(ddc, MakeReads(), true, &FakeDdc::DefaultValue) == 0);
+    // Every monitor has a thread of its own, but never gets two transactions at once
+    CHECK(ddc.GetMaxBusyMonitors() >= 2);
+    CHECK(ddc.GetCollisions() == 0);
+}
+
+TEST_CASE(VcpBatch, WriteReadBack)
+{
+    FakeDdc ddc(kMonitors, kGetLatency, kSetLatency);
+    CHECK(CountWrong(ddc, MakeWrites(), true, &Written) == 0);
+    CHECK(CountWrong(ddc, MakeReads(), true, &Written) == 0);
+    CHECK(ddc.GetCollisions() == 0);
+}
+
+TEST_CASE(VcpBatch, InOrder)
+{
+    // Transactions for one monitor run in the order they were added
+    FakeDdc ddc(1, kGetLatency, kSetLatency);
+    VcpBatch batch;
+    batch.Set(1, 0x10, 20);
+    batch.Get(1, 0x10);
+    batch.Set(1, 0x10, 30);
+    batch.Get(1, 0x10);
+    const auto results = batch.Run(ddc);
+    REQUIRE(results.size() == 4);
+    CHECK(results[1].value == 20);
+    CHECK(results[3].value == 30);
+    CHECK(results[0].startUs <= results[1].startUs && results[1].startUs <= results[2].startUs);
+}
+
+TEST_CASE(VcpBatch, UnknownDisplay)
+{
+    FakeDdc ddc(1, kGetLatency, kSetLatency);
+    VcpBatch batch;
+    batch.Get(2, 0x10);
+    const auto results = batch.Run(ddc);
+    REQUIRE(results.size() == 1);
+    CHECK(!results[0].succeeded);
+}
@@ -0,0 +1,47 @@
+/*
+    HDRTray, a notification icon for the "Use HDR" option
+    Copyright (C) 2025 Frank Richter
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Test.hpp"
+
+#include "VcpOutput.hpp"
+
+TEST_CASE(VcpOutput, Formats)
+{
+    int value = 0;
+    CHECK(ParseVcpCurrentValue(L"VCP 0x10 (Luminance): current value = 50, maximum value = 100\r\n", value));
+    CHECK(value == 50);
+    value = 0;
+    CHECK(ParseVcpCurrentValue(L"VCP 0x10 50 100\r\n", value));
+    CHECK(value == 50);
+    value = 0;
+    CHECK(ParseVcpCurrentValue(L"Luminance: value = 0x32, max = 0x64\r\n", value));
+    CHECK(value == 50);
+    value = 0;
+    CHECK(ParseVcpCurrentValue(L"current=35", value));
+    CHECK(value == 35);
+    value = 0;
+    CHECK(ParseVcpCurrentValue(L"current value: 0x0032", value));
+    CHECK(value == 50);
+}
+
+TEST_CASE(VcpOutput, NoValue)
+{
+    int value = -1;
+    CHECK(!ParseVcpCurrentValue(L"Invalid display\r\n", value));
+    CHECK(!ParseVcpCurrentValue(L"", value));
+}